@@ -0,0 +1,121 @@
+//
+// Copyright 2019 Jeff Bush
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+`include "defines.svh"
+
+import defines::*;
+
+//
+// Branch target buffer for instruction fetch. Each entry holds the address of
+// a PC relative branch that has been taken, its destination, and a two bit
+// saturating counter that predicts its direction. ifetch_tag_stage looks up
+// the PC it is fetching and, when this predicts the branch is taken, fetches
+// the destination next instead of the following instruction.
+//
+// int_execute_stage updates entries when it resolves branches. An entry is
+// only allocated when a branch is taken, and starts weakly taken, so a loop
+// branch stays predicted taken after it falls through once. The table is
+// shared by all threads, indexed by the low bits of the virtual address and
+// tagged with the rest. It doesn't track address spaces or code
+// modification, so instruction_decode_stage checks that each predicted
+// instruction is a PC relative branch to the predicted address.
+//
+
+module branch_predictor
+    #(parameter NUM_ENTRIES = 32)
+
+    (input                      clk,
+    input                       reset,
+
+    // Lookup
+    input scalar_t              lookup_pc,
+    output logic                lookup_taken,
+    output scalar_t             lookup_target,
+
+    // Update
+    input                       update_en,
+    input scalar_t              update_pc,
+    input                       update_taken,
+    input scalar_t              update_target);
+
+    localparam INDEX_WIDTH = $clog2(NUM_ENTRIES);
+    localparam TAG_WIDTH = 30 - INDEX_WIDTH;
+
+    typedef logic[INDEX_WIDTH - 1:0] btb_index_t;
+    typedef logic[TAG_WIDTH - 1:0] btb_tag_t;
+
+    logic entry_valid[NUM_ENTRIES];
+    btb_tag_t entry_tag[NUM_ENTRIES];
+    logic[29:0] entry_target[NUM_ENTRIES];
+    logic[1:0] entry_counter[NUM_ENTRIES];
+    btb_index_t lookup_index;
+    btb_index_t update_index;
+    logic update_hit;
+
+    initial
+    begin
+        assert(NUM_ENTRIES >= 2);
+        assert((NUM_ENTRIES & (NUM_ENTRIES - 1)) == 0);
+    end
+
+    assign lookup_index = lookup_pc[2+:INDEX_WIDTH];
+    assign lookup_taken = entry_valid[lookup_index]
+        && entry_tag[lookup_index] == lookup_pc[31-:TAG_WIDTH]
+        && entry_counter[lookup_index][1];
+    assign lookup_target = {entry_target[lookup_index], 2'b00};
+
+    assign update_index = update_pc[2+:INDEX_WIDTH];
+    assign update_hit = entry_valid[update_index]
+        && entry_tag[update_index] == update_pc[31-:TAG_WIDTH];
+
+    always_ff @(posedge clk, posedge reset)
+    begin
+        if (reset)
+        begin
+            for (int i = 0; i < NUM_ENTRIES; i++)
+                entry_valid[i] <= 0;
+        end
+        else if (update_en && update_taken)
+            entry_valid[update_index] <= 1;
+    end
+
+    always_ff @(posedge clk)
+    begin
+        if (update_en)
+        begin
+            if (update_hit)
+            begin
+                if (update_taken)
+                begin
+                    if (entry_counter[update_index] != 2'b11)
+                        entry_counter[update_index] <= entry_counter[update_index] + 2'd1;
+
+                    entry_target[update_index] <= update_target[31:2];
+                end
+                else if (entry_counter[update_index] != 2'b00)
+                    entry_counter[update_index] <= entry_counter[update_index] - 2'd1;
+            end
+            else if (update_taken)
+            begin
+                // Replace whatever was in this entry
+                entry_tag[update_index] <= update_pc[31-:TAG_WIDTH];
+                entry_target[update_index] <= update_target[31:2];
+                entry_counter[update_index] <= 2'b10;
+            end
+        end
+    end
+endmodule
@@ -23,12 +23,32 @@ import defines::*;
 // Storage for control registers.
 // Also contains interrupt handling logic.
 //
+// Performance counter control word (accessed via CR_PERF_DATA when the
+// field in CR_PERF_INDEX is PERF_FIELD_CONTROL):
+//  7:0   event select. The L2 cache events follow the core events.
+//  15:8  thread mask. Only events caused by threads with a bit set are
+//        counted (THREADS_PER_CORE is at most 8). Set to all ones at reset.
+//        L2 cache events are shared by all cores and ignore this.
+//  30    overflow interrupt enable
+//  31    overflow. Set when the counter wraps from all ones to zero. Cleared
+//        by writing the control word with this bit clear.
+// When a counter overflows with its interrupt enabled, the PERF_INTERRUPT
+// interrupt is asserted for each thread in its thread mask until software
+// clears the overflow bit. This is always level triggered, regardless of
+// CR_INTERRUPT_TRIGGER.
+//
+// CR_PREFETCH_CONTROL (see prefetch_control_t) is shared by all threads in
+// the core. At reset, it enables the L1 instruction cache prefetcher and the
+// L1 data cache prefetcher with a distance of two strides.
+//
 
 module control_registers
     #(parameter CORE_ID = 0,
     parameter NUM_INTERRUPTS = 16,
     parameter NUM_PERF_EVENTS = 8,
-    parameter EVENT_IDX_WIDTH = $clog2(NUM_PERF_EVENTS))
+    parameter EVENT_IDX_WIDTH = $clog2(NUM_PERF_EVENTS),
+    parameter NUM_PERF_COUNTERS = 2,
+    parameter PERF_COUNTER_IDX_WIDTH = $clog2(NUM_PERF_COUNTERS))
     (input                                  clk,
     input                                   reset,
 
@@ -73,11 +93,17 @@ module control_registers
     output scalar_t                         cr_trap_handler,
     output scalar_t                         cr_tlb_miss_handler,
 
+    // To l1_l2_interface
+    output prefetch_control_t               cr_prefetch_control,
+
     // To/from performance_counters
-    output logic[EVENT_IDX_WIDTH - 1:0]     cr_perf_event_select0,
-    output logic[EVENT_IDX_WIDTH - 1:0]     cr_perf_event_select1,
-    input[63:0]                             perf_event_count0,
-    input[63:0]                             perf_event_count1,
+    output logic[NUM_PERF_COUNTERS - 1:0][EVENT_IDX_WIDTH - 1:0] cr_perf_event_select,
+    output local_thread_bitmap_t            cr_perf_thread_mask[NUM_PERF_COUNTERS],
+    output logic[NUM_PERF_COUNTERS - 1:0]   cr_perf_count_write_en,
+    output logic                            cr_perf_count_write_high,
+    output scalar_t                         cr_perf_count_write_val,
+    input[NUM_PERF_COUNTERS - 1:0][63:0]    perf_event_count,
+    input[NUM_PERF_COUNTERS - 1:0]          perf_event_overflow,
 
     // To/from on_chip_debugger
     input scalar_t                          ocd_data_from_host,
@@ -87,6 +113,10 @@ module control_registers
     // One is for current state. Maximum nested traps is TRAP_LEVELS - 1.
     localparam TRAP_LEVELS = 3;
 
+    // Performance counter overflow is signaled on the highest interrupt
+    // line, which is not connected to an external interrupt source.
+    localparam PERF_INTERRUPT = NUM_INTERRUPTS - 1;
+
     typedef struct packed {
         logic supervisor_en;
         logic mmu_en;
@@ -116,9 +146,30 @@ module control_registers
     logic[NUM_INTERRUPTS - 1:0] interrupt_req_prev;
     logic[NUM_INTERRUPTS - 1:0] interrupt_edge;
     scalar_t jtag_data;
+    logic[PERF_COUNTER_IDX_WIDTH - 1:0] perf_counter_idx[`THREADS_PER_CORE];
+    perf_field_t perf_field[`THREADS_PER_CORE];
+    logic[PERF_COUNTER_IDX_WIDTH - 1:0] perf_access_idx;
+    logic[NUM_PERF_COUNTERS - 1:0] perf_int_en;
+    logic[NUM_PERF_COUNTERS - 1:0] perf_overflow;
+    logic[NUM_PERF_COUNTERS - 1:0] perf_overflow_clear;
+    logic perf_data_write;
 
     assign cr_data_to_host = jtag_data;
 
+    // The thread accessing CR_PERF_DATA this cycle and the counter/field it
+    // has selected with CR_PERF_INDEX.
+    assign perf_access_idx = perf_counter_idx[dt_thread_idx];
+    assign perf_data_write = dd_creg_write_en && dd_creg_index == CR_PERF_DATA;
+    assign cr_perf_count_write_en = (perf_data_write
+        && (perf_field[dt_thread_idx] == PERF_FIELD_COUNT_L
+        || perf_field[dt_thread_idx] == PERF_FIELD_COUNT_H))
+        ? NUM_PERF_COUNTERS'(1) << perf_access_idx : '0;
+    assign cr_perf_count_write_high = perf_field[dt_thread_idx] == PERF_FIELD_COUNT_H;
+    assign cr_perf_count_write_val = dd_creg_write_val;
+    assign perf_overflow_clear = (perf_data_write
+        && perf_field[dt_thread_idx] == PERF_FIELD_CONTROL
+        && !dd_creg_write_val[31]) ? NUM_PERF_COUNTERS'(1) << perf_access_idx : '0;
+
     always_ff @(posedge clk, posedge reset)
     begin
         if (reset)
@@ -130,8 +181,13 @@ module control_registers
                 cr_current_asid[thread_idx] <= '0;
                 page_dir_base[thread_idx] <= '0;
                 interrupt_mask[thread_idx] <= '0;
+                perf_counter_idx[thread_idx] <= '0;
+                perf_field[thread_idx] <= PERF_FIELD_CONTROL;
             end
 
+            for (int counter_idx = 0; counter_idx < NUM_PERF_COUNTERS; counter_idx++)
+                cr_perf_thread_mask[counter_idx] <= '1;
+
             // AUTORESET gets confused by all of the structure accesses
             // below, so the resets are all manual here. Be sure to add all registers
             // accessed below here.
@@ -142,8 +198,12 @@ module control_registers
             int_trigger_type <= '0;
             cr_suspend_thread <= '0;
             cr_resume_thread <= '0;
-            cr_perf_event_select0 <= '0;
-            cr_perf_event_select1 <= '0;
+            cr_perf_event_select <= '0;
+            perf_int_en <= '0;
+            cr_prefetch_control <= '0;
+            cr_prefetch_control.dcache_en <= 1;
+            cr_prefetch_control.dcache_distance <= 2;
+            cr_prefetch_control.icache_en <= 1;
         end
         else
         begin
@@ -207,8 +267,32 @@ module control_registers
                     CR_JTAG_DATA:         jtag_data <= dd_creg_write_val;
                     CR_SUSPEND_THREAD:    cr_suspend_thread <= dd_creg_write_val[TOTAL_THREADS - 1:0];
                     CR_RESUME_THREAD:     cr_resume_thread <= dd_creg_write_val[TOTAL_THREADS - 1:0];
-                    CR_PERF_EVENT_SELECT0: cr_perf_event_select0 <= dd_creg_write_val[EVENT_IDX_WIDTH - 1:0];
-                    CR_PERF_EVENT_SELECT1: cr_perf_event_select1 <= dd_creg_write_val[EVENT_IDX_WIDTH - 1:0];
+                    CR_PERF_EVENT_SELECT0: cr_perf_event_select[0] <= dd_creg_write_val[EVENT_IDX_WIDTH - 1:0];
+                    CR_PERF_EVENT_SELECT1: cr_perf_event_select[1] <= dd_creg_write_val[EVENT_IDX_WIDTH - 1:0];
+                    CR_PERF_INDEX:
+                    begin
+                        perf_counter_idx[dt_thread_idx] <= dd_creg_write_val[PERF_COUNTER_IDX_WIDTH - 1:0];
+                        perf_field[dt_thread_idx] <= perf_field_t'(dd_creg_write_val[9:8]);
+                    end
+
+                    CR_PERF_DATA:
+                    begin
+                        // Count fields are written in performance_counters
+                        if (perf_field[dt_thread_idx] == PERF_FIELD_CONTROL)
+                        begin
+                            cr_perf_event_select[perf_access_idx] <= dd_creg_write_val[EVENT_IDX_WIDTH - 1:0];
+                            cr_perf_thread_mask[perf_access_idx] <= dd_creg_write_val[8+:`THREADS_PER_CORE];
+                            perf_int_en[perf_access_idx] <= dd_creg_write_val[30];
+                        end
+                    end
+
+                    CR_PREFETCH_CONTROL:
+                    begin
+                        cr_prefetch_control.dcache_en <= dd_creg_write_val[0];
+                        cr_prefetch_control.dcache_distance <= dd_creg_write_val[7:4];
+                        cr_prefetch_control.icache_en <= dd_creg_write_val[8];
+                    end
+
                     default:
                         ;
                 endcase
@@ -228,12 +312,24 @@ module control_registers
 
     assign interrupt_edge = interrupt_req & ~interrupt_req_prev;
 
+    // A new overflow takes precedence over software clearing the flag in the
+    // same cycle, so an event isn't lost.
+    always_ff @(posedge clk, posedge reset)
+    begin
+        if (reset)
+            perf_overflow <= '0;
+        else
+            perf_overflow <= (perf_overflow & ~perf_overflow_clear) | perf_event_overflow;
+    end
+
     genvar thread_idx;
     generate
         for (thread_idx = 0; thread_idx < `THREADS_PER_CORE; thread_idx++)
         begin : interrupt_gen
             logic[NUM_INTERRUPTS - 1:0] interrupt_ack;
             logic do_interrupt_ack;
+            logic[NUM_PERF_COUNTERS - 1:0] perf_thread_en;
+            logic perf_interrupt;
 
             assign do_interrupt_ack = dt_thread_idx == thread_idx
                 && dd_creg_write_en
@@ -260,11 +356,20 @@ module control_registers
                 end
             end
 
+            always_comb
+            begin
+                for (int counter_idx = 0; counter_idx < NUM_PERF_COUNTERS; counter_idx++)
+                    perf_thread_en[counter_idx] = cr_perf_thread_mask[counter_idx][thread_idx];
+            end
+
+            assign perf_interrupt = |(perf_overflow & perf_int_en & perf_thread_en);
+
             // If the trigger type is 1 (level triggered), interrupt pending is
             // determined by level. Otherwise check interrupt_latch, which stores
             // if an edge has been detected.
             assign interrupt_pending[thread_idx] = (int_trigger_type & interrupt_req)
-                | (~int_trigger_type & interrupt_edge_latched[thread_idx]);
+                | (~int_trigger_type & interrupt_edge_latched[thread_idx])
+                | (NUM_INTERRUPTS'(perf_interrupt) << PERF_INTERRUPT);
 
             // Output to pipeline indicates if any interrupts are pending for each
             // thread.
@@ -301,10 +406,33 @@ module control_registers
                 CR_INTERRUPT_TRIGGER: cr_creg_read_val <= scalar_t'(int_trigger_type);
                 CR_JTAG_DATA:         cr_creg_read_val <= jtag_data;
                 CR_SYSCALL_INDEX:     cr_creg_read_val <= scalar_t'(trap_state[dt_thread_idx][0].syscall_index);
-                CR_PERF_EVENT_COUNT0_L: cr_creg_read_val <= perf_event_count0[31:0];
-                CR_PERF_EVENT_COUNT0_H: cr_creg_read_val <= perf_event_count0[63:32];
-                CR_PERF_EVENT_COUNT1_L: cr_creg_read_val <= perf_event_count1[31:0];
-                CR_PERF_EVENT_COUNT1_H: cr_creg_read_val <= perf_event_count1[63:32];
+                CR_PERF_EVENT_COUNT0_L: cr_creg_read_val <= perf_event_count[0][31:0];
+                CR_PERF_EVENT_COUNT0_H: cr_creg_read_val <= perf_event_count[0][63:32];
+                CR_PERF_EVENT_COUNT1_L: cr_creg_read_val <= perf_event_count[1][31:0];
+                CR_PERF_EVENT_COUNT1_H: cr_creg_read_val <= perf_event_count[1][63:32];
+                CR_PERF_INDEX:        cr_creg_read_val <= scalar_t'({perf_field[dt_thread_idx],
+                                                          8'(perf_counter_idx[dt_thread_idx])});
+                CR_PERF_DATA:
+                begin
+                    unique case (perf_field[dt_thread_idx])
+                        PERF_FIELD_CONTROL:
+                        begin
+                            cr_creg_read_val <= {
+                                perf_overflow[perf_access_idx],
+                                perf_int_en[perf_access_idx],
+                                14'd0,
+                                8'(cr_perf_thread_mask[perf_access_idx]),
+                                8'(cr_perf_event_select[perf_access_idx])
+                            };
+                        end
+
+                        PERF_FIELD_COUNT_L: cr_creg_read_val <= perf_event_count[perf_access_idx][31:0];
+                        PERF_FIELD_COUNT_H: cr_creg_read_val <= perf_event_count[perf_access_idx][63:32];
+                        default:            cr_creg_read_val <= 32'hffffffff;
+                    endcase
+                end
+
+                CR_PREFETCH_CONTROL:  cr_creg_read_val <= scalar_t'(cr_prefetch_control);
                 default:              cr_creg_read_val <= 32'hffffffff;
             endcase
         end
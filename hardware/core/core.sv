@@ -47,6 +47,9 @@ module core
     input                                  ii_response_valid,
     input iorsp_packet_t                   ii_response,
 
+    // From l2_cache
+    input [L2_PERF_EVENTS * `L2_BANKS - 1:0] l2_perf_events,
+
     // To io_request_queue
     output logic                           ior_request_valid,
     output ioreq_packet_t                  ior_request,
@@ -67,12 +70,13 @@ module core
     output logic[TOTAL_THREADS - 1:0]      cr_suspend_thread,
     output logic[TOTAL_THREADS - 1:0]      cr_resume_thread);
 
-    localparam EVENT_IDX_WIDTH = $clog2(CORE_PERF_EVENTS);
-    localparam NUM_PERF_COUNTERS = 2;
+    localparam TOTAL_PERF_EVENTS = CORE_PERF_EVENTS + L2_PERF_EVENTS * `L2_BANKS;
+    localparam EVENT_IDX_WIDTH = $clog2(TOTAL_PERF_EVENTS);
+    localparam NUM_PERF_COUNTERS = 8;
 
     logic core_selected_debug;
     logic[CORE_PERF_EVENTS - 1:0] perf_events;
-    logic[NUM_PERF_COUNTERS - 1:0][EVENT_IDX_WIDTH - 1:0] perf_event_select;
+    local_thread_idx_t[CORE_PERF_EVENTS - 1:0] perf_event_thread;
 
     /*AUTOLOGIC*/
     // Beginning of automatic wires (for undeclared instantiated-module outputs)
@@ -83,11 +87,18 @@ module core
     local_thread_bitmap_t cr_interrupt_en;      // From control_registers of control_registers.v
     logic [`THREADS_PER_CORE-1:0] cr_interrupt_pending;// From control_registers of control_registers.v
     logic               cr_mmu_en [`THREADS_PER_CORE];// From control_registers of control_registers.v
+    logic [NUM_PERF_COUNTERS-1:0] cr_perf_count_write_en;// From control_registers of control_registers.v
+    logic               cr_perf_count_write_high;// From control_registers of control_registers.v
+    scalar_t            cr_perf_count_write_val;// From control_registers of control_registers.v
+    logic [NUM_PERF_COUNTERS-1:0] [EVENT_IDX_WIDTH-1:0] cr_perf_event_select;// From control_registers of control_registers.v
+    local_thread_bitmap_t cr_perf_thread_mask [NUM_PERF_COUNTERS];// From control_registers of control_registers.v
+    prefetch_control_t  cr_prefetch_control;    // From control_registers of control_registers.v
     logic               cr_supervisor_en [`THREADS_PER_CORE];// From control_registers of control_registers.v
     scalar_t            cr_tlb_miss_handler;    // From control_registers of control_registers.v
     scalar_t            cr_trap_handler;        // From control_registers of control_registers.v
     logic               dd_cache_miss;          // From dcache_data_stage of dcache_data_stage.v
     cache_line_index_t  dd_cache_miss_addr;     // From dcache_data_stage of dcache_data_stage.v
+    scalar_t            dd_cache_miss_pc;       // From dcache_data_stage of dcache_data_stage.v
     logic               dd_cache_miss_sync;     // From dcache_data_stage of dcache_data_stage.v
     local_thread_idx_t  dd_cache_miss_thread_idx;// From dcache_data_stage of dcache_data_stage.v
     control_register_t  dd_creg_index;          // From dcache_data_stage of dcache_data_stage.v
@@ -111,10 +122,16 @@ module core
     logic               dd_membar_en;           // From dcache_data_stage of dcache_data_stage.v
     logic               dd_perf_dcache_hit;     // From dcache_data_stage of dcache_data_stage.v
     logic               dd_perf_dcache_miss;    // From dcache_data_stage of dcache_data_stage.v
+    logic               dd_perf_dcache_prefetch_hit;// From dcache_data_stage of dcache_data_stage.v
     logic               dd_perf_dtlb_miss;      // From dcache_data_stage of dcache_data_stage.v
+    logic               dd_prefetch_hit;        // From dcache_data_stage of dcache_data_stage.v
     l1d_addr_t          dd_request_vaddr;       // From dcache_data_stage of dcache_data_stage.v
     logic               dd_rollback_en;         // From dcache_data_stage of dcache_data_stage.v
     scalar_t            dd_rollback_pc;         // From dcache_data_stage of dcache_data_stage.v
+    logic               dd_scgath_covered;      // From dcache_data_stage of dcache_data_stage.v
+    logic               dd_scgath_run_done;     // From dcache_data_stage of dcache_data_stage.v
+    scgath_word_idx_t   dd_scgath_word_idx;     // From dcache_data_stage of dcache_data_stage.v
+    logic               dd_scratchpad_access;   // From dcache_data_stage of dcache_data_stage.v
     cache_line_index_t  dd_store_addr;          // From dcache_data_stage of dcache_data_stage.v
     cache_line_index_t  dd_store_bypass_addr;   // From dcache_data_stage of dcache_data_stage.v
     local_thread_idx_t  dd_store_bypass_thread_idx;// From dcache_data_stage of dcache_data_stage.v
@@ -130,14 +147,26 @@ module core
     trap_cause_t        dd_trap_cause;          // From dcache_data_stage of dcache_data_stage.v
     logic               dd_update_lru_en;       // From dcache_data_stage of dcache_data_stage.v
     l1d_way_idx_t       dd_update_lru_way;      // From dcache_data_stage of dcache_data_stage.v
+    logic               dd_wait_en;             // From dcache_data_stage of dcache_data_stage.v
+    local_thread_idx_t  dd_wait_thread_idx;     // From dcache_data_stage of dcache_data_stage.v
     l1d_way_idx_t       dt_fill_lru;            // From dcache_tag_stage of dcache_tag_stage.v
     decoded_instruction_t dt_instruction;       // From dcache_tag_stage of dcache_tag_stage.v
     logic               dt_instruction_valid;   // From dcache_tag_stage of dcache_tag_stage.v
     logic               dt_invalidate_tlb_all_en;// From dcache_tag_stage of dcache_tag_stage.v
     logic               dt_invalidate_tlb_en;   // From dcache_tag_stage of dcache_tag_stage.v
     vector_mask_t       dt_mask_value;          // From dcache_tag_stage of dcache_tag_stage.v
+    logic               dt_prefetched [`L1D_WAYS];// From dcache_tag_stage of dcache_tag_stage.v
     l1d_addr_t          dt_request_paddr;       // From dcache_tag_stage of dcache_tag_stage.v
     l1d_addr_t          dt_request_vaddr;       // From dcache_tag_stage of dcache_tag_stage.v
+    logic               dt_scgath_advance_done; // From dcache_tag_stage of dcache_tag_stage.v
+    logic               dt_scgath_advance_en;   // From dcache_tag_stage of dcache_tag_stage.v
+    subcycle_t          dt_scgath_advance_from; // From dcache_tag_stage of dcache_tag_stage.v
+    local_thread_idx_t  dt_scgath_advance_thread_idx;// From dcache_tag_stage of dcache_tag_stage.v
+    subcycle_t          dt_scgath_advance_to;   // From dcache_tag_stage of dcache_tag_stage.v
+    logic               dt_scgath_covered;      // From dcache_tag_stage of dcache_tag_stage.v
+    vector_mask_t       dt_scgath_lane_mask;    // From dcache_tag_stage of dcache_tag_stage.v
+    logic               dt_scgath_run_done;     // From dcache_tag_stage of dcache_tag_stage.v
+    scgath_word_idx_t   dt_scgath_word_idx;     // From dcache_tag_stage of dcache_tag_stage.v
     l1d_tag_t           dt_snoop_tag [`L1D_WAYS];// From dcache_tag_stage of dcache_tag_stage.v
     logic               dt_snoop_valid [`L1D_WAYS];// From dcache_tag_stage of dcache_tag_stage.v
     vector_t            dt_store_value;         // From dcache_tag_stage of dcache_tag_stage.v
@@ -154,12 +183,18 @@ module core
     logic               dt_update_itlb_global;  // From dcache_tag_stage of dcache_tag_stage.v
     page_index_t        dt_update_itlb_ppage_idx;// From dcache_tag_stage of dcache_tag_stage.v
     logic               dt_update_itlb_present; // From dcache_tag_stage of dcache_tag_stage.v
+    logic               dt_update_itlb_superpage;// From dcache_tag_stage of dcache_tag_stage.v
     logic               dt_update_itlb_supervisor;// From dcache_tag_stage of dcache_tag_stage.v
     page_index_t        dt_update_itlb_vpage_idx;// From dcache_tag_stage of dcache_tag_stage.v
     logic               dt_valid [`L1D_WAYS];   // From dcache_tag_stage of dcache_tag_stage.v
     logic [NUM_VECTOR_LANES-1:0] [7:0] fx1_add_exponent;// From fp_execute_stage1 of fp_execute_stage1.v
     logic [NUM_VECTOR_LANES-1:0] fx1_add_result_sign;// From fp_execute_stage1 of fp_execute_stage1.v
     logic [NUM_VECTOR_LANES-1:0] fx1_equal;     // From fp_execute_stage1 of fp_execute_stage1.v
+    logic [NUM_VECTOR_LANES-1:0] [23:0] fx1_fma_addend;// From fp_execute_stage1 of fp_execute_stage1.v
+    logic [NUM_VECTOR_LANES-1:0] fx1_fma_addend_sign;// From fp_execute_stage1 of fp_execute_stage1.v
+    logic [NUM_VECTOR_LANES-1:0] [5:0] fx1_fma_align_shift;// From fp_execute_stage1 of fp_execute_stage1.v
+    logic [NUM_VECTOR_LANES-1:0] [9:0] fx1_fma_exponent;// From fp_execute_stage1 of fp_execute_stage1.v
+    logic [NUM_VECTOR_LANES-1:0] fx1_fma_product_larger;// From fp_execute_stage1 of fp_execute_stage1.v
     logic [NUM_VECTOR_LANES-1:0] [5:0] fx1_ftoi_lshift;// From fp_execute_stage1 of fp_execute_stage1.v
     decoded_instruction_t fx1_instruction;      // From fp_execute_stage1 of fp_execute_stage1.v
     logic               fx1_instruction_valid;  // From fp_execute_stage1 of fp_execute_stage1.v
@@ -180,6 +215,11 @@ module core
     logic [NUM_VECTOR_LANES-1:0] [7:0] fx2_add_exponent;// From fp_execute_stage2 of fp_execute_stage2.v
     logic [NUM_VECTOR_LANES-1:0] fx2_add_result_sign;// From fp_execute_stage2 of fp_execute_stage2.v
     logic [NUM_VECTOR_LANES-1:0] fx2_equal;     // From fp_execute_stage2 of fp_execute_stage2.v
+    logic [NUM_VECTOR_LANES-1:0] [23:0] fx2_fma_addend;// From fp_execute_stage2 of fp_execute_stage2.v
+    logic [NUM_VECTOR_LANES-1:0] fx2_fma_addend_sign;// From fp_execute_stage2 of fp_execute_stage2.v
+    logic [NUM_VECTOR_LANES-1:0] [5:0] fx2_fma_align_shift;// From fp_execute_stage2 of fp_execute_stage2.v
+    logic [NUM_VECTOR_LANES-1:0] [9:0] fx2_fma_exponent;// From fp_execute_stage2 of fp_execute_stage2.v
+    logic [NUM_VECTOR_LANES-1:0] fx2_fma_product_larger;// From fp_execute_stage2 of fp_execute_stage2.v
     logic [NUM_VECTOR_LANES-1:0] [5:0] fx2_ftoi_lshift;// From fp_execute_stage2 of fp_execute_stage2.v
     logic [NUM_VECTOR_LANES-1:0] fx2_guard;     // From fp_execute_stage2 of fp_execute_stage2.v
     decoded_instruction_t fx2_instruction;      // From fp_execute_stage2 of fp_execute_stage2.v
@@ -202,6 +242,11 @@ module core
     logic [NUM_VECTOR_LANES-1:0] fx3_add_result_sign;// From fp_execute_stage3 of fp_execute_stage3.v
     scalar_t [NUM_VECTOR_LANES-1:0] fx3_add_significand;// From fp_execute_stage3 of fp_execute_stage3.v
     logic [NUM_VECTOR_LANES-1:0] fx3_equal;     // From fp_execute_stage3 of fp_execute_stage3.v
+    logic [NUM_VECTOR_LANES-1:0] [9:0] fx3_fma_exponent;// From fp_execute_stage3 of fp_execute_stage3.v
+    logic [NUM_VECTOR_LANES-1:0] fx3_fma_logical_subtract;// From fp_execute_stage3 of fp_execute_stage3.v
+    logic [NUM_VECTOR_LANES-1:0] fx3_fma_result_sign;// From fp_execute_stage3 of fp_execute_stage3.v
+    logic [NUM_VECTOR_LANES-1:0] [50:0] fx3_fma_significand_le;// From fp_execute_stage3 of fp_execute_stage3.v
+    logic [NUM_VECTOR_LANES-1:0] [50:0] fx3_fma_significand_se;// From fp_execute_stage3 of fp_execute_stage3.v
     logic [NUM_VECTOR_LANES-1:0] [5:0] fx3_ftoi_lshift;// From fp_execute_stage3 of fp_execute_stage3.v
     decoded_instruction_t fx3_instruction;      // From fp_execute_stage3 of fp_execute_stage3.v
     logic               fx3_instruction_valid;  // From fp_execute_stage3 of fp_execute_stage3.v
@@ -210,6 +255,7 @@ module core
     logic [NUM_VECTOR_LANES-1:0] [7:0] fx3_mul_exponent;// From fp_execute_stage3 of fp_execute_stage3.v
     logic [NUM_VECTOR_LANES-1:0] fx3_mul_sign;  // From fp_execute_stage3 of fp_execute_stage3.v
     logic [NUM_VECTOR_LANES-1:0] fx3_mul_underflow;// From fp_execute_stage3 of fp_execute_stage3.v
+    logic [3:0] [36:0]  fx3_reduce_partial;     // From fp_execute_stage3 of fp_execute_stage3.v
     logic [NUM_VECTOR_LANES-1:0] fx3_result_inf;// From fp_execute_stage3 of fp_execute_stage3.v
     logic [NUM_VECTOR_LANES-1:0] fx3_result_nan;// From fp_execute_stage3 of fp_execute_stage3.v
     logic [NUM_VECTOR_LANES-1:0] [63:0] fx3_significand_product;// From fp_execute_stage3 of fp_execute_stage3.v
@@ -219,6 +265,10 @@ module core
     logic [NUM_VECTOR_LANES-1:0] fx4_add_result_sign;// From fp_execute_stage4 of fp_execute_stage4.v
     logic [NUM_VECTOR_LANES-1:0] [31:0] fx4_add_significand;// From fp_execute_stage4 of fp_execute_stage4.v
     logic [NUM_VECTOR_LANES-1:0] fx4_equal;     // From fp_execute_stage4 of fp_execute_stage4.v
+    logic [NUM_VECTOR_LANES-1:0] [9:0] fx4_fma_exponent;// From fp_execute_stage4 of fp_execute_stage4.v
+    logic [NUM_VECTOR_LANES-1:0] [5:0] fx4_fma_norm_shift;// From fp_execute_stage4 of fp_execute_stage4.v
+    logic [NUM_VECTOR_LANES-1:0] fx4_fma_result_sign;// From fp_execute_stage4 of fp_execute_stage4.v
+    logic [NUM_VECTOR_LANES-1:0] [51:0] fx4_fma_significand;// From fp_execute_stage4 of fp_execute_stage4.v
     decoded_instruction_t fx4_instruction;      // From fp_execute_stage4 of fp_execute_stage4.v
     logic               fx4_instruction_valid;  // From fp_execute_stage4 of fp_execute_stage4.v
     logic [NUM_VECTOR_LANES-1:0] fx4_logical_subtract;// From fp_execute_stage4 of fp_execute_stage4.v
@@ -227,6 +277,9 @@ module core
     logic [NUM_VECTOR_LANES-1:0] fx4_mul_sign;  // From fp_execute_stage4 of fp_execute_stage4.v
     logic [NUM_VECTOR_LANES-1:0] fx4_mul_underflow;// From fp_execute_stage4 of fp_execute_stage4.v
     logic [NUM_VECTOR_LANES-1:0] [5:0] fx4_norm_shift;// From fp_execute_stage4 of fp_execute_stage4.v
+    logic [5:0]         fx4_reduce_norm_shift;  // From fp_execute_stage4 of fp_execute_stage4.v
+    logic               fx4_reduce_sign;        // From fp_execute_stage4 of fp_execute_stage4.v
+    logic [35:0]        fx4_reduce_value;       // From fp_execute_stage4 of fp_execute_stage4.v
     logic [NUM_VECTOR_LANES-1:0] fx4_result_inf;// From fp_execute_stage4 of fp_execute_stage4.v
     logic [NUM_VECTOR_LANES-1:0] fx4_result_nan;// From fp_execute_stage4 of fp_execute_stage4.v
     logic [NUM_VECTOR_LANES-1:0] [63:0] fx4_significand_product;// From fp_execute_stage4 of fp_execute_stage4.v
@@ -240,8 +293,12 @@ module core
     local_thread_idx_t  fx5_thread_idx;         // From fp_execute_stage5 of fp_execute_stage5.v
     decoded_instruction_t id_instruction;       // From instruction_decode_stage of instruction_decode_stage.v
     logic               id_instruction_valid;   // From instruction_decode_stage of instruction_decode_stage.v
+    logic               id_redirect_en;         // From instruction_decode_stage of instruction_decode_stage.v
+    scalar_t            id_redirect_pc;         // From instruction_decode_stage of instruction_decode_stage.v
+    local_thread_idx_t  id_redirect_thread_idx; // From instruction_decode_stage of instruction_decode_stage.v
     local_thread_idx_t  id_thread_idx;          // From instruction_decode_stage of instruction_decode_stage.v
     logic               ifd_alignment_fault;    // From ifetch_data_stage of ifetch_data_stage.v
+    logic               ifd_branch_predicted;   // From ifetch_data_stage of ifetch_data_stage.v
     logic               ifd_cache_miss;         // From ifetch_data_stage of ifetch_data_stage.v
     cache_line_index_t  ifd_cache_miss_paddr;   // From ifetch_data_stage of ifetch_data_stage.v
     local_thread_idx_t  ifd_cache_miss_thread_idx;// From ifetch_data_stage of ifetch_data_stage.v
@@ -254,16 +311,24 @@ module core
     scalar_t            ifd_pc;                 // From ifetch_data_stage of ifetch_data_stage.v
     logic               ifd_perf_icache_hit;    // From ifetch_data_stage of ifetch_data_stage.v
     logic               ifd_perf_icache_miss;   // From ifetch_data_stage of ifetch_data_stage.v
+    logic               ifd_perf_icache_prefetch_hit;// From ifetch_data_stage of ifetch_data_stage.v
     logic               ifd_perf_itlb_miss;     // From ifetch_data_stage of ifetch_data_stage.v
+    scalar_t            ifd_predicted_target;   // From ifetch_data_stage of ifetch_data_stage.v
+    logic               ifd_prefetch_hit;       // From ifetch_data_stage of ifetch_data_stage.v
     logic               ifd_supervisor_fault;   // From ifetch_data_stage of ifetch_data_stage.v
     local_thread_idx_t  ifd_thread_idx;         // From ifetch_data_stage of ifetch_data_stage.v
     logic               ifd_tlb_miss;           // From ifetch_data_stage of ifetch_data_stage.v
     logic               ifd_update_lru_en;      // From ifetch_data_stage of ifetch_data_stage.v
     l1i_way_idx_t       ifd_update_lru_way;     // From ifetch_data_stage of ifetch_data_stage.v
+    logic               ift_branch_predicted;   // From ifetch_tag_stage of ifetch_tag_stage.v
     l1i_way_idx_t       ift_fill_lru;           // From ifetch_tag_stage of ifetch_tag_stage.v
     logic               ift_instruction_requested;// From ifetch_tag_stage of ifetch_tag_stage.v
     l1i_addr_t          ift_pc_paddr;           // From ifetch_tag_stage of ifetch_tag_stage.v
     scalar_t            ift_pc_vaddr;           // From ifetch_tag_stage of ifetch_tag_stage.v
+    scalar_t            ift_predicted_target;   // From ifetch_tag_stage of ifetch_tag_stage.v
+    logic               ift_prefetched [`L1I_WAYS];// From ifetch_tag_stage of ifetch_tag_stage.v
+    l1i_tag_t           ift_snoop_tag [`L1I_WAYS];// From ifetch_tag_stage of ifetch_tag_stage.v
+    logic               ift_snoop_valid [`L1I_WAYS];// From ifetch_tag_stage of ifetch_tag_stage.v
     l1i_tag_t           ift_tag [`L1I_WAYS];    // From ifetch_tag_stage of ifetch_tag_stage.v
     local_thread_idx_t  ift_thread_idx;         // From ifetch_tag_stage of ifetch_tag_stage.v
     logic               ift_tlb_executable;     // From ifetch_tag_stage of ifetch_tag_stage.v
@@ -271,13 +336,22 @@ module core
     logic               ift_tlb_present;        // From ifetch_tag_stage of ifetch_tag_stage.v
     logic               ift_tlb_supervisor;     // From ifetch_tag_stage of ifetch_tag_stage.v
     logic               ift_valid [`L1I_WAYS];  // From ifetch_tag_stage of ifetch_tag_stage.v
+    local_thread_bitmap_t idv_pending;          // From int_divider of int_divider.v
+    vector_t            idv_result;             // From int_divider of int_divider.v
+    logic               idv_result_valid;       // From int_divider of int_divider.v
+    local_thread_bitmap_t idv_wake_bitmap;      // From int_divider of int_divider.v
     local_thread_bitmap_t ior_pending;          // From io_request_queue of io_request_queue.v
     scalar_t            ior_read_value;         // From io_request_queue of io_request_queue.v
     logic               ior_rollback_en;        // From io_request_queue of io_request_queue.v
     local_thread_bitmap_t ior_wake_bitmap;      // From io_request_queue of io_request_queue.v
+    logic               ix_branch_resolved;     // From int_execute_stage of int_execute_stage.v
+    logic               ix_branch_taken;        // From int_execute_stage of int_execute_stage.v
+    logic               ix_divide_en;           // From int_execute_stage of int_execute_stage.v
     decoded_instruction_t ix_instruction;       // From int_execute_stage of int_execute_stage.v
     logic               ix_instruction_valid;   // From int_execute_stage of int_execute_stage.v
     vector_mask_t       ix_mask_value;          // From int_execute_stage of int_execute_stage.v
+    logic               ix_perf_branch_mispredicted;// From int_execute_stage of int_execute_stage.v
+    logic               ix_perf_branch_predicted;// From int_execute_stage of int_execute_stage.v
     logic               ix_perf_cond_branch_not_taken;// From int_execute_stage of int_execute_stage.v
     logic               ix_perf_cond_branch_taken;// From int_execute_stage of int_execute_stage.v
     logic               ix_perf_uncond_branch;  // From int_execute_stage of int_execute_stage.v
@@ -286,29 +360,38 @@ module core
     logic               ix_rollback_en;         // From int_execute_stage of int_execute_stage.v
     scalar_t            ix_rollback_pc;         // From int_execute_stage of int_execute_stage.v
     subcycle_t          ix_subcycle;            // From int_execute_stage of int_execute_stage.v
+    logic               ix_suspend_thread;      // From int_execute_stage of int_execute_stage.v
     local_thread_idx_t  ix_thread_idx;          // From int_execute_stage of int_execute_stage.v
     logic               l2i_dcache_lru_fill_en; // From l1_l2_interface of l1_l2_interface.v
     l1d_set_idx_t       l2i_dcache_lru_fill_set;// From l1_l2_interface of l1_l2_interface.v
+    local_thread_idx_t  l2i_dcache_prefetch_thread_idx;// From l1_l2_interface of l1_l2_interface.v
     local_thread_bitmap_t l2i_dcache_wake_bitmap;// From l1_l2_interface of l1_l2_interface.v
     cache_line_data_t   l2i_ddata_update_data;  // From l1_l2_interface of l1_l2_interface.v
     logic               l2i_ddata_update_en;    // From l1_l2_interface of l1_l2_interface.v
     l1d_set_idx_t       l2i_ddata_update_set;   // From l1_l2_interface of l1_l2_interface.v
     l1d_way_idx_t       l2i_ddata_update_way;   // From l1_l2_interface of l1_l2_interface.v
     logic [`L1D_WAYS-1:0] l2i_dtag_update_en_oh;// From l1_l2_interface of l1_l2_interface.v
+    logic               l2i_dtag_update_prefetched;// From l1_l2_interface of l1_l2_interface.v
     l1d_set_idx_t       l2i_dtag_update_set;    // From l1_l2_interface of l1_l2_interface.v
     l1d_tag_t           l2i_dtag_update_tag;    // From l1_l2_interface of l1_l2_interface.v
     logic               l2i_dtag_update_valid;  // From l1_l2_interface of l1_l2_interface.v
     logic               l2i_icache_lru_fill_en; // From l1_l2_interface of l1_l2_interface.v
     l1i_set_idx_t       l2i_icache_lru_fill_set;// From l1_l2_interface of l1_l2_interface.v
+    local_thread_idx_t  l2i_icache_prefetch_thread_idx;// From l1_l2_interface of l1_l2_interface.v
     local_thread_bitmap_t l2i_icache_wake_bitmap;// From l1_l2_interface of l1_l2_interface.v
     cache_line_data_t   l2i_idata_update_data;  // From l1_l2_interface of l1_l2_interface.v
     logic               l2i_idata_update_en;    // From l1_l2_interface of l1_l2_interface.v
     l1i_set_idx_t       l2i_idata_update_set;   // From l1_l2_interface of l1_l2_interface.v
     l1i_way_idx_t       l2i_idata_update_way;   // From l1_l2_interface of l1_l2_interface.v
+    logic               l2i_isnoop_en;          // From l1_l2_interface of l1_l2_interface.v
+    l1i_set_idx_t       l2i_isnoop_set;         // From l1_l2_interface of l1_l2_interface.v
     logic [`L1I_WAYS-1:0] l2i_itag_update_en;   // From l1_l2_interface of l1_l2_interface.v
+    logic               l2i_itag_update_prefetched;// From l1_l2_interface of l1_l2_interface.v
     l1i_set_idx_t       l2i_itag_update_set;    // From l1_l2_interface of l1_l2_interface.v
     l1i_tag_t           l2i_itag_update_tag;    // From l1_l2_interface of l1_l2_interface.v
     logic               l2i_itag_update_valid;  // From l1_l2_interface of l1_l2_interface.v
+    logic               l2i_perf_dcache_prefetch;// From l1_l2_interface of l1_l2_interface.v
+    logic               l2i_perf_icache_prefetch;// From l1_l2_interface of l1_l2_interface.v
     logic               l2i_perf_store;         // From l1_l2_interface of l1_l2_interface.v
     logic               l2i_snoop_en;           // From l1_l2_interface of l1_l2_interface.v
     l1d_set_idx_t       l2i_snoop_set;          // From l1_l2_interface of l1_l2_interface.v
@@ -317,10 +400,12 @@ module core
     vector_mask_t       of_mask_value;          // From operand_fetch_stage of operand_fetch_stage.v
     vector_t            of_operand1;            // From operand_fetch_stage of operand_fetch_stage.v
     vector_t            of_operand2;            // From operand_fetch_stage of operand_fetch_stage.v
+    vector_t            of_operand3;            // From operand_fetch_stage of operand_fetch_stage.v
     vector_t            of_store_value;         // From operand_fetch_stage of operand_fetch_stage.v
     subcycle_t          of_subcycle;            // From operand_fetch_stage of operand_fetch_stage.v
     local_thread_idx_t  of_thread_idx;          // From operand_fetch_stage of operand_fetch_stage.v
-    logic [1:0] [63:0]  perf_event_count;       // From performance_counters of performance_counters.v
+    logic [NUM_PERF_COUNTERS-1:0] [63:0] perf_event_count;// From performance_counters of performance_counters.v
+    logic [NUM_PERF_COUNTERS-1:0] perf_event_overflow;// From performance_counters of performance_counters.v
     logic               sq_rollback_en;         // From l1_l2_interface of l1_l2_interface.v
     cache_line_data_t   sq_store_bypass_data;   // From l1_l2_interface of l1_l2_interface.v
     logic [CACHE_LINE_BYTES-1:0] sq_store_bypass_mask;// From l1_l2_interface of l1_l2_interface.v
@@ -369,6 +454,7 @@ module core
     dcache_data_stage dcache_data_stage(.*);
     dcache_tag_stage dcache_tag_stage(.*);
     int_execute_stage int_execute_stage(.*);
+    int_divider int_divider(.*);
     fp_execute_stage1 fp_execute_stage1(.*);
     fp_execute_stage2 fp_execute_stage2(.*);
     fp_execute_stage3 fp_execute_stage3(.*);
@@ -379,13 +465,9 @@ module core
     control_registers #(
         .CORE_ID(CORE_ID),
         .NUM_INTERRUPTS(NUM_INTERRUPTS),
-        .NUM_PERF_EVENTS(CORE_PERF_EVENTS)
-    ) control_registers(
-        .cr_perf_event_select0(perf_event_select[0]),
-        .cr_perf_event_select1(perf_event_select[1]),
-        .perf_event_count0(perf_event_count[0]),
-        .perf_event_count1(perf_event_count[1]),
-        .*);
+        .NUM_PERF_EVENTS(TOTAL_PERF_EVENTS),
+        .NUM_PERF_COUNTERS(NUM_PERF_COUNTERS)
+    ) control_registers(.*);
 
     l1_l2_interface #(.CORE_ID(CORE_ID)) l1_l2_interface(.*);
     io_request_queue #(.CORE_ID(CORE_ID)) io_request_queue(.*);
@@ -401,6 +483,12 @@ module core
     // The number of signals in this assignment must match CORE_PERF_EVENTS
     // in defines.sv.
     assign perf_events = {
+        ix_perf_branch_mispredicted,
+        ix_perf_branch_predicted,
+        ifd_perf_icache_prefetch_hit,
+        l2i_perf_icache_prefetch,
+        dd_perf_dcache_prefetch_hit,
+        l2i_perf_dcache_prefetch,
         ix_perf_cond_branch_not_taken,
         ix_perf_cond_branch_taken,
         ix_perf_uncond_branch,
@@ -417,9 +505,43 @@ module core
         wb_perf_interrupt
     };
 
+    // Thread that caused each of the events above, used to filter counts
+    // by thread. This must be in the same order as perf_events. A store
+    // request is always for the thread that issued it (the store queue has
+    // one entry per thread). A prefetch is counted for the thread whose
+    // fetch or load triggered it.
+    assign perf_event_thread = {
+        ix_thread_idx,
+        ix_thread_idx,
+        ifd_thread_idx,
+        l2i_icache_prefetch_thread_idx,
+        dd_thread_idx,
+        l2i_dcache_prefetch_thread_idx,
+        ix_thread_idx,
+        ix_thread_idx,
+        ix_thread_idx,
+        dd_thread_idx,
+        dd_thread_idx,
+        dd_thread_idx,
+        ifd_thread_idx,
+        ifd_thread_idx,
+        ifd_thread_idx,
+        ts_thread_idx,
+        wb_writeback_thread_idx,
+        local_thread_idx_t'(l2i_request.id),
+        wb_writeback_thread_idx,
+        wb_writeback_thread_idx
+    };
+
+    // The L2 events follow the core events in the event select, grouped by
+    // bank (L2_PERF_EVENTS per bank, starting with bank 0). They are
+    // shared by all cores and not caused by a thread in this one, so they
+    // have no entry in perf_event_thread.
     performance_counters #(
-        .NUM_EVENTS(CORE_PERF_EVENTS),
-        .NUM_COUNTERS(2)
+        .NUM_EVENTS(TOTAL_PERF_EVENTS),
+        .NUM_THREAD_EVENTS(CORE_PERF_EVENTS),
+        .NUM_COUNTERS(NUM_PERF_COUNTERS)
     ) performance_counters(
+        .perf_events({l2_perf_events, perf_events}),
         .*);
 endmodule
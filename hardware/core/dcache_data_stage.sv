@@ -24,6 +24,15 @@ import defines::*;
 //   stage.
 // - Reads from cache data storage.
 // - Drives signals to previous stage to update LRU
+// - Signals dcache_prefetcher when a load misses or hits a prefetched line.
+// - For scatter/gather accesses, services all lanes that dcache_tag_stage
+//   coalesced into this subcycle (dt_scgath_lane_mask) with one cache access.
+// - Reads and writes the core's scratchpad memory. This is a cache line wide
+//   SRAM mapped at SCRATCHPAD_BASE in the physical address space. Accesses to
+//   it don't go through the cache or store queue, so they never miss or
+//   roll back. Each core has its own, and other cores and the L2 cache can't
+//   see it. Synchronized loads and stores act like normal ones (stores always
+//   succeed), and cache control operations on it do nothing.
 //
 
 module dcache_data_stage(
@@ -48,10 +57,16 @@ module dcache_data_stage(
     input subcycle_t                          dt_subcycle,
     input                                     dt_valid[`L1D_WAYS],
     input l1d_tag_t                           dt_tag[`L1D_WAYS],
+    input                                     dt_prefetched[`L1D_WAYS],
+    input vector_mask_t                       dt_scgath_lane_mask,
+    input scgath_word_idx_t                   dt_scgath_word_idx,
+    input                                     dt_scgath_covered,
+    input                                     dt_scgath_run_done,
 
     // To dcache_tag_stage
     output logic                              dd_update_lru_en,
     output l1d_way_idx_t                      dd_update_lru_way,
+    output logic                              dd_prefetch_hit,
 
     // To io_request_queue
     output logic                              dd_io_write_en,
@@ -67,11 +82,15 @@ module dcache_data_stage(
     output local_thread_idx_t                 dd_thread_idx,
     output l1d_addr_t                         dd_request_vaddr,
     output subcycle_t                         dd_subcycle,
+    output scgath_word_idx_t                  dd_scgath_word_idx,
+    output logic                              dd_scgath_covered,
+    output logic                              dd_scgath_run_done,
     output logic                              dd_rollback_en,
     output scalar_t                           dd_rollback_pc,
     output cache_line_data_t                  dd_load_data,
     output logic                              dd_suspend_thread,
     output logic                              dd_io_access,
+    output logic                              dd_scratchpad_access,
     output logic                              dd_trap,
     output trap_cause_t                       dd_trap_cause,
 
@@ -99,6 +118,7 @@ module dcache_data_stage(
     output cache_line_index_t                 dd_cache_miss_addr,
     output local_thread_idx_t                 dd_cache_miss_thread_idx,
     output logic                              dd_cache_miss_sync,
+    output scalar_t                           dd_cache_miss_pc,
     output logic                              dd_store_en,
     output logic                              dd_flush_en,
     output logic                              dd_membar_en,
@@ -111,6 +131,8 @@ module dcache_data_stage(
     output logic                              dd_store_sync,
     output cache_line_index_t                 dd_store_bypass_addr,
     output local_thread_idx_t                 dd_store_bypass_thread_idx,
+    output logic                              dd_wait_en,
+    output local_thread_idx_t                 dd_wait_thread_idx,
 
     // From writeback_stage
     input logic                               wb_rollback_en,
@@ -120,14 +142,22 @@ module dcache_data_stage(
     // To performance_counters
     output logic                              dd_perf_dcache_hit,
     output logic                              dd_perf_dcache_miss,
-    output logic                              dd_perf_dtlb_miss);
+    output logic                              dd_perf_dtlb_miss,
+    output logic                              dd_perf_dcache_prefetch_hit);
 
     logic memory_access_req;
     logic cached_access_req;
     logic cached_load_req;
     logic cached_store_req;
     logic creg_access_req;
+    logic wait_req;
     logic io_access_req;
+    logic scratchpad_access_req;
+    logic scratchpad_load_en;
+    logic scratchpad_store_en;
+    logic scratchpad_load_latched;
+    cache_line_data_t l1d_load_data;
+    cache_line_data_t scratchpad_load_data;
     logic sync_access_req;
     logic cache_control_req;
     logic tlb_update_req;
@@ -136,6 +166,7 @@ module dcache_data_stage(
     logic dinvalidate_req;
     logic membar_req;
     logic addr_in_io_region;
+    logic addr_in_scratchpad_region;
     logic unaligned_address;
     logic supervisor_fault;
     logic alignment_fault;
@@ -148,7 +179,9 @@ module dcache_data_stage(
     logic[3:0] byte_store_mask;
     logic[$clog2(CACHE_LINE_WORDS) - 1:0] cache_lane_idx;
     cache_line_data_t endian_twiddled_data;
-    scalar_t lane_store_value;
+    vector_t store_vector;
+    vector_t scgath_store_value;
+    logic[CACHE_LINE_WORDS - 1:0] scgath_word_mask;
     logic[CACHE_LINE_WORDS - 1:0] cache_lane_mask;
     logic[CACHE_LINE_WORDS - 1:0] subcycle_mask;
     logic[`L1D_WAYS - 1:0] way_hit_oh;
@@ -157,7 +190,7 @@ module dcache_data_stage(
     scalar_t dcache_request_addr;
     logic squash_instruction;
     logic cache_near_miss;
-    logic[$clog2(NUM_VECTOR_LANES) - 1:0] scgath_lane;
+    logic scgath_access;
     logic tlb_read;
     logic fault_store_flag;
     logic lane_enabled;
@@ -170,11 +203,14 @@ module dcache_data_stage(
     assign squash_instruction = wb_rollback_en
         && wb_rollback_thread_idx == dt_thread_idx
         && wb_rollback_pipeline == PIPE_MEM;
-    assign scgath_lane = ~dt_subcycle;
+    assign scgath_access = dt_instruction.memory_access
+        && (dt_instruction.memory_access_type == MEM_SCGATH
+        || dt_instruction.memory_access_type == MEM_SCGATH_M);
 
     // If a scatter/gather is active, need to check if the lane is active.
     // This is more than an optimization: if the lane is masked, we need to
-    // ignore the pointer to not raise a fault if it is invalid.
+    // ignore the pointer to not raise a fault if it is invalid. The lane
+    // mask is also clear if an earlier subcycle covered this one.
     idx_to_oh #(
         .NUM_SIGNALS(CACHE_LINE_WORDS),
         .DIRECTION("LSB0")
@@ -182,14 +218,15 @@ module dcache_data_stage(
         .one_hot(subcycle_mask),
         .index(dt_subcycle));
 
-    assign lane_enabled = !dt_instruction.memory_access
-        || dt_instruction.memory_access_type != MEM_SCGATH_M
-        || (dt_mask_value & subcycle_mask) != 0;
+    assign lane_enabled = !scgath_access
+        || (dt_scgath_lane_mask & subcycle_mask) != 0;
 
     // Decode request type. If this instruction is squashed, ignore (same as
     // dt_instruction_valid being false). These do not consider if the
     // request is legal or possible, just what the instruction is asking to do.
     assign addr_in_io_region = dt_request_paddr ==? 32'hffff????;
+    assign addr_in_scratchpad_region = `SCRATCHPAD_LINES != 0
+        && dt_request_paddr[31:16] == SCRATCHPAD_BASE[31:16];
     assign sync_access_req = dt_instruction.memory_access_type == MEM_SYNC;
 
     // Note the last part that checks the store mask. If the store mask is zero
@@ -201,7 +238,9 @@ module dcache_data_stage(
         && dt_instruction.memory_access_type != MEM_CONTROL_REG
         && lane_enabled;
     assign io_access_req = memory_access_req && addr_in_io_region;
-    assign cached_access_req = memory_access_req && !addr_in_io_region;
+    assign scratchpad_access_req = memory_access_req && addr_in_scratchpad_region;
+    assign cached_access_req = memory_access_req && !addr_in_io_region
+        && !addr_in_scratchpad_region;
     assign cached_load_req = cached_access_req && dt_instruction.load;
     assign cached_store_req = cached_access_req && !dt_instruction.load;
     assign cache_control_req = dt_instruction_valid
@@ -209,13 +248,16 @@ module dcache_data_stage(
         && dt_instruction.cache_control;
     assign flush_req = cache_control_req
         && dt_instruction.cache_control_op == CACHE_DFLUSH
-        && !addr_in_io_region;
+        && !addr_in_io_region
+        && !addr_in_scratchpad_region;
     assign iinvalidate_req = cache_control_req
         && dt_instruction.cache_control_op == CACHE_IINVALIDATE
-        && !addr_in_io_region;
+        && !addr_in_io_region
+        && !addr_in_scratchpad_region;
     assign dinvalidate_req = cache_control_req
         && dt_instruction.cache_control_op == CACHE_DINVALIDATE
-        && !addr_in_io_region;
+        && !addr_in_io_region
+        && !addr_in_scratchpad_region;
     assign membar_req = cache_control_req
         && dt_instruction.cache_control_op == CACHE_MEMBAR;
     assign tlb_update_req = cache_control_req
@@ -228,6 +270,12 @@ module dcache_data_stage(
         && dt_instruction.memory_access
         && dt_instruction.memory_access_type == MEM_CONTROL_REG;
 
+    // Writing CR_WAIT_FOR_WRITE suspends the thread until l1_wait_monitor
+    // wakes it. Unlike other control registers, user mode code may write it.
+    assign wait_req = creg_access_req
+        && !dt_instruction.load
+        && dt_instruction.creg_index == CR_WAIT_FOR_WRITE;
+
     // Determine if this instruction accessed the TLB (and thus possibly
     // missed it)
     always_comb
@@ -265,8 +313,10 @@ module dcache_data_stage(
         endcase
     end
 
-    assign alignment_fault = (cached_access_req || io_access_req) && unaligned_address;
-    assign privileged_op_fault = (creg_access_req || tlb_update_req || dinvalidate_req)
+    assign alignment_fault = (cached_access_req || io_access_req || scratchpad_access_req)
+        && unaligned_address;
+    assign privileged_op_fault = ((creg_access_req && !wait_req) || tlb_update_req
+        || dinvalidate_req)
         && !cr_supervisor_en[dt_thread_idx];
     assign page_fault = memory_access_req
         && dt_tlb_hit
@@ -276,7 +326,8 @@ module dcache_data_stage(
         && dt_tlb_present
         && dt_tlb_supervisor
         && !cr_supervisor_en[dt_thread_idx];
-    assign write_fault = (cached_store_req || (io_access_req && !dt_instruction.load))
+    assign write_fault = (cached_store_req
+        || ((io_access_req || scratchpad_access_req) && !dt_instruction.load))
         && dt_tlb_hit
         && dt_tlb_present
         && !supervisor_fault
@@ -313,6 +364,16 @@ module dcache_data_stage(
     assign dd_io_thread_idx = dt_thread_idx;
     assign dd_io_addr = {16'd0, dt_request_paddr[15:0]};
 
+    // Scratchpad access
+    assign scratchpad_load_en = scratchpad_access_req
+        && dt_instruction.load
+        && !tlb_miss
+        && !any_fault;
+    assign scratchpad_store_en = scratchpad_access_req
+        && !dt_instruction.load
+        && !tlb_miss
+        && !any_fault;
+
     // Control register access
     assign dd_creg_write_en = creg_access_req
         && !dt_instruction.load
@@ -322,6 +383,8 @@ module dcache_data_stage(
         && !any_fault;
     assign dd_creg_write_val = dt_store_value[0];
     assign dd_creg_index = dt_instruction.creg_index;
+    assign dd_wait_en = wait_req && !any_fault;
+    assign dd_wait_thread_idx = dt_thread_idx;
 
     // Cache control
     // Unlike other operations, these check dt_tlb_present, as these will not raise
@@ -380,32 +443,45 @@ module dcache_data_stage(
                 word_store_mask = dt_mask_value;
 
             MEM_SCGATH, MEM_SCGATH_M:    // Scatter/Gather access
-            begin
-                if ((dt_mask_value & subcycle_mask) != 0)
-                    word_store_mask = cache_lane_mask;
-                else
-                    word_store_mask = 0;
-            end
+                word_store_mask = scgath_word_mask;
 
             default:    // Scalar access
                 word_store_mask = cache_lane_mask;
         endcase
     end
 
+    // Move the store values for coalesced scatter lanes to the words in the
+    // cache line they write, using the same layout as a block store. If more
+    // than one lane writes the same word, the last one wins, as it would if
+    // they were stored in separate subcycles.
+    always_comb
+    begin
+        scgath_word_mask = '0;
+        scgath_store_value = '0;
+        for (int sc = 0; sc < NUM_VECTOR_LANES; sc++)
+        begin
+            if (dt_scgath_lane_mask[sc])
+            begin
+                scgath_word_mask[dt_scgath_word_idx[sc]] = 1;
+                scgath_store_value[~dt_scgath_word_idx[sc]] = dt_store_value[~subcycle_t'(sc)];
+            end
+        end
+    end
+
+    assign store_vector = scgath_access ? scgath_store_value : dt_store_value;
+
     // Endian swap vector data
     genvar swap_word;
     generate
         for (swap_word = 0; swap_word < CACHE_LINE_BYTES / 4; swap_word++)
         begin : swap_word_gen
-            assign endian_twiddled_data[swap_word * 32+:8] = dt_store_value[swap_word][24+:8];
-            assign endian_twiddled_data[swap_word * 32 + 8+:8] = dt_store_value[swap_word][16+:8];
-            assign endian_twiddled_data[swap_word * 32 + 16+:8] = dt_store_value[swap_word][8+:8];
-            assign endian_twiddled_data[swap_word * 32 + 24+:8] = dt_store_value[swap_word][0+:8];
+            assign endian_twiddled_data[swap_word * 32+:8] = store_vector[swap_word][24+:8];
+            assign endian_twiddled_data[swap_word * 32 + 8+:8] = store_vector[swap_word][16+:8];
+            assign endian_twiddled_data[swap_word * 32 + 16+:8] = store_vector[swap_word][8+:8];
+            assign endian_twiddled_data[swap_word * 32 + 24+:8] = store_vector[swap_word][0+:8];
         end
     endgenerate
 
-    assign lane_store_value = dt_store_value[scgath_lane];
-
     // byte_store_mask and dd_store_data.
     always_comb
     begin
@@ -438,13 +514,6 @@ module dcache_data_stage(
                     dt_store_value[0][23:16], dt_store_value[0][31:24]}};
             end
 
-            MEM_SCGATH, MEM_SCGATH_M:
-            begin
-                byte_store_mask = 4'b1111;
-                dd_store_data = {CACHE_LINE_WORDS{lane_store_value[7:0], lane_store_value[15:8],
-                    lane_store_value[23:16], lane_store_value[31:24]}};
-            end
-
             default: // Vector
             begin
                 byte_store_mask = 4'b1111;
@@ -480,7 +549,7 @@ module dcache_data_stage(
         // Instruction pipeline access.
         .read_en(cache_hit && cached_load_req),
         .read_addr({way_hit_idx, dt_request_paddr.set_idx}),
-        .read_data(dd_load_data),
+        .read_data(l1d_load_data),
 
         // Update from L2 cache interface
         .write_en(l2i_ddata_update_en),
@@ -488,6 +557,43 @@ module dcache_data_stage(
         .write_data(l2i_ddata_update_data),
         .*);
 
+    // The scratchpad uses the same store mask and data as the cache, but
+    // writes them directly. Each byte lane is a separate SRAM so stores
+    // can update only some bytes of the line. Addresses past the end of the
+    // scratchpad wrap around.
+    generate
+        if (`SCRATCHPAD_LINES != 0)
+        begin : scratchpad_gen
+            localparam SCRATCHPAD_IDX_WIDTH = $clog2(`SCRATCHPAD_LINES);
+
+            logic[SCRATCHPAD_IDX_WIDTH - 1:0] line_idx;
+
+            assign line_idx = dt_request_paddr[CACHE_LINE_OFFSET_WIDTH+:SCRATCHPAD_IDX_WIDTH];
+
+            for (genvar byte_idx = 0; byte_idx < CACHE_LINE_BYTES; byte_idx++)
+            begin : byte_gen
+                sram_1r1w #(
+                    .DATA_WIDTH(8),
+                    .SIZE(`SCRATCHPAD_LINES),
+                    .READ_DURING_WRITE("NEW_DATA")
+                ) scratchpad_data(
+                    .read_en(scratchpad_load_en),
+                    .read_addr(line_idx),
+                    .read_data(scratchpad_load_data[byte_idx * 8+:8]),
+                    .write_en(scratchpad_store_en && dd_store_mask[byte_idx]),
+                    .write_addr(line_idx),
+                    .write_data(dd_store_data[byte_idx * 8+:8]),
+                    .*);
+            end
+        end
+        else
+        begin : no_scratchpad_gen
+            assign scratchpad_load_data = '0;
+        end
+    endgenerate
+
+    assign dd_load_data = scratchpad_load_latched ? scratchpad_load_data : l1d_load_data;
+
     // cache_near_miss indicates a cache miss is occurring in the cycle this is
     // filling the same line. If this suspends the thread, it will never
     // receive a wakeup. Instead, roll the thread back and let it retry.
@@ -510,10 +616,19 @@ module dcache_data_stage(
     assign dd_cache_miss_addr = dcache_request_addr[31:CACHE_LINE_OFFSET_WIDTH];
     assign dd_cache_miss_thread_idx = dt_thread_idx;
     assign dd_cache_miss_sync = sync_access_req;
+    assign dd_cache_miss_pc = dt_instruction.pc;
 
     assign dd_update_lru_en = cache_hit && cached_access_req && !any_fault;
     assign dd_update_lru_way = way_hit_idx;
 
+    // The first load to hit a line that was prefetched. dcache_tag_stage
+    // clears the prefetched flag for the line (in way dd_update_lru_way).
+    assign dd_prefetch_hit = cache_hit
+        && cached_load_req
+        && !sync_access_req
+        && !any_fault
+        && dt_prefetched[way_hit_idx];
+
     // Always treat the first synchronized load as a cache miss, even if data is
     // present. This is to register request with L2 cache. The second request will
     // not be a miss if the data is in the cache (there is a window where it could
@@ -545,12 +660,18 @@ module dcache_data_stage(
     always_ff @(posedge clk)
     begin
         dd_instruction <= dt_instruction;
-        dd_lane_mask <= dt_mask_value;
+        dd_lane_mask <= scgath_access ? dt_scgath_lane_mask : dt_mask_value;
         dd_thread_idx <= dt_thread_idx;
         dd_request_vaddr <= dt_request_vaddr;
         dd_subcycle <= dt_subcycle;
-        dd_rollback_pc <= dt_instruction.pc;
+        dd_scgath_word_idx <= dt_scgath_word_idx;
+        dd_scgath_covered <= dt_scgath_covered;
+        dd_scgath_run_done <= dt_scgath_run_done;
+        // A wait resumes at the next instruction when the thread wakes.
+        dd_rollback_pc <= wait_req ? dt_instruction.pc + 4 : dt_instruction.pc;
         dd_io_access <= io_access_req;
+        dd_scratchpad_access <= scratchpad_access_req;
+        scratchpad_load_latched <= scratchpad_load_en;
 
         // Check for TLB miss first, since permission bits are not valid if
         // there is a TLB miss. The order of the remaining items should match
@@ -578,6 +699,7 @@ module dcache_data_stage(
             dd_instruction_valid <= '0;
             dd_perf_dcache_hit <= '0;
             dd_perf_dcache_miss <= '0;
+            dd_perf_dcache_prefetch_hit <= '0;
             dd_perf_dtlb_miss <= '0;
             dd_rollback_en <= '0;
             dd_suspend_thread <= '0;
@@ -591,22 +713,24 @@ module dcache_data_stage(
 
             // Make sure this decodes only one type of instruction
             assert($onehot0({cached_load_req, cached_store_req, io_access_req,
-                flush_req, iinvalidate_req, dinvalidate_req,
+                scratchpad_access_req, flush_req, iinvalidate_req, dinvalidate_req,
                 membar_req, tlb_update_req, creg_access_req}));
 
             dd_instruction_valid <= dt_instruction_valid
                 && !squash_instruction;
 
-            // Rollback on cache miss
-            dd_rollback_en <= cached_load_req && !cache_hit && dt_tlb_hit && !any_fault;
+            // Rollback on cache miss or wait
+            dd_rollback_en <= (cached_load_req && !cache_hit && dt_tlb_hit && !any_fault)
+                || dd_wait_en;
 
-            // Suspend the thread if there is a cache miss.
+            // Suspend the thread if there is a cache miss or wait.
             // In the near miss case (described above), don't suspend thread.
-            dd_suspend_thread <= cached_load_req
+            dd_suspend_thread <= (cached_load_req
                 && dt_tlb_hit
                 && !cache_hit
                 && !cache_near_miss
-                && !any_fault;
+                && !any_fault)
+                || dd_wait_en;
 
             dd_trap <= any_fault || tlb_miss;
 
@@ -616,6 +740,7 @@ module dcache_data_stage(
             dd_perf_dcache_miss <= cached_load_req && !any_fault && !tlb_miss
                 && !cache_hit;
             dd_perf_dtlb_miss <= tlb_miss;
+            dd_perf_dcache_prefetch_hit <= dd_prefetch_hit;
         end
     end
 endmodule
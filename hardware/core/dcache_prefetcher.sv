@@ -0,0 +1,132 @@
+//
+// Copyright 2018 Jeff Bush
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+`include "defines.svh"
+
+import defines::*;
+
+//
+// L1 data cache stride prefetcher.
+// Each thread has STREAMS_PER_THREAD stream entries, selected by the
+// low bits of the PC of the load instruction and tagged with the full PC,
+// so a loop that walks several arrays can train on each independently.
+//
+// dcache_data_stage signals a trigger when a load misses the cache, or when
+// it hits a line that a prefetch brought in (which keeps a stream that is
+// being prefetched successfully running ahead). If the distance between
+// this line and the previous trigger for the same stream is the same as the
+// stride previously observed, this requests the line that is the
+// configured number of strides ahead. Addresses are physical, so prefetches
+// don't cross page boundaries.
+//
+// This holds one request until l1_load_miss_queue accepts it. A new
+// prefetch replaces one that hasn't been accepted yet.
+//
+
+module dcache_prefetcher(
+    input                               clk,
+    input                               reset,
+
+    // From control_registers
+    input prefetch_control_t            cr_prefetch_control,
+
+    // From dcache_data_stage
+    input                               dd_cache_miss,
+    input cache_line_index_t            dd_cache_miss_addr,
+    input local_thread_idx_t            dd_cache_miss_thread_idx,
+    input                               dd_cache_miss_sync,
+    input scalar_t                      dd_cache_miss_pc,
+    input                               dd_prefetch_hit,
+
+    // To/from l1_load_miss_queue
+    output logic                        dpf_request_valid,
+    output cache_line_index_t           dpf_request_addr,
+    output local_thread_idx_t           dpf_request_thread_idx,
+    input                               dpf_request_ack);
+
+    localparam STREAMS_PER_THREAD = 2;
+    localparam NUM_STREAMS = `THREADS_PER_CORE * STREAMS_PER_THREAD;
+    localparam STREAM_IDX_WIDTH = $clog2(NUM_STREAMS);
+    localparam LINES_PER_PAGE_WIDTH = $clog2(PAGE_SIZE / CACHE_LINE_BYTES);
+
+    typedef struct packed {
+        logic valid;
+        scalar_t pc;
+        cache_line_index_t last_line;
+        cache_line_index_t stride;
+    } stream_t;
+
+    stream_t streams[NUM_STREAMS];
+    logic[STREAM_IDX_WIDTH - 1:0] stream_idx;
+    logic trigger;
+    logic stream_match;
+    cache_line_index_t new_stride;
+    cache_line_index_t prefetch_line;
+    logic stream_confirmed;
+    logic same_page;
+
+    assign trigger = cr_prefetch_control.dcache_en
+        && ((dd_cache_miss && !dd_cache_miss_sync) || dd_prefetch_hit);
+    assign stream_idx = {dd_cache_miss_thread_idx,
+        dd_cache_miss_pc[2+:$clog2(STREAMS_PER_THREAD)]};
+    assign stream_match = streams[stream_idx].valid
+        && streams[stream_idx].pc == dd_cache_miss_pc;
+    assign new_stride = dd_cache_miss_addr - streams[stream_idx].last_line;
+    assign stream_confirmed = stream_match && new_stride == streams[stream_idx].stride
+        && new_stride != 0;
+    assign prefetch_line = dd_cache_miss_addr
+        + new_stride * cache_line_index_t'(cr_prefetch_control.dcache_distance);
+    assign same_page = prefetch_line[$bits(cache_line_index_t) - 1:LINES_PER_PAGE_WIDTH]
+        == dd_cache_miss_addr[$bits(cache_line_index_t) - 1:LINES_PER_PAGE_WIDTH];
+
+    always_ff @(posedge clk, posedge reset)
+    begin
+        if (reset)
+        begin
+            for (int i = 0; i < NUM_STREAMS; i++)
+                streams[i] <= '0;
+
+            /*AUTORESET*/
+            // Beginning of autoreset for uninitialized flops
+            dpf_request_addr <= '0;
+            dpf_request_thread_idx <= '0;
+            dpf_request_valid <= '0;
+            // End of automatics
+        end
+        else
+        begin
+            // Multiple lanes of a gather load may access the same line.
+            // Ignore the repeats so they don't reset the stride.
+            if (trigger && (!stream_match || new_stride != 0))
+            begin
+                streams[stream_idx].valid <= 1;
+                streams[stream_idx].pc <= dd_cache_miss_pc;
+                streams[stream_idx].last_line <= dd_cache_miss_addr;
+                streams[stream_idx].stride <= stream_match ? new_stride : '0;
+            end
+
+            if (trigger && stream_confirmed && same_page
+                && cr_prefetch_control.dcache_distance != 0)
+            begin
+                dpf_request_valid <= 1;
+                dpf_request_addr <= prefetch_line;
+                dpf_request_thread_idx <= dd_cache_miss_thread_idx;
+            end
+            else if (dpf_request_ack)
+                dpf_request_valid <= 0;
+        end
+    end
+endmodule
@@ -36,6 +36,17 @@ import defines::*;
 // be the same size or smaller than a virtual page
 // (cache line size * num sets <= page_size).
 //
+// Scatter/gather instructions issue one subcycle per lane, but this coalesces
+// lanes that access the same cache line. When a subcycle arrives, it checks
+// the addresses of the lanes for the following subcycles. The run of
+// subcycles whose lanes are in the same line as this one (or are masked off)
+// is serviced by this pass. This tells thread_select_stage to skip to the
+// first subcycle after the run. Subcycles in the run that were issued before
+// thread_select_stage got that are marked as covered and do nothing.
+// Lanes in the same line are in the same page, so the translation for this
+// lane is valid for all of them. A lane with an unaligned address ends
+// the run, so it faults in its own subcycle.
+//
 
 module dcache_tag_stage
     (input                                      clk,
@@ -53,6 +64,7 @@ module dcache_tag_stage
     // From dcache_data_stage
     input                                       dd_update_lru_en,
     input l1d_way_idx_t                         dd_update_lru_way,
+    input                                       dd_prefetch_hit,
 
     // To dcache_data_stage
     output logic                                dt_instruction_valid,
@@ -67,8 +79,20 @@ module dcache_tag_stage
     output subcycle_t                           dt_subcycle,
     output logic                                dt_valid[`L1D_WAYS],
     output l1d_tag_t                            dt_tag[`L1D_WAYS],
+    output logic                                dt_prefetched[`L1D_WAYS],
     output logic                                dt_tlb_supervisor,
     output logic                                dt_tlb_present,
+    output vector_mask_t                        dt_scgath_lane_mask,
+    output scgath_word_idx_t                    dt_scgath_word_idx,
+    output logic                                dt_scgath_covered,
+    output logic                                dt_scgath_run_done,
+
+    // To thread_select_stage
+    output logic                                dt_scgath_advance_en,
+    output local_thread_idx_t                   dt_scgath_advance_thread_idx,
+    output subcycle_t                           dt_scgath_advance_from,
+    output subcycle_t                           dt_scgath_advance_to,
+    output logic                                dt_scgath_advance_done,
 
     // To ifetch_tag_stage
     output logic                                dt_invalidate_tlb_en,
@@ -80,6 +104,7 @@ module dcache_tag_stage
     output logic                                dt_update_itlb_present,
     output logic                                dt_update_itlb_supervisor,
     output logic                                dt_update_itlb_global,
+    output logic                                dt_update_itlb_superpage,
     output logic                                dt_update_itlb_executable,
 
     // From l1_l2_interface
@@ -89,6 +114,7 @@ module dcache_tag_stage
     input l1d_set_idx_t                         l2i_dtag_update_set,
     input l1d_tag_t                             l2i_dtag_update_tag,
     input                                       l2i_dtag_update_valid,
+    input                                       l2i_dtag_update_prefetched,
     input                                       l2i_snoop_en,
     input l1d_set_idx_t                         l2i_snoop_set,
 
@@ -121,6 +147,15 @@ module dcache_tag_stage
     logic tlb_present;
     logic tlb_supervisor;
     tlb_entry_t new_tlb_value;
+    logic scgath_req;
+    scalar_t scgath_addr[NUM_VECTOR_LANES];
+    logic[NUM_VECTOR_LANES - 1:0] scgath_coalesce;
+    vector_mask_t scgath_follow;
+    vector_mask_t scgath_covered_lanes[`THREADS_PER_CORE];
+    subcycle_t scgath_run_end;
+    logic scgath_in_run;
+    logic scgath_covered;
+    logic scgath_leader;
 
     assign instruction_valid = of_instruction_valid
         && (!wb_rollback_en || wb_rollback_thread_idx != of_thread_idx)
@@ -148,6 +183,7 @@ module dcache_tag_stage
         && cr_supervisor_en[of_thread_idx];
     assign dt_update_itlb_supervisor = new_tlb_value.supervisor;
     assign dt_update_itlb_global = new_tlb_value.global_map;
+    assign dt_update_itlb_superpage = new_tlb_value.superpage;
     assign dt_update_itlb_present = new_tlb_value.present;
     assign tlb_lookup_en = instruction_valid
         && of_instruction.memory_access_type != MEM_CONTROL_REG
@@ -159,6 +195,59 @@ module dcache_tag_stage
     assign dt_update_itlb_executable = new_tlb_value.executable;
     assign dt_update_itlb_asid = cr_current_asid[of_thread_idx];
 
+    //
+    // Scatter/gather lane coalescing
+    //
+    assign scgath_req = instruction_valid
+        && of_instruction.memory_access
+        && (of_instruction.memory_access_type == MEM_SCGATH
+        || of_instruction.memory_access_type == MEM_SCGATH_M);
+
+    // These are indexed by subcycle. A lane can be serviced with this one
+    // if it is masked off, or if it is an aligned address in the same cache
+    // line (and this lane is enabled).
+    genvar lane_idx;
+    generate
+        for (lane_idx = 0; lane_idx < NUM_VECTOR_LANES; lane_idx++)
+        begin : scgath_lane_gen
+            assign scgath_addr[lane_idx] = of_operand1[NUM_VECTOR_LANES - lane_idx - 1]
+                + of_instruction.immediate_value;
+            assign scgath_coalesce[lane_idx] = !of_mask_value[lane_idx]
+                || (of_mask_value[of_subcycle]
+                && scgath_addr[lane_idx][1:0] == 0
+                && scgath_addr[lane_idx][31:CACHE_LINE_OFFSET_WIDTH]
+                == request_addr_nxt[31:CACHE_LINE_OFFSET_WIDTH]);
+        end
+    endgenerate
+
+    always_comb
+    begin
+        scgath_follow = '0;
+        scgath_run_end = of_subcycle;
+        scgath_in_run = 1;
+        for (int sc = 0; sc < NUM_VECTOR_LANES; sc++)
+        begin
+            if (subcycle_t'(sc) > of_subcycle)
+            begin
+                scgath_in_run = scgath_in_run && scgath_coalesce[sc];
+                if (scgath_in_run)
+                begin
+                    scgath_follow[sc] = 1;
+                    scgath_run_end = subcycle_t'(sc);
+                end
+            end
+        end
+    end
+
+    assign scgath_covered = scgath_req
+        && scgath_covered_lanes[of_thread_idx][of_subcycle];
+    assign scgath_leader = scgath_req && !scgath_covered;
+    assign dt_scgath_advance_en = scgath_leader && scgath_follow != 0;
+    assign dt_scgath_advance_thread_idx = of_thread_idx;
+    assign dt_scgath_advance_from = of_subcycle;
+    assign dt_scgath_advance_to = scgath_run_end + subcycle_t'(1);
+    assign dt_scgath_advance_done = scgath_run_end == of_instruction.last_subcycle;
+
     initial
     begin
         // Cannot use more than 64 dcache sets
@@ -174,8 +263,15 @@ module dcache_tag_stage
         for (way_idx = 0; way_idx < `L1D_WAYS; way_idx++)
         begin : way_tag_gen
             // Valid flags are flops instead of SRAM because they need
-            // to all be cleared on reset.
+            // to all be cleared on reset. line_prefetched is set when a
+            // prefetch fills a line and cleared by the first load that
+            // hits it.
             logic line_valid[`L1D_SETS];
+            logic line_prefetched[`L1D_SETS];
+            logic prefetch_hit_this_way;
+
+            assign prefetch_hit_this_way = dd_prefetch_hit
+                && dd_update_lru_way == l1d_way_idx_t'(way_idx);
 
             sram_2r1w #(
                 .DATA_WIDTH($bits(l1d_tag_t)),
@@ -198,12 +294,22 @@ module dcache_tag_stage
                 if (reset)
                 begin
                     for (int set_idx = 0; set_idx < `L1D_SETS; set_idx++)
+                    begin
                         line_valid[set_idx] <= 0;
+                        line_prefetched[set_idx] <= 0;
+                    end
                 end
                 else
                 begin
+                    if (prefetch_hit_this_way)
+                        line_prefetched[dt_request_vaddr.set_idx] <= 0;
+
+                    // A fill takes precedence if it is to the same line
                     if (l2i_dtag_update_en_oh[way_idx])
+                    begin
                         line_valid[l2i_dtag_update_set] <= l2i_dtag_update_valid;
+                        line_prefetched[l2i_dtag_update_set] <= l2i_dtag_update_prefetched;
+                    end
                 end
             end
 
@@ -213,9 +319,18 @@ module dcache_tag_stage
                 if (cache_load_en)
                 begin
                     if (l2i_dtag_update_en_oh[way_idx] && l2i_dtag_update_set == request_addr_nxt.set_idx)
-                        dt_valid[way_idx] <= l2i_dtag_update_valid;    // Bypass
+                    begin
+                        // Bypass
+                        dt_valid[way_idx] <= l2i_dtag_update_valid;
+                        dt_prefetched[way_idx] <= l2i_dtag_update_prefetched;
+                    end
                     else
+                    begin
                         dt_valid[way_idx] <= line_valid[request_addr_nxt.set_idx];
+                        dt_prefetched[way_idx] <= line_prefetched[request_addr_nxt.set_idx]
+                            && !(prefetch_hit_this_way
+                            && dt_request_vaddr.set_idx == request_addr_nxt.set_idx);
+                    end
                 end
 
                 // Fetch cache line state for snoop
@@ -232,7 +347,8 @@ module dcache_tag_stage
 
     tlb #(
         .NUM_ENTRIES(`DTLB_ENTRIES),
-        .NUM_WAYS(`TLB_WAYS)
+        .NUM_WAYS(`TLB_WAYS),
+        .NUM_SUPERPAGE_ENTRIES(`TLB_SUPERPAGE_ENTRIES)
     ) dtlb(
         .lookup_en(tlb_lookup_en),
         .update_en(update_dtlb_en),
@@ -245,6 +361,7 @@ module dcache_tag_stage
         .update_exe_writable(new_tlb_value.writable),
         .update_supervisor(new_tlb_value.supervisor),
         .update_global(new_tlb_value.global_map),
+        .update_superpage(new_tlb_value.superpage),
         .lookup_ppage_idx(tlb_ppage_idx),
         .lookup_hit(tlb_hit),
         .lookup_present(tlb_present),
@@ -296,16 +413,36 @@ module dcache_tag_stage
         dt_store_value <= of_store_value;
         dt_subcycle <= of_subcycle;
         fetched_addr <= request_addr_nxt;
+        dt_scgath_lane_mask <= scgath_leader
+            ? (scgath_follow | (vector_mask_t'(1) << of_subcycle)) & of_mask_value
+            : '0;
+        dt_scgath_covered <= scgath_covered;
+        dt_scgath_run_done <= scgath_leader
+            && scgath_run_end == of_instruction.last_subcycle;
+        for (int sc = 0; sc < NUM_VECTOR_LANES; sc++)
+            dt_scgath_word_idx[sc] <= scgath_addr[sc][2+:$clog2(CACHE_LINE_WORDS)];
     end
 
     always_ff @(posedge clk, posedge reset)
     begin
         if (reset)
+        begin
             dt_instruction_valid <= '0;
+            for (int i = 0; i < `THREADS_PER_CORE; i++)
+                scgath_covered_lanes[i] <= '0;
+        end
         else
         begin
             assert($onehot0(l2i_dtag_update_en_oh));
             dt_instruction_valid <= instruction_valid;
+
+            // A rollback restarts the instruction at a subcycle that was not
+            // covered, so forget the run.
+            if (scgath_leader)
+                scgath_covered_lanes[of_thread_idx] <= scgath_follow;
+
+            if (wb_rollback_en)
+                scgath_covered_lanes[wb_rollback_thread_idx] <= '0;
         end
     end
 
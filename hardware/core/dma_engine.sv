@@ -0,0 +1,369 @@
+//
+// Copyright 2019 Jeff Bush
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+`include "defines.svh"
+
+import defines::*;
+
+//
+// DMA engine. Copies or fills memory without using a hardware thread. A
+// transfer is a number of rows of the same length, with a stride between
+// the starts of consecutive rows for both the source and destination, so
+// it can copy or clear a rectangle in a frame buffer. A linear transfer is
+// one row.
+//
+// This sends requests through the L2 cache like a core, so transfers are
+// coherent: a DMA store updates L1 lines like a store from another core,
+// and L2 lines are loaded or written back as needed. Requests and responses
+// have the dma flag set so cores don't treat the responses as their own.
+// The texture samplers share the port (see nyuzi), so this ignores
+// responses without its id.
+//
+// This processes one cache line at a time. A copy loads the source line,
+// then stores the bytes of it that are in the row to the destination, so
+// the source and destination must have the same offset within a cache line.
+// A fill stores a replicated 32-bit value. Addresses, row lengths, and
+// strides are in bytes, and must be multiples of four (the low bits are
+// ignored). The source and destination must not overlap.
+//
+// Stores are issued without waiting for the previous one to complete, but
+// the transfer isn't finished until all are acknowledged, so software
+// sees all of the data when the status register indicates it is done.
+// The L2 cache is write back, so other bus masters (like the display
+// controller) won't see the data until it is evicted. If the flush control
+// bit is set, this flushes each destination line after storing to it, like
+// a dflush instruction. It waits for the store to complete first, otherwise
+// a store that missed could fill the line after the flush.
+//
+// Registers (offsets from DMA_BASE):
+// 0x00 source address
+// 0x04 destination address
+// 0x08 row length
+// 0x0c number of rows
+// 0x10 source stride
+// 0x14 destination stride
+// 0x18 fill value
+// 0x1c control. Writing starts a transfer. Bit 0 selects fill (1) or copy
+//      (0), bit 1 enables the completion interrupt, bit 2 flushes
+//      destination lines.
+// 0x20 status. Bit 0 is set while a transfer is in progress, bit 1 is set
+//      when one finishes. Writing clears bit 1 and the interrupt.
+// Writes other than to the status register are ignored while a transfer is
+// in progress.
+//
+
+module dma_engine(
+    input                       clk,
+    input                       reset,
+
+    // From io_interconnect
+    input                       ii_dma_write_en,
+    input [3:0]                 ii_dma_reg,
+    input scalar_t              ii_dma_write_data,
+    output scalar_t             dma_read_data,
+
+    // To/from l2_cache
+    output logic                dma_l2_request_valid,
+    output l2req_packet_t       dma_l2_request,
+    input                       l2_dma_ready,
+    input                       l2_response_valid,
+    input l2rsp_packet_t        l2_response,
+
+    // To cores
+    output logic                dma_interrupt);
+
+    localparam REG_SRC = 4'd0;
+    localparam REG_DEST = 4'd1;
+    localparam REG_ROW_BYTES = 4'd2;
+    localparam REG_ROWS = 4'd3;
+    localparam REG_SRC_STRIDE = 4'd4;
+    localparam REG_DEST_STRIDE = 4'd5;
+    localparam REG_FILL_VALUE = 4'd6;
+    localparam REG_CONTROL = 4'd7;
+    localparam REG_STATUS = 4'd8;
+
+    typedef enum logic[2:0] {
+        DMA_IDLE,
+        DMA_LOAD,       // Send load for the source line
+        DMA_WAIT_LOAD,  // Wait for source line data
+        DMA_STORE,      // Send store for the destination line
+        DMA_WAIT_STORE, // Wait for stores to finish before flushing
+        DMA_FLUSH,      // Send flush for the destination line
+        DMA_WAIT_FLUSH, // Wait for the flush to finish
+        DMA_DRAIN       // Wait for outstanding stores to be acknowledged
+    } dma_state_t;
+
+    dma_state_t state;
+    scalar_t src_addr;
+    scalar_t dest_addr;
+    scalar_t row_bytes;
+    scalar_t rows;
+    scalar_t src_stride;
+    scalar_t dest_stride;
+    scalar_t fill_value;
+    scalar_t control;
+    logic done;
+    scalar_t row_src_addr;
+    scalar_t row_dest_addr;
+    scalar_t row_end_addr;
+    scalar_t rows_remaining;
+    scalar_t src_cur;
+    scalar_t dest_cur;
+    cache_line_data_t line_data;
+    logic[15:0] pending_stores;
+    logic fill;
+    logic flush;
+    scalar_t bytes_to_row_end;
+    logic[CACHE_LINE_OFFSET_WIDTH:0] line_start;
+    logic[CACHE_LINE_OFFSET_WIDTH:0] line_bytes;
+    logic[CACHE_LINE_OFFSET_WIDTH:0] line_end;
+    logic[CACHE_LINE_BYTES - 1:0] store_mask;
+    cache_line_data_t fill_line;
+    logic start;
+    logic response_valid;
+    logic store_accepted;
+    logic store_acked;
+    logic load_acked;
+    logic flush_acked;
+    logic row_done;
+    logic next_line;
+
+    assign fill = control[0];
+    assign flush = control[2];
+    assign start = ii_dma_write_en && ii_dma_reg == REG_CONTROL && state == DMA_IDLE;
+
+    // Bytes of the current row that are in this cache line
+    assign bytes_to_row_end = row_end_addr - dest_cur;
+    assign line_start = {1'b0, dest_cur[CACHE_LINE_OFFSET_WIDTH - 1:0]};
+    assign line_bytes = bytes_to_row_end < scalar_t'(CACHE_LINE_BYTES - line_start)
+        ? (CACHE_LINE_OFFSET_WIDTH + 1)'(bytes_to_row_end)
+        : (CACHE_LINE_OFFSET_WIDTH + 1)'(CACHE_LINE_BYTES) - line_start;
+    assign line_end = line_start + line_bytes;
+    assign row_done = scalar_t'(line_bytes) == bytes_to_row_end;
+
+    // Byte lanes are in reverse order of address (see dcache_data_stage)
+    genvar byte_lane;
+    generate
+        for (byte_lane = 0; byte_lane < CACHE_LINE_BYTES; byte_lane++)
+        begin : store_mask_gen
+            assign store_mask[byte_lane] = (CACHE_LINE_OFFSET_WIDTH + 1)'(CACHE_LINE_BYTES - 1 - byte_lane) >= line_start
+                && (CACHE_LINE_OFFSET_WIDTH + 1)'(CACHE_LINE_BYTES - 1 - byte_lane) < line_end;
+        end
+    endgenerate
+
+    assign fill_line = {CACHE_LINE_WORDS{fill_value[7:0], fill_value[15:8],
+        fill_value[23:16], fill_value[31:24]}};
+
+    always_comb
+    begin
+        dma_l2_request = '0;
+        dma_l2_request.dma = 1;
+        dma_l2_request.id = L2_DMA_ID_ENGINE;
+        dma_l2_request.cache_type = CT_DCACHE;
+        if (state == DMA_LOAD)
+        begin
+            dma_l2_request.packet_type = L2REQ_LOAD;
+            dma_l2_request.address = src_cur[31:CACHE_LINE_OFFSET_WIDTH];
+        end
+        else if (state == DMA_FLUSH)
+        begin
+            dma_l2_request.packet_type = L2REQ_FLUSH;
+            dma_l2_request.address = dest_cur[31:CACHE_LINE_OFFSET_WIDTH];
+        end
+        else
+        begin
+            dma_l2_request.packet_type = L2REQ_STORE;
+            dma_l2_request.address = dest_cur[31:CACHE_LINE_OFFSET_WIDTH];
+            dma_l2_request.store_mask = store_mask;
+            dma_l2_request.data = fill ? fill_line : line_data;
+        end
+    end
+
+    assign dma_l2_request_valid = state == DMA_LOAD || state == DMA_STORE
+        || state == DMA_FLUSH;
+    assign store_accepted = state == DMA_STORE && l2_dma_ready;
+    assign response_valid = l2_response_valid && l2_response.dma
+        && l2_response.id == L2_DMA_ID_ENGINE;
+    assign store_acked = response_valid && l2_response.packet_type == L2RSP_STORE_ACK;
+    assign load_acked = response_valid && l2_response.packet_type == L2RSP_LOAD_ACK;
+    assign flush_acked = response_valid && l2_response.packet_type == L2RSP_FLUSH_ACK;
+
+    // Done with the current destination line
+    assign next_line = (store_accepted && !flush)
+        || (state == DMA_WAIT_FLUSH && flush_acked);
+    assign dma_interrupt = done && control[1];
+
+    always_ff @(posedge clk)
+    begin
+        if (load_acked)
+            line_data <= l2_response.data;
+
+        unique case (ii_dma_reg)
+            REG_SRC: dma_read_data <= src_addr;
+            REG_DEST: dma_read_data <= dest_addr;
+            REG_ROW_BYTES: dma_read_data <= row_bytes;
+            REG_ROWS: dma_read_data <= rows;
+            REG_SRC_STRIDE: dma_read_data <= src_stride;
+            REG_DEST_STRIDE: dma_read_data <= dest_stride;
+            REG_FILL_VALUE: dma_read_data <= fill_value;
+            REG_CONTROL: dma_read_data <= control;
+            REG_STATUS: dma_read_data <= {30'd0, done, state != DMA_IDLE};
+            default: dma_read_data <= '0;
+        endcase
+    end
+
+    always_ff @(posedge clk, posedge reset)
+    begin
+        if (reset)
+        begin
+            state <= DMA_IDLE;
+            /*AUTORESET*/
+            // Beginning of autoreset for uninitialized flops
+            control <= '0;
+            dest_addr <= '0;
+            dest_cur <= '0;
+            dest_stride <= '0;
+            done <= '0;
+            fill_value <= '0;
+            pending_stores <= '0;
+            row_bytes <= '0;
+            row_dest_addr <= '0;
+            row_end_addr <= '0;
+            row_src_addr <= '0;
+            rows <= '0;
+            rows_remaining <= '0;
+            src_addr <= '0;
+            src_cur <= '0;
+            src_stride <= '0;
+            // End of automatics
+        end
+        else
+        begin
+            if (ii_dma_write_en && state == DMA_IDLE)
+            begin
+                unique0 case (ii_dma_reg)
+                    REG_SRC: src_addr <= {ii_dma_write_data[31:2], 2'd0};
+                    REG_DEST: dest_addr <= {ii_dma_write_data[31:2], 2'd0};
+                    REG_ROW_BYTES: row_bytes <= {ii_dma_write_data[31:2], 2'd0};
+                    REG_ROWS: rows <= ii_dma_write_data;
+                    REG_SRC_STRIDE: src_stride <= {ii_dma_write_data[31:2], 2'd0};
+                    REG_DEST_STRIDE: dest_stride <= {ii_dma_write_data[31:2], 2'd0};
+                    REG_FILL_VALUE: fill_value <= ii_dma_write_data;
+                    REG_CONTROL: control <= ii_dma_write_data;
+                endcase
+            end
+
+            if (ii_dma_write_en && ii_dma_reg == REG_STATUS)
+                done <= 0;
+
+            if (store_accepted && !store_acked)
+                pending_stores <= pending_stores + 1;
+            else if (store_acked && !store_accepted)
+                pending_stores <= pending_stores - 1;
+
+            unique case (state)
+                DMA_IDLE:
+                begin
+                    if (start)
+                    begin
+                        src_cur <= src_addr;
+                        dest_cur <= dest_addr;
+                        row_src_addr <= src_addr;
+                        row_dest_addr <= dest_addr;
+                        row_end_addr <= dest_addr + row_bytes;
+                        rows_remaining <= rows;
+                        done <= 0;
+                        if (rows == 0 || row_bytes == 0)
+                            done <= 1;
+                        else if (ii_dma_write_data[0])
+                            state <= DMA_STORE;
+                        else
+                            state <= DMA_LOAD;
+                    end
+                end
+
+                DMA_LOAD:
+                begin
+                    if (l2_dma_ready)
+                        state <= DMA_WAIT_LOAD;
+                end
+
+                DMA_WAIT_LOAD:
+                begin
+                    if (load_acked)
+                        state <= DMA_STORE;
+                end
+
+                DMA_STORE:
+                begin
+                    if (l2_dma_ready && flush)
+                        state <= DMA_WAIT_STORE;
+                end
+
+                DMA_WAIT_STORE:
+                begin
+                    if (pending_stores == 0)
+                        state <= DMA_FLUSH;
+                end
+
+                DMA_FLUSH:
+                begin
+                    if (l2_dma_ready)
+                        state <= DMA_WAIT_FLUSH;
+                end
+
+                DMA_WAIT_FLUSH:
+                    ;
+
+                DMA_DRAIN:
+                begin
+                    if (pending_stores == 0)
+                    begin
+                        done <= 1;
+                        state <= DMA_IDLE;
+                    end
+                end
+
+                default:
+                    state <= DMA_IDLE;
+            endcase
+
+            if (next_line)
+            begin
+                if (row_done)
+                begin
+                    // Start the next row
+                    row_src_addr <= row_src_addr + src_stride;
+                    row_dest_addr <= row_dest_addr + dest_stride;
+                    row_end_addr <= row_dest_addr + dest_stride + row_bytes;
+                    src_cur <= row_src_addr + src_stride;
+                    dest_cur <= row_dest_addr + dest_stride;
+                    rows_remaining <= rows_remaining - 1;
+                    if (rows_remaining == 1)
+                        state <= DMA_DRAIN;
+                    else
+                        state <= fill ? DMA_STORE : DMA_LOAD;
+                end
+                else
+                begin
+                    src_cur <= src_cur + scalar_t'(line_bytes);
+                    dest_cur <= dest_cur + scalar_t'(line_bytes);
+                    state <= fill ? DMA_STORE : DMA_LOAD;
+                end
+            end
+        end
+    end
+endmodule
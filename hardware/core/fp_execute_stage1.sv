@@ -30,6 +30,15 @@ import defines::*;
 // - Steer significand down smaller-exponent lane
 // Floating point multiplication
 // - Add exponents/multiply significands
+// Fused multiply-add
+// - Compute product exponent and determine whether the product or the
+//   addend has the larger exponent
+// - Compute alignment shift count for the smaller one
+// Reductions
+// - Replace disabled lanes with the identity value for the operation
+// - For floating point sums, find the largest exponent and compute the
+//   shift count to align each lane to it. The add pipeline shifts
+//   them in the next stage.
 // The floating point pipeline also handles integer multiplication. This
 // stages passes through the integer value to the multiplier in the next
 // stage.
@@ -46,6 +55,7 @@ module fp_execute_stage1(
     // From operand_fetch_stage
     input vector_t                                  of_operand1,
     input vector_t                                  of_operand2,
+    input vector_t                                  of_operand3,
     input vector_mask_t                             of_mask_value,
     input                                           of_instruction_valid,
     input decoded_instruction_t                     of_instruction,
@@ -76,15 +86,33 @@ module fp_execute_stage1(
     output logic[NUM_VECTOR_LANES - 1:0][31:0]      fx1_multiplier,
     output logic[NUM_VECTOR_LANES - 1:0][7:0]       fx1_mul_exponent,
     output logic[NUM_VECTOR_LANES - 1:0]            fx1_mul_underflow,
-    output logic[NUM_VECTOR_LANES - 1:0]            fx1_mul_sign);
+    output logic[NUM_VECTOR_LANES - 1:0]            fx1_mul_sign,
+
+    // Fused multiply-add
+    output logic[NUM_VECTOR_LANES - 1:0][23:0]      fx1_fma_addend,
+    output logic[NUM_VECTOR_LANES - 1:0]            fx1_fma_addend_sign,
+    output logic[NUM_VECTOR_LANES - 1:0][9:0]       fx1_fma_exponent,
+    output logic[NUM_VECTOR_LANES - 1:0][5:0]       fx1_fma_align_shift,
+    output logic[NUM_VECTOR_LANES - 1:0]            fx1_fma_product_larger);
 
     logic fmul;
     logic imul;
     logic ftoi;
     logic itof;
     logic compare;
+    logic fma;
+    logic reduce_add_f;
+    logic[NUM_VECTOR_LANES - 1:0][7:0] reduce_lane_exponent;
+    logic[NUM_VECTOR_LANES - 1:0] reduce_lane_nan;
+    logic[NUM_VECTOR_LANES - 1:0] reduce_lane_pos_inf;
+    logic[NUM_VECTOR_LANES - 1:0] reduce_lane_neg_inf;
+    logic[7:0] reduce_exponent;
+    logic reduce_nan;
+    logic reduce_inf;
 
     assign fmul = of_instruction.alu_op == OP_MUL_F;
+    assign fma = of_instruction.alu_op == OP_MLA_F;
+    assign reduce_add_f = of_instruction.alu_op == OP_REDUCE_ADD_F;
     assign imul = of_instruction.alu_op == OP_MULL_I || of_instruction.alu_op == OP_MULH_U
         || of_instruction.alu_op == OP_MULH_I;
     assign ftoi = of_instruction.alu_op == OP_FTOI;
@@ -121,6 +149,20 @@ module fp_execute_stage1(
             logic mul_exponent_carry;
             logic[5:0] ftoi_rshift;
             logic[5:0] ftoi_lshift_nxt;
+            float32_t fop3;
+            logic[FLOAT32_SIG_WIDTH:0] full_significand3;
+            logic fop3_inf;
+            logic fop3_nan;
+            logic fop1_zero;
+            logic fop2_zero;
+            logic[9:0] fma_product_exponent;
+            logic[9:0] fma_addend_exponent;
+            logic fma_product_larger;
+            logic[9:0] fma_exp_difference;
+            logic fma_result_nan;
+            logic lane_enabled;
+            logic[7:0] reduce_shift;
+            scalar_t reduce_value;
 
             assign fop1 = of_operand1[lane_idx];
             assign fop2 = of_operand2[lane_idx];
@@ -133,6 +175,12 @@ module fp_execute_stage1(
             assign fop1_nan = fop1.exponent == 8'hff && fop1.significand != 0;
             assign fop2_inf = fop2.exponent == 8'hff && fop2.significand == 0;
             assign fop2_nan = fop2.exponent == 8'hff && fop2.significand != 0;
+            assign fop3 = of_operand3[lane_idx];
+            assign full_significand3 = {fop3.exponent != 0, fop3.significand};
+            assign fop3_inf = fop3.exponent == 8'hff && fop3.significand == 0;
+            assign fop3_nan = fop3.exponent == 8'hff && fop3.significand != 0;
+            assign fop1_zero = full_significand1 == 0;
+            assign fop2_zero = full_significand2 == 0;
 
             // Compute how much to shift the significand right to truncate
             // fractional digits
@@ -176,6 +224,10 @@ module fp_execute_stage1(
                     result_nan = fop2_nan || fop2_inf || fop2.exponent >= 8'd159;
                 else if (compare)
                     result_nan = fop1_nan || fop2_nan;
+                else if (fma)
+                    result_nan = fma_result_nan;
+                else if (of_instruction.reduce)
+                    result_nan = reduce_add_f && reduce_nan;
                 else
                     result_nan = fop1_nan || fop2_nan || (fop1_inf && fop2_inf && logical_subtract);
             end
@@ -190,6 +242,64 @@ module fp_execute_stage1(
             assign {mul_exponent_underflow, mul_exponent_carry, mul_exponent}
                 =  {2'd0, fop1.exponent} + {2'd0, fop2.exponent} - 10'd127;
 
+            // Fused multiply-add (operand1 * operand2 + operand3). This uses
+            // effective exponents (1 for subnormal numbers) so the product and
+            // addend can be aligned exactly. The exponents are signed because the
+            // product exponent may be out of range before it is added. If
+            // either value is zero, the other is always the larger one.
+            assign fma_product_exponent = 10'(fop1.exponent) + 10'(!op1_hidden_bit)
+                + 10'(fop2.exponent) + 10'(!op2_hidden_bit) - 10'd127;
+            assign fma_addend_exponent = 10'(fop3.exponent) + 10'(fop3.exponent == 0);
+            assign fma_product_larger = full_significand3 == 0 || (!fop1_zero && !fop2_zero
+                && $signed(fma_product_exponent) >= $signed(fma_addend_exponent));
+            assign fma_exp_difference = fma_product_larger
+                ? fma_product_exponent - fma_addend_exponent
+                : fma_addend_exponent - fma_product_exponent;
+            assign fma_result_nan = fop1_nan || fop2_nan || fop3_nan
+                || (fop1_inf && fop2_zero) || (fop2_inf && fop1_zero)
+                || ((fop1_inf || fop2_inf) && fop3_inf && (fop1.sign ^ fop2.sign) != fop3.sign);
+
+            // Reductions. Disabled lanes are replaced with a value that doesn't
+            // affect the result. Signed integers are biased and floating point
+            // values are converted to a key that orders the same way as an
+            // unsigned integer (negative values below positive ones, NaNs at
+            // the ends), so later stages only need unsigned comparisons.
+            assign lane_enabled = of_mask_value[NUM_VECTOR_LANES - lane_idx - 1];
+            assign reduce_lane_exponent[lane_idx] = lane_enabled && op2_hidden_bit ? fop2.exponent : 8'd1;
+            assign reduce_lane_nan[lane_idx] = lane_enabled && fop2_nan;
+            assign reduce_lane_pos_inf[lane_idx] = lane_enabled && fop2_inf && !fop2.sign;
+            assign reduce_lane_neg_inf[lane_idx] = lane_enabled && fop2_inf && fop2.sign;
+            assign reduce_shift = reduce_exponent - reduce_lane_exponent[lane_idx];
+
+            always_comb
+            begin
+                unique case (of_instruction.alu_op)
+                    OP_REDUCE_ADD_F:
+                        reduce_value = lane_enabled ? {full_significand2, 8'd0} : 32'd0;
+
+                    OP_REDUCE_MIN_F, OP_REDUCE_MAX_F:
+                    begin
+                        if (!lane_enabled)
+                            reduce_value = of_instruction.alu_op == OP_REDUCE_MIN_F ? 32'hffffffff : 32'd0;
+                        else if (fop2.sign)
+                            reduce_value = ~of_operand2[lane_idx];
+                        else
+                            reduce_value = of_operand2[lane_idx] | 32'h80000000;
+                    end
+
+                    OP_REDUCE_MIN_I, OP_REDUCE_MAX_I:
+                    begin
+                        if (!lane_enabled)
+                            reduce_value = of_instruction.alu_op == OP_REDUCE_MIN_I ? 32'hffffffff : 32'd0;
+                        else
+                            reduce_value = of_operand2[lane_idx] ^ 32'h80000000;
+                    end
+
+                    default:    // OP_REDUCE_ADD_I
+                        reduce_value = lane_enabled ? of_operand2[lane_idx] : 32'd0;
+                endcase
+            end
+
             // Subtle: In the case where values are equal, leave operand1 in the _le slot. This properly
             // handles the sign for +/- zero.
             assign op1_larger = fop1.exponent > fop2.exponent
@@ -200,8 +310,16 @@ module fp_execute_stage1(
             always_ff @(posedge clk)
             begin
                 fx1_result_nan[lane_idx] <= result_nan;
-                fx1_result_inf[lane_idx] <= !itof && !result_nan && (fop1_inf || fop2_inf
-                    || (fmul && mul_exponent_carry && !mul_exponent_underflow));
+                if (fma)
+                    fx1_result_inf[lane_idx] <= !result_nan && (fop1_inf || fop2_inf || fop3_inf);
+                else if (of_instruction.reduce)
+                    fx1_result_inf[lane_idx] <= reduce_add_f && !result_nan && reduce_inf;
+                else
+                begin
+                    fx1_result_inf[lane_idx] <= !itof && !result_nan && (fop1_inf || fop2_inf
+                        || (fmul && mul_exponent_carry && !mul_exponent_underflow));
+                end
+
                 fx1_equal[lane_idx] <= equal;
                 fx1_mul_underflow[lane_idx] <= mul_exponent_underflow;
 
@@ -210,7 +328,26 @@ module fp_execute_stage1(
                 //   The large exponent is set to zero.
                 // - For addition/subtraction, sort into significand_le (the larger value) and
                 //   sigificand_se (the smaller).
-                if (op1_larger || ftoi || itof)
+                // - Reductions also use the small exponent path, which aligns floating point
+                //   values to the largest exponent. Integer values are not shifted.
+                //   add_result_sign is the sign of an infinite sum.
+                if (of_instruction.reduce)
+                begin
+                    fx1_significand_le[lane_idx] <= 0;
+                    fx1_significand_se[lane_idx] <= reduce_value;
+                    fx1_add_exponent[lane_idx] <= reduce_exponent;
+                    fx1_add_result_sign[lane_idx] <= |reduce_lane_neg_inf;
+                end
+                else if (fma)
+                begin
+                    // Only used if the result is infinite
+                    fx1_significand_le[lane_idx] <= 0;
+                    fx1_significand_se[lane_idx] <= 0;
+                    fx1_add_exponent[lane_idx] <= 0;
+                    fx1_add_result_sign[lane_idx] <= fop1_inf || fop2_inf
+                        ? fop1.sign ^ fop2.sign : fop3.sign;
+                end
+                else if (op1_larger || ftoi || itof)
                 begin
                     if (ftoi || itof)
                         fx1_significand_le[lane_idx] <= 0;
@@ -241,8 +378,18 @@ module fp_execute_stage1(
                     fx1_add_result_sign[lane_idx] <= fop2.sign ^ subtract;
                 end
 
-                fx1_logical_subtract[lane_idx] <= logical_subtract;
-                if (itof)
+                if (of_instruction.reduce)
+                    fx1_logical_subtract[lane_idx] <= reduce_add_f && lane_enabled && fop2.sign;
+                else
+                    fx1_logical_subtract[lane_idx] <= logical_subtract;
+
+                if (reduce_add_f)
+                begin
+                    // The significand is at the top of the 32 bit value. Shifting
+                    // 32 bits or more truncates it to zero.
+                    fx1_se_align_shift[lane_idx] <= reduce_shift < 8'd32 ? 6'(reduce_shift) : 6'd32;
+                end
+                else if (itof || of_instruction.reduce)
                     fx1_se_align_shift[lane_idx] <= 0;
                 else if (ftoi)
                 begin
@@ -276,10 +423,37 @@ module fp_execute_stage1(
 
                 fx1_mul_exponent[lane_idx] <= mul_exponent;
                 fx1_mul_sign[lane_idx] <= fop1.sign ^ fop2.sign;
+
+                // Fused multiply-add. The product comes from the multiplier. Stage 3
+                // aligns the smaller value. Shifts of 51 bits or more move it entirely
+                // into the sticky bit.
+                fx1_fma_addend[lane_idx] <= full_significand3;
+                fx1_fma_addend_sign[lane_idx] <= fop3.sign;
+                fx1_fma_exponent[lane_idx] <= fma_product_larger ? fma_product_exponent
+                    : fma_addend_exponent;
+                if (fop1_zero || fop2_zero || full_significand3 == 0 || fma_exp_difference > 10'd63)
+                    fx1_fma_align_shift[lane_idx] <= 6'd63;
+                else
+                    fx1_fma_align_shift[lane_idx] <= 6'(fma_exp_difference);
+                fx1_fma_product_larger[lane_idx] <= fma_product_larger;
             end
         end
     endgenerate
 
+    // Largest exponent of the enabled lanes for floating point sum reductions
+    always_comb
+    begin
+        reduce_exponent = reduce_lane_exponent[0];
+        for (int lane = 1; lane < NUM_VECTOR_LANES; lane++)
+        begin
+            if (reduce_lane_exponent[lane] > reduce_exponent)
+                reduce_exponent = reduce_lane_exponent[lane];
+        end
+    end
+
+    assign reduce_nan = |reduce_lane_nan || (|reduce_lane_pos_inf && |reduce_lane_neg_inf);
+    assign reduce_inf = |reduce_lane_pos_inf || |reduce_lane_neg_inf;
+
     always_ff @(posedge clk)
     begin
         fx1_instruction <= of_instruction;
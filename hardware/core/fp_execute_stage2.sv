@@ -27,6 +27,10 @@ import defines::*;
 // - Perform actual operation (XXX placeholder, see below)
 // Float to int conversion
 // - Shift significand right to truncate fractional bit positions
+// Fused multiply-add
+// - Multiply significands (shares multiplier with multiplication)
+// Reductions
+// - Align floating point values using the addition shifter
 //
 
 module fp_execute_stage2(
@@ -64,6 +68,13 @@ module fp_execute_stage2(
     input [NUM_VECTOR_LANES - 1:0][31:0]        fx1_multiplier,
     input [NUM_VECTOR_LANES - 1:0]              fx1_mul_underflow,
 
+    // Fused multiply-add
+    input [NUM_VECTOR_LANES - 1:0][23:0]        fx1_fma_addend,
+    input [NUM_VECTOR_LANES - 1:0]              fx1_fma_addend_sign,
+    input [NUM_VECTOR_LANES - 1:0][9:0]         fx1_fma_exponent,
+    input [NUM_VECTOR_LANES - 1:0][5:0]         fx1_fma_align_shift,
+    input [NUM_VECTOR_LANES - 1:0]              fx1_fma_product_larger,
+
     // To fp_execute_stage3
     output logic                                fx2_instruction_valid,
     output decoded_instruction_t                fx2_instruction,
@@ -89,7 +100,14 @@ module fp_execute_stage2(
     output logic[NUM_VECTOR_LANES - 1:0][63:0]  fx2_significand_product,
     output logic[NUM_VECTOR_LANES - 1:0][7:0]   fx2_mul_exponent,
     output logic[NUM_VECTOR_LANES - 1:0]        fx2_mul_underflow,
-    output logic[NUM_VECTOR_LANES - 1:0]        fx2_mul_sign);
+    output logic[NUM_VECTOR_LANES - 1:0]        fx2_mul_sign,
+
+    // Fused multiply-add
+    output logic[NUM_VECTOR_LANES - 1:0][23:0]  fx2_fma_addend,
+    output logic[NUM_VECTOR_LANES - 1:0]        fx2_fma_addend_sign,
+    output logic[NUM_VECTOR_LANES - 1:0][9:0]   fx2_fma_exponent,
+    output logic[NUM_VECTOR_LANES - 1:0][5:0]   fx2_fma_align_shift,
+    output logic[NUM_VECTOR_LANES - 1:0]        fx2_fma_product_larger);
 
     logic imulhs;
 
@@ -134,6 +152,11 @@ module fp_execute_stage2(
                 fx2_result_nan[lane_idx] <= fx1_result_nan[lane_idx];
                 fx2_equal[lane_idx] <= fx1_equal[lane_idx];
                 fx2_ftoi_lshift[lane_idx] <= fx1_ftoi_lshift[lane_idx];
+                fx2_fma_addend[lane_idx] <= fx1_fma_addend[lane_idx];
+                fx2_fma_addend_sign[lane_idx] <= fx1_fma_addend_sign[lane_idx];
+                fx2_fma_exponent[lane_idx] <= fx1_fma_exponent[lane_idx];
+                fx2_fma_align_shift[lane_idx] <= fx1_fma_align_shift[lane_idx];
+                fx2_fma_product_larger[lane_idx] <= fx1_fma_product_larger[lane_idx];
 
                 // XXX Simple version. Should have a wallace tree here to collect partial products.
                 fx2_significand_product[lane_idx] <= sext_multiplicand * sext_multiplier;
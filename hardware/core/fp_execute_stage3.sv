@@ -28,6 +28,12 @@ import defines::*;
 // - Convert negative values to 2's complement.
 // Floating point multiplication
 // - pass through
+// Fused multiply-add
+// - Swap product and addend so the one with the larger exponent is in the
+//   _le slot
+// - Shift the smaller one to align it, keeping guard, round, and sticky bits
+// Reductions
+// - First two levels of the reduction tree (each group of four lanes)
 //
 
 module fp_execute_stage3(
@@ -61,6 +67,13 @@ module fp_execute_stage3(
     input [NUM_VECTOR_LANES - 1:0]              fx2_mul_underflow,
     input [NUM_VECTOR_LANES - 1:0]              fx2_mul_sign,
 
+    // Fused multiply-add
+    input [NUM_VECTOR_LANES - 1:0][23:0]        fx2_fma_addend,
+    input [NUM_VECTOR_LANES - 1:0]              fx2_fma_addend_sign,
+    input [NUM_VECTOR_LANES - 1:0][9:0]         fx2_fma_exponent,
+    input [NUM_VECTOR_LANES - 1:0][5:0]         fx2_fma_align_shift,
+    input [NUM_VECTOR_LANES - 1:0]              fx2_fma_product_larger,
+
     // To fp_execute_stage4
     output logic                                fx3_instruction_valid,
     output decoded_instruction_t                fx3_instruction,
@@ -82,11 +95,28 @@ module fp_execute_stage3(
     output logic[NUM_VECTOR_LANES - 1:0][63:0]  fx3_significand_product,
     output logic[NUM_VECTOR_LANES - 1:0][7:0]   fx3_mul_exponent,
     output logic[NUM_VECTOR_LANES - 1:0]        fx3_mul_underflow,
-    output logic[NUM_VECTOR_LANES - 1:0]        fx3_mul_sign);
+    output logic[NUM_VECTOR_LANES - 1:0]        fx3_mul_sign,
+
+    // Fused multiply-add
+    output logic[NUM_VECTOR_LANES - 1:0][50:0]  fx3_fma_significand_le,
+    output logic[NUM_VECTOR_LANES - 1:0][50:0]  fx3_fma_significand_se,
+    output logic[NUM_VECTOR_LANES - 1:0][9:0]   fx3_fma_exponent,
+    output logic[NUM_VECTOR_LANES - 1:0]        fx3_fma_logical_subtract,
+    output logic[NUM_VECTOR_LANES - 1:0]        fx3_fma_result_sign,
+
+    // Reductions
+    output logic[3:0][36:0]                     fx3_reduce_partial);
 
     logic ftoi;
+    logic reduce_min;
+    logic reduce_max;
+    logic[NUM_VECTOR_LANES - 1:0][36:0] reduce_lane_value;
 
     assign ftoi = fx2_instruction.alu_op == OP_FTOI;
+    assign reduce_min = fx2_instruction.alu_op == OP_REDUCE_MIN_F
+        || fx2_instruction.alu_op == OP_REDUCE_MIN_I;
+    assign reduce_max = fx2_instruction.alu_op == OP_REDUCE_MAX_F
+        || fx2_instruction.alu_op == OP_REDUCE_MAX_I;
 
     genvar lane_idx;
     generate
@@ -99,6 +129,10 @@ module fp_execute_stage3(
             logic round_tie;
             logic do_round;
             logic _unused;
+            logic[47:0] fma_product;
+            logic[47:0] fma_addend;
+            logic[50:0] fma_aligned;
+            logic[62:0] fma_sticky_bits;
 
             // Round-to-nearest, round half to even. Compute the value of the low bit
             // of the sum to predict if the result is odd.
@@ -120,6 +154,22 @@ module fp_execute_stage3(
             assign {unnormalized_sum, _unused} = {fx2_significand_le[lane_idx], 1'b1}
                 + {(fx2_significand_se[lane_idx] ^ {32{fx2_logical_subtract[lane_idx]}}), carry_in};
 
+            // Fused multiply-add. The product and addend have the same scale:
+            // the leading one of the addend (if it is normalized) is at bit 46
+            // and the product's is at bit 46 or 47 (if the factors are normalized).
+            // Three extra bits at the bottom hold the guard, round, and sticky
+            // bits for the smaller value.
+            assign fma_product = fx2_significand_product[lane_idx][47:0];
+            assign fma_addend = {1'b0, fx2_fma_addend[lane_idx], 23'd0};
+            assign {fma_aligned, fma_sticky_bits} = {fx2_fma_product_larger[lane_idx]
+                ? fma_addend : fma_product, 3'd0, 63'd0} >> fx2_fma_align_shift[lane_idx];
+
+            // Signed value of this lane for reductions. Floating point values
+            // are sign/magnitude. Integer values and min/max keys are unsigned.
+            assign reduce_lane_value[lane_idx] = fx2_logical_subtract[lane_idx]
+                ? -37'(fx2_significand_se[lane_idx])
+                : 37'(fx2_significand_se[lane_idx]);
+
             always_ff @(posedge clk)
             begin
                 fx3_result_inf[lane_idx] <= fx2_result_inf[lane_idx];
@@ -139,7 +189,51 @@ module fp_execute_stage3(
                 fx3_mul_exponent[lane_idx] <= fx2_mul_exponent[lane_idx];
                 fx3_mul_underflow[lane_idx] <= fx2_mul_underflow[lane_idx];
                 fx3_mul_sign[lane_idx] <= fx2_mul_sign[lane_idx];
+
+                // Fused multiply-add
+                fx3_fma_significand_le[lane_idx] <= {fx2_fma_product_larger[lane_idx]
+                    ? fma_product : fma_addend, 3'd0};
+                fx3_fma_significand_se[lane_idx] <= {fma_aligned[50:1], fma_aligned[0] || |fma_sticky_bits};
+                fx3_fma_exponent[lane_idx] <= fx2_fma_exponent[lane_idx];
+                fx3_fma_logical_subtract[lane_idx] <= fx2_mul_sign[lane_idx] ^ fx2_fma_addend_sign[lane_idx];
+                fx3_fma_result_sign[lane_idx] <= fx2_fma_product_larger[lane_idx]
+                    ? fx2_mul_sign[lane_idx] : fx2_fma_addend_sign[lane_idx];
+            end
+        end
+    endgenerate
+
+    // Combine each group of four lanes. Lanes are aligned to the same exponent,
+    // so floating point values can be added as integers. The extra bits hold
+    // the carries so the sum is exact.
+    genvar group_idx;
+    generate
+        for (group_idx = 0; group_idx < 4; group_idx++)
+        begin : reduce_group_gen
+            logic[36:0] group_result;
+
+            always_comb
+            begin
+                group_result = reduce_lane_value[group_idx * NUM_VECTOR_LANES / 4];
+                for (int lane = group_idx * NUM_VECTOR_LANES / 4 + 1;
+                    lane < (group_idx + 1) * NUM_VECTOR_LANES / 4; lane++)
+                begin
+                    if (reduce_min)
+                    begin
+                        if (reduce_lane_value[lane] < group_result)
+                            group_result = reduce_lane_value[lane];
+                    end
+                    else if (reduce_max)
+                    begin
+                        if (reduce_lane_value[lane] > group_result)
+                            group_result = reduce_lane_value[lane];
+                    end
+                    else
+                        group_result = group_result + reduce_lane_value[lane];
+                end
             end
+
+            always_ff @(posedge clk)
+                fx3_reduce_partial[group_idx] <= group_result;
         end
     endgenerate
 
@@ -26,6 +26,12 @@ import defines::*;
 //   addition
 // - Passes through multiplication result. Could have second stage of wallace
 //   tree here.
+// Fused multiply-add
+// - Add/subtract aligned significands, convert to sign/magnitude
+// - Find leading zero to determine normalization shift
+// Reductions
+// - Last two levels of the reduction tree
+// - For floating point sums, convert to sign/magnitude and find leading zero
 //
 
 module fp_execute_stage4(
@@ -55,6 +61,16 @@ module fp_execute_stage4(
     input [NUM_VECTOR_LANES - 1:0]              fx3_mul_underflow,
     input [NUM_VECTOR_LANES - 1:0]              fx3_mul_sign,
 
+    // Fused multiply-add
+    input [NUM_VECTOR_LANES - 1:0][50:0]        fx3_fma_significand_le,
+    input [NUM_VECTOR_LANES - 1:0][50:0]        fx3_fma_significand_se,
+    input [NUM_VECTOR_LANES - 1:0][9:0]         fx3_fma_exponent,
+    input [NUM_VECTOR_LANES - 1:0]              fx3_fma_logical_subtract,
+    input [NUM_VECTOR_LANES - 1:0]              fx3_fma_result_sign,
+
+    // Reductions
+    input [3:0][36:0]                           fx3_reduce_partial,
+
     // To fp_execute_stage5
     output logic                                fx4_instruction_valid,
     output decoded_instruction_t                fx4_instruction,
@@ -76,17 +92,42 @@ module fp_execute_stage4(
     output logic[NUM_VECTOR_LANES - 1:0][63:0]  fx4_significand_product,
     output logic[NUM_VECTOR_LANES - 1:0][7:0]   fx4_mul_exponent,
     output logic[NUM_VECTOR_LANES - 1:0]        fx4_mul_underflow,
-    output logic[NUM_VECTOR_LANES - 1:0]        fx4_mul_sign);
+    output logic[NUM_VECTOR_LANES - 1:0]        fx4_mul_sign,
+
+    // Fused multiply-add
+    output logic[NUM_VECTOR_LANES - 1:0][51:0]  fx4_fma_significand,
+    output logic[NUM_VECTOR_LANES - 1:0][5:0]   fx4_fma_norm_shift,
+    output logic[NUM_VECTOR_LANES - 1:0][9:0]   fx4_fma_exponent,
+    output logic[NUM_VECTOR_LANES - 1:0]        fx4_fma_result_sign,
+
+    // Reductions
+    output logic[35:0]                          fx4_reduce_value,
+    output logic                                fx4_reduce_sign,
+    output logic[5:0]                           fx4_reduce_norm_shift);
 
     logic ftoi;
+    logic reduce_min;
+    logic reduce_max;
+    logic[36:0] reduce_result;
+    logic reduce_negative;
+    logic[35:0] reduce_magnitude;
+    logic[5:0] reduce_leading_zeroes;
 
     assign ftoi = fx3_instruction.alu_op == OP_FTOI;
+    assign reduce_min = fx3_instruction.alu_op == OP_REDUCE_MIN_F
+        || fx3_instruction.alu_op == OP_REDUCE_MIN_I;
+    assign reduce_max = fx3_instruction.alu_op == OP_REDUCE_MAX_F
+        || fx3_instruction.alu_op == OP_REDUCE_MAX_I;
 
     genvar lane_idx;
     generate
         for (lane_idx = 0; lane_idx < NUM_VECTOR_LANES; lane_idx++)
         begin : lane_logic_gen
             logic[5:0] leading_zeroes;
+            logic[51:0] fma_sum;
+            logic fma_negative;
+            logic[51:0] fma_magnitude;
+            logic[5:0] fma_leading_zeroes;
 
             // Determine normalization shift count for add/sub.
             always_comb
@@ -133,6 +174,42 @@ module fp_execute_stage4(
                 endcase
             end
 
+            // Fused multiply-add. The addend may be larger than the product, even
+            // though it has a smaller exponent (or vice versa), so a subtraction
+            // may produce a negative value.
+            assign fma_sum = fx3_fma_logical_subtract[lane_idx]
+                ? {1'b0, fx3_fma_significand_le[lane_idx]} - {1'b0, fx3_fma_significand_se[lane_idx]}
+                : {1'b0, fx3_fma_significand_le[lane_idx]} + {1'b0, fx3_fma_significand_se[lane_idx]};
+            assign fma_negative = fx3_fma_logical_subtract[lane_idx] && fma_sum[51];
+            assign fma_magnitude = fma_negative ? -fma_sum : fma_sum;
+
+            always_comb
+            begin
+                fma_leading_zeroes = 6'd52;
+                for (int bit_idx = 0; bit_idx < 52; bit_idx++)
+                begin
+                    if (fma_magnitude[bit_idx])
+                        fma_leading_zeroes = 6'(51 - bit_idx);
+                end
+            end
+
+            always_ff @(posedge clk)
+            begin
+                fx4_fma_significand[lane_idx] <= fma_magnitude;
+                fx4_fma_norm_shift[lane_idx] <= fma_leading_zeroes;
+                fx4_fma_exponent[lane_idx] <= fx3_fma_exponent[lane_idx];
+
+                // IEEE754-2008, 6.3: an exact zero sum of operands with opposite
+                // signs is +0. If both are zero with the same sign, keep it.
+                if (fma_magnitude == 0)
+                begin
+                    fx4_fma_result_sign[lane_idx] <= !fx3_fma_logical_subtract[lane_idx]
+                        && fx3_fma_result_sign[lane_idx];
+                end
+                else
+                    fx4_fma_result_sign[lane_idx] <= fx3_fma_result_sign[lane_idx] ^ fma_negative;
+            end
+
             always_ff @(posedge clk)
             begin
                 fx4_add_significand[lane_idx] <= fx3_add_significand[lane_idx];
@@ -151,6 +228,48 @@ module fp_execute_stage4(
         end
     endgenerate
 
+    // Reductions. Combine the four partial results. The sum is exact and
+    // fits in 37 bits, so the two's complement sign is the top bit.
+    always_comb
+    begin
+        reduce_result = fx3_reduce_partial[0];
+        for (int group = 1; group < 4; group++)
+        begin
+            if (reduce_min)
+            begin
+                if (fx3_reduce_partial[group] < reduce_result)
+                    reduce_result = fx3_reduce_partial[group];
+            end
+            else if (reduce_max)
+            begin
+                if (fx3_reduce_partial[group] > reduce_result)
+                    reduce_result = fx3_reduce_partial[group];
+            end
+            else
+                reduce_result = reduce_result + fx3_reduce_partial[group];
+        end
+    end
+
+    assign reduce_negative = fx3_instruction.alu_op == OP_REDUCE_ADD_F && reduce_result[36];
+    assign reduce_magnitude = reduce_negative ? 36'(-reduce_result) : reduce_result[35:0];
+
+    always_comb
+    begin
+        reduce_leading_zeroes = 6'd36;
+        for (int bit_idx = 0; bit_idx < 36; bit_idx++)
+        begin
+            if (reduce_magnitude[bit_idx])
+                reduce_leading_zeroes = 6'(35 - bit_idx);
+        end
+    end
+
+    always_ff @(posedge clk)
+    begin
+        fx4_reduce_value <= reduce_magnitude;
+        fx4_reduce_sign <= reduce_negative;
+        fx4_reduce_norm_shift <= reduce_leading_zeroes;
+    end
+
     always_ff @(posedge clk)
     begin
         fx4_instruction <= fx3_instruction;
@@ -24,6 +24,11 @@ import defines::*;
 // Floating point addition/multiplication
 // - Normalization shift
 // - Post normalization rounding (for addition overflow)
+// Fused multiply-add/floating point sum reduction
+// - Normalization shift and rounding
+// Reductions
+// - Convert min/max keys back to values. The result is written to every
+//   lane, but only the first is used.
 //
 
 module fp_execute_stage5(
@@ -53,6 +58,17 @@ module fp_execute_stage5(
     input [NUM_VECTOR_LANES - 1:0]          fx4_mul_underflow,
     input [NUM_VECTOR_LANES - 1:0]          fx4_mul_sign,
 
+    // Fused multiply-add
+    input [NUM_VECTOR_LANES - 1:0][51:0]    fx4_fma_significand,
+    input [NUM_VECTOR_LANES - 1:0][5:0]     fx4_fma_norm_shift,
+    input [NUM_VECTOR_LANES - 1:0][9:0]     fx4_fma_exponent,
+    input [NUM_VECTOR_LANES - 1:0]          fx4_fma_result_sign,
+
+    // Reductions
+    input [35:0]                            fx4_reduce_value,
+    input                                   fx4_reduce_sign,
+    input [5:0]                             fx4_reduce_norm_shift,
+
     // To writeback_stage
     output logic                            fx5_instruction_valid,
     output decoded_instruction_t            fx5_instruction,
@@ -65,8 +81,18 @@ module fp_execute_stage5(
     logic imull;
     logic imulh;
     logic ftoi;
+    logic fma;
+    logic[35:0] reduce_normalized;
+    logic[22:0] reduce_significand;
+    logic[22:0] reduce_rounded_significand;
+    logic reduce_do_round;
+    logic[9:0] reduce_unrounded_exponent;
+    logic[9:0] reduce_exponent;
+    scalar_t reduce_sum_result;
+    scalar_t reduce_result;
 
     assign fmul = fx4_instruction.alu_op == OP_MUL_F;
+    assign fma = fx4_instruction.alu_op == OP_MLA_F;
     assign imull = fx4_instruction.alu_op == OP_MULL_I;
     assign imulh = fx4_instruction.alu_op == OP_MULH_U || fx4_instruction.alu_op == OP_MULH_I;
     assign ftoi = fx4_instruction.alu_op == OP_FTOI;
@@ -99,6 +125,13 @@ module fp_execute_stage5(
             logic sum_zero;
             logic mul_hidden_bit;
             logic mul_round_overflow;
+            logic[51:0] fma_normalized;
+            logic[22:0] fma_significand;
+            logic[22:0] fma_rounded_significand;
+            logic fma_do_round;
+            logic[9:0] fma_unrounded_exponent;
+            logic[9:0] fma_exponent;
+            scalar_t fma_result;
 
             assign adjusted_add_exponent = fx4_add_exponent[lane_idx]
                 - FLOAT32_EXP_WIDTH'(fx4_norm_shift[lane_idx]) + FLOAT32_EXP_WIDTH'(8);
@@ -182,9 +215,43 @@ module fp_execute_stage5(
                     fmul_result = {fx4_mul_sign[lane_idx], mul_exponent, mul_rounded_significand};
             end
 
+            // Fused multiply-add. The leading one of an unnormalized sum of value 1.0
+            // is at bit 49, so the exponent is adjusted by that amount. Round to
+            // nearest, ties to even. Whether the result is subnormal (and flushes
+            // to zero) depends on the exponent before rounding, so a value just
+            // below the smallest normal that rounds up to it still flushes.
+            assign fma_normalized = fx4_fma_significand[lane_idx] << fx4_fma_norm_shift[lane_idx];
+            assign fma_significand = fma_normalized[50:28];
+            assign fma_do_round = fma_normalized[27] && (|fma_normalized[26:0] || fma_significand[0]);
+            assign fma_rounded_significand = fma_significand + FLOAT32_SIG_WIDTH'(fma_do_round);
+            assign fma_unrounded_exponent = fx4_fma_exponent[lane_idx] + 10'd2
+                - 10'(fx4_fma_norm_shift[lane_idx]);
+            assign fma_exponent = fma_unrounded_exponent
+                + 10'(fma_do_round && fma_rounded_significand == 0);
+
+            always_comb
+            begin
+                if (fx4_result_nan[lane_idx])
+                    fma_result = 32'h7fffffff;
+                else if (fx4_result_inf[lane_idx])
+                    fma_result = {fx4_add_result_sign[lane_idx], 8'hff, 23'd0};
+                else if (fx4_fma_significand[lane_idx] == 0)
+                    fma_result = {fx4_fma_result_sign[lane_idx], 31'd0};
+                else if ($signed(fma_exponent) >= 10'sd255)
+                    fma_result = {fx4_fma_result_sign[lane_idx], 8'hff, 23'd0};
+                else if ($signed(fma_unrounded_exponent) <= 10'sd0)
+                    fma_result = {fx4_fma_result_sign[lane_idx], 31'd0};    // Subnormal results flush to zero
+                else
+                    fma_result = {fx4_fma_result_sign[lane_idx], fma_exponent[7:0], fma_rounded_significand};
+            end
+
             always_ff @(posedge clk)
             begin
-                if (ftoi)
+                if (fx4_instruction.reduce)
+                    fx5_result[lane_idx] <= reduce_result;
+                else if (fma)
+                    fx5_result[lane_idx] <= fma_result;
+                else if (ftoi)
                 begin
                     if (fx4_result_nan[lane_idx])
                         fx5_result[lane_idx] <= 32'h80000000;    // nan signal indicates an invalid conversion
@@ -205,6 +272,52 @@ module fp_execute_stage5(
         end
     endgenerate
 
+    // Floating point sum reduction. The sum is scaled so a value with the
+    // largest exponent of 1.0 has its leading one at bit 31. Round to nearest,
+    // ties to even. As with fused multiply-add, subnormal results are detected
+    // before rounding.
+    assign reduce_normalized = fx4_reduce_value << fx4_reduce_norm_shift;
+    assign reduce_significand = reduce_normalized[34:12];
+    assign reduce_do_round = reduce_normalized[11] && (|reduce_normalized[10:0] || reduce_significand[0]);
+    assign reduce_rounded_significand = reduce_significand + FLOAT32_SIG_WIDTH'(reduce_do_round);
+    assign reduce_unrounded_exponent = 10'(fx4_add_exponent[0]) + 10'd4
+        - 10'(fx4_reduce_norm_shift);
+    assign reduce_exponent = reduce_unrounded_exponent
+        + 10'(reduce_do_round && reduce_rounded_significand == 0);
+
+    always_comb
+    begin
+        if (fx4_result_nan[0])
+            reduce_sum_result = 32'h7fffffff;
+        else if (fx4_result_inf[0])
+            reduce_sum_result = {fx4_add_result_sign[0], 8'hff, 23'd0};
+        else if (fx4_reduce_value == 0)
+            reduce_sum_result = 32'h00000000;
+        else if ($signed(reduce_exponent) >= 10'sd255)
+            reduce_sum_result = {fx4_reduce_sign, 8'hff, 23'd0};
+        else if ($signed(reduce_unrounded_exponent) <= 10'sd0)
+            reduce_sum_result = {fx4_reduce_sign, 31'd0};    // Subnormal results flush to zero
+        else
+            reduce_sum_result = {fx4_reduce_sign, reduce_exponent[7:0], reduce_rounded_significand};
+    end
+
+    always_comb
+    begin
+        unique case (fx4_instruction.alu_op)
+            OP_REDUCE_ADD_F: reduce_result = reduce_sum_result;
+            OP_REDUCE_MIN_I, OP_REDUCE_MAX_I: reduce_result = fx4_reduce_value[31:0] ^ 32'h80000000;
+            OP_REDUCE_MIN_F, OP_REDUCE_MAX_F:
+            begin
+                if (fx4_reduce_value[31])
+                    reduce_result = fx4_reduce_value[31:0] & 32'h7fffffff;
+                else
+                    reduce_result = ~fx4_reduce_value[31:0];
+            end
+
+            default: reduce_result = fx4_reduce_value[31:0];    // OP_REDUCE_ADD_I
+        endcase
+    end
+
     always_ff @(posedge clk)
     begin
         fx5_instruction <= fx4_instruction;
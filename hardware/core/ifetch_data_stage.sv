@@ -24,6 +24,7 @@ import defines::*;
 //   the contents of the cache line.
 // - Drives signals to update LRU in previous stage
 // - Detects alignment fault and TLB misses.
+// - Signals ifetch_prefetcher when a fetch misses or hits a prefetched line.
 //
 
 module ifetch_data_stage(
@@ -43,10 +44,14 @@ module ifetch_data_stage(
     input                            ift_tlb_supervisor,
     input l1i_tag_t                  ift_tag[`L1I_WAYS],
     input                            ift_valid[`L1I_WAYS],
+    input                            ift_prefetched[`L1I_WAYS],
+    input                            ift_branch_predicted,
+    input scalar_t                   ift_predicted_target,
 
     // To ifetch_tag_stage
     output logic                     ifd_update_lru_en,
     output l1i_way_idx_t             ifd_update_lru_way,
+    output logic                     ifd_prefetch_hit,
     output logic                     ifd_near_miss,
 
     // From l1_l2_interface
@@ -77,6 +82,12 @@ module ifetch_data_stage(
     output logic                     ifd_page_fault,
     output logic                     ifd_executable_fault,
     output logic                     ifd_inst_injected,
+    output logic                     ifd_branch_predicted,
+    output scalar_t                  ifd_predicted_target,
+
+    // From instruction_decode_stage
+    input                            id_redirect_en,
+    input local_thread_idx_t         id_redirect_thread_idx,
 
     // From writeback_stage
     input                            wb_rollback_en,
@@ -86,6 +97,7 @@ module ifetch_data_stage(
     output logic                     ifd_perf_icache_hit,
     output logic                     ifd_perf_icache_miss,
     output logic                     ifd_perf_itlb_miss,
+    output logic                     ifd_perf_icache_prefetch_hit,
 
     // from core
     input                            core_selected_debug,
@@ -106,8 +118,9 @@ module ifetch_data_stage(
     logic squash_instruction;
     logic ocd_halt_latched;
 
-    assign squash_instruction = wb_rollback_en && wb_rollback_thread_idx
-        == ift_thread_idx;
+    assign squash_instruction = (wb_rollback_en && wb_rollback_thread_idx
+        == ift_thread_idx) || (id_redirect_en && id_redirect_thread_idx
+        == ift_thread_idx);
 
     //
     // Check for cache hit
@@ -174,9 +187,17 @@ module ifetch_data_stage(
     assign ifd_update_lru_en = cache_hit && ift_instruction_requested;
     assign ifd_update_lru_way = way_hit_idx;
 
+    // The first fetch to hit a line that was prefetched. ifetch_tag_stage
+    // clears the prefetched flag for the line (in way ifd_update_lru_way).
+    assign ifd_prefetch_hit = cache_hit
+        && ift_instruction_requested
+        && !squash_instruction
+        && ift_prefetched[way_hit_idx];
+
     always_ff @(posedge clk)
     begin
         ifd_pc <= ift_pc_vaddr;
+        ifd_predicted_target <= ift_predicted_target;
         ifd_thread_idx <= ocd_halt ? ocd_thread : ift_thread_idx;
     end
 
@@ -187,12 +208,14 @@ module ifetch_data_stage(
             /*AUTORESET*/
             // Beginning of autoreset for uninitialized flops
             ifd_alignment_fault <= '0;
+            ifd_branch_predicted <= '0;
             ifd_executable_fault <= '0;
             ifd_inst_injected <= '0;
             ifd_instruction_valid <= '0;
             ifd_page_fault <= '0;
             ifd_perf_icache_hit <= '0;
             ifd_perf_icache_miss <= '0;
+            ifd_perf_icache_prefetch_hit <= '0;
             ifd_perf_itlb_miss <= '0;
             ifd_supervisor_fault <= '0;
             ifd_tlb_miss <= '0;
@@ -210,6 +233,7 @@ module ifetch_data_stage(
             begin
                 ifd_instruction_valid <= ocd_inject_en && core_selected_debug;
                 ifd_inst_injected <= 1;
+                ifd_branch_predicted <= 0;
                 ifd_alignment_fault <= 0;
                 ifd_supervisor_fault <= 0;
                 ifd_tlb_miss <= 0;
@@ -223,6 +247,8 @@ module ifetch_data_stage(
                 ifd_instruction_valid <= ift_instruction_requested && !squash_instruction
                     && cache_hit && ift_tlb_hit;
                 ifd_inst_injected <= 0;
+                ifd_branch_predicted <= ift_instruction_requested && !squash_instruction
+                    && cache_hit && ift_tlb_hit && ift_branch_predicted;
                 ifd_alignment_fault <= ift_instruction_requested && !squash_instruction
                     && alignment_fault;
                 ifd_supervisor_fault <= ift_instruction_requested && !squash_instruction
@@ -251,6 +277,7 @@ module ifetch_data_stage(
                     && ift_instruction_requested
                     && !squash_instruction;
                 ifd_perf_itlb_miss <= ift_instruction_requested && !ift_tlb_hit;
+                ifd_perf_icache_prefetch_hit <= ifd_prefetch_hit;
             end
         end
     end
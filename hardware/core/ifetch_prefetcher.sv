@@ -0,0 +1,83 @@
+//
+// Copyright 2018 Jeff Bush
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+`include "defines.svh"
+
+import defines::*;
+
+//
+// L1 instruction cache next-line prefetcher.
+// When an instruction fetch misses the cache, or is the first to hit a line
+// that a prefetch brought in, this requests the following cache line. Code
+// that runs sequentially then finds the next line already resident (or in
+// flight) when it gets there. Addresses are physical, so prefetches don't
+// cross page boundaries.
+//
+// This holds one request until l1_load_miss_queue accepts it. A new
+// prefetch replaces one that hasn't been accepted yet.
+//
+
+module ifetch_prefetcher(
+    input                               clk,
+    input                               reset,
+
+    // From control_registers
+    input prefetch_control_t            cr_prefetch_control,
+
+    // From ifetch_data_stage
+    input                               ifd_cache_miss,
+    input cache_line_index_t            ifd_cache_miss_paddr,
+    input local_thread_idx_t            ifd_cache_miss_thread_idx,
+    input                               ifd_prefetch_hit,
+
+    // To/from l1_load_miss_queue
+    output logic                        ipf_request_valid,
+    output cache_line_index_t           ipf_request_addr,
+    output local_thread_idx_t           ipf_request_thread_idx,
+    input                               ipf_request_ack);
+
+    localparam LINES_PER_PAGE_WIDTH = $clog2(PAGE_SIZE / CACHE_LINE_BYTES);
+
+    logic trigger;
+    logic last_line_in_page;
+
+    assign trigger = cr_prefetch_control.icache_en && (ifd_cache_miss || ifd_prefetch_hit);
+    assign last_line_in_page = &ifd_cache_miss_paddr[LINES_PER_PAGE_WIDTH - 1:0];
+
+    always_ff @(posedge clk, posedge reset)
+    begin
+        if (reset)
+        begin
+            /*AUTORESET*/
+            // Beginning of autoreset for uninitialized flops
+            ipf_request_addr <= '0;
+            ipf_request_thread_idx <= '0;
+            ipf_request_valid <= '0;
+            // End of automatics
+        end
+        else
+        begin
+            if (trigger && !last_line_in_page)
+            begin
+                ipf_request_valid <= 1;
+                ipf_request_addr <= ifd_cache_miss_paddr + cache_line_index_t'(1);
+                ipf_request_thread_idx <= ifd_cache_miss_thread_idx;
+            end
+            else if (ipf_request_ack)
+                ipf_request_valid <= 0;
+        end
+    end
+endmodule
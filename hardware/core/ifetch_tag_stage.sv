@@ -25,8 +25,14 @@ import defines::*;
 //   thread every cycle whenever possible.
 // - Reads instruction cache tag memory to determine if the cache line is
 //   resident.
+// - Reads tag memory for l1_l2_interface when a fill arrives, so a line that
+//   is already resident (because a prefetch requested it) isn't filled into
+//   a second way.
 // - Reads translation lookaside buffer to translate from virtual to physical
 //   address.
+// - Looks up the PC in the branch predictor. If it is a branch that is
+//   predicted taken, the next fetch for this thread is from the branch
+//   destination.
 //
 
 module ifetch_tag_stage
@@ -38,6 +44,7 @@ module ifetch_tag_stage
     // From ifetch_data_stage
     input                               ifd_update_lru_en,
     input l1i_way_idx_t                 ifd_update_lru_way,
+    input                               ifd_prefetch_hit,
     input                               ifd_cache_miss,
     input                               ifd_near_miss,
     input local_thread_idx_t            ifd_cache_miss_thread_idx,
@@ -53,6 +60,9 @@ module ifetch_tag_stage
     output logic                        ift_tlb_supervisor,
     output l1i_tag_t                    ift_tag[`L1I_WAYS],
     output logic                        ift_valid[`L1I_WAYS],
+    output logic                        ift_prefetched[`L1I_WAYS],
+    output logic                        ift_branch_predicted,
+    output scalar_t                     ift_predicted_target,
 
     // From l1_l2_interface
     input                               l2i_icache_lru_fill_en,
@@ -61,8 +71,13 @@ module ifetch_tag_stage
     input l1i_set_idx_t                 l2i_itag_update_set,
     input l1i_tag_t                     l2i_itag_update_tag,
     input                               l2i_itag_update_valid,
+    input                               l2i_itag_update_prefetched,
     input local_thread_bitmap_t         l2i_icache_wake_bitmap,
+    input                               l2i_isnoop_en,
+    input l1i_set_idx_t                 l2i_isnoop_set,
     output l1i_way_idx_t                ift_fill_lru,
+    output logic                        ift_snoop_valid[`L1I_WAYS],
+    output l1i_tag_t                    ift_snoop_tag[`L1I_WAYS],
 
     // From control_registers
     input                               cr_mmu_en[`THREADS_PER_CORE],
@@ -76,10 +91,22 @@ module ifetch_tag_stage
     input                               dt_update_itlb_en,
     input                               dt_update_itlb_supervisor,
     input                               dt_update_itlb_global,
+    input                               dt_update_itlb_superpage,
     input                               dt_update_itlb_present,
     input                               dt_update_itlb_executable,
     input page_index_t                  dt_update_itlb_ppage_idx,
 
+    // From instruction_decode_stage
+    input                               id_redirect_en,
+    input local_thread_idx_t            id_redirect_thread_idx,
+    input scalar_t                      id_redirect_pc,
+
+    // From int_execute_stage
+    input                               ix_branch_resolved,
+    input                               ix_branch_taken,
+    input decoded_instruction_t         ix_instruction,
+    input scalar_t                      ix_rollback_pc,
+
     // From writeback_stage
     input                               wb_rollback_en,
     input local_thread_idx_t            wb_rollback_thread_idx,
@@ -112,6 +139,8 @@ module ifetch_tag_stage
     logic tlb_executable;
     page_index_t request_vpage_idx;
     logic[ASID_WIDTH - 1:0] request_asid;
+    logic predict_taken;
+    scalar_t predict_target;
 
     initial
     begin
@@ -147,6 +176,12 @@ module ifetch_tag_stage
 
     //
     // Program counter update logic
+    // When instruction_decode_stage finds a prediction was wrong, the instructions
+    // this thread fetched after it are discarded (like a rollback) and it
+    // continues at the following instruction. A cache miss retries the
+    // instruction that missed. Because the PC after it may have been a
+    // predicted branch destination, this restores the PC of the missed fetch
+    // rather than backing up by one instruction.
     //
     genvar thread_idx;
     generate
@@ -158,16 +193,46 @@ module ifetch_tag_stage
                     next_program_counter[thread_idx] <= RESET_PC;
                 else if (wb_rollback_en && wb_rollback_thread_idx == local_thread_idx_t'(thread_idx))
                     next_program_counter[thread_idx] <= wb_rollback_pc;
+                else if (id_redirect_en && id_redirect_thread_idx == local_thread_idx_t'(thread_idx))
+                    next_program_counter[thread_idx] <= id_redirect_pc;
                 else if ((ifd_cache_miss || ifd_near_miss) && last_selected_thread_oh[thread_idx])
-                    next_program_counter[thread_idx] <= next_program_counter[thread_idx] - 4;
+                    next_program_counter[thread_idx] <= last_selected_pc;
                 else if (selected_thread_oh[thread_idx] && cache_fetch_en)
-                    next_program_counter[thread_idx] <= next_program_counter[thread_idx] + 4;
+                begin
+                    if (predict_taken)
+                        next_program_counter[thread_idx] <= predict_target;
+                    else
+                        next_program_counter[thread_idx] <= next_program_counter[thread_idx] + 4;
+                end
             end
         end
     endgenerate
 
     assign pc_to_fetch = next_program_counter[ocd_halt ? ocd_thread : selected_thread_idx];
 
+    //
+    // Branch prediction
+    //
+    generate
+        if (`BTB_ENTRIES > 0)
+        begin : branch_predictor_gen
+            branch_predictor #(.NUM_ENTRIES(`BTB_ENTRIES)) branch_predictor(
+                .lookup_pc(pc_to_fetch),
+                .lookup_taken(predict_taken),
+                .lookup_target(predict_target),
+                .update_en(ix_branch_resolved),
+                .update_pc(ix_instruction.pc),
+                .update_taken(ix_branch_taken),
+                .update_target(ix_rollback_pc),
+                .*);
+        end
+        else
+        begin : no_branch_predictor_gen
+            assign predict_taken = 0;
+            assign predict_target = 0;
+        end
+    endgenerate
+
     //
     // Cache way metadata
     //
@@ -176,17 +241,27 @@ module ifetch_tag_stage
         for (way_idx = 0; way_idx < `L1I_WAYS; way_idx++)
         begin : way_tag_gen
             // Valid flags are flops instead of SRAM because they need
-            // to simultaneously be cleared on reset.
+            // to simultaneously be cleared on reset. line_prefetched is set
+            // when a prefetch fills a line and cleared by the first fetch
+            // that hits it.
             logic line_valid[`L1I_SETS];
+            logic line_prefetched[`L1I_SETS];
+            logic prefetch_hit_this_way;
+
+            assign prefetch_hit_this_way = ifd_prefetch_hit
+                && ifd_update_lru_way == l1i_way_idx_t'(way_idx);
 
-            sram_1r1w #(
+            sram_2r1w #(
                 .DATA_WIDTH($bits(l1i_tag_t)),
                 .SIZE(`L1I_SETS),
                 .READ_DURING_WRITE("NEW_DATA")
             ) sram_tags(
-                .read_en(cache_fetch_en),
-                .read_addr(pc_to_fetch.set_idx),
-                .read_data(ift_tag[way_idx]),
+                .read1_en(cache_fetch_en),
+                .read1_addr(pc_to_fetch.set_idx),
+                .read1_data(ift_tag[way_idx]),
+                .read2_en(l2i_isnoop_en),
+                .read2_addr(l2i_isnoop_set),
+                .read2_data(ift_snoop_tag[way_idx]),
                 .write_en(l2i_itag_update_en[way_idx]),
                 .write_addr(l2i_itag_update_set),
                 .write_data(l2i_itag_update_tag),
@@ -197,12 +272,22 @@ module ifetch_tag_stage
                 if (reset)
                 begin
                     for (int set_idx = 0; set_idx < `L1I_SETS; set_idx++)
+                    begin
                         line_valid[set_idx] <= 0;
+                        line_prefetched[set_idx] <= 0;
+                    end
                 end
                 else
                 begin
+                    if (prefetch_hit_this_way)
+                        line_prefetched[ift_pc_paddr.set_idx] <= 0;
+
+                    // A fill takes precedence if it is to the same line
                     if (l2i_itag_update_en[way_idx])
+                    begin
                         line_valid[l2i_itag_update_set] <= l2i_itag_update_valid;
+                        line_prefetched[l2i_itag_update_set] <= l2i_itag_update_prefetched;
+                    end
                 end
             end
 
@@ -210,9 +295,27 @@ module ifetch_tag_stage
             begin
                 // Fetch cache line state for pipeline
                 if (l2i_itag_update_en[way_idx] && l2i_itag_update_set == pc_to_fetch.set_idx)
-                    ift_valid[way_idx] <= l2i_itag_update_valid;    // Bypass
+                begin
+                    // Bypass
+                    ift_valid[way_idx] <= l2i_itag_update_valid;
+                    ift_prefetched[way_idx] <= l2i_itag_update_prefetched;
+                end
                 else
+                begin
                     ift_valid[way_idx] <= line_valid[pc_to_fetch.set_idx];
+                    ift_prefetched[way_idx] <= line_prefetched[pc_to_fetch.set_idx]
+                        && !(prefetch_hit_this_way
+                        && ift_pc_paddr.set_idx == pc_to_fetch.set_idx);
+                end
+
+                // Fetch cache line state for snoop
+                if (l2i_isnoop_en)
+                begin
+                    if (l2i_itag_update_en[way_idx] && l2i_itag_update_set == l2i_isnoop_set)
+                        ift_snoop_valid[way_idx] <= l2i_itag_update_valid;    // Bypass
+                    else
+                        ift_snoop_valid[way_idx] <= line_valid[l2i_isnoop_set];
+                end
             end
         end
     endgenerate
@@ -234,7 +337,8 @@ module ifetch_tag_stage
 
     tlb #(
         .NUM_ENTRIES(`ITLB_ENTRIES),
-        .NUM_WAYS(`TLB_WAYS)
+        .NUM_WAYS(`TLB_WAYS),
+        .NUM_SUPERPAGE_ENTRIES(`TLB_SUPERPAGE_ENTRIES)
     ) itlb(
         .lookup_en(cache_fetch_en),
         .update_en(dt_update_itlb_en),
@@ -242,6 +346,7 @@ module ifetch_tag_stage
         .update_exe_writable(dt_update_itlb_executable),
         .update_supervisor(dt_update_itlb_supervisor),
         .update_global(dt_update_itlb_global),
+        .update_superpage(dt_update_itlb_superpage),
         .invalidate_en(dt_invalidate_tlb_en),
         .invalidate_all_en(dt_invalidate_tlb_all_en),
         .update_ppage_idx(dt_update_itlb_ppage_idx),
@@ -317,13 +422,16 @@ module ifetch_tag_stage
             icache_wait_threads <= icache_wait_threads_nxt;
             ift_instruction_requested <= cache_fetch_en
                 && !((ifd_cache_miss || ifd_near_miss) && ifd_cache_miss_thread_idx == selected_thread_idx)
-                && !(wb_rollback_en && wb_rollback_thread_idx == selected_thread_idx);
+                && !(wb_rollback_en && wb_rollback_thread_idx == selected_thread_idx)
+                && !(id_redirect_en && id_redirect_thread_idx == selected_thread_idx);
         end
     end
 
     always_ff @(posedge clk)
     begin
         last_selected_pc <= pc_to_fetch;
+        ift_branch_predicted <= predict_taken;
+        ift_predicted_target <= predict_target;
         ift_thread_idx <= selected_thread_idx;
         last_selected_thread_oh <= selected_thread_oh;
     end
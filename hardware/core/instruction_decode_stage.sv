@@ -35,6 +35,13 @@ import defines::*;
 // - There may be pending instructions in the pipeline for the thread that
 //   will cause a rollback in a subsequent cycle.
 //
+// This also checks branch predictions. The branch predictor entry that
+// redirected a fetch may be for different code that was at the same address.
+// If the instruction isn't a PC relative branch to the address that was
+// fetched after it, this discards the instructions the thread fetched since
+// and restarts fetch at the next instruction (id_redirect_en). Otherwise it
+// marks the branch as predicted, and int_execute_stage checks the direction.
+//
 // Register port to operand mapping
 //                                               store
 //       format           op1     op2    mask    value
@@ -67,6 +74,13 @@ module instruction_decode_stage(
     input                         ifd_page_fault,
     input                         ifd_executable_fault,
     input                         ifd_tlb_miss,
+    input                         ifd_branch_predicted,
+    input scalar_t                ifd_predicted_target,
+
+    // To ifetch_tag_stage/ifetch_data_stage
+    output logic                  id_redirect_en,
+    output local_thread_idx_t     id_redirect_thread_idx,
+    output scalar_t               id_redirect_pc,
 
     // From dcache_data_stage
     input local_thread_bitmap_t   dd_load_sync_pending,
@@ -82,6 +96,9 @@ module instruction_decode_stage(
     // From io_request_queue
     input local_thread_bitmap_t   ior_pending,
 
+    // From int_divider
+    input local_thread_bitmap_t   idv_pending,
+
     // From control_registers
     input local_thread_bitmap_t   cr_interrupt_en,
     input local_thread_bitmap_t   cr_interrupt_pending,
@@ -144,6 +161,8 @@ module instruction_decode_stage(
     logic fmt_m;
     logic getlane;
     logic compare;
+    logic reduce;
+    logic divide;
     alu_op_t alu_op;
     memory_op_t memory_access_type;
     register_idx_t scalar_sel2;
@@ -153,6 +172,8 @@ module instruction_decode_stage(
     logic raise_interrupt;
     local_thread_bitmap_t masked_interrupt_flags;
     logic unary_arith;
+    logic pc_relative_branch;
+    logic prediction_correct;
 
     // I originally tried to structure the instruction set so that this could
     // determine the format of the instruction from the first 7 bits. Those
@@ -231,6 +252,21 @@ module instruction_decode_stage(
     assign fmt_m = ifd_instruction[31:30] == 2'b10;
     assign getlane = (fmt_r || fmt_i) && alu_op == OP_GETLANE;
 
+    // Reductions are unary: the source vector is in the src2 field.
+    assign reduce = fmt_r && (alu_op == OP_REDUCE_ADD_F
+        || alu_op == OP_REDUCE_MIN_F
+        || alu_op == OP_REDUCE_MAX_F
+        || alu_op == OP_REDUCE_ADD_I
+        || alu_op == OP_REDUCE_MIN_I
+        || alu_op == OP_REDUCE_MAX_I);
+
+    // Divides are in the floating point range of opcodes, but are executed
+    // by the integer divider attached to int_execute_stage.
+    assign divide = fmt_r && (alu_op == OP_DIV_I
+        || alu_op == OP_DIV_U
+        || alu_op == OP_REM_I
+        || alu_op == OP_REM_U);
+
     assign syscall = fmt_i && 6'(ifd_instruction[28:24]) == OP_SYSCALL;
     assign breakpoint = fmt_r && ifd_instruction[25:20] == OP_BREAKPOINT;
     assign nop = ifd_instruction == INSTRUCTION_NOP;
@@ -270,14 +306,14 @@ module instruction_decode_stage(
     assign decoded_instr_nxt.injected = ifd_inst_injected;
 
     // Subtle: Certain instructions need to be issued twice, including I/O
-    // requests and synchronized memory accesses. The first queues the
-    // transaction and the second collects the result. Because the first
+    // requests, integer divides, and synchronized memory accesses. The first
+    // queues the transaction and the second collects the result. Because the first
     // instruction updates internal state, bad things would happen if an
     // interrupt were dispatched between them. To avoid this, don't dispatch
     // an interrupt if the first instruction has been issued (indicated by
-    // dd_load_sync_pending, ior_pending, or sq_store_sync_pending).
+    // dd_load_sync_pending, ior_pending, idv_pending, or sq_store_sync_pending).
     assign masked_interrupt_flags = cr_interrupt_pending & cr_interrupt_en
-        & ~ior_pending & ~dd_load_sync_pending & ~sq_store_sync_pending;
+        & ~ior_pending & ~idv_pending & ~dd_load_sync_pending & ~sq_store_sync_pending;
     assign raise_interrupt = masked_interrupt_flags[ifd_thread_idx] && !ocd_halt;
     assign decoded_instr_nxt.has_trap = has_trap;
 
@@ -316,7 +352,8 @@ module instruction_decode_stage(
     end
 
     assign decoded_instr_nxt.scalar_sel2 = scalar_sel2;
-    assign decoded_instr_nxt.has_vector1 = dlut_out.has_vector1 && !nop && !has_trap;
+    assign decoded_instr_nxt.has_vector1 = dlut_out.has_vector1 && !nop && !has_trap
+        && !reduce;
     assign decoded_instr_nxt.vector_sel1 = ifd_instruction[4:0];
     assign decoded_instr_nxt.has_vector2 = dlut_out.has_vector2 && !nop && !has_trap;
     always_comb
@@ -330,7 +367,7 @@ module instruction_decode_stage(
     assign decoded_instr_nxt.has_dest = dlut_out.has_dest && !nop && !has_trap;
 
     assign decoded_instr_nxt.dest_vector = dlut_out.dest_vector && !compare
-        && !getlane;
+        && !getlane && !reduce;
     assign decoded_instr_nxt.dest_reg = dlut_out.call ? REG_RA : ifd_instruction[9:5];
     assign decoded_instr_nxt.call = dlut_out.call;
     always_comb
@@ -379,13 +416,28 @@ module instruction_decode_stage(
         && !has_trap;
     assign decoded_instr_nxt.pc = ifd_pc;
 
+    assign pc_relative_branch = ifd_instruction[31:28] == 4'b1111
+        && (decoded_instr_nxt.branch_type == BRANCH_ZERO
+        || decoded_instr_nxt.branch_type == BRANCH_NOT_ZERO
+        || decoded_instr_nxt.branch_type == BRANCH_ALWAYS
+        || decoded_instr_nxt.branch_type == BRANCH_CALL_OFFSET);
+    assign prediction_correct = pc_relative_branch
+        && !has_trap
+        && ifd_pc + decoded_instr_nxt.immediate_value == ifd_predicted_target;
+    assign decoded_instr_nxt.branch_predicted = ifd_branch_predicted && prediction_correct;
+    assign id_redirect_en = ifd_branch_predicted
+        && !prediction_correct
+        && (!wb_rollback_en || wb_rollback_thread_idx != ifd_thread_idx);
+    assign id_redirect_thread_idx = ifd_thread_idx;
+    assign id_redirect_pc = ifd_pc + 32'd4;
+
     always_comb
     begin
         if (has_trap)
             decoded_instr_nxt.pipeline_sel = PIPE_INT_ARITH;
         else if (fmt_r || fmt_i)
         begin
-            if (alu_op[5] || alu_op == OP_MULL_I || alu_op == OP_MULH_U
+            if ((alu_op[5] && !divide) || alu_op == OP_MULL_I || alu_op == OP_MULH_U
                  || alu_op == OP_MULH_I || alu_op == OP_FTOI)
                 decoded_instr_nxt.pipeline_sel = PIPE_FLOAT_ARITH;
             else
@@ -440,6 +492,10 @@ module instruction_decode_stage(
         || alu_op == OP_CMPEQ_F
         || alu_op == OP_CMPNE_F);
     assign decoded_instr_nxt.compare = compare;
+    assign decoded_instr_nxt.reduce = reduce;
+
+    // Fused multiply-add reads the destination register as the addend
+    assign decoded_instr_nxt.accumulate = fmt_r && alu_op == OP_MLA_F && !nop && !has_trap;
 
     always_ff @(posedge clk)
     begin
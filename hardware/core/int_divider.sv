@@ -0,0 +1,226 @@
+//
+// Copyright 2019 Jeff Bush
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+`include "defines.svh"
+
+import defines::*;
+
+//
+// Iterative integer divider, shared by all threads in a core. It divides all
+// vector lanes in parallel, producing one quotient bit per cycle, so a divide
+// takes 32 cycles. Signed operations divide the magnitudes and fix the signs
+// of the results at the end.
+//
+// Divides are issued twice, like I/O requests. When int_execute_stage sees
+// a divide and the divider is idle, it starts the operation here, then rolls
+// back and suspends the thread. When the result is ready, this wakes the
+// thread, which reissues the instruction and collects the result. If the
+// divider is in use by another thread, the thread is also rolled back and
+// suspended, and is woken when the divider is free. The divider remembers the
+// PC of the instruction that started it, and starts over if the owning thread
+// issues a different divide. If the owning thread is halted or takes a trap
+// before it collects the result, the result is discarded so other threads can
+// use the divider.
+//
+// Division by zero returns a quotient with all bits set and a remainder equal
+// to the dividend. Dividing the most negative integer by -1 returns the
+// dividend with a remainder of zero.
+//
+
+module int_divider(
+    input                           clk,
+    input                           reset,
+
+    // From operand_fetch_stage
+    input vector_t                  of_operand1,
+    input vector_t                  of_operand2,
+    input decoded_instruction_t     of_instruction,
+    input local_thread_idx_t        of_thread_idx,
+
+    // From int_execute_stage
+    input                           ix_divide_en,
+
+    // From writeback_stage
+    input                           wb_trap,
+    input local_thread_idx_t        wb_rollback_thread_idx,
+
+    // From nyuzi
+    input local_thread_bitmap_t     thread_en,
+
+    // To int_execute_stage
+    output logic                    idv_result_valid,
+    output vector_t                 idv_result,
+
+    // To instruction_decode_stage
+    output local_thread_bitmap_t    idv_pending,
+
+    // To thread_select_stage
+    output local_thread_bitmap_t    idv_wake_bitmap);
+
+    typedef enum logic[1:0] {
+        DIV_IDLE,
+        DIV_BUSY,
+        DIV_DONE
+    } divider_state_t;
+
+    divider_state_t state;
+    local_thread_idx_t owner_thread;
+    scalar_t owner_pc;
+    logic[4:0] bit_count;
+    logic remainder_op;
+    local_thread_bitmap_t waiting_threads;
+    local_thread_bitmap_t owner_oh;
+    logic signed_op;
+    logic owner_match;
+    logic start_en;
+    logic release_owner;
+
+    assign signed_op = of_instruction.alu_op == OP_DIV_I || of_instruction.alu_op == OP_REM_I;
+    assign owner_match = of_thread_idx == owner_thread && of_instruction.pc == owner_pc;
+    assign idv_result_valid = ix_divide_en && state == DIV_DONE && owner_match;
+    assign release_owner = state == DIV_DONE && (!thread_en[owner_thread]
+        || (wb_trap && wb_rollback_thread_idx == owner_thread));
+    assign start_en = ix_divide_en && !idv_result_valid
+        && (state == DIV_IDLE || of_thread_idx == owner_thread || release_owner);
+
+    genvar lane;
+    generate
+        for (lane = 0; lane < NUM_VECTOR_LANES; lane++)
+        begin : lane_divide_gen
+            scalar_t quotient;
+            scalar_t remainder;
+            scalar_t divisor;
+            logic negate_quotient;
+            logic negate_remainder;
+            logic dividend_negative;
+            logic divisor_negative;
+            logic borrow;
+            scalar_t difference;
+            scalar_t lane_result;
+
+            assign dividend_negative = signed_op && of_operand1[lane][31];
+            assign divisor_negative = signed_op && of_operand2[lane][31];
+
+            // Shift the next dividend bit into the partial remainder and try
+            // to subtract the divisor.
+            assign {borrow, difference} = {remainder, quotient[31]} - {1'b0, divisor};
+
+            always_ff @(posedge clk)
+            begin
+                if (start_en)
+                begin
+                    quotient <= dividend_negative ? -of_operand1[lane] : of_operand1[lane];
+                    remainder <= '0;
+                    divisor <= divisor_negative ? -of_operand2[lane] : of_operand2[lane];
+                    negate_quotient <= (dividend_negative != divisor_negative)
+                        && of_operand2[lane] != 0;
+                    negate_remainder <= dividend_negative;
+                end
+                else if (state == DIV_BUSY)
+                begin
+                    if (borrow)
+                    begin
+                        remainder <= {remainder[30:0], quotient[31]};
+                        quotient <= {quotient[30:0], 1'b0};
+                    end
+                    else
+                    begin
+                        remainder <= difference;
+                        quotient <= {quotient[30:0], 1'b1};
+                    end
+                end
+            end
+
+            always_comb
+            begin
+                if (remainder_op)
+                    lane_result = negate_remainder ? -remainder : remainder;
+                else
+                    lane_result = negate_quotient ? -quotient : quotient;
+            end
+
+            assign idv_result[lane] = lane_result;
+        end
+    endgenerate
+
+    idx_to_oh #(.NUM_SIGNALS(`THREADS_PER_CORE)) idx_to_oh_owner(
+        .index(owner_thread),
+        .one_hot(owner_oh));
+
+    assign idv_pending = state != DIV_IDLE ? owner_oh : local_thread_bitmap_t'(0);
+
+    always_ff @(posedge clk, posedge reset)
+    begin
+        if (reset)
+        begin
+            state <= DIV_IDLE;
+            /*AUTORESET*/
+            // Beginning of autoreset for uninitialized flops
+            bit_count <= '0;
+            idv_wake_bitmap <= '0;
+            owner_pc <= '0;
+            owner_thread <= '0;
+            remainder_op <= '0;
+            waiting_threads <= '0;
+            // End of automatics
+        end
+        else
+        begin
+            idv_wake_bitmap <= '0;
+            if (start_en)
+            begin
+                state <= DIV_BUSY;
+                owner_thread <= of_thread_idx;
+                owner_pc <= of_instruction.pc;
+                remainder_op <= of_instruction.alu_op == OP_REM_I
+                    || of_instruction.alu_op == OP_REM_U;
+                bit_count <= '0;
+            end
+            else if (idv_result_valid)
+            begin
+                // Result collected. Wake threads that are waiting to use
+                // the divider.
+                state <= DIV_IDLE;
+                idv_wake_bitmap <= waiting_threads;
+                waiting_threads <= '0;
+            end
+            else if (release_owner)
+            begin
+                // The owner won't collect the result. The owner isn't
+                // suspended in this state, so only wake the waiting threads.
+                state <= DIV_IDLE;
+                idv_wake_bitmap <= waiting_threads;
+                waiting_threads <= '0;
+            end
+            else if (ix_divide_en)
+            begin
+                // Divider is in use by another thread
+                waiting_threads[of_thread_idx] <= 1'b1;
+            end
+
+            if (state == DIV_BUSY && !start_en)
+            begin
+                bit_count <= bit_count + 5'd1;
+                if (bit_count == 5'd31)
+                begin
+                    state <= DIV_DONE;
+                    idv_wake_bitmap <= owner_oh;
+                end
+            end
+        end
+    end
+endmodule
@@ -22,7 +22,12 @@ import defines::*;
 // Instruction Pipeline Integer Execute Stage
 // - Performs simple operations that only require a single stage like integer
 //   addition or bitwise logical operations.
-// - Detects branches
+// - Detects branches. A branch rolls back the thread if it is taken and
+//   wasn't predicted taken, or was predicted taken but isn't. This also
+//   updates the branch predictor with the outcome of PC relative branches.
+// - Sends integer divides to int_divider. Unless the result of this
+//   instruction is ready, this rolls back the thread to reissue the divide
+//   and suspends it until the divider wakes it up.
 //
 // (despite the name, this stage also handles floating point reciprocal
 // estimates)
@@ -55,6 +60,18 @@ module int_execute_stage(
     output scalar_t                   ix_rollback_pc,
     output subcycle_t                 ix_subcycle,
     output logic                      ix_privileged_op_fault,
+    output logic                      ix_suspend_thread,
+
+    // To int_divider
+    output logic                      ix_divide_en,
+
+    // From int_divider
+    input                             idv_result_valid,
+    input vector_t                    idv_result,
+
+    // To ifetch_tag_stage
+    output logic                      ix_branch_resolved,
+    output logic                      ix_branch_taken,
 
     // From control_registers
     input scalar_t                    cr_eret_address[`THREADS_PER_CORE],
@@ -63,14 +80,18 @@ module int_execute_stage(
     // To performance_counters
     output logic                      ix_perf_uncond_branch,
     output logic                      ix_perf_cond_branch_taken,
-    output logic                      ix_perf_cond_branch_not_taken);
+    output logic                      ix_perf_cond_branch_not_taken,
+    output logic                      ix_perf_branch_predicted,
+    output logic                      ix_perf_branch_mispredicted);
 
     vector_t vector_result;
     logic eret;
     logic privileged_op_fault;
     logic branch_taken;
     logic conditional_branch;
+    logic pc_relative_branch;
     logic valid_instruction;
+    logic divide_wait;
 
     genvar lane;
     generate
@@ -259,11 +280,19 @@ module int_execute_stage(
         && of_instruction.branch
         && of_instruction.branch_type == BRANCH_ERET;
     assign privileged_op_fault = eret && !cr_supervisor_en[of_thread_idx];
+    assign ix_divide_en = valid_instruction
+        && !of_instruction.has_trap
+        && (of_instruction.alu_op == OP_DIV_I
+        || of_instruction.alu_op == OP_DIV_U
+        || of_instruction.alu_op == OP_REM_I
+        || of_instruction.alu_op == OP_REM_U);
+    assign divide_wait = ix_divide_en && !idv_result_valid;
 
     always_comb
     begin
         branch_taken = 0;
         conditional_branch = 0;
+        pc_relative_branch = 0;
 
         if (valid_instruction
             && of_instruction.branch
@@ -274,16 +303,23 @@ module int_execute_stage(
                 begin
                     branch_taken = of_operand1[0] == 0;
                     conditional_branch = 1;
+                    pc_relative_branch = 1;
                 end
 
                 BRANCH_NOT_ZERO:
                 begin
                     branch_taken = of_operand1[0] != 0;
                     conditional_branch = 1;
+                    pc_relative_branch = 1;
                 end
 
                 BRANCH_ALWAYS,
-                BRANCH_CALL_OFFSET,
+                BRANCH_CALL_OFFSET:
+                begin
+                    branch_taken = 1;
+                    pc_relative_branch = 1;
+                end
+
                 BRANCH_CALL_REGISTER,
                 BRANCH_REGISTER,
                 BRANCH_ERET:
@@ -301,19 +337,26 @@ module int_execute_stage(
     always_ff @(posedge clk)
     begin
         ix_instruction <= of_instruction;
-        ix_result <= vector_result;
+        ix_result <= ix_divide_en ? idv_result : vector_result;
         ix_mask_value <= of_mask_value;
         ix_thread_idx <= of_thread_idx;
         ix_subcycle <= of_subcycle;
 
         // Branch handling
-        unique case (of_instruction.branch_type)
-            BRANCH_CALL_REGISTER,
-            BRANCH_REGISTER: ix_rollback_pc <= of_operand1[0];
-            BRANCH_ERET: ix_rollback_pc <= cr_eret_address[of_thread_idx];
-            default:
-                ix_rollback_pc <= of_instruction.pc + of_instruction.immediate_value;
-        endcase
+        if (divide_wait)
+            ix_rollback_pc <= of_instruction.pc;
+        else if (of_instruction.branch_predicted && !branch_taken)
+            ix_rollback_pc <= of_instruction.pc + 32'd4;
+        else
+        begin
+            unique case (of_instruction.branch_type)
+                BRANCH_CALL_REGISTER,
+                BRANCH_REGISTER: ix_rollback_pc <= of_operand1[0];
+                BRANCH_ERET: ix_rollback_pc <= cr_eret_address[of_thread_idx];
+                default:
+                    ix_rollback_pc <= of_instruction.pc + of_instruction.immediate_value;
+            endcase
+        end
     end
 
     always_ff @(posedge clk, posedge reset)
@@ -322,12 +365,17 @@ module int_execute_stage(
         begin
             /*AUTORESET*/
             // Beginning of autoreset for uninitialized flops
+            ix_branch_resolved <= '0;
+            ix_branch_taken <= '0;
             ix_instruction_valid <= '0;
+            ix_perf_branch_mispredicted <= '0;
+            ix_perf_branch_predicted <= '0;
             ix_perf_cond_branch_not_taken <= '0;
             ix_perf_cond_branch_taken <= '0;
             ix_perf_uncond_branch <= '0;
             ix_privileged_op_fault <= '0;
             ix_rollback_en <= '0;
+            ix_suspend_thread <= '0;
             // End of automatics
         end
         else
@@ -336,17 +384,25 @@ module int_execute_stage(
             begin
                 ix_instruction_valid <= 1;
                 ix_privileged_op_fault <= privileged_op_fault;
-                ix_rollback_en <= branch_taken;
+                ix_rollback_en <= branch_taken != of_instruction.branch_predicted
+                    || divide_wait;
+                ix_suspend_thread <= divide_wait;
             end
             else
             begin
                 ix_instruction_valid <= 0;
                 ix_rollback_en <= 0;
+                ix_suspend_thread <= 0;
             end
 
             ix_perf_uncond_branch <= !conditional_branch && branch_taken;
             ix_perf_cond_branch_taken <= conditional_branch && branch_taken;
             ix_perf_cond_branch_not_taken <= conditional_branch && !branch_taken;
+            ix_perf_branch_predicted <= pc_relative_branch && of_instruction.branch_predicted;
+            ix_perf_branch_mispredicted <= pc_relative_branch
+                && branch_taken != of_instruction.branch_predicted;
+            ix_branch_resolved <= pc_relative_branch;
+            ix_branch_taken <= branch_taken;
         end
     end
 endmodule
@@ -20,7 +20,10 @@ import defines::*;
 
 //
 // Accepts IO requests from all cores and serializes requests to external
-// IO interface. Sends responses back to cores.
+// IO interface. Sends responses back to cores. Accesses to the DMA engine
+// registers go to dma_engine, and accesses to the texture sampler registers
+// go to the requesting core's texture_sampler, instead of the external
+// interface.
 //
 
 module io_interconnect(
@@ -35,7 +38,20 @@ module io_interconnect(
     output logic                     ii_ready[`NUM_CORES],
     output logic                     ii_response_valid,
     output iorsp_packet_t            ii_response,
-    io_bus_interface.master          io_bus);
+    io_bus_interface.master          io_bus,
+
+    // To/from dma_engine
+    output logic                     ii_dma_write_en,
+    output logic[3:0]                ii_dma_reg,
+    output scalar_t                  ii_dma_write_data,
+    input scalar_t                   dma_read_data,
+
+    // To/from texture_sampler
+    output logic[`NUM_CORES - 1:0]   ii_tex_write_en,
+    output logic[3:0]                ii_tex_reg,
+    output local_thread_idx_t        ii_tex_thread,
+    output scalar_t                  ii_tex_write_data,
+    input scalar_t                   tex_read_data[`NUM_CORES]);
 
     core_id_t grant_idx;
     logic[`NUM_CORES - 1:0] grant_oh;
@@ -43,6 +59,11 @@ module io_interconnect(
     core_id_t request_core;
     local_thread_idx_t request_thread_idx;
     ioreq_packet_t grant_request;
+    logic dma_select;
+    logic request_dma;
+    logic tex_select;
+    logic request_tex;
+    scalar_t request_tex_read_data;
 
     genvar request_idx;
     generate
@@ -75,29 +96,50 @@ module io_interconnect(
             end
 
             assign grant_request = ior_request[grant_idx[CORE_ID_WIDTH - 1:0]];
+            assign request_tex_read_data = tex_read_data[request_core[CORE_ID_WIDTH - 1:0]];
         end
         else
         begin
             assign grant_oh[0] = ior_request_valid[0];
             assign grant_idx = 0;
             assign grant_request = ior_request[0];
+            assign request_tex_read_data = tex_read_data[0];
         end
     endgenerate
 
-    assign io_bus.write_en = |grant_oh && grant_request.store;
-    assign io_bus.read_en = |grant_oh && !grant_request.store;
+    assign dma_select = grant_request.address[31:6] == DMA_BASE[31:6];
+    assign tex_select = grant_request.address[31:6] == TEXTURE_BASE[31:6];
+    assign io_bus.write_en = |grant_oh && grant_request.store && !dma_select
+        && !tex_select;
+    assign io_bus.read_en = |grant_oh && !grant_request.store && !dma_select
+        && !tex_select;
     assign io_bus.write_data = grant_request.value;
     assign io_bus.address = grant_request.address;
+    assign ii_dma_write_en = |grant_oh && grant_request.store && dma_select;
+    assign ii_dma_reg = grant_request.address[5:2];
+    assign ii_dma_write_data = grant_request.value;
+    assign ii_tex_write_en = grant_oh & {`NUM_CORES{grant_request.store && tex_select}};
+    assign ii_tex_reg = grant_request.address[5:2];
+    assign ii_tex_thread = grant_request.thread_idx;
+    assign ii_tex_write_data = grant_request.value;
 
     always_ff @(posedge clk)
     begin
         ii_response.core <= request_core;
         ii_response.thread_idx <= request_thread_idx;
-        ii_response.read_value <= io_bus.read_data;
+        if (request_dma)
+            ii_response.read_value <= dma_read_data;
+        else if (request_tex)
+            ii_response.read_value <= request_tex_read_data;
+        else
+            ii_response.read_value <= io_bus.read_data;
+
         if (|ior_request_valid)
         begin
             request_core <= grant_idx;
             request_thread_idx <= grant_request.thread_idx;
+            request_dma <= dma_select;
+            request_tex <= tex_select;
         end
     end
 
@@ -25,11 +25,17 @@ import defines::*;
 // Additional things this module handles:
 // - Tracks pending load misses from L1 instruction and data caches
 //   (l1_load_miss_queue).
+// - Predicts instruction and data cache misses and prefetches lines into
+//   the L1 caches (ifetch_prefetcher, dcache_prefetcher).
 // - Tracks pending stores from pipeline (l1_store_queue).
+// - Wakes threads waiting for a write to a cache line (l1_wait_monitor).
 // - Arbitrates miss sources and sends L2 cache requests.
 // - Processes L2 responses, updating L1 instruction and data caches.
 //
-// This processes L2 responses using a three stage pipeline:
+// The L2 cache sends this core responses to its own requests, and store and
+// invalidate responses for lines its snoop filter indicates may be in this
+// L1 data cache (see l2_cache_snoop_filter). This processes L2 responses
+// using a three stage pipeline:
 // 1. Sends store address from the response to L1D tag memory (which
 //    has one cycle of latency) to snoop it.
 // 2. Checks the snoop responses. If the data are in the cache, selects the
@@ -63,17 +69,23 @@ module l1_l2_interface
     output l1i_set_idx_t                          l2i_itag_update_set,
     output l1i_tag_t                              l2i_itag_update_tag,
     output logic                                  l2i_itag_update_valid,
+    output logic                                  l2i_itag_update_prefetched,
+    output logic                                  l2i_isnoop_en,
+    output l1i_set_idx_t                          l2i_isnoop_set,
 
     // To instruction_decode_stage
     output local_thread_bitmap_t                  sq_store_sync_pending,
 
     // From ifetch_tag_stage
     input l1i_way_idx_t                           ift_fill_lru,
+    input logic                                   ift_snoop_valid[`L1I_WAYS],
+    input l1i_tag_t                               ift_snoop_tag[`L1I_WAYS],
 
     // From ifetch_data_stage
     input logic                                   ifd_cache_miss,
     input cache_line_index_t                      ifd_cache_miss_paddr,
     input local_thread_idx_t                      ifd_cache_miss_thread_idx,
+    input                                         ifd_prefetch_hit,
 
     // To ifetch_data_stage
     output logic                                  l2i_idata_update_en,
@@ -97,6 +109,7 @@ module l1_l2_interface
     output l1d_set_idx_t                          l2i_dtag_update_set,
     output l1d_tag_t                              l2i_dtag_update_tag,
     output logic                                  l2i_dtag_update_valid,
+    output logic                                  l2i_dtag_update_prefetched,
     output logic                                  l2i_dcache_lru_fill_en,
     output l1d_set_idx_t                          l2i_dcache_lru_fill_set,
 
@@ -105,6 +118,8 @@ module l1_l2_interface
     input cache_line_index_t                      dd_cache_miss_addr,
     input local_thread_idx_t                      dd_cache_miss_thread_idx,
     input                                         dd_cache_miss_sync,
+    input scalar_t                                dd_cache_miss_pc,
+    input                                         dd_prefetch_hit,
     input                                         dd_store_en,
     input                                         dd_flush_en,
     input                                         dd_membar_en,
@@ -117,6 +132,8 @@ module l1_l2_interface
     input                                         dd_store_sync,
     input cache_line_index_t                      dd_store_bypass_addr,
     input local_thread_idx_t                      dd_store_bypass_thread_idx,
+    input                                         dd_wait_en,
+    input local_thread_idx_t                      dd_wait_thread_idx,
 
     // To dcache_data_stage
     output logic                                  l2i_ddata_update_en,
@@ -130,12 +147,24 @@ module l1_l2_interface
     output cache_line_data_t                      sq_store_bypass_data,
     output logic                                  sq_rollback_en,
 
+    // From control_registers
+    input prefetch_control_t                      cr_prefetch_control,
+    input local_thread_bitmap_t                   cr_interrupt_pending,
+    input local_thread_bitmap_t                   cr_interrupt_en,
+
     // To core
-    output logic                                  l2i_perf_store);
+    output logic                                  l2i_perf_store,
+    output logic                                  l2i_perf_dcache_prefetch,
+    output local_thread_idx_t                     l2i_dcache_prefetch_thread_idx,
+    output logic                                  l2i_perf_icache_prefetch,
+    output local_thread_idx_t                     l2i_icache_prefetch_thread_idx);
 
     logic[`L1D_WAYS - 1:0] snoop_hit_way_oh;    // Only snoops dcache
     l1d_way_idx_t snoop_hit_way_idx;
+    logic[`L1I_WAYS - 1:0] isnoop_hit_way_oh;
+    l1i_way_idx_t isnoop_hit_way_idx;
     logic[`L1I_WAYS - 1:0] ifill_way_oh;
+    l1i_way_idx_t ifill_way_idx;
     logic[`L1D_WAYS - 1:0] dupdate_way_oh;
     l1d_way_idx_t dupdate_way_idx;
     logic ack_for_me;
@@ -148,6 +177,7 @@ module l1_l2_interface
     logic storebuf_l2_response_valid;
     l1_miss_entry_idx_t storebuf_l2_response_idx;
     local_thread_bitmap_t dcache_miss_wake_bitmap;
+    local_thread_bitmap_t wait_wake_bitmap;
     logic storebuf_dequeue_ack;
     logic icache_dequeue_ready;
     logic icache_dequeue_ack;
@@ -169,9 +199,19 @@ module l1_l2_interface
     logic storebuf_l2_sync_success;
     logic response_iinvalidate;
     logic response_dinvalidate;
+    logic dpf_request_ack;
+    logic dcache_prefetch_fill;
+    logic ipf_request_ack;
+    logic icache_prefetch_fill;
 
     /*AUTOLOGIC*/
     // Beginning of automatic wires (for undeclared instantiated-module outputs)
+    cache_line_index_t  dpf_request_addr;       // From dcache_prefetcher of dcache_prefetcher.v
+    local_thread_idx_t  dpf_request_thread_idx; // From dcache_prefetcher of dcache_prefetcher.v
+    logic               dpf_request_valid;      // From dcache_prefetcher of dcache_prefetcher.v
+    cache_line_index_t  ipf_request_addr;       // From ifetch_prefetcher of ifetch_prefetcher.v
+    local_thread_idx_t  ipf_request_thread_idx; // From ifetch_prefetcher of ifetch_prefetcher.v
+    logic               ipf_request_valid;      // From ifetch_prefetcher of ifetch_prefetcher.v
     cache_line_index_t  sq_dequeue_addr;        // From l1_store_queue of l1_store_queue.v
     cache_line_data_t   sq_dequeue_data;        // From l1_store_queue of l1_store_queue.v
     logic               sq_dequeue_dinvalidate; // From l1_store_queue of l1_store_queue.v
@@ -186,13 +226,23 @@ module l1_l2_interface
 
     l1_store_queue l1_store_queue(.*);
 
-    l1_load_miss_queue l1_load_miss_queue_dcache(
+    dcache_prefetcher dcache_prefetcher(.*);
+
+    l1_load_miss_queue #(
+        .NUM_PREFETCH_ENTRIES(`L1D_PREFETCH_ENTRIES)
+    ) l1_load_miss_queue_dcache(
         // Enqueue requests
         .cache_miss(dd_cache_miss),
         .cache_miss_addr(dd_cache_miss_addr),
         .cache_miss_thread_idx(dd_cache_miss_thread_idx),
         .cache_miss_sync(dd_cache_miss_sync),
 
+        // Prefetch requests
+        .prefetch_en(dpf_request_valid),
+        .prefetch_addr(dpf_request_addr),
+        .prefetch_ack(dpf_request_ack),
+        .prefetch_enqueued(l2i_perf_dcache_prefetch),
+
         // Next request
         .dequeue_ready(dcache_dequeue_ready),
         .dequeue_ack(dcache_dequeue_ack),
@@ -204,17 +254,36 @@ module l1_l2_interface
         .l2_response_valid(dcache_l2_response_valid),
         .l2_response_idx(dcache_l2_response_idx),
         .wake_bitmap(dcache_miss_wake_bitmap),
+        .prefetch_fill(dcache_prefetch_fill),
+        .*);
+
+    l1_wait_monitor l1_wait_monitor(
+        .l2_response_valid(response_stage2_valid),
+        .l2_response(response_stage2),
+        .wake_bitmap(wait_wake_bitmap),
         .*);
 
-    assign l2i_dcache_wake_bitmap = dcache_miss_wake_bitmap | sq_wake_bitmap;
+    assign l2i_dcache_wake_bitmap = dcache_miss_wake_bitmap | sq_wake_bitmap
+        | wait_wake_bitmap;
+    assign l2i_dcache_prefetch_thread_idx = dpf_request_thread_idx;
 
-    l1_load_miss_queue l1_load_miss_queue_icache(
+    ifetch_prefetcher ifetch_prefetcher(.*);
+
+    l1_load_miss_queue #(
+        .NUM_PREFETCH_ENTRIES(`L1I_PREFETCH_ENTRIES)
+    ) l1_load_miss_queue_icache(
         // Enqueue requests
         .cache_miss(ifd_cache_miss),
         .cache_miss_addr(ifd_cache_miss_paddr),
         .cache_miss_thread_idx(ifd_cache_miss_thread_idx),
         .cache_miss_sync('0),
 
+        // Prefetch requests
+        .prefetch_en(ipf_request_valid),
+        .prefetch_addr(ipf_request_addr),
+        .prefetch_ack(ipf_request_ack),
+        .prefetch_enqueued(l2i_perf_icache_prefetch),
+
         // Next request
         .dequeue_ready(icache_dequeue_ready),
         .dequeue_ack(icache_dequeue_ack),
@@ -226,8 +295,11 @@ module l1_l2_interface
         .l2_response_valid(icache_l2_response_valid),
         .l2_response_idx(icache_l2_response_idx),
         .wake_bitmap(l2i_icache_wake_bitmap),
+        .prefetch_fill(icache_prefetch_fill),
         .*);
 
+    assign l2i_icache_prefetch_thread_idx = ipf_request_thread_idx;
+
     /////////////////////////////////////////////////
     // Response pipeline stage 1
     /////////////////////////////////////////////////
@@ -237,11 +309,14 @@ module l1_l2_interface
     assign l2i_snoop_en = l2_response_valid && l2_response.cache_type == CT_DCACHE;
     assign l2i_snoop_set = dcache_set_stage1;
     assign l2i_dcache_lru_fill_en = l2_response_valid && l2_response.cache_type == CT_DCACHE
-        && l2_response.packet_type == L2RSP_LOAD_ACK && l2_response.core == CORE_ID;
+        && l2_response.packet_type == L2RSP_LOAD_ACK && l2_response.core == CORE_ID
+        && !l2_response.dma;
     assign l2i_dcache_lru_fill_set = dcache_set_stage1;
     assign l2i_icache_lru_fill_en = l2_response_valid && l2_response.cache_type == CT_ICACHE
         && l2_response.packet_type == L2RSP_LOAD_ACK && l2_response.core == CORE_ID;
     assign l2i_icache_lru_fill_set = icache_set_stage1;
+    assign l2i_isnoop_en = l2i_icache_lru_fill_en;
+    assign l2i_isnoop_set = icache_set_stage1;
 
     always_ff @(posedge clk, posedge reset)
     begin
@@ -251,6 +326,7 @@ module l1_l2_interface
         begin
             // Should not get a wake from miss queue and store queue in the same cycle.
             assert((dcache_miss_wake_bitmap & sq_wake_bitmap) == 0);
+            assert((wait_wake_bitmap & (dcache_miss_wake_bitmap | sq_wake_bitmap)) == 0);
             response_stage2_valid <= l2_response_valid;
         end
     end
@@ -298,11 +374,34 @@ module l1_l2_interface
         .index(dupdate_way_idx),
         .one_hot(dupdate_way_oh));
 
+    //
+    // Determine instruction cache fill way. A prefetch may request a line
+    // that is already in the cache. Refill the way that has it rather than
+    // creating a duplicate.
+    //
+    generate
+        for (way_idx = 0; way_idx < `L1I_WAYS; way_idx++)
+        begin : isnoop_hit_check_gen
+            assign isnoop_hit_way_oh[way_idx] = ift_snoop_tag[way_idx] == icache_tag_stage2
+                && ift_snoop_valid[way_idx];
+        end
+    endgenerate
+
+    oh_to_idx #(.NUM_SIGNALS(`L1I_WAYS)) convert_isnoop_hit(
+        .index(isnoop_hit_way_idx),
+        .one_hot(isnoop_hit_way_oh));
+
+    assign ifill_way_idx = |isnoop_hit_way_oh ? isnoop_hit_way_idx : ift_fill_lru;
+
     idx_to_oh #(.NUM_SIGNALS(`L1I_WAYS)) idx_to_oh_ifill_way(
-        .index(ift_fill_lru),
+        .index(ifill_way_idx),
         .one_hot(ifill_way_oh));
 
-    assign ack_for_me = response_stage2_valid && response_stage2.core == CORE_ID;
+    // Store responses to the DMA engine go to cores that may have the line
+    // like other store responses, so snoops update it, but no miss is
+    // waiting for them.
+    assign ack_for_me = response_stage2_valid && response_stage2.core == CORE_ID
+        && !response_stage2.dma;
 
     //
     // Update data cache tag
@@ -316,6 +415,11 @@ module l1_l2_interface
     assign l2i_dtag_update_set = dcache_set_stage2;
     assign l2i_dtag_update_valid = !response_dinvalidate;
 
+    // Mark a line filled by a prefetch so dcache_data_stage can detect the
+    // first load that uses it. If a thread already missed on the line while
+    // the prefetch was pending, it has been used.
+    assign l2i_dtag_update_prefetched = dcache_prefetch_fill;
+
     //
     // Update instruction cache tag. For a fill, mark the line valid and update the tag.
     // For a invalidate, mark all ways for the selected set invalid
@@ -329,6 +433,7 @@ module l1_l2_interface
     assign l2i_itag_update_tag = icache_tag_stage2;
     assign l2i_itag_update_set = icache_set_stage2;
     assign l2i_itag_update_valid = !response_iinvalidate;
+    assign l2i_itag_update_prefetched = icache_prefetch_fill && !|isnoop_hit_way_oh;
 
     // Wake up entries that have had their miss satisfied.
     assign icache_l2_response_valid = ack_for_me && response_stage2.cache_type == CT_ICACHE;
@@ -353,7 +458,7 @@ module l1_l2_interface
         l2i_ddata_update_way <= dupdate_way_idx;
         l2i_ddata_update_set <= dcache_set_stage2;
         l2i_ddata_update_data <= response_stage2.data;
-        l2i_idata_update_way <= ift_fill_lru;
+        l2i_idata_update_way <= ifill_way_idx;
         l2i_idata_update_set <= icache_set_stage2;
         l2i_idata_update_data <= response_stage2.data;
     end
@@ -373,6 +478,7 @@ module l1_l2_interface
             // Make sure more than one snoop way isn't a hit
             assert(!response_stage2_valid || response_stage2.cache_type != CT_DCACHE
                 || $onehot0(snoop_hit_way_oh));
+            assert(!icache_l2_response_valid || $onehot0(isnoop_hit_way_oh));
 
             // Ensure only one dequeue type is set
             assert(!sq_dequeue_ready || $onehot0({sq_dequeue_flush, sq_dequeue_iinvalidate,
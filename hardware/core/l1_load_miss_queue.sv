@@ -22,9 +22,16 @@ import defines::*;
 // Tracks pending L1 misses. Detects and consolidates multiple misses
 // for the same address. Wakes threads when loads complete.
 //
+// There is one entry per thread for demand misses, followed by
+// NUM_PREFETCH_ENTRIES entries for prefetches. A prefetch has no waiting
+// threads when it is enqueued, but a later miss for the same line is
+// consolidated with it like any other pending miss. A prefetch for a line
+// that already has a pending entry is dropped.
+//
 
-module l1_load_miss_queue(
-    input                                   clk,
+module l1_load_miss_queue
+    #(parameter NUM_PREFETCH_ENTRIES = 0)
+    (input                                  clk,
     input                                   reset,
 
     // Enqueue request
@@ -33,6 +40,12 @@ module l1_load_miss_queue(
     input local_thread_idx_t                cache_miss_thread_idx,
     input                                   cache_miss_sync,
 
+    // Prefetch request
+    input                                   prefetch_en,
+    input cache_line_index_t                prefetch_addr,
+    output logic                            prefetch_ack,
+    output logic                            prefetch_enqueued,
+
     // Dequeue request
     output logic                            dequeue_ready,
     input                                   dequeue_ack,
@@ -43,7 +56,11 @@ module l1_load_miss_queue(
     // Wake
     input                                   l2_response_valid,
     input l1_miss_entry_idx_t               l2_response_idx,
-    output local_thread_bitmap_t            wake_bitmap);
+    output local_thread_bitmap_t            wake_bitmap,
+    output logic                            prefetch_fill);
+
+    localparam NUM_ENTRIES = `THREADS_PER_CORE + NUM_PREFETCH_ENTRIES;
+    localparam ENTRY_IDX_WIDTH = $clog2(NUM_ENTRIES);
 
     struct packed {
         logic valid;
@@ -51,48 +68,103 @@ module l1_load_miss_queue(
         local_thread_bitmap_t waiting_threads;
         cache_line_index_t address;
         logic sync;
-    } pending_entries[`THREADS_PER_CORE];
+    } pending_entries[NUM_ENTRIES];
 
-    local_thread_bitmap_t collided_miss_oh;
+    logic[NUM_ENTRIES - 1:0] collided_miss_oh;
     local_thread_bitmap_t miss_thread_oh;
     logic request_unique;
-    local_thread_bitmap_t send_grant_oh;
-    local_thread_bitmap_t arbiter_request;
-    local_thread_idx_t send_grant_idx;
+    logic[NUM_ENTRIES - 1:0] send_grant_oh;
+    logic[NUM_ENTRIES - 1:0] arbiter_request;
+    logic[ENTRY_IDX_WIDTH - 1:0] send_grant_idx;
+    logic[ENTRY_IDX_WIDTH - 1:0] response_entry_idx;
+    logic[NUM_ENTRIES - 1:0] prefetch_collided_oh;
+    logic[NUM_ENTRIES - 1:0] prefetch_alloc_oh;
+    logic prefetch_unique;
+
+    initial
+        assert(NUM_PREFETCH_ENTRIES <= `THREADS_PER_CORE);
 
     idx_to_oh #(.NUM_SIGNALS(`THREADS_PER_CORE)) idx_to_oh_miss_thread(
         .index(cache_miss_thread_idx),
         .one_hot(miss_thread_oh));
 
-    rr_arbiter #(.NUM_REQUESTERS(`THREADS_PER_CORE)) request_arbiter(
+    rr_arbiter #(.NUM_REQUESTERS(NUM_ENTRIES)) request_arbiter(
         .request(arbiter_request),
         .update_lru(1'b1),
         .grant_oh(send_grant_oh),
         .*);
 
-    oh_to_idx #(.NUM_SIGNALS(`THREADS_PER_CORE)) oh_to_idx_send_grant(
+    oh_to_idx #(.NUM_SIGNALS(NUM_ENTRIES)) oh_to_idx_send_grant(
         .index(send_grant_idx),
         .one_hot(send_grant_oh));
 
     // Request out
     assign dequeue_ready = |arbiter_request;
     assign dequeue_addr = pending_entries[send_grant_idx].address;
-    assign dequeue_idx = send_grant_idx;
+    assign dequeue_idx = l1_miss_entry_idx_t'(send_grant_idx);
     assign dequeue_sync = pending_entries[send_grant_idx].sync;
 
     assign request_unique = !(|collided_miss_oh);
 
-    assign wake_bitmap = l2_response_valid ? pending_entries[l2_response_idx].waiting_threads : local_thread_bitmap_t'(0);
+    assign response_entry_idx = ENTRY_IDX_WIDTH'(l2_response_idx);
+    assign wake_bitmap = l2_response_valid ? pending_entries[response_entry_idx].waiting_threads : local_thread_bitmap_t'(0);
+
+    // A prefetch entry is filling a line that no thread has missed on yet.
+    assign prefetch_fill = l2_response_valid
+        && l2_response_idx >= l1_miss_entry_idx_t'(`THREADS_PER_CORE)
+        && pending_entries[response_entry_idx].waiting_threads == 0;
+
+    // Pick the first free prefetch entry. If there isn't one, the prefetch
+    // request waits.
+    always_comb
+    begin
+        prefetch_alloc_oh = '0;
+        for (int i = NUM_ENTRIES - 1; i >= `THREADS_PER_CORE; i--)
+        begin
+            if (!pending_entries[i].valid)
+            begin
+                prefetch_alloc_oh = '0;
+                prefetch_alloc_oh[i] = 1;
+            end
+        end
+    end
+
+    assign prefetch_unique = !(|prefetch_collided_oh)
+        && !(cache_miss && cache_miss_addr == prefetch_addr);
+    assign prefetch_ack = prefetch_en && |prefetch_alloc_oh;
+    assign prefetch_enqueued = prefetch_ack && prefetch_unique;
 
     genvar wait_entry;
     generate
-        for (wait_entry = 0; wait_entry < `THREADS_PER_CORE; wait_entry++)
+        for (wait_entry = 0; wait_entry < NUM_ENTRIES; wait_entry++)
         begin : wait_logic_gen
+            logic enqueue_en;
+            local_thread_bitmap_t enqueue_waiting;
+            cache_line_index_t enqueue_addr;
+            logic enqueue_sync;
+
+            if (wait_entry < `THREADS_PER_CORE)
+            begin : miss_entry_gen
+                assign enqueue_en = cache_miss && miss_thread_oh[wait_entry] && request_unique;
+                assign enqueue_waiting = miss_thread_oh;
+                assign enqueue_addr = cache_miss_addr;
+                assign enqueue_sync = cache_miss_sync;
+            end
+            else
+            begin : prefetch_entry_gen
+                assign enqueue_en = prefetch_enqueued && prefetch_alloc_oh[wait_entry];
+                assign enqueue_waiting = '0;
+                assign enqueue_addr = prefetch_addr;
+                assign enqueue_sync = 0;
+            end
+
             // Synchronized requests cannot be combined with other requests.
             assign collided_miss_oh[wait_entry] = pending_entries[wait_entry].valid
                 && pending_entries[wait_entry].address == cache_miss_addr
                 && !pending_entries[wait_entry].sync
                 && !cache_miss_sync;
+            assign prefetch_collided_oh[wait_entry] = pending_entries[wait_entry].valid
+                && pending_entries[wait_entry].address == prefetch_addr;
             assign arbiter_request[wait_entry] = pending_entries[wait_entry].valid
                 && !pending_entries[wait_entry].request_sent;
 
@@ -112,14 +184,14 @@ module l1_load_miss_queue(
                         assert(pending_entries[wait_entry].valid);
                         assert(!pending_entries[wait_entry].request_sent);
                     end
-                    else if (cache_miss && miss_thread_oh[wait_entry] && request_unique)
+                    else if (enqueue_en)
                     begin
-                        // Enqueue a cache miss
-                        pending_entries[wait_entry].waiting_threads <= miss_thread_oh;
+                        // Enqueue a cache miss or prefetch
+                        pending_entries[wait_entry].waiting_threads <= enqueue_waiting;
                         pending_entries[wait_entry].valid <= 1;
-                        pending_entries[wait_entry].address <= cache_miss_addr;
+                        pending_entries[wait_entry].address <= enqueue_addr;
                         pending_entries[wait_entry].request_sent <= 0;
-                        pending_entries[wait_entry].sync <= cache_miss_sync;
+                        pending_entries[wait_entry].sync <= enqueue_sync;
 
                         // Ensure this entry isn't already in use or a response
                         // isn't coming in this cycle (lower level logic should prevent
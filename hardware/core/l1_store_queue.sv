@@ -26,6 +26,15 @@ import defines::*;
 // It acts like a store in terms of rollback logic, but doesn't enqueue
 // anything.
 //
+// Stores from the same thread to the same cache line are write combined
+// into one L2 request. A store that doesn't fill the whole line is held
+// for up to WRITE_COMBINE_CYCLES before it is sent, so following stores can
+// merge into it. Each store that writes new bytes restarts the timer (which
+// bounds the total delay, since the mask only grows). A request from the
+// thread that can't combine with the entry (a store to another line, a
+// synchronized store, a cache control command, or a memory barrier) rolls
+// back as before, and also sends the held entry immediately.
+//
 
 module l1_store_queue(
     input                                  clk,
@@ -72,6 +81,9 @@ module l1_store_queue(
     output logic                           sq_rollback_en,
     output local_thread_bitmap_t           sq_wake_bitmap);
 
+    localparam WRITE_COMBINE_CYCLES = 16;
+    localparam COMBINE_TIMER_WIDTH = $clog2(WRITE_COMBINE_CYCLES + 1);
+
     struct packed {
         logic sync;
         logic flush;
@@ -82,6 +94,7 @@ module l1_store_queue(
         logic sync_success;
         logic thread_waiting;
         logic valid;
+        logic[COMBINE_TIMER_WIDTH - 1:0] combine_timer;
         cache_line_data_t data;
         logic[CACHE_LINE_BYTES - 1:0] mask;
         cache_line_index_t address;
@@ -113,9 +126,12 @@ module l1_store_queue(
             logic got_response_this_entry;
             logic membar_requested_this_entry;
             logic enqueue_cache_control;
+            logic[CACHE_LINE_BYTES - 1:0] combined_mask;
+            logic restart_combine_timer;
 
             assign send_request[thread_idx] = pending_stores[thread_idx].valid
-                && !pending_stores[thread_idx].request_sent;
+                && !pending_stores[thread_idx].request_sent
+                && pending_stores[thread_idx].combine_timer == 0;
             assign store_requested_this_entry = dd_store_en && dd_store_thread_idx == local_thread_idx_t'(thread_idx);
             assign membar_requested_this_entry = dd_membar_en && dd_store_thread_idx == local_thread_idx_t'(thread_idx);
             assign send_this_cycle = send_grant_oh[thread_idx] && storebuf_dequeue_ack;
@@ -137,7 +153,7 @@ module l1_store_queue(
                 && (!pending_stores[thread_idx].valid || can_write_combine || got_response_this_entry)
                 && !restarted_sync_request;
             assign got_response_this_entry = storebuf_l2_response_valid
-                && storebuf_l2_response_idx == local_thread_idx_t'(thread_idx);
+                && storebuf_l2_response_idx == l1_miss_entry_idx_t'(thread_idx);
             assign sq_wake_bitmap[thread_idx] = got_response_this_entry
                 && pending_stores[thread_idx].thread_waiting;
             assign enqueue_cache_control = dd_store_thread_idx == local_thread_idx_t'(thread_idx)
@@ -145,6 +161,18 @@ module l1_store_queue(
                 && (dd_flush_en || dd_dinvalidate_en || dd_iinvalidate_en);
             assign sq_store_sync_pending[thread_idx] = pending_stores[thread_idx].valid
                 && pending_stores[thread_idx].sync;
+            assign combined_mask = can_write_combine
+                ? pending_stores[thread_idx].mask | dd_store_mask
+                : dd_store_mask;
+
+            // Hold a new store, or one that was combined and added bytes,
+            // unless the line is now complete. Don't extend the time for an
+            // entry that is already waiting to be sent.
+            assign restart_combine_timer = update_store_entry
+                && !dd_store_sync
+                && combined_mask != {CACHE_LINE_BYTES{1'b1}}
+                && (!can_write_combine || (pending_stores[thread_idx].combine_timer != 0
+                && (dd_store_mask & ~pending_stores[thread_idx].mask) != 0));
 
             always_comb
             begin
@@ -215,11 +243,24 @@ module l1_store_queue(
                                 pending_stores[thread_idx].data[byte_lane * 8+:8] <= dd_store_data[byte_lane * 8+:8];
                         end
 
-                        if (can_write_combine)
-                            pending_stores[thread_idx].mask <= pending_stores[thread_idx].mask | dd_store_mask;
-                        else
-                            pending_stores[thread_idx].mask <= dd_store_mask;
+                        pending_stores[thread_idx].mask <= combined_mask;
+                    end
+
+                    // A rollback means this thread can't continue until the
+                    // entry finishes, so stop holding it.
+                    if (rollback[thread_idx])
+                        pending_stores[thread_idx].combine_timer <= 0;
+                    else if (restart_combine_timer)
+                        pending_stores[thread_idx].combine_timer <= COMBINE_TIMER_WIDTH'(WRITE_COMBINE_CYCLES);
+                    else if (update_store_entry && (!can_write_combine
+                        || combined_mask == {CACHE_LINE_BYTES{1'b1}}))
+                    begin
+                        // A new entry that isn't held, or a combined store
+                        // that completed the line.
+                        pending_stores[thread_idx].combine_timer <= 0;
                     end
+                    else if (pending_stores[thread_idx].combine_timer != 0)
+                        pending_stores[thread_idx].combine_timer <= pending_stores[thread_idx].combine_timer - 1'b1;
 
                     if (sq_wake_bitmap[thread_idx])
                         pending_stores[thread_idx].thread_waiting <= 0;
@@ -307,7 +348,7 @@ module l1_store_queue(
     // New request out.
     // XXX may want to register this to reduce latency.
     assign sq_dequeue_ready = |send_grant_oh;
-    assign sq_dequeue_idx = send_grant_idx;
+    assign sq_dequeue_idx = l1_miss_entry_idx_t'(send_grant_idx);
     assign sq_dequeue_addr = pending_stores[send_grant_idx].address;
     assign sq_dequeue_mask = pending_stores[send_grant_idx].mask;
     assign sq_dequeue_data = pending_stores[send_grant_idx].data;
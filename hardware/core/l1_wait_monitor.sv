@@ -0,0 +1,122 @@
+//
+// Copyright 2018 Jeff Bush
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+`include "defines.svh"
+
+import defines::*;
+
+//
+// Wakes threads that are waiting for a write to a cache line (CR_WAIT_FOR_WRITE).
+// Each thread watches the line that its most recent synchronized load was
+// sent to the L2 cache for. Any later store or data cache invalidate
+// response for that line marks it written. The synchronized load records
+// this core in the L2 snoop filter entry for the line, so the L2 cache sends
+// it responses for writes from other cores, even if the line has since been
+// evicted from this core's L1 cache.
+//
+// When a thread writes CR_WAIT_FOR_WRITE, dcache_data_stage suspends it and
+// rolls it back to the next instruction. This wakes the thread when the line
+// it is watching has been written, or when an interrupt is pending and
+// enabled for it. If the thread isn't watching a line, this wakes it right
+// away. Waking stops the watch, so each wait must follow a new synchronized
+// load. Wakeups may be spurious (a failed synchronized store also sends a
+// store response), so software must check the value again.
+//
+
+module l1_wait_monitor(
+    input                               clk,
+    input                               reset,
+
+    // From dcache_data_stage
+    input                               dd_cache_miss,
+    input cache_line_index_t            dd_cache_miss_addr,
+    input local_thread_idx_t            dd_cache_miss_thread_idx,
+    input                               dd_cache_miss_sync,
+    input                               dd_wait_en,
+    input local_thread_idx_t            dd_wait_thread_idx,
+
+    // From control_registers
+    input local_thread_bitmap_t         cr_interrupt_pending,
+    input local_thread_bitmap_t         cr_interrupt_en,
+
+    // From l1_l2_interface
+    input                               l2_response_valid,
+    input l2rsp_packet_t                l2_response,
+
+    // To thread_select_stage
+    output local_thread_bitmap_t        wake_bitmap);
+
+    logic response_write;
+
+    assign response_write = l2_response_valid
+        && (l2_response.packet_type == L2RSP_STORE_ACK
+        || l2_response.packet_type == L2RSP_DINVALIDATE_ACK);
+
+    genvar thread_idx;
+    generate
+        for (thread_idx = 0; thread_idx < `THREADS_PER_CORE; thread_idx++)
+        begin : thread_gen
+            logic watch_valid;
+            cache_line_index_t watch_line;
+            logic written;
+            logic waiting;
+            logic start_watch;
+
+            assign start_watch = dd_cache_miss
+                && dd_cache_miss_sync
+                && dd_cache_miss_thread_idx == local_thread_idx_t'(thread_idx);
+            assign wake_bitmap[thread_idx] = waiting
+                && (!watch_valid || written
+                || (cr_interrupt_pending[thread_idx] && cr_interrupt_en[thread_idx]));
+
+            always_ff @(posedge clk, posedge reset)
+            begin
+                if (reset)
+                begin
+                    /*AUTORESET*/
+                    // Beginning of autoreset for uninitialized flops
+                    waiting <= '0;
+                    watch_line <= '0;
+                    watch_valid <= '0;
+                    written <= '0;
+                    // End of automatics
+                end
+                else
+                begin
+                    // A thread can't wait again until it has been woken.
+                    assert(!(dd_wait_en && dd_wait_thread_idx == local_thread_idx_t'(thread_idx)
+                        && waiting));
+
+                    if (dd_wait_en && dd_wait_thread_idx == local_thread_idx_t'(thread_idx))
+                        waiting <= 1;
+                    else if (wake_bitmap[thread_idx])
+                        waiting <= 0;
+
+                    if (start_watch)
+                    begin
+                        watch_valid <= 1;
+                        watch_line <= dd_cache_miss_addr;
+                        written <= 0;
+                    end
+                    else if (wake_bitmap[thread_idx])
+                        watch_valid <= 0;
+                    else if (response_write && l2_response.address == watch_line)
+                        written <= 1;
+                end
+            end
+        end
+    endgenerate
+endmodule
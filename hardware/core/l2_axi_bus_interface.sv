@@ -31,13 +31,17 @@ import defines::*;
 // The interface to system memory is the AMBA AXI interface.
 // http://www.arm.com/products/system-ip/amba-specifications.php
 //
+// The read address, read data, and write channels are handled independently.
+// This issues the addresses for up to MAX_OUTSTANDING_READS fills before the
+// data for the first one has arrived, and writebacks proceed while fill data
+// is being transferred. All reads use the same AXI ID, so the slave returns
+// their data in the order they were issued. Fills are moved from
+// pending_fill_fifo to outstanding_read_fifo when their address is accepted
+// and are reissued to the L2 pipeline in that order.
+//
 // I've tried to keep all bus logic consolidated in this module to make it
 // easier to swap this out for other bus implementations (eg Wishbone).
 //
-// Todo: This should issue the address for the next bus transaction before it
-// has finished the previous data transfer to improve utilization, especially
-// in systems with larger memory latency.
-//
 
 module l2_axi_bus_interface(
     input                                  clk,
@@ -51,6 +55,7 @@ module l2_axi_bus_interface(
     output cache_line_data_t               l2bi_data_from_memory,
     output logic                           l2bi_stall,
     output logic                           l2bi_collided_miss,
+    output logic                           l2bi_prefetch_ready,
 
     // From l2_cache_read_stage
     input                                  l2r_needs_writeback,
@@ -66,28 +71,39 @@ module l2_axi_bus_interface(
     output logic                           l2bi_perf_l2_writeback);
 
     typedef enum {
-        STATE_IDLE,
+        STATE_WRITE_IDLE,
         STATE_WRITE_ISSUE_ADDRESS,
-        STATE_WRITE_TRANSFER,
-        STATE_READ_ISSUE_ADDRESS,
-        STATE_READ_TRANSFER,
-        STATE_READ_COMPLETE
-    } bus_interface_state_t;
+        STATE_WRITE_TRANSFER
+    } write_state_t;
 
     typedef struct packed {
         cache_line_index_t address;
         cache_line_data_t data;
         logic flush;
         core_id_t core;
+        logic dma;
         l1_miss_entry_idx_t id;
     } writeback_fifo_entry_t;
 
+    typedef struct packed {
+        logic collided_miss;
+        logic skip_read;
+        l2req_packet_t request;
+    } outstanding_read_t;
+
     localparam FIFO_SIZE = 8;
 
+    // l2_cache_pending_miss_cam must be able to track all fills in both
+    // FIFOs, plus those in the L2 pipeline.
+    localparam MAX_OUTSTANDING_READS = 4;
+
     // This is the number of stages before this one in the pipeline. Assert the
     // signal to stop accepting new packets this number of cycles early so
     // requests that are already in the L2 pipeline don't overrun the FIFOs.
     localparam L2REQ_LATENCY = 4;
+    // Only accept prefetches when there are this many or fewer fills queued,
+    // leaving room for demand misses.
+    localparam PREFETCH_FILL_THRESHOLD = 1;
     localparam BURST_BEATS = CACHE_LINE_BITS / `AXI_DATA_WIDTH;
     localparam BURST_OFFSET_WIDTH = $clog2(BURST_BEATS);
 
@@ -105,14 +121,23 @@ module l2_axi_bus_interface(
     logic writeback_complete;
     logic writeback_fifo_almost_full;
     logic fill_queue_almost_full;
-    bus_interface_state_t state_ff;
-    bus_interface_state_t state_nxt;
-    logic[BURST_OFFSET_WIDTH - 1:0] burst_offset_ff;
-    logic[BURST_OFFSET_WIDTH - 1:0] burst_offset_nxt;
+    write_state_t write_state_ff;
+    write_state_t write_state_nxt;
+    logic[BURST_OFFSET_WIDTH - 1:0] write_offset_ff;
+    logic[BURST_OFFSET_WIDTH - 1:0] write_offset_nxt;
+    logic[BURST_OFFSET_WIDTH - 1:0] read_offset;
     logic[`AXI_DATA_WIDTH - 1:0] fill_buffer[0:BURST_BEATS - 1];
     logic restart_flush_request;
+    logic fill_collided_miss;
+    logic fill_skip_read;
     logic fill_dequeue_en;
-    l2req_packet_t lmq_out_request;
+    l2req_packet_t fill_request;
+    logic outstanding_full;
+    logic outstanding_empty;
+    logic outstanding_dequeue_en;
+    outstanding_read_t outstanding_read;
+    logic read_data_active;
+    logic read_data_done;
     writeback_fifo_entry_t writeback_fifo_in;
     writeback_fifo_entry_t writeback_fifo_out;
 
@@ -124,7 +149,9 @@ module l2_axi_bus_interface(
         && (l2r_request.packet_type == L2REQ_LOAD
         || l2r_request.packet_type == L2REQ_STORE
         || l2r_request.packet_type == L2REQ_LOAD_SYNC
-        || l2r_request.packet_type == L2REQ_STORE_SYNC);
+        || l2r_request.packet_type == L2REQ_STORE_SYNC
+        // If a fill for the line is already pending, drop the prefetch.
+        || (l2r_request.packet_type == L2REQ_PREFETCH && !duplicate_request));
     assign writeback_pending = !writeback_fifo_empty;
     assign fill_request_pending = !fill_queue_empty;
 
@@ -137,6 +164,7 @@ module l2_axi_bus_interface(
     assign writeback_fifo_in.data = l2r_data; // Old line to writeback
     assign writeback_fifo_in.flush = l2r_request.packet_type == L2REQ_FLUSH;
     assign writeback_fifo_in.core = l2r_request.core;
+    assign writeback_fifo_in.dma = l2r_request.dma;
     assign writeback_fifo_in.id = l2r_request.id;
 
     sync_fifo #(
@@ -162,7 +190,8 @@ module l2_axi_bus_interface(
     sync_fifo #(
         .WIDTH($bits(l2req_packet_t) + 1),
         .SIZE(FIFO_SIZE),
-        .ALMOST_FULL_THRESHOLD(FIFO_SIZE - L2REQ_LATENCY)
+        .ALMOST_FULL_THRESHOLD(FIFO_SIZE - L2REQ_LATENCY),
+        .ALMOST_EMPTY_THRESHOLD(PREFETCH_FILL_THRESHOLD)
     ) pending_fill_fifo(
         .clk(clk),
         .reset(reset),
@@ -171,9 +200,9 @@ module l2_axi_bus_interface(
         .enqueue_en(enqueue_fill_request),
         .enqueue_value({duplicate_request, l2r_request}),
         .empty(fill_queue_empty),
-        .almost_empty(),
+        .almost_empty(l2bi_prefetch_ready),
         .dequeue_en(fill_dequeue_en),
-        .dequeue_value({l2bi_collided_miss, lmq_out_request}),
+        .dequeue_value({fill_collided_miss, fill_request}),
         .full(/* ignore */));
 
     // Stop accepting new L2 packets until space is available in the queues
@@ -189,6 +218,59 @@ module l2_axi_bus_interface(
     assign axi_bus.m_aclk = clk;
     assign axi_bus.m_aresetn = !reset;
 
+    //
+    // Read address channel
+    //
+    // Skip the read and restart the request as soon as earlier fills finish if:
+    // 1. If there is already a pending L2 miss for this cache
+    //    line. Some other request has filled it, so
+    //    don't need to do anything but (try to) pick up the
+    //    result. That could result in another miss in some
+    //    cases, in which case must make another pass through
+    //    here.
+    // 2. It is a store that replaces the entire line.
+    //    Let this flow through the read miss queue instead
+    //    of handling it immediately in the pipeline
+    //    because it must go through the pending miss unit
+    //    to reconcile any other misses that may be in progress.
+    assign fill_skip_read = fill_collided_miss
+        || (fill_request.store_mask == {CACHE_LINE_BYTES{1'b1}}
+        && fill_request.packet_type == L2REQ_STORE);
+
+    // A fill moves to outstanding_read_fifo when the slave accepts its
+    // address, or immediately if it doesn't need to read.
+    assign fill_dequeue_en = fill_request_pending && !outstanding_full
+        && (fill_skip_read || (axi_bus.m_arvalid && axi_bus.s_arready));
+
+    sync_fifo #(
+        .WIDTH($bits(outstanding_read_t)),
+        .SIZE(MAX_OUTSTANDING_READS)
+    ) outstanding_read_fifo(
+        .clk(clk),
+        .reset(reset),
+        .flush_en(1'b0),
+        .almost_full(),
+        .enqueue_en(fill_dequeue_en),
+        .enqueue_value({fill_collided_miss, fill_skip_read, fill_request}),
+        .empty(outstanding_empty),
+        .almost_empty(),
+        .dequeue_en(outstanding_dequeue_en),
+        .dequeue_value(outstanding_read),
+        .full(outstanding_full));
+
+    //
+    // Read data channel
+    //
+    assign read_data_active = !outstanding_empty && !outstanding_read.skip_read
+        && !read_data_done;
+    assign axi_bus.m_rready = read_data_active;
+
+    // Push the response back into the L2 pipeline. This can't happen the same
+    // cycle as a restarted flush, so delay it until the next cycle if needed.
+    assign outstanding_dequeue_en = !outstanding_empty
+        && (outstanding_read.skip_read || read_data_done)
+        && !restart_flush_request;
+
     // Flatten array
     genvar fill_buffer_idx;
     generate
@@ -201,97 +283,44 @@ module l2_axi_bus_interface(
 
     logic wait_axi_write_response;
 
-    // Bus state machine
+    //
+    // Write channels
+    //
     always_comb
     begin
-        state_nxt = state_ff;
-        fill_dequeue_en = 0;
-        burst_offset_nxt = burst_offset_ff;
+        write_state_nxt = write_state_ff;
+        write_offset_nxt = write_offset_ff;
         writeback_complete = 0;
         restart_flush_request = 0;
 
-        unique case (state_ff)
-            STATE_IDLE:
+        unique case (write_state_ff)
+            STATE_WRITE_IDLE:
             begin
-                // Writebacks take precendence over loads to avoid a race condition
-                // where this loads stale data. Since loads can also enqueue writebacks,
-                // it ensures this doesn't overrun the write FIFO.
-                if (writeback_pending)
-                begin
-                    if (!wait_axi_write_response)
-                        state_nxt = STATE_WRITE_ISSUE_ADDRESS;
-                end
-                else if (fill_request_pending)
-                begin
-                    if (l2bi_collided_miss
-                        || (lmq_out_request.store_mask == {CACHE_LINE_BYTES{1'b1}}
-                        && lmq_out_request.packet_type == L2REQ_STORE))
-                    begin
-                        // Skip the read and restart the request immediately if:
-                        // 1. If there is already a pending L2 miss for this cache
-                        //    line. Some other request has filled it, so
-                        //    don't need to do anything but (try to) pick up the
-                        //    result. That could result in another miss in some
-                        //    cases, in which case must make another pass through
-                        //    here.
-                        // 2. It is a store that replaces the entire line.
-                        //    Let this flow through the read miss queue instead
-                        //    of handling it immediately in the pipeline
-                        //    because it must go through the pending miss unit
-                        //    to reconcile any other misses that may be in progress.
-                        state_nxt = STATE_READ_COMPLETE;
-                    end
-                    else
-                        state_nxt = STATE_READ_ISSUE_ADDRESS;
-                end
+                if (writeback_pending && !wait_axi_write_response)
+                    write_state_nxt = STATE_WRITE_ISSUE_ADDRESS;
             end
 
             STATE_WRITE_ISSUE_ADDRESS:
             begin
-                burst_offset_nxt = 0;
+                write_offset_nxt = 0;
                 if (axi_bus.s_awready)
-                    state_nxt = STATE_WRITE_TRANSFER;
+                    write_state_nxt = STATE_WRITE_TRANSFER;
             end
 
             STATE_WRITE_TRANSFER:
             begin
                 if (axi_bus.s_wready)
                 begin
-                    if (burst_offset_ff == {BURST_OFFSET_WIDTH{1'b1}})
+                    if (write_offset_ff == {BURST_OFFSET_WIDTH{1'b1}})
                     begin
                         writeback_complete = 1;
                         restart_flush_request = writeback_fifo_out.flush;
-                        state_nxt = STATE_IDLE;
+                        write_state_nxt = STATE_WRITE_IDLE;
                     end
 
-                    burst_offset_nxt = burst_offset_ff + BURST_OFFSET_WIDTH'(1);
+                    write_offset_nxt = write_offset_ff + BURST_OFFSET_WIDTH'(1);
                 end
             end
-
-            STATE_READ_ISSUE_ADDRESS:
-            begin
-                burst_offset_nxt = 0;
-                if (axi_bus.s_arready)
-                    state_nxt = STATE_READ_TRANSFER;
-            end
-
-            STATE_READ_TRANSFER:
-            begin
-                if (axi_bus.s_rvalid)
-                begin
-                    if (burst_offset_ff == {BURST_OFFSET_WIDTH{1'b1}})
-                        state_nxt = STATE_READ_COMPLETE;
-
-                    burst_offset_nxt = burst_offset_ff + BURST_OFFSET_WIDTH'(1);
-                end
-            end
-
-            STATE_READ_COMPLETE:
-            begin
-                // Push the response back into the L2 pipeline
-                state_nxt = STATE_IDLE;
-                fill_dequeue_en = 1'b1;
-            end
         endcase
     end
 
@@ -306,7 +335,8 @@ module l2_axi_bus_interface(
 
     always_comb
     begin
-        l2bi_request = lmq_out_request;
+        l2bi_request = outstanding_read.request;
+        l2bi_collided_miss = outstanding_read.collided_miss;
         if (restart_flush_request)
         begin
             // For this request, the other fields in the request packet are ignored.
@@ -315,48 +345,73 @@ module l2_axi_bus_interface(
             l2bi_request_valid = 1'b1;
             l2bi_request.packet_type = L2REQ_FLUSH;
             l2bi_request.core = writeback_fifo_out.core;
+            l2bi_request.dma = writeback_fifo_out.dma;
             l2bi_request.id = writeback_fifo_out.id;
             l2bi_request.cache_type = CT_DCACHE;
+            l2bi_collided_miss = 1'b0;
         end
         else
-            l2bi_request_valid = fill_dequeue_en;
+            l2bi_request_valid = outstanding_dequeue_en;
     end
 
     always_ff @(posedge clk, posedge reset)
     begin : update
         if (reset)
         begin
-            state_ff <= STATE_IDLE;
+            write_state_ff <= STATE_WRITE_IDLE;
             /*AUTORESET*/
             // Beginning of autoreset for uninitialized flops
             axi_bus.m_arvalid <= '0;
             axi_bus.m_awvalid <= '0;
-            axi_bus.m_rready <= '0;
             axi_bus.m_wlast <= '0;
             axi_bus.m_wvalid <= '0;
-            burst_offset_ff <= '0;
             l2bi_perf_l2_writeback <= '0;
+            read_data_done <= '0;
+            read_offset <= '0;
             wait_axi_write_response <= '0;
+            write_offset_ff <= '0;
             // End of automatics
         end
         else
         begin
-            state_ff <= state_nxt;
-            burst_offset_ff <= burst_offset_nxt;
+            write_state_ff <= write_state_nxt;
+            write_offset_ff <= write_offset_nxt;
 
             // Write response state machine
-            if (state_ff == STATE_WRITE_ISSUE_ADDRESS)
+            if (write_state_ff == STATE_WRITE_ISSUE_ADDRESS)
                 wait_axi_write_response <= 1;
             else if (axi_bus.s_bvalid)
                 wait_axi_write_response <= 0;
 
+            // Read address. Writebacks take precendence over loads to avoid
+            // a race condition where this loads stale data. Since loads can
+            // also enqueue writebacks, it ensures this doesn't overrun the
+            // write FIFO.
+            if (axi_bus.m_arvalid)
+            begin
+                if (axi_bus.s_arready)
+                    axi_bus.m_arvalid <= 0;
+            end
+            else if (fill_request_pending && !fill_skip_read && !outstanding_full
+                && !writeback_pending)
+                axi_bus.m_arvalid <= 1;
+
+            // Read data
+            if (outstanding_dequeue_en)
+                read_data_done <= 0;
+            else if (read_data_active && axi_bus.s_rvalid)
+            begin
+                if (read_offset == {BURST_OFFSET_WIDTH{1'b1}})
+                    read_data_done <= 1;
+
+                read_offset <= read_offset + BURST_OFFSET_WIDTH'(1);
+            end
+
             // Register AXI output signals
-            axi_bus.m_arvalid <= state_nxt == STATE_READ_ISSUE_ADDRESS;
-            axi_bus.m_rready <= state_nxt == STATE_READ_TRANSFER;
-            axi_bus.m_awvalid <= state_nxt == STATE_WRITE_ISSUE_ADDRESS;
-            axi_bus.m_wvalid <= state_nxt == STATE_WRITE_TRANSFER;
-            axi_bus.m_wlast <= state_nxt == STATE_WRITE_TRANSFER
-                && burst_offset_nxt == BURST_OFFSET_WIDTH'(BURST_BEATS - 1);
+            axi_bus.m_awvalid <= write_state_nxt == STATE_WRITE_ISSUE_ADDRESS;
+            axi_bus.m_wvalid <= write_state_nxt == STATE_WRITE_TRANSFER;
+            axi_bus.m_wlast <= write_state_nxt == STATE_WRITE_TRANSFER
+                && write_offset_nxt == BURST_OFFSET_WIDTH'(BURST_BEATS - 1);
             l2bi_perf_l2_writeback <= enqueue_writeback_request
                 && !writeback_fifo_almost_full;
         end
@@ -364,11 +419,13 @@ module l2_axi_bus_interface(
 
     always_ff @(posedge clk)
     begin
-        if (state_ff == STATE_READ_TRANSFER && axi_bus.s_rvalid)
-            fill_buffer[burst_offset_ff] <= axi_bus.s_rdata;
+        if (read_data_active && axi_bus.s_rvalid)
+            fill_buffer[read_offset] <= axi_bus.s_rdata;
+
+        if (!axi_bus.m_arvalid)
+            axi_bus.m_araddr <= {fill_request.address, {CACHE_LINE_OFFSET_WIDTH{1'b0}}};
 
-        axi_bus.m_araddr <= {l2bi_request.address, {CACHE_LINE_OFFSET_WIDTH{1'b0}}};
         axi_bus.m_awaddr <= {writeback_address, {CACHE_LINE_OFFSET_WIDTH{1'b0}}};
-        axi_bus.m_wdata <= writeback_lanes[~burst_offset_nxt];
+        axi_bus.m_wdata <= writeback_lanes[~write_offset_nxt];
     end
 endmodule
@@ -19,103 +19,456 @@
 import defines::*;
 
 //
-// The L2 cache has a four stage pipeline:
-//  - Arbitrate: selects one request from cores, or a restarted request
-//    (described below) to send to the next stage.
-//  - Tag: issues address to tag ram ways, checks LRU.
-//  - Read: checks for cache hit, reads cache memory
-//  - Update: generates signals to update cache memory and broadcasts response
-//    to cores.
-// When the cache detects a cache miss (after the read stage), it puts it into
-// a fill request queue. The system memory interface fetches the data, then
-// restarts the request (with the new data) at the beginning of the L2 pipeline.
-// If the evicted line has unwritten data, the read stage reads it from cache
-// memory and puts it into a writeback queue in the system memory interface.
-//
-// The L2 cache is physically indexed/physically tagged, and thus all addresses
-// used here are physical. Address translation is done by TLBs in the L1 caches.
+// The L2 cache is split into NUM_BANKS independent banks (l2_cache_bank),
+// which each accept one request per cycle. Cache lines are interleaved
+// between banks by the low bits of their address. This module connects the
+// banks to the cores, the DMA engine, and system memory:
+//  - Requests: each request goes to the bank that holds its line, with the
+//    bank index bits removed from the address. Requests to different banks
+//    are accepted in the same cycle.
+//  - Responses: each bank queues its responses. Every cycle, this delivers
+//    the response at the head of each queue if none of the cores (or the DMA
+//    engine) it is addressed to has already been given a response from
+//    another bank that cycle. A response is delivered to all of its
+//    destinations in the same cycle, so a core can't see a store
+//    acknowledged before the other cores have seen the store. Which bank is
+//    considered first rotates each cycle. A bank stops accepting new requests
+//    when its queue doesn't have room for the responses of requests it has
+//    already accepted.
+//  - System memory: banks share the AXI bus. Reads are arbitrated round
+//    robin and data is returned to banks in the order their addresses were
+//    accepted. A write burst holds the write channels until its write
+//    response arrives.
+// With one bank, this connects the bank directly.
 //
 
-module l2_cache(
-    input                                 clk,
-    input                                 reset,
+module l2_cache
+    #(parameter NUM_BANKS = `L2_BANKS)
+
+    (input                                 clk,
+    input                                  reset,
 
     // From l1_l2_interface
-    input [`NUM_CORES - 1:0]              l2i_request_valid,
-    input l2req_packet_t                  l2i_request[`NUM_CORES],
+    input [`NUM_CORES - 1:0]               l2i_request_valid,
+    input l2req_packet_t                   l2i_request[`NUM_CORES],
 
     // To l1_l2_interface
-    output logic                          l2_ready[`NUM_CORES],
-    output logic                          l2_response_valid,
-    output l2rsp_packet_t                 l2_response,
+    output logic                           l2_ready[`NUM_CORES],
+    output logic                           l2_core_response_valid[`NUM_CORES],
+    output l2rsp_packet_t                  l2_core_response[`NUM_CORES],
+
+    // From/to dma_engine
+    input                                  dma_l2_request_valid,
+    input l2req_packet_t                   dma_l2_request,
+    output logic                           l2_dma_ready,
+    output logic                           l2_dma_response_valid,
+    output l2rsp_packet_t                  l2_dma_response,
 
     // External bus interface
-    axi4_interface.master                 axi_bus,
-
-    // To performance_counters
-    output logic[L2_PERF_EVENTS - 1:0]    l2_perf_events);
-
-    /*AUTOLOGIC*/
-    // Beginning of automatic wires (for undeclared instantiated-module outputs)
-    cache_line_data_t   l2a_data_from_memory;   // From l2_cache_arb_stage of l2_cache_arb_stage.v
-    logic               l2a_l2_fill;            // From l2_cache_arb_stage of l2_cache_arb_stage.v
-    l2req_packet_t      l2a_request;            // From l2_cache_arb_stage of l2_cache_arb_stage.v
-    logic               l2a_request_valid;      // From l2_cache_arb_stage of l2_cache_arb_stage.v
-    logic               l2a_restarted_flush;    // From l2_cache_arb_stage of l2_cache_arb_stage.v
-    logic               l2bi_collided_miss;     // From l2_axi_bus_interface of l2_axi_bus_interface.v
-    cache_line_data_t   l2bi_data_from_memory;  // From l2_axi_bus_interface of l2_axi_bus_interface.v
-    logic               l2bi_perf_l2_writeback; // From l2_axi_bus_interface of l2_axi_bus_interface.v
-    l2req_packet_t      l2bi_request;           // From l2_axi_bus_interface of l2_axi_bus_interface.v
-    logic               l2bi_request_valid;     // From l2_axi_bus_interface of l2_axi_bus_interface.v
-    logic               l2bi_stall;             // From l2_axi_bus_interface of l2_axi_bus_interface.v
-    logic               l2r_cache_hit;          // From l2_cache_read_stage of l2_cache_read_stage.v
-    cache_line_data_t   l2r_data;               // From l2_cache_read_stage of l2_cache_read_stage.v
-    cache_line_data_t   l2r_data_from_memory;   // From l2_cache_read_stage of l2_cache_read_stage.v
-    logic [$clog2(`L2_WAYS*`L2_SETS)-1:0] l2r_hit_cache_idx;// From l2_cache_read_stage of l2_cache_read_stage.v
-    logic               l2r_l2_fill;            // From l2_cache_read_stage of l2_cache_read_stage.v
-    logic               l2r_needs_writeback;    // From l2_cache_read_stage of l2_cache_read_stage.v
-    logic               l2r_perf_l2_hit;        // From l2_cache_read_stage of l2_cache_read_stage.v
-    logic               l2r_perf_l2_miss;       // From l2_cache_read_stage of l2_cache_read_stage.v
-    l2req_packet_t      l2r_request;            // From l2_cache_read_stage of l2_cache_read_stage.v
-    logic               l2r_request_valid;      // From l2_cache_read_stage of l2_cache_read_stage.v
-    logic               l2r_restarted_flush;    // From l2_cache_read_stage of l2_cache_read_stage.v
-    logic               l2r_store_sync_success; // From l2_cache_read_stage of l2_cache_read_stage.v
-    logic [`L2_WAYS-1:0] l2r_update_dirty_en;   // From l2_cache_read_stage of l2_cache_read_stage.v
-    l2_set_idx_t        l2r_update_dirty_set;   // From l2_cache_read_stage of l2_cache_read_stage.v
-    logic               l2r_update_dirty_value; // From l2_cache_read_stage of l2_cache_read_stage.v
-    logic               l2r_update_lru_en;      // From l2_cache_read_stage of l2_cache_read_stage.v
-    l2_way_idx_t        l2r_update_lru_hit_way; // From l2_cache_read_stage of l2_cache_read_stage.v
-    logic [`L2_WAYS-1:0] l2r_update_tag_en;     // From l2_cache_read_stage of l2_cache_read_stage.v
-    l2_set_idx_t        l2r_update_tag_set;     // From l2_cache_read_stage of l2_cache_read_stage.v
-    logic               l2r_update_tag_valid;   // From l2_cache_read_stage of l2_cache_read_stage.v
-    l2_tag_t            l2r_update_tag_value;   // From l2_cache_read_stage of l2_cache_read_stage.v
-    l2_tag_t            l2r_writeback_tag;      // From l2_cache_read_stage of l2_cache_read_stage.v
-    cache_line_data_t   l2t_data_from_memory;   // From l2_cache_tag_stage of l2_cache_tag_stage.v
-    logic               l2t_dirty [`L2_WAYS];   // From l2_cache_tag_stage of l2_cache_tag_stage.v
-    l2_way_idx_t        l2t_fill_way;           // From l2_cache_tag_stage of l2_cache_tag_stage.v
-    logic               l2t_l2_fill;            // From l2_cache_tag_stage of l2_cache_tag_stage.v
-    l2req_packet_t      l2t_request;            // From l2_cache_tag_stage of l2_cache_tag_stage.v
-    logic               l2t_request_valid;      // From l2_cache_tag_stage of l2_cache_tag_stage.v
-    logic               l2t_restarted_flush;    // From l2_cache_tag_stage of l2_cache_tag_stage.v
-    l2_tag_t            l2t_tag [`L2_WAYS];     // From l2_cache_tag_stage of l2_cache_tag_stage.v
-    logic               l2t_valid [`L2_WAYS];   // From l2_cache_tag_stage of l2_cache_tag_stage.v
-    logic [$clog2(`L2_WAYS*`L2_SETS)-1:0] l2u_write_addr;// From l2_cache_update_stage of l2_cache_update_stage.v
-    cache_line_data_t   l2u_write_data;         // From l2_cache_update_stage of l2_cache_update_stage.v
-    logic               l2u_write_en;           // From l2_cache_update_stage of l2_cache_update_stage.v
-    // End of automatics
-
-    l2_cache_arb_stage l2_cache_arb_stage(.*);
-    l2_cache_tag_stage l2_cache_tag_stage(.*);
-    l2_cache_read_stage l2_cache_read_stage(.*);
-    l2_cache_update_stage l2_cache_update_stage(.*);
-
-    l2_axi_bus_interface l2_axi_bus_interface(.*);
-
-    // The number of signals in this assignment must match L2_PERF_EVENTS
-    // in defines.sv.
-    assign l2_perf_events = {
-        l2r_perf_l2_hit,
-        l2r_perf_l2_miss,
-        l2bi_perf_l2_writeback
-    };
+    axi4_interface.master                  axi_bus,
+
+    // To performance_counters. Each bank has L2_PERF_EVENTS events, with
+    // bank 0 in the low bits.
+    output logic[L2_PERF_EVENTS * NUM_BANKS - 1:0] l2_perf_events);
+
+    localparam BANK_IDX_WIDTH = $clog2(NUM_BANKS);
+
+    // Responses are sent to cores, then the DMA engine
+    localparam NUM_CLIENTS = `NUM_CORES + 1;
+    localparam DMA_CLIENT = `NUM_CORES;
+
+    // A bank may still send responses for requests it has accepted after it
+    // stops accepting new ones: up to four in its pipeline, plus those in
+    // the fill (8), outstanding read (4), and writeback (8) queues of
+    // l2_axi_bus_interface, which restart without waiting. The queue must
+    // have room for all of them when it asserts l2_response_stall.
+    localparam RESPONSE_QUEUE_SIZE = 32;
+    localparam RESPONSE_QUEUE_RESERVE = 24;
+
+    // l2_axi_bus_interface has up to four reads outstanding.
+    localparam MAX_OUTSTANDING_READS = 4 * NUM_BANKS;
+    localparam BURST_BEATS = CACHE_LINE_BITS / `AXI_DATA_WIDTH;
+    localparam BURST_OFFSET_WIDTH = $clog2(BURST_BEATS);
+
+    typedef logic[NUM_CLIENTS - 1:0] client_mask_t;
+
+    typedef struct packed {
+        client_mask_t clients;
+        l2rsp_packet_t response;
+    } queued_response_t;
+
+    logic[NUM_BANKS - 1:0] bank_l2_ready[`NUM_CORES];
+    logic[NUM_BANKS - 1:0] bank_dma_ready;
+    logic[NUM_BANKS - 1:0] bank_response_valid;
+    queued_response_t bank_response[NUM_BANKS];
+    logic[NUM_BANKS - 1:0] response_stall;
+    logic[NUM_BANKS - 1:0] bank_arvalid;
+    logic[NUM_BANKS - 1:0] bank_arready;
+    logic[AXI_ADDR_WIDTH - 1:0] bank_araddr[NUM_BANKS];
+    logic[NUM_BANKS - 1:0] bank_rvalid;
+    logic[NUM_BANKS - 1:0] bank_rready;
+    logic[NUM_BANKS - 1:0] bank_awvalid;
+    logic[NUM_BANKS - 1:0] bank_awready;
+    logic[AXI_ADDR_WIDTH - 1:0] bank_awaddr[NUM_BANKS];
+    logic[NUM_BANKS - 1:0] bank_wvalid;
+    logic[NUM_BANKS - 1:0] bank_wready;
+    logic[NUM_BANKS - 1:0] bank_wlast;
+    logic[`AXI_DATA_WIDTH - 1:0] bank_wdata[NUM_BANKS];
+    logic[NUM_BANKS - 1:0] bank_bvalid;
+
+    function logic in_bank(input cache_line_index_t line, input int bank);
+        return (line & cache_line_index_t'(NUM_BANKS - 1)) == cache_line_index_t'(bank);
+    endfunction
+
+    function cache_line_index_t to_bank_line(input cache_line_index_t line);
+        return line >> BANK_IDX_WIDTH;
+    endfunction
+
+    function cache_line_index_t from_bank_line(input cache_line_index_t line, input int bank);
+        return (line << BANK_IDX_WIDTH) | cache_line_index_t'(bank);
+    endfunction
+
+    function l2req_packet_t to_bank_request(input l2req_packet_t request);
+        l2req_packet_t bank_request;
+
+        bank_request = request;
+        bank_request.address = to_bank_line(request.address);
+        return bank_request;
+    endfunction
+
+    function logic[AXI_ADDR_WIDTH - 1:0] from_bank_axi_address(
+        input logic[AXI_ADDR_WIDTH - 1:0] address,
+        input int bank);
+
+        return {from_bank_line(address[AXI_ADDR_WIDTH - 1:CACHE_LINE_OFFSET_WIDTH], bank),
+            {CACHE_LINE_OFFSET_WIDTH{1'b0}}};
+    endfunction
+
+    genvar bank_idx;
+    genvar core_idx;
+    generate
+        for (bank_idx = 0; bank_idx < NUM_BANKS; bank_idx++)
+        begin : bank_gen
+            logic[`NUM_CORES - 1:0] bank_l2i_request_valid;
+            l2req_packet_t bank_l2i_request[`NUM_CORES];
+            logic bank_core_l2_ready[`NUM_CORES];
+            logic bank_dma_l2_request_valid;
+            l2req_packet_t bank_dma_l2_request;
+            logic bank_l2_response_valid;
+            logic bank_core_response_valid[`NUM_CORES];
+            l2rsp_packet_t bank_l2_response;
+            client_mask_t response_clients;
+            l2rsp_packet_t global_response;
+            axi4_interface bank_axi_bus();
+
+            for (core_idx = 0; core_idx < `NUM_CORES; core_idx++)
+            begin : core_request_gen
+                assign bank_l2i_request_valid[core_idx] = l2i_request_valid[core_idx]
+                    && in_bank(l2i_request[core_idx].address, bank_idx);
+                assign bank_l2i_request[core_idx] = to_bank_request(l2i_request[core_idx]);
+                assign bank_l2_ready[core_idx][bank_idx] = bank_core_l2_ready[core_idx];
+                assign response_clients[core_idx] = bank_core_response_valid[core_idx];
+            end
+
+            assign bank_dma_l2_request_valid = dma_l2_request_valid
+                && in_bank(dma_l2_request.address, bank_idx);
+            assign bank_dma_l2_request = to_bank_request(dma_l2_request);
+            assign response_clients[DMA_CLIENT] = bank_l2_response.dma;
+
+            always_comb
+            begin
+                global_response = bank_l2_response;
+                global_response.address = from_bank_line(bank_l2_response.address, bank_idx);
+            end
+
+            assign bank_response_valid[bank_idx] = bank_l2_response_valid;
+            assign bank_response[bank_idx] = {response_clients, global_response};
+
+            l2_cache_bank l2_cache_bank(
+                .l2i_request_valid(bank_l2i_request_valid),
+                .l2i_request(bank_l2i_request),
+                .l2_ready(bank_core_l2_ready),
+                .l2_response_valid(bank_l2_response_valid),
+                .l2_core_response_valid(bank_core_response_valid),
+                .l2_response(bank_l2_response),
+                .l2_response_stall(response_stall[bank_idx]),
+                .dma_l2_request_valid(bank_dma_l2_request_valid),
+                .dma_l2_request(bank_dma_l2_request),
+                .l2_dma_ready(bank_dma_ready[bank_idx]),
+                .axi_bus(bank_axi_bus),
+                .l2_perf_events(l2_perf_events[bank_idx * L2_PERF_EVENTS+:L2_PERF_EVENTS]),
+                .*);
+
+            assign bank_arvalid[bank_idx] = bank_axi_bus.m_arvalid;
+            assign bank_araddr[bank_idx] = bank_axi_bus.m_araddr;
+            assign bank_rready[bank_idx] = bank_axi_bus.m_rready;
+            assign bank_awvalid[bank_idx] = bank_axi_bus.m_awvalid;
+            assign bank_awaddr[bank_idx] = bank_axi_bus.m_awaddr;
+            assign bank_wvalid[bank_idx] = bank_axi_bus.m_wvalid;
+            assign bank_wlast[bank_idx] = bank_axi_bus.m_wlast;
+            assign bank_wdata[bank_idx] = bank_axi_bus.m_wdata;
+            assign bank_axi_bus.s_arready = bank_arready[bank_idx];
+            assign bank_axi_bus.s_rvalid = bank_rvalid[bank_idx];
+            assign bank_axi_bus.s_rdata = axi_bus.s_rdata;
+            assign bank_axi_bus.s_awready = bank_awready[bank_idx];
+            assign bank_axi_bus.s_wready = bank_wready[bank_idx];
+            assign bank_axi_bus.s_bvalid = bank_bvalid[bank_idx];
+        end
+
+        for (core_idx = 0; core_idx < `NUM_CORES; core_idx++)
+        begin : core_ready_gen
+            assign l2_ready[core_idx] = |bank_l2_ready[core_idx];
+        end
+    endgenerate
+
+    assign l2_dma_ready = |bank_dma_ready;
+
+    assign axi_bus.m_awlen = 8'(BURST_BEATS - 1);
+    assign axi_bus.m_arlen = 8'(BURST_BEATS - 1);
+    assign axi_bus.m_bready = 1'b1;
+    assign axi_bus.m_awprot = 3'b000;
+    assign axi_bus.m_arprot = 3'b000;
+    assign axi_bus.m_aclk = clk;
+    assign axi_bus.m_aresetn = !reset;
+
+    generate
+        if (NUM_BANKS == 1)
+        begin : single_bank_gen
+            assign response_stall = 1'b0;
+
+            for (core_idx = 0; core_idx < `NUM_CORES; core_idx++)
+            begin : core_response_gen
+                assign l2_core_response_valid[core_idx] = bank_response_valid[0]
+                    && bank_response[0].clients[core_idx];
+                assign l2_core_response[core_idx] = bank_response[0].response;
+            end
+
+            assign l2_dma_response_valid = bank_response_valid[0]
+                && bank_response[0].clients[DMA_CLIENT];
+            assign l2_dma_response = bank_response[0].response;
+
+            assign axi_bus.m_arvalid = bank_arvalid[0];
+            assign axi_bus.m_araddr = bank_araddr[0];
+            assign axi_bus.m_rready = bank_rready[0];
+            assign axi_bus.m_awvalid = bank_awvalid[0];
+            assign axi_bus.m_awaddr = bank_awaddr[0];
+            assign axi_bus.m_wvalid = bank_wvalid[0];
+            assign axi_bus.m_wlast = bank_wlast[0];
+            assign axi_bus.m_wdata = bank_wdata[0];
+            assign bank_arready[0] = axi_bus.s_arready;
+            assign bank_rvalid[0] = axi_bus.s_rvalid;
+            assign bank_awready[0] = axi_bus.s_awready;
+            assign bank_wready[0] = axi_bus.s_wready;
+            assign bank_bvalid[0] = axi_bus.s_bvalid;
+        end
+        else
+        begin : multi_bank_gen
+            logic[NUM_BANKS - 1:0] queue_empty;
+            logic[NUM_BANKS - 1:0] queue_grant;
+            queued_response_t queue_head[NUM_BANKS];
+            logic[BANK_IDX_WIDTH - 1:0] first_bank;
+            client_mask_t client_response_valid;
+            logic[NUM_BANKS - 1:0] read_arb_oh;
+            logic[NUM_BANKS - 1:0] read_locked_oh;
+            logic[NUM_BANKS - 1:0] read_select_oh;
+            logic[BANK_IDX_WIDTH - 1:0] read_select_idx;
+            logic read_locked;
+            logic read_address_accepted;
+            logic read_order_full;
+            logic read_order_empty;
+            logic[BANK_IDX_WIDTH - 1:0] read_data_bank;
+            logic[BURST_OFFSET_WIDTH - 1:0] read_offset;
+            logic read_data_accepted;
+            logic[NUM_BANKS - 1:0] write_arb_oh;
+            logic[NUM_BANKS - 1:0] write_locked_oh;
+            logic[NUM_BANKS - 1:0] write_select_oh;
+            logic[BANK_IDX_WIDTH - 1:0] write_select_idx;
+            logic write_locked;
+
+            //
+            // Responses
+            //
+            for (bank_idx = 0; bank_idx < NUM_BANKS; bank_idx++)
+            begin : response_queue_gen
+                sync_fifo #(
+                    .WIDTH($bits(queued_response_t)),
+                    .SIZE(RESPONSE_QUEUE_SIZE),
+                    .ALMOST_FULL_THRESHOLD(RESPONSE_QUEUE_SIZE - RESPONSE_QUEUE_RESERVE)
+                ) response_queue(
+                    .clk(clk),
+                    .reset(reset),
+                    .flush_en(1'b0),
+                    .full(/* ignore */),
+                    .almost_full(response_stall[bank_idx]),
+                    .enqueue_en(bank_response_valid[bank_idx]),
+                    .enqueue_value(bank_response[bank_idx]),
+                    .empty(queue_empty[bank_idx]),
+                    .almost_empty(),
+                    .dequeue_en(queue_grant[bank_idx]),
+                    .dequeue_value(queue_head[bank_idx]));
+            end
+
+            always_comb
+            begin
+                client_mask_t claimed_clients;
+
+                claimed_clients = '0;
+                queue_grant = '0;
+                for (int i = 0; i < NUM_BANKS; i++)
+                begin
+                    logic[BANK_IDX_WIDTH - 1:0] bank;
+
+                    bank = first_bank + BANK_IDX_WIDTH'(i);
+                    if (!queue_empty[bank] && (queue_head[bank].clients & claimed_clients) == '0)
+                    begin
+                        queue_grant[bank] = 1;
+                        claimed_clients |= queue_head[bank].clients;
+                    end
+                end
+
+                client_response_valid = claimed_clients;
+            end
+
+            always_ff @(posedge clk, posedge reset)
+            begin
+                if (reset)
+                begin
+                    first_bank <= '0;
+                    l2_dma_response_valid <= 0;
+                    for (int i = 0; i < `NUM_CORES; i++)
+                        l2_core_response_valid[i] <= 0;
+                end
+                else
+                begin
+                    first_bank <= first_bank + BANK_IDX_WIDTH'(1);
+                    l2_dma_response_valid <= client_response_valid[DMA_CLIENT];
+                    for (int i = 0; i < `NUM_CORES; i++)
+                        l2_core_response_valid[i] <= client_response_valid[i];
+                end
+            end
+
+            always_ff @(posedge clk)
+            begin
+                for (int bank = 0; bank < NUM_BANKS; bank++)
+                begin
+                    if (queue_grant[bank])
+                    begin
+                        for (int i = 0; i < `NUM_CORES; i++)
+                        begin
+                            if (queue_head[bank].clients[i])
+                                l2_core_response[i] <= queue_head[bank].response;
+                        end
+
+                        if (queue_head[bank].clients[DMA_CLIENT])
+                            l2_dma_response <= queue_head[bank].response;
+                    end
+                end
+            end
+
+            //
+            // Read address and data channels
+            //
+            rr_arbiter #(.NUM_REQUESTERS(NUM_BANKS)) read_arbiter(
+                .request(bank_arvalid),
+                .update_lru(read_address_accepted),
+                .grant_oh(read_arb_oh),
+                .*);
+
+            // Once the address is presented, it must not change until the
+            // slave accepts it.
+            assign read_select_oh = read_locked ? read_locked_oh : read_arb_oh;
+
+            oh_to_idx #(.NUM_SIGNALS(NUM_BANKS)) oh_to_idx_read(
+                .one_hot(read_select_oh),
+                .index(read_select_idx));
+
+            assign axi_bus.m_arvalid = |read_select_oh && (read_locked || !read_order_full);
+            assign axi_bus.m_araddr = from_bank_axi_address(bank_araddr[read_select_idx],
+                int'(read_select_idx));
+            assign read_address_accepted = axi_bus.m_arvalid && axi_bus.s_arready;
+            assign bank_arready = read_select_oh & {NUM_BANKS{read_address_accepted}};
+
+            // Tracks which bank each outstanding read belongs to
+            sync_fifo #(
+                .WIDTH(BANK_IDX_WIDTH),
+                .SIZE(MAX_OUTSTANDING_READS)
+            ) read_order_fifo(
+                .clk(clk),
+                .reset(reset),
+                .flush_en(1'b0),
+                .full(read_order_full),
+                .almost_full(),
+                .enqueue_en(read_address_accepted),
+                .enqueue_value(read_select_idx),
+                .empty(read_order_empty),
+                .almost_empty(),
+                .dequeue_en(read_data_accepted
+                    && read_offset == BURST_OFFSET_WIDTH'(BURST_BEATS - 1)),
+                .dequeue_value(read_data_bank));
+
+            assign axi_bus.m_rready = !read_order_empty && bank_rready[read_data_bank];
+            assign read_data_accepted = axi_bus.m_rready && axi_bus.s_rvalid;
+
+            always_comb
+            begin
+                bank_rvalid = '0;
+                bank_rvalid[read_data_bank] = axi_bus.s_rvalid && !read_order_empty;
+            end
+
+            //
+            // Write address, data, and response channels
+            //
+            rr_arbiter #(.NUM_REQUESTERS(NUM_BANKS)) write_arbiter(
+                .request(bank_awvalid),
+                .update_lru(!write_locked && |bank_awvalid),
+                .grant_oh(write_arb_oh),
+                .*);
+
+            assign write_select_oh = write_locked ? write_locked_oh : write_arb_oh;
+
+            oh_to_idx #(.NUM_SIGNALS(NUM_BANKS)) oh_to_idx_write(
+                .one_hot(write_select_oh),
+                .index(write_select_idx));
+
+            assign axi_bus.m_awvalid = |(bank_awvalid & write_select_oh);
+            assign axi_bus.m_awaddr = from_bank_axi_address(bank_awaddr[write_select_idx],
+                int'(write_select_idx));
+            assign axi_bus.m_wvalid = |(bank_wvalid & write_select_oh);
+            assign axi_bus.m_wlast = bank_wlast[write_select_idx];
+            assign axi_bus.m_wdata = bank_wdata[write_select_idx];
+            assign bank_awready = write_select_oh & {NUM_BANKS{axi_bus.s_awready}};
+            assign bank_wready = write_select_oh & {NUM_BANKS{axi_bus.s_wready}};
+            assign bank_bvalid = write_locked_oh & {NUM_BANKS{write_locked && axi_bus.s_bvalid}};
+
+            always_ff @(posedge clk, posedge reset)
+            begin
+                if (reset)
+                begin
+                    read_locked <= 0;
+                    read_locked_oh <= '0;
+                    read_offset <= '0;
+                    write_locked <= 0;
+                    write_locked_oh <= '0;
+                end
+                else
+                begin
+                    read_locked <= axi_bus.m_arvalid && !axi_bus.s_arready;
+                    read_locked_oh <= read_select_oh;
+                    if (read_data_accepted)
+                        read_offset <= read_offset + BURST_OFFSET_WIDTH'(1);
+
+                    if (!write_locked)
+                    begin
+                        if (|bank_awvalid)
+                        begin
+                            write_locked <= 1;
+                            write_locked_oh <= write_arb_oh;
+                        end
+                    end
+                    else if (axi_bus.s_bvalid)
+                        write_locked <= 0;
+                end
+            end
+        end
+    endgenerate
 endmodule
@@ -20,8 +20,13 @@ import defines::*;
 
 //
 // l2 request arbiter stage.
-// Selects among core L2 requests and restarted request from fill interface.
-// Restarted requests take precedence to avoid the miss queue filling up.
+// Selects among core L2 requests, DMA engine requests, restarted request from
+// fill interface, and prefetch requests. Restarted requests take precedence to
+// avoid the miss queue filling up. The DMA engine is arbitrated round robin
+// with the cores. Prefetches have the lowest priority and are only accepted
+// when the miss queue is nearly empty. New requests also wait while
+// l2_cache can't queue more responses from this bank, but restarted requests
+// don't, because l2_cache reserves space for their responses.
 // l2_ready depends combinationally on the valid signals in the request
 // packets, so valid bits must not be dependent on l2_ready to avoid a
 // combinational loop.
@@ -36,6 +41,11 @@ module l2_cache_arb_stage(
     input l2req_packet_t                  l2i_request[`NUM_CORES],
     output logic                          l2_ready[`NUM_CORES],
 
+    // From dma_engine
+    input                                 dma_l2_request_valid,
+    input l2req_packet_t                  dma_l2_request,
+    output logic                          l2_dma_ready,
+
     // To l2_cache_tag_stage
     output logic                          l2a_request_valid,
     output l2req_packet_t                 l2a_request,
@@ -48,48 +58,68 @@ module l2_cache_arb_stage(
     input l2req_packet_t                  l2bi_request,
     input cache_line_data_t               l2bi_data_from_memory,
     input                                 l2bi_stall,
-    input                                 l2bi_collided_miss);
+    input                                 l2bi_collided_miss,
+    input                                 l2bi_prefetch_ready,
+
+    // From l2_cache
+    input                                 l2_response_stall,
+
+    // From/to l2_cache_prefetcher
+    input                                 l2pf_request_valid,
+    input cache_line_index_t              l2pf_address,
+    output logic                          l2a_prefetch_accepted);
+
+    localparam NUM_REQUESTERS = `NUM_CORES + 1;
 
     logic can_accept_request;
+    logic[NUM_REQUESTERS - 1:0] request_valid;
+    l2req_packet_t request[NUM_REQUESTERS];
     l2req_packet_t grant_request;
-    logic[`NUM_CORES - 1:0] grant_oh;
+    logic[NUM_REQUESTERS - 1:0] grant_oh;
+    logic[$clog2(NUM_REQUESTERS) - 1:0] grant_idx;
     logic restarted_flush;
+    l2req_packet_t prefetch_request;
 
-    assign can_accept_request = !l2bi_request_valid && !l2bi_stall;
+    assign can_accept_request = !l2bi_request_valid && !l2bi_stall && !l2_response_stall;
     assign restarted_flush = l2bi_request.packet_type == L2REQ_FLUSH;
+    assign l2a_prefetch_accepted = l2pf_request_valid && can_accept_request
+        && !(|request_valid) && l2bi_prefetch_ready;
+
+    always_comb
+    begin
+        prefetch_request = grant_request;
+        prefetch_request.packet_type = L2REQ_PREFETCH;
+        prefetch_request.dma = 0;
+        prefetch_request.cache_type = CT_DCACHE;
+        prefetch_request.address = l2pf_address;
+        prefetch_request.store_mask = '0;
+    end
+
+    // The DMA engine is the last requester
+    assign request_valid = {dma_l2_request_valid, l2i_request_valid};
+    assign l2_dma_ready = grant_oh[`NUM_CORES] && can_accept_request;
+    assign request[`NUM_CORES] = dma_l2_request;
 
     genvar request_idx;
     generate
         for (request_idx = 0; request_idx < `NUM_CORES; request_idx++)
         begin : handshake_gen
             assign l2_ready[request_idx] = grant_oh[request_idx] && can_accept_request;
+            assign request[request_idx] = l2i_request[request_idx];
         end
     endgenerate
 
-    generate
-        if (`NUM_CORES > 1)
-        begin
-            core_id_t grant_idx;
+    rr_arbiter #(.NUM_REQUESTERS(NUM_REQUESTERS)) request_arbiter(
+        .request(request_valid),
+        .update_lru(can_accept_request),
+        .grant_oh(grant_oh),
+        .*);
 
-            rr_arbiter #(.NUM_REQUESTERS(`NUM_CORES)) request_arbiter(
-                .request(l2i_request_valid),
-                .update_lru(can_accept_request),
-                .grant_oh(grant_oh),
-                .*);
+    oh_to_idx #(.NUM_SIGNALS(NUM_REQUESTERS)) oh_to_idx_grant(
+        .one_hot(grant_oh),
+        .index(grant_idx));
 
-            oh_to_idx #(.NUM_SIGNALS(`NUM_CORES)) oh_to_idx_grant(
-                .one_hot(grant_oh),
-                .index(grant_idx[CORE_ID_WIDTH - 1:0]));
-
-            assign grant_request = l2i_request[grant_idx[CORE_ID_WIDTH - 1:0]];
-        end
-        else
-        begin
-            // Single core
-            assign grant_oh[0] = l2i_request_valid[0];
-            assign grant_request = l2i_request[0];
-        end
-    endgenerate
+    assign grant_request = request[grant_idx];
 
     always_ff @(posedge clk)
     begin
@@ -101,9 +131,15 @@ module l2_cache_arb_stage(
             l2a_l2_fill <= !l2bi_collided_miss && !restarted_flush;
             l2a_restarted_flush <= restarted_flush;
         end
+        else if (l2a_prefetch_accepted)
+        begin
+            l2a_request <= prefetch_request;
+            l2a_l2_fill <= 0;
+            l2a_restarted_flush <= 0;
+        end
         else
         begin
-            // New request from a core
+            // New request from a core or the DMA engine
             l2a_request <= grant_request;
             l2a_l2_fill <= 0;
             l2a_restarted_flush <= 0;
@@ -125,7 +161,9 @@ module l2_cache_arb_stage(
                 assert(l2bi_request.packet_type != L2REQ_DINVALIDATE);
                 l2a_request_valid <= 1;
             end
-            else if (|l2i_request_valid && can_accept_request)
+            else if (|request_valid && can_accept_request)
+                l2a_request_valid <= 1;
+            else if (l2a_prefetch_accepted)
                 l2a_request_valid <= 1;
             else
             begin
@@ -0,0 +1,158 @@
+//
+// Copyright 2011-2015 Jeff Bush
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+`include "defines.svh"
+
+import defines::*;
+
+//
+// One bank of the L2 cache. l2_cache routes requests for a subset of cache
+// lines here, with the bank index bits removed from the address, so every
+// address in this module is bank local.
+//
+// Each bank has a four stage pipeline:
+//  - Arbitrate: selects one request from cores or the DMA engine, or a
+//    restarted request (described below) to send to the next stage.
+//  - Tag: issues address to tag ram ways, checks LRU.
+//  - Read: checks for cache hit, reads cache memory
+//  - Update: generates signals to update cache memory and sends the response
+//    to cores. A snoop filter tracks which cores may have each line in their
+//    L1 data cache, so store and invalidate responses only go to those cores.
+// A prefetcher watches data misses and injects requests for lines ahead of
+// strided streams through the arbiter. These fill the cache like misses, but
+// don't send responses to the cores.
+// When the cache detects a cache miss (after the read stage), it puts it into
+// a fill request queue. The system memory interface fetches the data, then
+// restarts the request (with the new data) at the beginning of the L2 pipeline.
+// If the evicted line has unwritten data, the read stage reads it from cache
+// memory and puts it into a writeback queue in the system memory interface.
+//
+// The L2 cache is physically indexed/physically tagged, and thus all addresses
+// used here are physical. Address translation is done by TLBs in the L1 caches.
+//
+
+module l2_cache_bank(
+    input                                 clk,
+    input                                 reset,
+
+    // From l1_l2_interface
+    input [`NUM_CORES - 1:0]              l2i_request_valid,
+    input l2req_packet_t                  l2i_request[`NUM_CORES],
+
+    // To l1_l2_interface
+    output logic                          l2_ready[`NUM_CORES],
+    output logic                          l2_response_valid,
+    output logic                          l2_core_response_valid[`NUM_CORES],
+    output l2rsp_packet_t                 l2_response,
+
+    // From l2_cache
+    input                                 l2_response_stall,
+
+    // From/to dma_engine
+    input                                 dma_l2_request_valid,
+    input l2req_packet_t                  dma_l2_request,
+    output logic                          l2_dma_ready,
+
+    // External bus interface
+    axi4_interface.master                 axi_bus,
+
+    // To performance_counters
+    output logic[L2_PERF_EVENTS - 1:0]    l2_perf_events);
+
+    /*AUTOLOGIC*/
+    // Beginning of automatic wires (for undeclared instantiated-module outputs)
+    cache_line_data_t   l2a_data_from_memory;   // From l2_cache_arb_stage of l2_cache_arb_stage.v
+    logic               l2a_l2_fill;            // From l2_cache_arb_stage of l2_cache_arb_stage.v
+    logic               l2a_prefetch_accepted;  // From l2_cache_arb_stage of l2_cache_arb_stage.v
+    l2req_packet_t      l2a_request;            // From l2_cache_arb_stage of l2_cache_arb_stage.v
+    logic               l2a_request_valid;      // From l2_cache_arb_stage of l2_cache_arb_stage.v
+    logic               l2a_restarted_flush;    // From l2_cache_arb_stage of l2_cache_arb_stage.v
+    logic               l2bi_collided_miss;     // From l2_axi_bus_interface of l2_axi_bus_interface.v
+    cache_line_data_t   l2bi_data_from_memory;  // From l2_axi_bus_interface of l2_axi_bus_interface.v
+    logic               l2bi_perf_l2_writeback; // From l2_axi_bus_interface of l2_axi_bus_interface.v
+    logic               l2bi_prefetch_ready;    // From l2_axi_bus_interface of l2_axi_bus_interface.v
+    l2req_packet_t      l2bi_request;           // From l2_axi_bus_interface of l2_axi_bus_interface.v
+    logic               l2bi_request_valid;     // From l2_axi_bus_interface of l2_axi_bus_interface.v
+    logic               l2bi_stall;             // From l2_axi_bus_interface of l2_axi_bus_interface.v
+    cache_line_index_t  l2pf_address;           // From l2_cache_prefetcher of l2_cache_prefetcher.v
+    logic               l2pf_request_valid;     // From l2_cache_prefetcher of l2_cache_prefetcher.v
+    logic               l2r_cache_hit;          // From l2_cache_read_stage of l2_cache_read_stage.v
+    cache_line_data_t   l2r_data;               // From l2_cache_read_stage of l2_cache_read_stage.v
+    cache_line_data_t   l2r_data_from_memory;   // From l2_cache_read_stage of l2_cache_read_stage.v
+    logic [$clog2(`L2_WAYS*`L2_SETS)-1:0] l2r_hit_cache_idx;// From l2_cache_read_stage of l2_cache_read_stage.v
+    logic               l2r_l2_fill;            // From l2_cache_read_stage of l2_cache_read_stage.v
+    logic               l2r_needs_writeback;    // From l2_cache_read_stage of l2_cache_read_stage.v
+    logic               l2r_perf_l2_hit;        // From l2_cache_read_stage of l2_cache_read_stage.v
+    logic               l2r_perf_l2_miss;       // From l2_cache_read_stage of l2_cache_read_stage.v
+    logic               l2r_perf_prefetch_useful;// From l2_cache_read_stage of l2_cache_read_stage.v
+    logic               l2r_perf_prefetch_useless;// From l2_cache_read_stage of l2_cache_read_stage.v
+    logic               l2r_prefetch_trigger;   // From l2_cache_read_stage of l2_cache_read_stage.v
+    l2req_packet_t      l2r_request;            // From l2_cache_read_stage of l2_cache_read_stage.v
+    logic               l2r_request_valid;      // From l2_cache_read_stage of l2_cache_read_stage.v
+    logic               l2r_restarted_flush;    // From l2_cache_read_stage of l2_cache_read_stage.v
+    logic               l2r_store_sync_success; // From l2_cache_read_stage of l2_cache_read_stage.v
+    logic [`L2_WAYS-1:0] l2r_update_dirty_en;   // From l2_cache_read_stage of l2_cache_read_stage.v
+    l2_set_idx_t        l2r_update_dirty_set;   // From l2_cache_read_stage of l2_cache_read_stage.v
+    logic               l2r_update_dirty_value; // From l2_cache_read_stage of l2_cache_read_stage.v
+    logic               l2r_update_lru_en;      // From l2_cache_read_stage of l2_cache_read_stage.v
+    l2_way_idx_t        l2r_update_lru_hit_way; // From l2_cache_read_stage of l2_cache_read_stage.v
+    logic [`L2_WAYS-1:0] l2r_update_prefetched_en;// From l2_cache_read_stage of l2_cache_read_stage.v
+    l2_set_idx_t        l2r_update_prefetched_set;// From l2_cache_read_stage of l2_cache_read_stage.v
+    logic               l2r_update_prefetched_value;// From l2_cache_read_stage of l2_cache_read_stage.v
+    logic [`L2_WAYS-1:0] l2r_update_tag_en;     // From l2_cache_read_stage of l2_cache_read_stage.v
+    l2_set_idx_t        l2r_update_tag_set;     // From l2_cache_read_stage of l2_cache_read_stage.v
+    logic               l2r_update_tag_valid;   // From l2_cache_read_stage of l2_cache_read_stage.v
+    l2_tag_t            l2r_update_tag_value;   // From l2_cache_read_stage of l2_cache_read_stage.v
+    l2_tag_t            l2r_writeback_tag;      // From l2_cache_read_stage of l2_cache_read_stage.v
+    logic [`NUM_CORES-1:0] l2sf_sharers;        // From l2_cache_snoop_filter of l2_cache_snoop_filter.v
+    cache_line_data_t   l2t_data_from_memory;   // From l2_cache_tag_stage of l2_cache_tag_stage.v
+    logic               l2t_dirty [`L2_WAYS];   // From l2_cache_tag_stage of l2_cache_tag_stage.v
+    l2_way_idx_t        l2t_fill_way;           // From l2_cache_tag_stage of l2_cache_tag_stage.v
+    logic               l2t_l2_fill;            // From l2_cache_tag_stage of l2_cache_tag_stage.v
+    logic               l2t_prefetched [`L2_WAYS];// From l2_cache_tag_stage of l2_cache_tag_stage.v
+    l2req_packet_t      l2t_request;            // From l2_cache_tag_stage of l2_cache_tag_stage.v
+    logic               l2t_request_valid;      // From l2_cache_tag_stage of l2_cache_tag_stage.v
+    logic               l2t_restarted_flush;    // From l2_cache_tag_stage of l2_cache_tag_stage.v
+    l2_tag_t            l2t_tag [`L2_WAYS];     // From l2_cache_tag_stage of l2_cache_tag_stage.v
+    logic               l2t_valid [`L2_WAYS];   // From l2_cache_tag_stage of l2_cache_tag_stage.v
+    logic               l2u_perf_snoop_filtered;// From l2_cache_update_stage of l2_cache_update_stage.v
+    logic               l2u_perf_snoop_sent;    // From l2_cache_update_stage of l2_cache_update_stage.v
+    logic [$clog2(`L2_WAYS*`L2_SETS)-1:0] l2u_write_addr;// From l2_cache_update_stage of l2_cache_update_stage.v
+    cache_line_data_t   l2u_write_data;         // From l2_cache_update_stage of l2_cache_update_stage.v
+    logic               l2u_write_en;           // From l2_cache_update_stage of l2_cache_update_stage.v
+    // End of automatics
+
+    l2_cache_arb_stage l2_cache_arb_stage(.*);
+    l2_cache_tag_stage l2_cache_tag_stage(.*);
+    l2_cache_read_stage l2_cache_read_stage(.*);
+    l2_cache_update_stage l2_cache_update_stage(.*);
+    l2_cache_snoop_filter l2_cache_snoop_filter(.*);
+
+    l2_axi_bus_interface l2_axi_bus_interface(.*);
+    l2_cache_prefetcher l2_cache_prefetcher(.*);
+
+    // The number of signals in this assignment must match L2_PERF_EVENTS
+    // in defines.sv.
+    assign l2_perf_events = {
+        l2u_perf_snoop_filtered,
+        l2u_perf_snoop_sent,
+        l2r_perf_prefetch_useless,
+        l2r_perf_prefetch_useful,
+        l2r_perf_l2_hit,
+        l2r_perf_l2_miss,
+        l2bi_perf_l2_writeback
+    };
+endmodule
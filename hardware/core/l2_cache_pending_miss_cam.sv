@@ -31,8 +31,9 @@ import defines::*;
 //
 // The pending miss for the line may be anywhere in the L2 pipeline,
 // not just the l2 bus interface. Because of this, QUEUE_SIZE must be greater
-// than or equal to the number of entries in the bus interface request queue
-// + the number of pipeline stages.
+// than or equal to the number of entries in the bus interface request queues
+// (including reads that have been issued to memory) + the number of pipeline
+// stages.
 //
 
 module l2_cache_pending_miss_cam
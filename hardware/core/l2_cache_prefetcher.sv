@@ -0,0 +1,129 @@
+//
+// Copyright 2018 Jeff Bush
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+`include "defines.svh"
+
+import defines::*;
+
+//
+// L2 cache hardware prefetcher.
+// Detects strided data streams and requests lines ahead of them. A stream
+// is tracked for each hardware thread (the low bits of the requester ID in
+// the L2 request packet), because interleaved accesses from several threads would otherwise
+// hide each other's patterns. Sequential (next-line) streams are the case
+// where the stride is one.
+//
+// The read stage signals a trigger when a data request misses, or hits a
+// line that was brought in by a prefetch (so a stream that is being
+// prefetched successfully keeps running ahead). If the distance between this
+// line and the previous trigger for the thread is the same as the stride
+// previously observed, this requests the line L2_PREFETCH_DISTANCE strides
+// ahead. Prefetches don't cross page boundaries, because adjacent physical
+// pages are usually not related.
+//
+// This holds one request. A new prefetch replaces one the arbiter hasn't
+// accepted yet, since the newer one is more likely to be useful. The arbiter
+// only accepts a prefetch when there are no requests from cores and the miss
+// queue is nearly empty, so prefetches don't delay demand misses.
+//
+
+module l2_cache_prefetcher(
+    input                       clk,
+    input                       reset,
+
+    // From l2_cache_read_stage
+    input                       l2r_prefetch_trigger,
+    input l2req_packet_t        l2r_request,
+
+    // To/from l2_cache_arb_stage
+    output logic                l2pf_request_valid,
+    output cache_line_index_t   l2pf_address,
+    input                       l2a_prefetch_accepted);
+
+    localparam GLOBAL_THREAD_IDX_WIDTH = $clog2(TOTAL_THREADS);
+    localparam LINES_PER_PAGE_WIDTH = $clog2(PAGE_SIZE / CACHE_LINE_BYTES);
+
+    generate
+        if (`L2_PREFETCH_DISTANCE == 0)
+        begin : prefetch_disabled_gen
+            assign l2pf_request_valid = 0;
+            assign l2pf_address = '0;
+        end
+        else
+        begin : prefetch_enabled_gen
+            cache_line_index_t last_line[TOTAL_THREADS];
+            cache_line_index_t stride[TOTAL_THREADS];
+            logic last_line_valid[TOTAL_THREADS];
+            logic[GLOBAL_THREAD_IDX_WIDTH - 1:0] slot;
+            cache_line_index_t trigger_line;
+            cache_line_index_t new_stride;
+            cache_line_index_t prefetch_line;
+            logic stream_confirmed;
+            logic same_page;
+
+            assign slot = GLOBAL_THREAD_IDX_WIDTH'({l2r_request.core,
+                local_thread_idx_t'(l2r_request.id)});
+            assign trigger_line = {l2r_request.address.tag, l2r_request.address.set_idx};
+            assign new_stride = trigger_line - last_line[slot];
+            assign stream_confirmed = last_line_valid[slot] && new_stride == stride[slot]
+                && new_stride != 0;
+            assign prefetch_line = trigger_line
+                + new_stride * cache_line_index_t'(`L2_PREFETCH_DISTANCE);
+            assign same_page = prefetch_line[$bits(cache_line_index_t) - 1:LINES_PER_PAGE_WIDTH]
+                == trigger_line[$bits(cache_line_index_t) - 1:LINES_PER_PAGE_WIDTH];
+
+            always_ff @(posedge clk, posedge reset)
+            begin
+                if (reset)
+                begin
+                    for (int i = 0; i < TOTAL_THREADS; i++)
+                    begin
+                        last_line_valid[i] <= 0;
+                        last_line[i] <= '0;
+                        stride[i] <= '0;
+                    end
+
+                    /*AUTORESET*/
+                    // Beginning of autoreset for uninitialized flops
+                    l2pf_address <= '0;
+                    l2pf_request_valid <= '0;
+                    // End of automatics
+                end
+                else
+                begin
+                    // A restarted request that collided with a fill for the
+                    // same line triggers again. Ignore it so it doesn't reset
+                    // the stride.
+                    if (l2r_prefetch_trigger && (!last_line_valid[slot]
+                        || trigger_line != last_line[slot]))
+                    begin
+                        last_line[slot] <= trigger_line;
+                        last_line_valid[slot] <= 1;
+                        stride[slot] <= last_line_valid[slot] ? new_stride : '0;
+                    end
+
+                    if (l2r_prefetch_trigger && stream_confirmed && same_page)
+                    begin
+                        l2pf_request_valid <= 1;
+                        l2pf_address <= prefetch_line;
+                    end
+                    else if (l2a_prefetch_accepted)
+                        l2pf_request_valid <= 0;
+                end
+            end
+        end
+    endgenerate
+endmodule
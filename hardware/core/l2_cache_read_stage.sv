@@ -34,6 +34,10 @@ import defines::*;
 //   * If this is a store request, sets the dirty bit
 // - Drives signals to update tags in prevous stage if this is a cache fill.
 // - Tracks synchronized load/store state.
+// - Tracks which lines were filled by prefetches and haven't been accessed
+//   yet, and signals the prefetcher when a data access from a core misses or
+//   hits one of those lines. DMA engine accesses don't train the prefetcher,
+//   which tracks streams per thread.
 //
 
 module l2_cache_read_stage(
@@ -46,6 +50,7 @@ module l2_cache_read_stage(
     input                                     l2t_valid[`L2_WAYS],
     input l2_tag_t                            l2t_tag[`L2_WAYS],
     input                                     l2t_dirty[`L2_WAYS],
+    input                                     l2t_prefetched[`L2_WAYS],
     input                                     l2t_l2_fill,
     input                                     l2t_restarted_flush,
     input l2_way_idx_t                        l2t_fill_way,
@@ -56,6 +61,9 @@ module l2_cache_read_stage(
     output logic[`L2_WAYS - 1:0]              l2r_update_dirty_en,
     output l2_set_idx_t                       l2r_update_dirty_set,
     output logic                              l2r_update_dirty_value,
+    output logic[`L2_WAYS - 1:0]              l2r_update_prefetched_en,
+    output l2_set_idx_t                       l2r_update_prefetched_set,
+    output logic                              l2r_update_prefetched_value,
     output logic[`L2_WAYS - 1:0]              l2r_update_tag_en,
     output l2_set_idx_t                       l2r_update_tag_set,
     output logic                              l2r_update_tag_valid,
@@ -83,9 +91,14 @@ module l2_cache_read_stage(
     output l2_tag_t                           l2r_writeback_tag,
     output logic                              l2r_needs_writeback,
 
+    // To l2_cache_prefetcher
+    output logic                              l2r_prefetch_trigger,
+
     // To performance_counters
     output logic                              l2r_perf_l2_miss,
-    output logic                              l2r_perf_l2_hit);
+    output logic                              l2r_perf_l2_hit,
+    output logic                              l2r_perf_prefetch_useful,
+    output logic                              l2r_perf_prefetch_useless);
 
     localparam GLOBAL_THREAD_IDX_WIDTH = $clog2(TOTAL_THREADS);
 
@@ -109,6 +122,9 @@ module l2_cache_read_stage(
     logic dinvalidate;
     l2_way_idx_t tag_update_way;
     logic[GLOBAL_THREAD_IDX_WIDTH - 1:0] request_sync_slot;
+    logic prefetch_hit;
+    logic prefetch_evicted;
+    logic data_access;
 
     assign load = l2t_request.packet_type == L2REQ_LOAD
         || l2t_request.packet_type == L2REQ_LOAD_SYNC;
@@ -196,6 +212,32 @@ module l2_cache_read_stage(
     assign l2r_update_tag_valid = !dinvalidate;
     assign l2r_update_tag_value = l2t_request.address.tag;
 
+    //
+    // Update prefetched flags. A fill sets the flag if it was a prefetch,
+    // and the first load or store that hits the line clears it.
+    //
+    assign prefetch_hit = cache_hit && (load || store) && l2t_prefetched[hit_way_idx];
+    assign prefetch_evicted = l2t_l2_fill && l2t_valid[l2t_fill_way]
+        && l2t_prefetched[l2t_fill_way];
+    assign l2r_update_prefetched_set = l2t_request.address.set_idx;
+    assign l2r_update_prefetched_value = l2t_request.packet_type == L2REQ_PREFETCH;
+
+    genvar prefetched_update_idx;
+    generate
+        for (prefetched_update_idx = 0; prefetched_update_idx < `L2_WAYS;
+            prefetched_update_idx++)
+        begin : prefetched_update_gen
+            assign l2r_update_prefetched_en[prefetched_update_idx] = l2t_request_valid
+                && (l2t_l2_fill ? l2t_fill_way == l2_way_idx_t'(prefetched_update_idx)
+                : prefetch_hit && hit_way_oh[prefetched_update_idx]);
+        end
+    endgenerate
+
+    // The prefetcher only looks at data accesses. Instruction streams are
+    // prefetched by the L1 instruction cache.
+    assign data_access = l2t_request_valid && (load || store) && !l2t_l2_fill
+        && l2t_request.cache_type == CT_DCACHE;
+
     //
     // Update LRU
     //
@@ -203,9 +245,11 @@ module l2_cache_read_stage(
     assign l2r_update_lru_hit_way = hit_way_idx;
 
     //
-    // Synchronized requests
+    // Synchronized requests. These always come from one of the per-thread
+    // L1 queue entries, so the ID is the thread index.
     //
-    assign request_sync_slot = GLOBAL_THREAD_IDX_WIDTH'({l2t_request.core, l2t_request.id});
+    assign request_sync_slot = GLOBAL_THREAD_IDX_WIDTH'({l2t_request.core,
+        local_thread_idx_t'(l2t_request.id)});
     assign can_store_sync = load_sync_address[request_sync_slot]
         == {l2t_request.address.tag, l2t_request.address.set_idx}
         && load_sync_address_valid[request_sync_slot]
@@ -242,6 +286,9 @@ module l2_cache_read_stage(
             // Beginning of autoreset for uninitialized flops
             l2r_perf_l2_hit <= '0;
             l2r_perf_l2_miss <= '0;
+            l2r_perf_prefetch_useful <= '0;
+            l2r_perf_prefetch_useless <= '0;
+            l2r_prefetch_trigger <= '0;
             l2r_request_valid <= '0;
             l2r_store_sync_success <= '0;
             // End of automatics
@@ -294,6 +341,10 @@ module l2_cache_read_stage(
             // Perf events
             l2r_perf_l2_miss <= hit_or_miss && !(|hit_way_oh);
             l2r_perf_l2_hit <= hit_or_miss && |hit_way_oh;
+            l2r_perf_prefetch_useful <= prefetch_hit;
+            l2r_perf_prefetch_useless <= l2t_request_valid && prefetch_evicted;
+            l2r_prefetch_trigger <= data_access && !l2t_request.dma
+                && (!cache_hit || prefetch_hit);
         end
     end
 endmodule
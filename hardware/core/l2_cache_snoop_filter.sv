@@ -0,0 +1,89 @@
+//
+// Copyright 2019 Jeff Bush
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+`include "defines.svh"
+
+import defines::*;
+
+//
+// L2 cache snoop filter.
+// Tracks which cores may have a cache line in their L1 data cache, so
+// l2_cache_update_stage only sends store and invalidate responses to those
+// cores, rather than making every core snoop its L1 tags.
+//
+// Each entry has a bit per core and is shared by all lines whose low address
+// bits match its index. A core's bit is set when it sends a data cache load
+// or store for one of those lines (a store response also fills the line in
+// the requester's L1 cache). L1 caches evict lines without telling the L2
+// cache, so bits are never cleared except by reset. This means the filter
+// may send responses to cores that no longer have the line, but never skips
+// a core that does. Entries aren't tied to L2 cache lines, so L2 evictions
+// don't lose track of lines that are still in L1 caches.
+//
+// The read stage registers the request, and this reads and updates the entry
+// in the update stage, so back-to-back requests see each other's updates.
+//
+
+module l2_cache_snoop_filter(
+    input                               clk,
+    input                               reset,
+
+    // From l2_cache_read_stage
+    input                               l2r_request_valid,
+    input l2req_packet_t                l2r_request,
+
+    // To l2_cache_update_stage
+    output logic[`NUM_CORES - 1:0]      l2sf_sharers);
+
+    generate
+        if (`L2_SNOOP_FILTER_ENTRIES == 0)
+        begin : filter_disabled_gen
+            assign l2sf_sharers = '1;
+        end
+        else
+        begin : filter_enabled_gen
+            localparam ENTRY_IDX_WIDTH = $clog2(`L2_SNOOP_FILTER_ENTRIES);
+
+            logic[`NUM_CORES - 1:0] sharers[`L2_SNOOP_FILTER_ENTRIES];
+            logic[ENTRY_IDX_WIDTH - 1:0] entry_idx;
+            logic fills_l1;
+
+            assign entry_idx = l2r_request.address[ENTRY_IDX_WIDTH - 1:0];
+            assign fills_l1 = l2r_request_valid
+                && !l2r_request.dma
+                && l2r_request.cache_type == CT_DCACHE
+                && (l2r_request.packet_type == L2REQ_LOAD
+                || l2r_request.packet_type == L2REQ_LOAD_SYNC
+                || l2r_request.packet_type == L2REQ_STORE
+                || l2r_request.packet_type == L2REQ_STORE_SYNC);
+            assign l2sf_sharers = sharers[entry_idx];
+
+            always_ff @(posedge clk, posedge reset)
+            begin
+                if (reset)
+                begin
+                    for (int i = 0; i < `L2_SNOOP_FILTER_ENTRIES; i++)
+                        sharers[i] <= '0;
+                end
+                else if (fills_l1)
+                begin
+                    sharers[entry_idx] <= sharers[entry_idx]
+                        | (`NUM_CORES'(1) << l2r_request.core);
+                end
+            end
+        end
+    endgenerate
+endmodule
@@ -21,7 +21,8 @@ import defines::*;
 //
 // L2 cache pipeline - tag stage.
 // Performs tag lookup. Results will be available in the next stage.
-// Also reads the LRU
+// Also reads the LRU and the flags that track whether each line was filled
+// by the prefetcher and hasn't been accessed yet.
 //
 
 module l2_cache_tag_stage(
@@ -39,6 +40,9 @@ module l2_cache_tag_stage(
     input [`L2_WAYS - 1:0]                l2r_update_dirty_en,
     input l2_set_idx_t                    l2r_update_dirty_set,
     input                                 l2r_update_dirty_value,
+    input [`L2_WAYS - 1:0]                l2r_update_prefetched_en,
+    input l2_set_idx_t                    l2r_update_prefetched_set,
+    input                                 l2r_update_prefetched_value,
     input [`L2_WAYS - 1:0]                l2r_update_tag_en,
     input l2_set_idx_t                    l2r_update_tag_set,
     input                                 l2r_update_tag_valid,
@@ -52,6 +56,7 @@ module l2_cache_tag_stage(
     output logic                          l2t_valid[`L2_WAYS],
     output l2_tag_t                       l2t_tag[`L2_WAYS],
     output logic                          l2t_dirty[`L2_WAYS],
+    output logic                          l2t_prefetched[`L2_WAYS],
     output logic                          l2t_l2_fill,
     output l2_way_idx_t                   l2t_fill_way,
     output cache_line_data_t              l2t_data_from_memory,
@@ -110,6 +115,19 @@ module l2_cache_tag_stage(
                 .write_data(l2r_update_dirty_value),
                 .*);
 
+            sram_1r1w #(
+                .DATA_WIDTH(1),
+                .SIZE(`L2_SETS),
+                .READ_DURING_WRITE("NEW_DATA")
+            ) sram_prefetched_flags(
+                .read_en(l2a_request_valid),
+                .read_addr(l2a_request.address.set_idx),
+                .read_data(l2t_prefetched[way_idx]),
+                .write_en(l2r_update_prefetched_en[way_idx]),
+                .write_addr(l2r_update_prefetched_set),
+                .write_data(l2r_update_prefetched_value),
+                .*);
+
             always_ff @(posedge clk, posedge reset)
             begin
                 if (reset)
@@ -22,7 +22,11 @@ import defines::*;
 // L2 cache pipeline - update stage.
 // - Update cache data if this is a cache fill or store.
 //   This applies the store mask and requested data to the original data.
-// - Sends response packet to cores.
+// - Sends response packet to cores. Prefetches don't have a response because
+//   no core is waiting for them. Other responses go to the requesting core.
+//   Store and data cache invalidate responses also go to cores that the snoop
+//   filter indicates may have the line in their L1 cache, so they can update
+//   or invalidate it. Instruction cache invalidate responses go to all cores.
 //
 
 module l2_cache_update_stage(
@@ -41,19 +45,31 @@ module l2_cache_update_stage(
     input                                          l2r_store_sync_success,
     input                                          l2r_needs_writeback,
 
+    // From l2_cache_snoop_filter
+    input [`NUM_CORES - 1:0]                       l2sf_sharers,
+
     // To l2_cache_read_stage
     output logic                                   l2u_write_en,
     output logic[$clog2(`L2_WAYS * `L2_SETS) - 1:0] l2u_write_addr,
     output cache_line_data_t                       l2u_write_data,
 
-    // To cores
+    // To cores and dma_engine
     output logic                                   l2_response_valid,
-    output l2rsp_packet_t                          l2_response);
+    output logic                                   l2_core_response_valid[`NUM_CORES],
+    output l2rsp_packet_t                          l2_response,
+
+    // To performance_counters
+    output logic                                   l2u_perf_snoop_sent,
+    output logic                                   l2u_perf_snoop_filtered);
 
     cache_line_data_t original_data;
     logic update_data;
     l2rsp_packet_type_t response_type;
     logic completed_flush;
+    logic send_response;
+    logic coherence_response;
+    logic[`NUM_CORES - 1:0] requester_oh;
+    logic[`NUM_CORES - 1:0] response_cores;
 
     assign original_data = l2r_l2_fill ? l2r_data_from_memory : l2r_data;
     assign update_data = l2r_request.packet_type == L2REQ_STORE
@@ -106,29 +122,63 @@ module l2_cache_update_stage(
     assign completed_flush = l2r_request.packet_type == L2REQ_FLUSH
         && (l2r_restarted_flush || !l2r_cache_hit || !l2r_needs_writeback);
 
+    assign send_response = l2r_request_valid && l2r_request.packet_type != L2REQ_PREFETCH
+        && ((l2r_cache_hit && l2r_request.packet_type != L2REQ_FLUSH)
+        || l2r_l2_fill
+        || completed_flush
+        || l2r_request.packet_type == L2REQ_DINVALIDATE
+        || l2r_request.packet_type == L2REQ_IINVALIDATE);
+
+    //
+    // Select which cores receive the response. The DMA engine sees all
+    // responses, but no core is waiting for the ones it requested.
+    //
+    assign coherence_response = response_type == L2RSP_STORE_ACK
+        || response_type == L2RSP_DINVALIDATE_ACK;
+    assign requester_oh = l2r_request.dma ? '0 : `NUM_CORES'(1) << l2r_request.core;
+
+    always_comb
+    begin
+        if (response_type == L2RSP_IINVALIDATE_ACK)
+            response_cores = '1;
+        else if (coherence_response)
+            response_cores = requester_oh | l2sf_sharers;
+        else
+            response_cores = requester_oh;
+    end
+
     always_ff @(posedge clk, posedge reset)
     begin
         if (reset)
+        begin
             l2_response_valid <= 0;
+            for (int i = 0; i < `NUM_CORES; i++)
+                l2_core_response_valid[i] <= 0;
+
+            l2u_perf_snoop_sent <= 0;
+            l2u_perf_snoop_filtered <= 0;
+        end
         else
         begin
-            if (l2r_request_valid
-                && ((l2r_cache_hit && l2r_request.packet_type != L2REQ_FLUSH)
-                || l2r_l2_fill
-                || completed_flush
-                || l2r_request.packet_type == L2REQ_DINVALIDATE
-                || l2r_request.packet_type == L2REQ_IINVALIDATE))
+            if (send_response)
             begin
                 // Restarted flush must have packet type L2REQ_FLUSH
                 assert(!l2r_restarted_flush || l2r_request.packet_type == L2REQ_FLUSH);
 
                 // Cannot be both a fill and restarted flush
                 assert(!l2r_restarted_flush || !l2r_l2_fill);
-
-                l2_response_valid <= 1;
             end
-            else
-                l2_response_valid <= 0;
+
+            l2_response_valid <= send_response;
+            for (int i = 0; i < `NUM_CORES; i++)
+                l2_core_response_valid[i] <= send_response && response_cores[i];
+
+            // A coherence response may be sent to some other cores and
+            // filtered for others, which signals both events.
+            l2u_perf_snoop_sent <= send_response && coherence_response
+                && |(l2sf_sharers & ~requester_oh);
+            l2u_perf_snoop_filtered <= send_response && coherence_response
+                && |(~l2sf_sharers & ~requester_oh);
         end
     end
 
@@ -137,6 +187,7 @@ module l2_cache_update_stage(
         l2_response.status <= l2r_request.packet_type == L2REQ_STORE_SYNC
             ? l2r_store_sync_success : 1'b1;
         l2_response.core <= l2r_request.core;
+        l2_response.dma <= l2r_request.dma;
         l2_response.id <= l2r_request.id;
         l2_response.packet_type <= response_type;
         l2_response.cache_type <= l2r_request.cache_type;
@@ -19,8 +19,8 @@
 import defines::*;
 
 //
-// Top level block for processor. Contains all cores and L2 cache, connects
-// to AXI system bus.
+// Top level block for processor. Contains all cores, L2 cache, DMA engine,
+// and texture samplers, connects to AXI system bus.
 //
 
 module nyuzi
@@ -47,15 +47,40 @@ module nyuzi
     logic[`NUM_CORES - 1:0][TOTAL_THREADS - 1:0] core_resume_thread;
     logic[TOTAL_THREADS - 1:0] thread_suspend_mask;
     logic[TOTAL_THREADS - 1:0] thread_resume_mask;
+    logic[NUM_INTERRUPTS - 1:0] core_interrupt_req;
+    scalar_t tex_read_data[`NUM_CORES];
+
+    // The DMA engine (requester 0) and texture samplers share the L2 cache's
+    // DMA port.
+    localparam NUM_DMA_REQUESTERS = `TEXTURE_SAMPLER ? `NUM_CORES + 1 : 1;
+
+    logic[NUM_DMA_REQUESTERS - 1:0] dma_port_request_valid;
+    l2req_packet_t dma_port_request[NUM_DMA_REQUESTERS];
+    logic[NUM_DMA_REQUESTERS - 1:0] dma_port_ready;
+    logic dma_l2_request_valid;
+    l2req_packet_t dma_l2_request;
 
     /*AUTOLOGIC*/
     // Beginning of automatic wires (for undeclared instantiated-module outputs)
+    logic               dma_interrupt;          // From dma_engine of dma_engine.v
+    scalar_t            dma_read_data;          // From dma_engine of dma_engine.v
+    logic [3:0]         ii_dma_reg;             // From io_interconnect of io_interconnect.v
+    scalar_t            ii_dma_write_data;      // From io_interconnect of io_interconnect.v
+    logic               ii_dma_write_en;        // From io_interconnect of io_interconnect.v
     logic               ii_ready [`NUM_CORES];  // From io_interconnect of io_interconnect.v
     iorsp_packet_t      ii_response;            // From io_interconnect of io_interconnect.v
     logic               ii_response_valid;      // From io_interconnect of io_interconnect.v
+    logic [3:0]         ii_tex_reg;             // From io_interconnect of io_interconnect.v
+    local_thread_idx_t  ii_tex_thread;          // From io_interconnect of io_interconnect.v
+    scalar_t            ii_tex_write_data;      // From io_interconnect of io_interconnect.v
+    logic [`NUM_CORES-1:0] ii_tex_write_en;     // From io_interconnect of io_interconnect.v
+    l2rsp_packet_t      l2_core_response [`NUM_CORES];// From l2_cache of l2_cache.v
+    logic               l2_core_response_valid [`NUM_CORES];// From l2_cache of l2_cache.v
+    logic               l2_dma_ready;           // From l2_cache of l2_cache.v
+    l2rsp_packet_t      l2_dma_response;        // From l2_cache of l2_cache.v
+    logic               l2_dma_response_valid;  // From l2_cache of l2_cache.v
+    logic [L2_PERF_EVENTS*`L2_BANKS-1:0] l2_perf_events;// From l2_cache of l2_cache.v
     logic               l2_ready [`NUM_CORES];  // From l2_cache of l2_cache.v
-    l2rsp_packet_t      l2_response;            // From l2_cache of l2_cache.v
-    logic               l2_response_valid;      // From l2_cache of l2_cache.v
     core_id_t           ocd_core;               // From on_chip_debugger of on_chip_debugger.v
     scalar_t            ocd_data_from_host;     // From on_chip_debugger of on_chip_debugger.v
     logic               ocd_data_update;        // From on_chip_debugger of on_chip_debugger.v
@@ -71,6 +96,8 @@ module nyuzi
         assert(`NUM_CORES >= 1 && `NUM_CORES <= (1 << CORE_ID_WIDTH));
         assert(`L1D_WAYS >= `THREADS_PER_CORE);
         assert(`L1I_WAYS >= `THREADS_PER_CORE);
+        assert(INT_DMA < NUM_INTERRUPTS);
+        assert(CORE_PERF_EVENTS + L2_PERF_EVENTS * `L2_BANKS <= 256);
     end
 
     // Thread enable
@@ -93,12 +120,74 @@ module nyuzi
             thread_en <= (thread_en | thread_resume_mask) & ~thread_suspend_mask;
     end
 
-    l2_cache l2_cache(
-        .l2_perf_events(),
-        .*);
+    // The L2 performance events go to every core, so software on any core
+    // can count them. soc_tb also prints the counts for each bank at the end
+    // of a simulation.
+    l2_cache l2_cache(.*);
 
     io_interconnect io_interconnect(.*);
 
+    dma_engine dma_engine(
+        .dma_l2_request_valid(dma_port_request_valid[0]),
+        .dma_l2_request(dma_port_request[0]),
+        .l2_dma_ready(dma_port_ready[0]),
+        .l2_response_valid(l2_dma_response_valid),
+        .l2_response(l2_dma_response),
+        .*);
+
+    genvar core_idx;
+    generate
+        if (NUM_DMA_REQUESTERS > 1)
+        begin : dma_port_arbiter_gen
+            logic[NUM_DMA_REQUESTERS - 1:0] grant_oh;
+            logic[$clog2(NUM_DMA_REQUESTERS) - 1:0] grant_idx;
+
+            rr_arbiter #(.NUM_REQUESTERS(NUM_DMA_REQUESTERS)) dma_port_arbiter(
+                .request(dma_port_request_valid),
+                .update_lru(dma_l2_request_valid && l2_dma_ready),
+                .grant_oh(grant_oh),
+                .*);
+
+            oh_to_idx #(.NUM_SIGNALS(NUM_DMA_REQUESTERS)) oh_to_idx_dma_port(
+                .one_hot(grant_oh),
+                .index(grant_idx));
+
+            assign dma_l2_request_valid = |dma_port_request_valid;
+            assign dma_l2_request = dma_port_request[grant_idx];
+            assign dma_port_ready = grant_oh & {NUM_DMA_REQUESTERS{l2_dma_ready}};
+        end
+        else
+        begin : dma_port_direct_gen
+            assign dma_l2_request_valid = dma_port_request_valid[0];
+            assign dma_l2_request = dma_port_request[0];
+            assign dma_port_ready[0] = l2_dma_ready;
+        end
+
+        for (core_idx = 0; core_idx < `NUM_CORES; core_idx++)
+        begin : texture_sampler_gen
+            if (`TEXTURE_SAMPLER)
+            begin : sampler_gen
+                texture_sampler #(.CORE_ID(core_id_t'(core_idx))) texture_sampler(
+                    .ii_tex_write_en(ii_tex_write_en[core_idx]),
+                    .tex_read_data(tex_read_data[core_idx]),
+                    .tex_l2_request_valid(dma_port_request_valid[core_idx + 1]),
+                    .tex_l2_request(dma_port_request[core_idx + 1]),
+                    .l2_tex_ready(dma_port_ready[core_idx + 1]),
+                    .l2_response_valid(l2_dma_response_valid),
+                    .l2_response(l2_dma_response),
+                    .*);
+            end
+            else
+            begin : no_sampler_gen
+                assign tex_read_data[core_idx] = '0;
+            end
+        end
+    endgenerate
+
+    // The DMA completion interrupt is combined with the external ones
+    assign core_interrupt_req = interrupt_req
+        | (NUM_INTERRUPTS'(dma_interrupt) << INT_DMA);
+
     on_chip_debugger on_chip_debugger(
         .jtag(jtag),
         .injected_complete(|core_injected_complete),
@@ -112,7 +201,6 @@ module nyuzi
             assign data_to_host = cr_data_to_host[0];
     endgenerate
 
-    genvar core_idx;
     generate
         for (core_idx = 0; core_idx < `NUM_CORES; core_idx++)
         begin : core_gen
@@ -124,6 +212,8 @@ module nyuzi
                 .l2i_request_valid(l2i_request_valid[core_idx]),
                 .l2i_request(l2i_request[core_idx]),
                 .l2_ready(l2_ready[core_idx]),
+                .l2_response_valid(l2_core_response_valid[core_idx]),
+                .l2_response(l2_core_response[core_idx]),
                 .thread_en(thread_en[core_idx * `THREADS_PER_CORE+:`THREADS_PER_CORE]),
                 .ior_request_valid(ior_request_valid[core_idx]),
                 .ior_request(ior_request[core_idx]),
@@ -134,6 +224,7 @@ module nyuzi
                 .injected_rollback(core_injected_rollback[core_idx]),
                 .cr_suspend_thread(core_suspend_thread[core_idx]),
                 .cr_resume_thread(core_resume_thread[core_idx]),
+                .interrupt_req(core_interrupt_req),
                 .*);
         end
     endgenerate
@@ -21,6 +21,9 @@ import defines::*;
 //
 // Contains vector and scalar register files and fetches values
 // from them.
+// Fused multiply-add reads a third operand, the destination register. Rather
+// than adding a read port to each register file, this keeps a copy of each
+// one that is written the same way and has a single read port.
 //
 
 module operand_fetch_stage(
@@ -36,6 +39,7 @@ module operand_fetch_stage(
     // To fp_execute_stage1/int_execute_stage/dcache_tag_stage
     output vector_t                   of_operand1,
     output vector_t                   of_operand2,
+    output vector_t                   of_operand3,
     output vector_mask_t              of_mask_value,
     output vector_t                   of_store_value,
     output decoded_instruction_t      of_instruction,
@@ -57,6 +61,8 @@ module operand_fetch_stage(
     scalar_t scalar_val2;
     vector_t vector_val1;
     vector_t vector_val2;
+    scalar_t scalar_val3;
+    vector_t vector_val3;
 
     sram_2r1w #(
         .DATA_WIDTH($bits(scalar_t)),
@@ -74,6 +80,20 @@ module operand_fetch_stage(
         .write_data(wb_writeback_value[0]),
         .*);
 
+    sram_1r1w #(
+        .DATA_WIDTH($bits(scalar_t)),
+        .SIZE(32 * `THREADS_PER_CORE),
+        .READ_DURING_WRITE("DONT_CARE")
+    ) scalar_registers3(
+        .read_en(ts_instruction_valid && ts_instruction.accumulate
+            && !ts_instruction.dest_vector),
+        .read_addr({ts_thread_idx, ts_instruction.dest_reg}),
+        .read_data(scalar_val3),
+        .write_en(wb_writeback_en && !wb_writeback_vector),
+        .write_addr({wb_writeback_thread_idx, wb_writeback_reg}),
+        .write_data(wb_writeback_value[0]),
+        .*);
+
     genvar lane;
     generate
         for (lane = 0; lane < NUM_VECTOR_LANES; lane++)
@@ -93,6 +113,19 @@ module operand_fetch_stage(
                 .write_addr({wb_writeback_thread_idx, wb_writeback_reg}),
                 .write_data(wb_writeback_value[lane]),
                 .*);
+
+            sram_1r1w #(
+                .DATA_WIDTH($bits(scalar_t)),
+                .SIZE(32 * `THREADS_PER_CORE),
+                .READ_DURING_WRITE("DONT_CARE")
+            ) vector_registers3 (
+                .read_en(ts_instruction.accumulate && ts_instruction.dest_vector),
+                .read_addr({ts_thread_idx, ts_instruction.dest_reg}),
+                .read_data(vector_val3[lane]),
+                .write_en(wb_writeback_en && wb_writeback_vector && wb_writeback_mask[NUM_VECTOR_LANES - lane - 1]),
+                .write_addr({wb_writeback_thread_idx, wb_writeback_reg}),
+                .write_data(wb_writeback_value[lane]),
+                .*);
         end
     endgenerate
 
@@ -131,6 +164,11 @@ module operand_fetch_stage(
             default:         of_operand2 = {NUM_VECTOR_LANES{of_instruction.immediate_value}}; // OP2_SRC_IMMEDIATE
         endcase
 
+        if (of_instruction.dest_vector)
+            of_operand3 = vector_val3;
+        else
+            of_operand3 = {NUM_VECTOR_LANES{scalar_val3}};
+
         unique case (of_instruction.mask_src)
             MASK_SRC_SCALAR1: of_mask_value = scalar_val1[NUM_VECTOR_LANES - 1:0];
             MASK_SRC_SCALAR2: of_mask_value = scalar_val2[NUM_VECTOR_LANES - 1:0];
@@ -14,13 +14,25 @@
 // limitations under the License.
 //
 
+`include "defines.svh"
+
+import defines::*;
+
 //
 // Collects statistics from various modules used for performance measuring and tuning.
 // Counts the number of discrete events in each category.
+// Each counter can be restricted to events caused by a subset of threads with
+// cr_perf_thread_mask. Only the first NUM_THREAD_EVENTS events have an entry
+// in perf_event_thread. The others (L2 events) aren't caused by a thread in
+// this core, so the thread mask doesn't apply to them. Software can also
+// load a counter value, which is used for sampling: if a counter is set to
+// -N, perf_event_overflow will pulse after N more events, when it wraps to
+// zero. control_registers latches this and may raise an interrupt.
 //
 
 module performance_counters
     #(parameter NUM_EVENTS = 1,
+    parameter NUM_THREAD_EVENTS = NUM_EVENTS,
     parameter EVENT_IDX_WIDTH = $clog2(NUM_EVENTS),
     parameter NUM_COUNTERS = 2,
     parameter COUNTER_IDX_WIDTH = $clog2(NUM_COUNTERS))
@@ -28,8 +40,30 @@ module performance_counters
     (input                                              clk,
     input                                               reset,
     input [NUM_EVENTS - 1:0]                            perf_events,
-    input [NUM_COUNTERS - 1:0][EVENT_IDX_WIDTH - 1:0]   perf_event_select,
-    output logic[NUM_COUNTERS - 1:0][63:0]              perf_event_count);
+    input local_thread_idx_t[NUM_THREAD_EVENTS - 1:0]   perf_event_thread,
+
+    // From control_registers
+    input [NUM_COUNTERS - 1:0][EVENT_IDX_WIDTH - 1:0]   cr_perf_event_select,
+    input local_thread_bitmap_t                         cr_perf_thread_mask[NUM_COUNTERS],
+    input [NUM_COUNTERS - 1:0]                          cr_perf_count_write_en,
+    input                                               cr_perf_count_write_high,
+    input scalar_t                                      cr_perf_count_write_val,
+
+    // To control_registers
+    output logic[NUM_COUNTERS - 1:0][63:0]              perf_event_count,
+    output logic[NUM_COUNTERS - 1:0]                    perf_event_overflow);
+
+    logic[NUM_COUNTERS - 1:0] count_en;
+
+    always_comb
+    begin
+        for (int i = 0; i < NUM_COUNTERS; i++)
+        begin
+            count_en[i] = perf_events[cr_perf_event_select[i]]
+                && (int'(cr_perf_event_select[i]) >= NUM_THREAD_EVENTS
+                || cr_perf_thread_mask[i][perf_event_thread[cr_perf_event_select[i]]]);
+        end
+    end
 
     always_ff @(posedge clk, posedge reset)
     begin : update
@@ -37,13 +71,25 @@ module performance_counters
         begin
             for (int i = 0; i < NUM_COUNTERS; i++)
                 perf_event_count[i] <= 0;
+
+            perf_event_overflow <= '0;
         end
         else
         begin
             for (int i = 0; i < NUM_COUNTERS; i++)
             begin
-                if (perf_events[perf_event_select[i]])
+                if (cr_perf_count_write_en[i])
+                begin
+                    if (cr_perf_count_write_high)
+                        perf_event_count[i][63:32] <= cr_perf_count_write_val;
+                    else
+                        perf_event_count[i][31:0] <= cr_perf_count_write_val;
+                end
+                else if (count_en[i])
                     perf_event_count[i] <= perf_event_count[i] + 1;
+
+                perf_event_overflow[i] <= count_en[i] && !cr_perf_count_write_en[i]
+                    && &perf_event_count[i];
             end
         end
     end
@@ -0,0 +1,443 @@
+//
+// Copyright 2019 Jeff Bush
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+`include "defines.svh"
+
+import defines::*;
+
+//
+// Texture sampler. Reads the texels for 16 texture coordinates (one per
+// vector lane), filters them, and writes the colors back to memory, without
+// using a hardware thread. Each core has one, which its threads share.
+//
+// A thread describes the work in a job, which is four cache lines in memory
+// (the job address must be cache line aligned):
+// line 0: descriptor
+//   word 0 texture base address
+//   word 1 width in texels
+//   word 2 height in texels
+//   word 3 stride (bytes between the starts of rows)
+//   word 4 format: 0 is 32 bits per texel (red in the lowest byte), 1 is
+//          8 bit gray, which is returned in all four channels.
+//   word 5 flags: bit 0 enables bilinear filtering
+//   word 6 lane mask: bit n enables lane n
+// line 1: u coordinate for each lane
+// line 2: v coordinate for each lane
+// line 3: results, written by this. Each lane is a 32-bit color in the same
+//         format as a 32 bit texel. Disabled lanes aren't written.
+// The base address and stride must be multiples of four for 32-bit texels.
+// Coordinates are in texels, unsigned 16.16 fixed point, and must be less
+// than the width/height (software wraps or clamps them). With bilinear
+// filtering, this blends the texel at the coordinate with the ones to the
+// right of and below it, which wrap around the edges of the texture, using
+// the top eight bits of the fraction. Otherwise it uses the texel at the
+// coordinate.
+//
+// Like dma_engine, this sends requests through the L2 cache, so jobs are
+// coherent: the result store updates the requesting core's L1 cache. A thread
+// must make sure its stores to the job have reached the L2 cache (with a
+// membar) before starting it. This processes one job at a time, then starts
+// the next waiting thread's. It processes one texel per cycle when its line
+// is in one of the two line buffers, otherwise it loads the line and waits.
+// The line buffers are invalidated at the start of each job.
+//
+// Registers (offsets from TEXTURE_BASE). Each thread has its own job register
+// and status bit:
+// 0x00 job address. Writing starts the job. Writes are ignored while the
+//      thread's previous job is in progress.
+// 0x04 status. Bit 0 is set while the thread's job is in progress.
+// 0x08 id. Reads SAMPLER_ID, so software can check if this is present.
+//
+
+module texture_sampler
+    #(parameter core_id_t CORE_ID = '0)
+
+    (input                      clk,
+    input                       reset,
+
+    // From io_interconnect
+    input                       ii_tex_write_en,
+    input [3:0]                 ii_tex_reg,
+    input local_thread_idx_t    ii_tex_thread,
+    input scalar_t              ii_tex_write_data,
+    output scalar_t             tex_read_data,
+
+    // To/from l2_cache
+    output logic                tex_l2_request_valid,
+    output l2req_packet_t       tex_l2_request,
+    input                       l2_tex_ready,
+    input                       l2_response_valid,
+    input l2rsp_packet_t        l2_response);
+
+    localparam REG_JOB = 4'd0;
+    localparam REG_STATUS = 4'd1;
+    localparam REG_ID = 4'd2;
+    localparam SAMPLER_ID = 32'h54455831;  // "TEX1"
+    localparam LANE_IDX_WIDTH = $clog2(NUM_VECTOR_LANES);
+
+    // Cache lines of a job
+    localparam JOB_DESCRIPTOR = 2'd0;
+    localparam JOB_U = 2'd1;
+    localparam JOB_V = 2'd2;
+    localparam JOB_RESULT = 2'd3;
+
+    typedef enum logic[2:0] {
+        TS_IDLE,
+        TS_LOAD_JOB,    // Send load for a line of the job
+        TS_WAIT_JOB,    // Wait for job line data
+        TS_SAMPLE,      // Filter texels that are in the line buffers
+        TS_LOAD_TEXEL,  // Send load for the line with the next texel
+        TS_WAIT_TEXEL,  // Wait for texel line data
+        TS_STORE,       // Send store for the results
+        TS_WAIT_STORE   // Wait for the store to be acknowledged
+    } sampler_state_t;
+
+    sampler_state_t state;
+    logic[`THREADS_PER_CORE - 1:0] job_pending;
+    cache_line_index_t job_addr[`THREADS_PER_CORE];
+    logic[`THREADS_PER_CORE - 1:0] job_grant_oh;
+    local_thread_idx_t job_grant_idx;
+    local_thread_idx_t job_thread;
+    cache_line_index_t job_line;
+    logic[1:0] job_line_idx;
+    scalar_t tex_base;
+    logic[15:0] tex_width;
+    logic[15:0] tex_height;
+    scalar_t tex_stride;
+    logic gray;
+    logic bilinear;
+    vector_mask_t lane_mask;
+    cache_line_data_t u_line;
+    cache_line_data_t v_line;
+    cache_line_data_t result_line;
+    logic[1:0] buffer_valid;
+    cache_line_index_t buffer_line[2];
+    cache_line_data_t buffer_data[2];
+    logic replace_idx;
+    logic[LANE_IDX_WIDTH - 1:0] lane_idx;
+    logic[1:0] texel_idx;
+    scalar_t lane_u;
+    scalar_t lane_v;
+    logic[15:0] x0;
+    logic[15:0] y0;
+    logic[15:0] x1;
+    logic[15:0] y1;
+    logic[15:0] texel_x;
+    logic[15:0] texel_y;
+    scalar_t texel_addr;
+    logic[1:0] buffer_hit;
+    logic texel_hit;
+    scalar_t texel_word;
+    logic[7:0] texel_channel[4];
+    logic[8:0] weight_x;
+    logic[8:0] weight_y;
+    logic[16:0] weight;
+    logic[23:0] channel_acc[4];
+    logic[23:0] channel_sum[4];
+    logic[7:0] lane_color[4];
+    logic last_texel;
+    logic lane_done;
+    logic response_valid;
+    logic[CACHE_LINE_BYTES - 1:0] store_mask;
+    logic start;
+
+    // Returns word 'index' of a line as a little endian value. Byte lanes
+    // are in reverse order of address (see dcache_data_stage).
+    function scalar_t line_word(input cache_line_data_t line, input int index);
+        scalar_t word;
+
+        word = line[(CACHE_LINE_WORDS - 1 - index) * 32+:32];
+        return {word[7:0], word[15:8], word[23:16], word[31:24]};
+    endfunction
+
+    rr_arbiter #(.NUM_REQUESTERS(`THREADS_PER_CORE)) job_arbiter(
+        .request(job_pending),
+        .update_lru(start),
+        .grant_oh(job_grant_oh),
+        .*);
+
+    oh_to_idx #(.NUM_SIGNALS(`THREADS_PER_CORE)) oh_to_idx_job(
+        .one_hot(job_grant_oh),
+        .index(job_grant_idx));
+
+    assign start = state == TS_IDLE && |job_pending;
+
+    //
+    // Texel address. Texels are fetched in the order top left, top right,
+    // bottom left, bottom right (texel_idx bit 0 selects right, bit 1 bottom).
+    //
+    assign lane_u = line_word(u_line, int'(lane_idx));
+    assign lane_v = line_word(v_line, int'(lane_idx));
+    assign x0 = lane_u[31:16];
+    assign y0 = lane_v[31:16];
+    assign x1 = x0 + 16'd1 == tex_width ? 16'd0 : x0 + 16'd1;
+    assign y1 = y0 + 16'd1 == tex_height ? 16'd0 : y0 + 16'd1;
+    assign texel_x = texel_idx[0] ? x1 : x0;
+    assign texel_y = texel_idx[1] ? y1 : y0;
+    assign texel_addr = tex_base + scalar_t'(texel_y) * tex_stride
+        + (gray ? scalar_t'(texel_x) : scalar_t'({texel_x, 2'b00}));
+
+    genvar buffer_idx;
+    generate
+        for (buffer_idx = 0; buffer_idx < 2; buffer_idx++)
+        begin : buffer_hit_gen
+            assign buffer_hit[buffer_idx] = buffer_valid[buffer_idx]
+                && buffer_line[buffer_idx] == texel_addr[31:CACHE_LINE_OFFSET_WIDTH];
+        end
+    endgenerate
+
+    assign texel_hit = |buffer_hit;
+    assign texel_word = line_word(buffer_hit[1] ? buffer_data[1] : buffer_data[0],
+        int'(texel_addr[CACHE_LINE_OFFSET_WIDTH - 1:2]));
+
+    //
+    // Filter. Each texel's weight is the product of its horizontal and
+    // vertical weights, which are out of 256, so the weights of the four
+    // texels add up to 65536. Results are rounded to the nearest value.
+    //
+    assign weight_x = texel_idx[0] ? 9'(lane_u[15:8]) : 9'd256 - 9'(lane_u[15:8]);
+    assign weight_y = texel_idx[1] ? 9'(lane_v[15:8]) : 9'd256 - 9'(lane_v[15:8]);
+    assign weight = bilinear ? 17'(weight_x) * 17'(weight_y) : 17'h10000;
+    assign last_texel = !bilinear || texel_idx == 2'd3;
+
+    genvar channel;
+    generate
+        for (channel = 0; channel < 4; channel++)
+        begin : channel_gen
+            assign texel_channel[channel] = gray
+                ? texel_word[texel_addr[1:0] * 8+:8]
+                : texel_word[channel * 8+:8];
+            assign channel_sum[channel] = channel_acc[channel]
+                + 24'(texel_channel[channel]) * 24'(weight);
+            assign lane_color[channel] = 8'((channel_sum[channel] + 24'h8000) >> 16);
+        end
+    endgenerate
+
+    // Done with the current lane
+    assign lane_done = state == TS_SAMPLE && (!lane_mask[lane_idx]
+        || (texel_hit && last_texel));
+
+    //
+    // L2 requests
+    //
+    genvar lane;
+    generate
+        for (lane = 0; lane < NUM_VECTOR_LANES; lane++)
+        begin : store_mask_gen
+            assign store_mask[(CACHE_LINE_WORDS - 1 - lane) * 4+:4] = {4{lane_mask[lane]}};
+        end
+    endgenerate
+
+    always_comb
+    begin
+        tex_l2_request = '0;
+        tex_l2_request.core = CORE_ID;
+        tex_l2_request.dma = 1;
+        tex_l2_request.id = L2_DMA_ID_TEXTURE;
+        tex_l2_request.cache_type = CT_DCACHE;
+        if (state == TS_STORE)
+        begin
+            tex_l2_request.packet_type = L2REQ_STORE;
+            tex_l2_request.address = job_line + cache_line_index_t'(JOB_RESULT);
+            tex_l2_request.store_mask = store_mask;
+            tex_l2_request.data = result_line;
+        end
+        else if (state == TS_LOAD_TEXEL)
+        begin
+            tex_l2_request.packet_type = L2REQ_LOAD;
+            tex_l2_request.address = texel_addr[31:CACHE_LINE_OFFSET_WIDTH];
+        end
+        else
+        begin
+            tex_l2_request.packet_type = L2REQ_LOAD;
+            tex_l2_request.address = job_line + cache_line_index_t'(job_line_idx);
+        end
+    end
+
+    assign tex_l2_request_valid = state == TS_LOAD_JOB || state == TS_LOAD_TEXEL
+        || state == TS_STORE;
+    assign response_valid = l2_response_valid && l2_response.dma
+        && l2_response.id == L2_DMA_ID_TEXTURE && l2_response.core == CORE_ID;
+
+    always_ff @(posedge clk)
+    begin
+        unique case (ii_tex_reg)
+            REG_JOB: tex_read_data <= {job_addr[ii_tex_thread], {CACHE_LINE_OFFSET_WIDTH{1'b0}}};
+            REG_STATUS: tex_read_data <= scalar_t'(job_pending[ii_tex_thread]);
+            REG_ID: tex_read_data <= SAMPLER_ID;
+            default: tex_read_data <= '0;
+        endcase
+
+        if (state == TS_WAIT_JOB && response_valid)
+        begin
+            unique0 case (job_line_idx)
+                JOB_DESCRIPTOR:
+                begin
+                    tex_base <= line_word(l2_response.data, 0);
+                    tex_width <= 16'(line_word(l2_response.data, 1));
+                    tex_height <= 16'(line_word(l2_response.data, 2));
+                    tex_stride <= line_word(l2_response.data, 3);
+                    gray <= 1'(line_word(l2_response.data, 4));
+                    bilinear <= 1'(line_word(l2_response.data, 5));
+                    lane_mask <= vector_mask_t'(line_word(l2_response.data, 6));
+                end
+
+                JOB_U: u_line <= l2_response.data;
+                JOB_V: v_line <= l2_response.data;
+            endcase
+        end
+
+        if (state == TS_WAIT_TEXEL && response_valid)
+        begin
+            buffer_line[replace_idx] <= l2_response.address;
+            buffer_data[replace_idx] <= l2_response.data;
+        end
+
+        if (lane_done)
+        begin
+            result_line[(CACHE_LINE_WORDS - 1 - int'(lane_idx)) * 32+:32] <= {lane_color[0],
+                lane_color[1], lane_color[2], lane_color[3]};
+        end
+    end
+
+    always_ff @(posedge clk, posedge reset)
+    begin
+        if (reset)
+        begin
+            state <= TS_IDLE;
+            for (int i = 0; i < `THREADS_PER_CORE; i++)
+                job_addr[i] <= '0;
+
+            for (int i = 0; i < 4; i++)
+                channel_acc[i] <= '0;
+
+            /*AUTORESET*/
+            // Beginning of autoreset for uninitialized flops
+            buffer_valid <= '0;
+            job_line <= '0;
+            job_line_idx <= '0;
+            job_pending <= '0;
+            job_thread <= '0;
+            lane_idx <= '0;
+            replace_idx <= '0;
+            texel_idx <= '0;
+            // End of automatics
+        end
+        else
+        begin
+            if (ii_tex_write_en && ii_tex_reg == REG_JOB && !job_pending[ii_tex_thread])
+            begin
+                job_addr[ii_tex_thread] <= ii_tex_write_data[31:CACHE_LINE_OFFSET_WIDTH];
+                job_pending[ii_tex_thread] <= 1;
+            end
+
+            unique case (state)
+                TS_IDLE:
+                begin
+                    if (start)
+                    begin
+                        job_thread <= job_grant_idx;
+                        job_line <= job_addr[job_grant_idx];
+                        job_line_idx <= JOB_DESCRIPTOR;
+                        buffer_valid <= '0;
+                        lane_idx <= '0;
+                        texel_idx <= '0;
+                        state <= TS_LOAD_JOB;
+                    end
+                end
+
+                TS_LOAD_JOB:
+                begin
+                    if (l2_tex_ready)
+                        state <= TS_WAIT_JOB;
+                end
+
+                TS_WAIT_JOB:
+                begin
+                    if (response_valid)
+                    begin
+                        job_line_idx <= job_line_idx + 2'd1;
+                        if (job_line_idx == JOB_V)
+                            state <= TS_SAMPLE;
+                        else
+                            state <= TS_LOAD_JOB;
+                    end
+                end
+
+                TS_SAMPLE:
+                begin
+                    if (lane_done)
+                    begin
+                        for (int i = 0; i < 4; i++)
+                            channel_acc[i] <= '0;
+
+                        texel_idx <= '0;
+                        lane_idx <= lane_idx + LANE_IDX_WIDTH'(1);
+                        if (lane_idx == LANE_IDX_WIDTH'(NUM_VECTOR_LANES - 1))
+                            state <= TS_STORE;
+                    end
+                    else if (texel_hit)
+                    begin
+                        for (int i = 0; i < 4; i++)
+                            channel_acc[i] <= channel_sum[i];
+
+                        texel_idx <= texel_idx + 2'd1;
+                    end
+                    else
+                        state <= TS_LOAD_TEXEL;
+
+                    // Replace the buffer that wasn't used most recently
+                    if (lane_mask[lane_idx] && texel_hit)
+                        replace_idx <= !buffer_hit[1];
+                end
+
+                TS_LOAD_TEXEL:
+                begin
+                    if (l2_tex_ready)
+                        state <= TS_WAIT_TEXEL;
+                end
+
+                TS_WAIT_TEXEL:
+                begin
+                    if (response_valid)
+                    begin
+                        buffer_valid[replace_idx] <= 1;
+                        replace_idx <= !replace_idx;
+                        state <= TS_SAMPLE;
+                    end
+                end
+
+                TS_STORE:
+                begin
+                    if (l2_tex_ready)
+                        state <= TS_WAIT_STORE;
+                end
+
+                TS_WAIT_STORE:
+                begin
+                    if (response_valid)
+                    begin
+                        job_pending[job_thread] <= 0;
+                        state <= TS_IDLE;
+                    end
+                end
+
+                default:
+                    state <= TS_IDLE;
+            endcase
+        end
+    end
+endmodule
@@ -28,7 +28,10 @@ import defines::*;
 //     each thread.
 //   * writeback hazards between the pipelines of different lengths, tracked
 //     with a shared shift register.
-// - Tracks dcache misses and suspends threads until they are resolved.
+// - Tracks dcache misses, waits (CR_WAIT_FOR_WRITE), and integer divides, and
+//   suspends threads until they are resolved.
+// - Skips the subcycles of a scatter/gather instruction that
+//   dcache_tag_stage has coalesced into an earlier subcycle.
 //
 
 module thread_select_stage(
@@ -63,11 +66,21 @@ module thread_select_stage(
     // From nyuzi
     input local_thread_bitmap_t        thread_en,
 
+    // From dcache_tag_stage
+    input                              dt_scgath_advance_en,
+    input local_thread_idx_t           dt_scgath_advance_thread_idx,
+    input subcycle_t                   dt_scgath_advance_from,
+    input subcycle_t                   dt_scgath_advance_to,
+    input                              dt_scgath_advance_done,
+
     // From dcache_data_stage
     input local_thread_bitmap_t        wb_suspend_thread_oh,
     input local_thread_bitmap_t        l2i_dcache_wake_bitmap,
     input local_thread_bitmap_t        ior_wake_bitmap,
 
+    // From int_divider
+    input local_thread_bitmap_t        idv_wake_bitmap,
+
     // To performance_counters
     output logic                       ts_perf_instruction_issue);
 
@@ -112,6 +125,7 @@ module thread_select_stage(
             logic enqueue_this_thread;
             logic writeback_this_thread;
             logic scoreboard_can_issue;
+            logic scgath_advance_this_thread;
 
             assign enqueue_this_thread = id_instruction_valid
                 && id_thread_idx == local_thread_idx_t'(thread_idx);
@@ -128,7 +142,8 @@ module thread_select_stage(
                 .enqueue_value(id_instruction),
                 .empty(ififo_empty),
                 .almost_empty(),
-                .dequeue_en(issue_last_subcycle[thread_idx]),
+                .dequeue_en(issue_last_subcycle[thread_idx]
+                    || (scgath_advance_this_thread && dt_scgath_advance_done)),
                 .dequeue_value(thread_instr[thread_idx]),
                 .*);
 
@@ -175,12 +190,30 @@ module thread_select_stage(
             assign issue_last_subcycle[thread_idx] = thread_issue_oh[thread_idx]
                 && current_subcycle[thread_idx] == thread_instr[thread_idx].last_subcycle;
 
+            // dcache_tag_stage coalesced the subcycles up to
+            // dt_scgath_advance_to (or the rest of the instruction if
+            // dt_scgath_advance_done is set). This thread may have already
+            // issued some of them, which that stage will ignore. If this thread
+            // has moved past the instruction (current_subcycle was reset after
+            // the last subcycle issued) or past the run, ignore this.
+            assign scgath_advance_this_thread = dt_scgath_advance_en
+                && dt_scgath_advance_thread_idx == local_thread_idx_t'(thread_idx)
+                && !rollback_this_thread
+                && current_subcycle[thread_idx] > dt_scgath_advance_from
+                && (dt_scgath_advance_done
+                || current_subcycle[thread_idx] < dt_scgath_advance_to);
+
             always_ff @(posedge clk, posedge reset)
             begin
                 if (reset)
                     current_subcycle[thread_idx] <= 0;
                 else if (wb_rollback_en && wb_rollback_thread_idx == local_thread_idx_t'(thread_idx))
                     current_subcycle[thread_idx] <= wb_rollback_subcycle;
+                else if (scgath_advance_this_thread)
+                begin
+                    // If the run finished the instruction, this wraps to 0
+                    current_subcycle[thread_idx] <= dt_scgath_advance_to;
+                end
                 else if (issue_last_subcycle[thread_idx])
                     current_subcycle[thread_idx] <= 0;
                 else if (thread_issue_oh[thread_idx])
@@ -267,14 +300,17 @@ module thread_select_stage(
         end
         else
         begin
-            // Should not get a wake from l1 cache and io queue in the same cycle
+            // Should not get a wake from l1 cache, io queue, and divider in the
+            // same cycle
             assert((l2i_dcache_wake_bitmap & ior_wake_bitmap) == 0);
+            assert(((l2i_dcache_wake_bitmap | ior_wake_bitmap) & idv_wake_bitmap) == 0);
 
             // Check for suspending a thread that isn't running
             assert((wb_suspend_thread_oh & thread_blocked) == 0);
 
             // Check for waking a thread that isn't suspended (or about to be suspended, see note below)
-            assert(((l2i_dcache_wake_bitmap | ior_wake_bitmap) & ~(thread_blocked | wb_suspend_thread_oh)) == 0);
+            assert(((l2i_dcache_wake_bitmap | ior_wake_bitmap | idv_wake_bitmap)
+                & ~(thread_blocked | wb_suspend_thread_oh)) == 0);
 
             // Don't issue blocked threads
             assert((thread_issue_oh & thread_blocked) == 0);
@@ -291,7 +327,7 @@ module thread_select_stage(
             // because of the order of this expression. This is intended, since
             // cache data is now available and the thread won't be rolled back.
             thread_blocked <= (thread_blocked | wb_suspend_thread_oh)
-                & ~(l2i_dcache_wake_bitmap | ior_wake_bitmap);
+                & ~(l2i_dcache_wake_bitmap | ior_wake_bitmap | idv_wake_bitmap);
 
             writeback_allocate <= writeback_allocate_nxt;
             ts_perf_instruction_issue <= |thread_issue_oh;
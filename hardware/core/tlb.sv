@@ -21,11 +21,19 @@ import defines::*;
 //
 // Translation lookaside buffer.
 // Caches virtual to physical address translations.
+// 4k pages are stored in a set associative array. Superpages (which map
+// SUPERPAGE_SIZE bytes with one entry) are stored in a small fully associative
+// array, which is checked in parallel. For a superpage, update_ppage_idx and
+// request_vpage_idx only use the upper bits; the lower bits of the physical
+// page index come from the virtual address. Inserting a superpage removes a 4k
+// entry for the same page. If a lookup hits in both arrays, the 4k entry is
+// used. Invalidating an address removes the superpage entry that contains it.
 //
 
 module tlb
     #(parameter NUM_ENTRIES = 64,
-    parameter NUM_WAYS = 4)
+    parameter NUM_WAYS = 4,
+    parameter NUM_SUPERPAGE_ENTRIES = 4)
 
     (input                    clk,
     input                     reset,
@@ -43,6 +51,7 @@ module tlb
     input                     update_exe_writable,
     input                     update_supervisor,
     input                     update_global,
+    input                     update_superpage,
 
     // Response
     output page_index_t       lookup_ppage_idx,
@@ -54,6 +63,7 @@ module tlb
     localparam NUM_SETS = NUM_ENTRIES / NUM_WAYS;
     localparam SET_INDEX_WIDTH = $clog2(NUM_SETS);
     localparam WAY_INDEX_WIDTH = $clog2(NUM_WAYS);
+    localparam SUPERPAGE_NUM_BITS = 32 - $clog2(SUPERPAGE_SIZE);
 
     logic[NUM_WAYS - 1:0] way_hit_oh;
     page_index_t way_ppage_idx[NUM_WAYS];
@@ -74,7 +84,17 @@ module tlb
     logic update_exe_writable_latched;
     logic update_supervisor_latched;
     logic update_global_latched;
+    logic update_superpage_latched;
     logic[ASID_WIDTH - 1:0] request_asid_latched;
+    logic way_hit;
+    logic[NUM_SUPERPAGE_ENTRIES - 1:0] super_hit_oh;
+    logic[NUM_SUPERPAGE_ENTRIES - 1:0] super_update_oh;
+    logic[NUM_SUPERPAGE_ENTRIES - 1:0] next_super_oh;
+    logic[SUPERPAGE_NUM_BITS - 1:0] super_ppage_idx[NUM_SUPERPAGE_ENTRIES];
+    logic super_present[NUM_SUPERPAGE_ENTRIES];
+    logic super_exe_writable[NUM_SUPERPAGE_ENTRIES];
+    logic super_supervisor[NUM_SUPERPAGE_ENTRIES];
+    logic update_superpage_en;
 
     //
     // Stage 1: lookup
@@ -161,6 +181,7 @@ module tlb
         update_exe_writable_latched <= update_exe_writable;
         update_supervisor_latched <= update_supervisor;
         update_global_latched <= update_global;
+        update_superpage_latched <= update_superpage;
         request_asid_latched <= request_asid;
         request_vpage_idx_latched <= request_vpage_idx;
     end
@@ -183,10 +204,55 @@ module tlb
         end
     end
 
+    //
+    // Superpage entries. These are in flip flops, so they are compared in
+    // stage 2 against the latched request.
+    //
+    genvar super_idx;
+    generate
+        for (super_idx = 0; super_idx < NUM_SUPERPAGE_ENTRIES; super_idx++)
+        begin : super_gen
+            logic super_valid;
+            logic[SUPERPAGE_NUM_BITS - 1:0] super_vpage_idx;
+            logic[ASID_WIDTH - 1:0] super_asid;
+            logic super_global;
+
+            assign super_hit_oh[super_idx] = super_valid
+                && super_vpage_idx == request_vpage_idx_latched[PAGE_NUM_BITS - 1-:SUPERPAGE_NUM_BITS]
+                && (super_asid == request_asid_latched || super_global
+                    || (update_en_latched && update_global_latched));
+
+            always_ff @(posedge clk, posedge reset)
+            begin
+                if (reset)
+                    super_valid <= 0;
+                else if (invalidate_all_en)
+                    super_valid <= 0;
+                else if (super_update_oh[super_idx])
+                    super_valid <= update_superpage_en;
+            end
+
+            always_ff @(posedge clk)
+            begin
+                if (super_update_oh[super_idx] && update_superpage_en)
+                begin
+                    super_vpage_idx <= request_vpage_idx_latched[PAGE_NUM_BITS - 1-:SUPERPAGE_NUM_BITS];
+                    super_asid <= request_asid_latched;
+                    super_ppage_idx[super_idx] <= update_ppage_idx_latched[PAGE_NUM_BITS - 1-:SUPERPAGE_NUM_BITS];
+                    super_present[super_idx] <= update_present_latched;
+                    super_exe_writable[super_idx] <= update_exe_writable_latched;
+                    super_supervisor[super_idx] <= update_supervisor_latched;
+                    super_global <= update_global_latched;
+                end
+            end
+        end
+    endgenerate
+
     //
     // Stage 2: output/update
     //
-    assign lookup_hit = |way_hit_oh;
+    assign way_hit = |way_hit_oh;
+    assign lookup_hit = way_hit || |super_hit_oh;
     always_comb
     begin
         // Enabled mux. Use OR to avoid inferring priority encoder.
@@ -194,23 +260,46 @@ module tlb
         lookup_present = 0;
         lookup_exe_writable = 0;
         lookup_supervisor = 0;
-        for (int way = 0; way < NUM_WAYS; way++)
+        if (way_hit)
+        begin
+            for (int way = 0; way < NUM_WAYS; way++)
+            begin
+                if (way_hit_oh[way])
+                begin
+                    lookup_ppage_idx |= way_ppage_idx[way];
+                    lookup_present |= way_present[way];
+                    lookup_exe_writable |= way_exe_writable[way];
+                    lookup_supervisor |= way_supervisor[way];
+                end
+            end
+        end
+        else
         begin
-            if (way_hit_oh[way])
+            for (int entry = 0; entry < NUM_SUPERPAGE_ENTRIES; entry++)
             begin
-                lookup_ppage_idx |= way_ppage_idx[way];
-                lookup_present |= way_present[way];
-                lookup_exe_writable |= way_exe_writable[way];
-                lookup_supervisor |= way_supervisor[way];
+                if (super_hit_oh[entry])
+                begin
+                    lookup_ppage_idx |= {super_ppage_idx[entry],
+                        request_vpage_idx_latched[PAGE_NUM_BITS - SUPERPAGE_NUM_BITS - 1:0]};
+                    lookup_present |= super_present[entry];
+                    lookup_exe_writable |= super_exe_writable[entry];
+                    lookup_supervisor |= super_supervisor[entry];
+                end
             end
         end
     end
 
+    // A superpage update also clears a 4k entry for the same page, which
+    // would otherwise take priority.
+    assign update_superpage_en = update_en_latched && update_superpage_latched;
+
     always_comb
     begin
-        if (update_en_latched || invalidate_en_latched)
+        if (update_superpage_en)
+            way_update_oh = way_hit_oh;
+        else if (update_en_latched || invalidate_en_latched)
         begin
-            if (lookup_hit)
+            if (way_hit)
                 way_update_oh = way_hit_oh;
             else
                 way_update_oh = next_way_oh;
@@ -219,25 +308,48 @@ module tlb
             way_update_oh = '0;
     end
 
+    always_comb
+    begin
+        if (update_superpage_en)
+        begin
+            if (|super_hit_oh)
+                super_update_oh = super_hit_oh;
+            else
+                super_update_oh = next_super_oh;
+        end
+        else if (invalidate_en_latched)
+            super_update_oh = super_hit_oh;
+        else
+            super_update_oh = '0;
+    end
+
     // If there is an invalidate, clear the valid bit
-    assign update_valid = update_en_latched;
+    assign update_valid = update_en_latched && !update_superpage_latched;
 
     always_ff @(posedge clk, posedge reset)
     begin
         if (reset)
         begin
             next_way_oh <= NUM_WAYS'(1);
+            next_super_oh <= NUM_SUPERPAGE_ENTRIES'(1);
             /*AUTORESET*/
         end
         else
         begin
             // Make sure we don't have duplicate entries in a set
             assert($onehot0(way_hit_oh));
-            if (update_en)
+            assert($onehot0(super_hit_oh));
+            if (update_en && !update_superpage)
             begin
                 // Rotate
                 next_way_oh <= {next_way_oh[NUM_WAYS - 2:0], next_way_oh[NUM_WAYS - 1]};
             end
+
+            if (update_en && update_superpage)
+            begin
+                next_super_oh <= {next_super_oh[NUM_SUPERPAGE_ENTRIES - 2:0],
+                    next_super_oh[NUM_SUPERPAGE_ENTRIES - 1]};
+            end
         end
     end
 endmodule
@@ -61,6 +61,7 @@ module writeback_stage(
     input scalar_t                        ix_rollback_pc,
     input subcycle_t                      ix_subcycle,
     input                                 ix_privileged_op_fault,
+    input                                 ix_suspend_thread,
 
     // From dcache_data_stage (memory pipeline)
     input                                 dd_instruction_valid,
@@ -69,11 +70,15 @@ module writeback_stage(
     input local_thread_idx_t              dd_thread_idx,
     input l1d_addr_t                      dd_request_vaddr,
     input subcycle_t                      dd_subcycle,
+    input scgath_word_idx_t               dd_scgath_word_idx,
+    input                                 dd_scgath_covered,
+    input                                 dd_scgath_run_done,
     input                                 dd_rollback_en,
     input scalar_t                        dd_rollback_pc,
     input cache_line_data_t               dd_load_data,
     input                                 dd_suspend_thread,
     input                                 dd_io_access,
+    input                                 dd_scratchpad_access,
     input logic                           dd_trap,
     input trap_cause_t                    dd_trap_cause,
 
@@ -138,9 +143,10 @@ module writeback_stage(
     cache_line_data_t endian_twiddled_data;
     logic[NUM_VECTOR_LANES - 1:0] scycle_vcompare_result;
     logic[NUM_VECTOR_LANES - 1:0] mcycle_vcompare_result;
-    vector_mask_t dd_vector_lane_oh;
+    vector_t gather_value;
     cache_line_data_t bypassed_read_data;
     local_thread_bitmap_t thread_dd_oh;
+    local_thread_bitmap_t thread_ix_oh;
     logic last_subcycle_dd;
     logic last_subcycle_ix;
     logic last_subcycle_fx;
@@ -262,9 +268,24 @@ module writeback_stage(
         .one_hot(thread_dd_oh),
         .index(dd_thread_idx));
 
-    // Suspend thread if necessary
-    assign wb_suspend_thread_oh = (dd_suspend_thread || sq_rollback_en || ior_rollback_en)
-        ? thread_dd_oh : local_thread_bitmap_t'(0);
+    idx_to_oh #(
+        .NUM_SIGNALS(`THREADS_PER_CORE),
+        .DIRECTION("LSB0")
+    ) idx_to_oh_ix_thread(
+        .one_hot(thread_ix_oh),
+        .index(ix_thread_idx));
+
+    // Suspend thread if necessary. Instructions from the integer and memory
+    // pipelines never arrive in the same cycle.
+    always_comb
+    begin
+        if (dd_suspend_thread || sq_rollback_en || ior_rollback_en)
+            wb_suspend_thread_oh = thread_dd_oh;
+        else if (ix_instruction_valid && ix_suspend_thread)
+            wb_suspend_thread_oh = thread_ix_oh;
+        else
+            wb_suspend_thread_oh = '0;
+    end
 
     // If there is a pending store for the value that was just read, merge it into
     // the data returned from the L1 data cache.
@@ -332,14 +353,26 @@ module writeback_stage(
         end
     endgenerate
 
-    idx_to_oh #(
-        .NUM_SIGNALS(NUM_VECTOR_LANES),
-        .DIRECTION("LSB0")
-    ) convert_dd_lane(
-        .one_hot(dd_vector_lane_oh),
-        .index(dd_subcycle));
+    // Gather load. dcache_tag_stage may have coalesced several lanes into this
+    // subcycle. Each reads the word at its own offset in the cache line.
+    genvar gather_lane;
+    generate
+        for (gather_lane = 0; gather_lane < NUM_VECTOR_LANES; gather_lane++)
+        begin : gather_lane_gen
+            logic[$clog2(CACHE_LINE_WORDS) - 1:0] lane_word_idx;
+            scalar_t lane_word;
+
+            assign lane_word_idx = ~dd_scgath_word_idx[NUM_VECTOR_LANES - gather_lane - 1];
+            assign lane_word = bypassed_read_data[lane_word_idx * 32+:32];
+            assign gather_value[gather_lane] = {lane_word[7:0], lane_word[15:8],
+                lane_word[23:16], lane_word[31:24]};
+        end
+    endgenerate
 
-    assign last_subcycle_dd = dd_subcycle == dd_instruction.last_subcycle;
+    // If a scatter/gather subcycle coalesced all remaining lanes, it finishes
+    // the instruction.
+    assign last_subcycle_dd = dd_subcycle == dd_instruction.last_subcycle
+        || dd_scgath_run_done;
     assign last_subcycle_ix = ix_subcycle == ix_instruction.last_subcycle;
     assign last_subcycle_fx = fx5_subcycle == fx5_instruction.last_subcycle;
 
@@ -412,7 +445,11 @@ module writeback_stage(
             //
             // Memory pipeline result
             //
-            writeback_en_nxt = dd_instruction.has_dest && !wb_rollback_en;
+            // A scatter/gather subcycle that was covered by an earlier one
+            // doesn't write back. This also keeps it from clearing the
+            // scoreboard entry for the destination register again.
+            writeback_en_nxt = dd_instruction.has_dest && !wb_rollback_en
+                && !dd_scgath_covered;
             writeback_thread_idx_nxt = dd_thread_idx;
             if (!dd_instruction.cache_control)
             begin
@@ -455,17 +492,18 @@ module writeback_stage(
                         default:
                         begin
                             // Gather load
-                            // Grab the appropriate lane.
-                            writeback_mask_nxt = dd_vector_lane_oh & dd_lane_mask;
-                            writeback_value_nxt = {NUM_VECTOR_LANES{swapped_word_value}};
+                            writeback_mask_nxt = dd_lane_mask;
+                            writeback_value_nxt = gather_value;
                         end
                     endcase
                 end
                 else if (memory_op == MEM_SYNC)
                 begin
                     // Synchronized stores are special because they write
-                    // back (whether they were successful).
-                    writeback_value_nxt[0] = scalar_t'(sq_store_sync_success);
+                    // back (whether they were successful). They always
+                    // succeed in the scratchpad.
+                    writeback_value_nxt[0] = scalar_t'(sq_store_sync_success
+                        || dd_scratchpad_access);
                 end
             end
 
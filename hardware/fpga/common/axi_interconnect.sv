@@ -46,6 +46,16 @@ module axi_interconnect
         STATE_ACTIVE_BURST
     } burst_state_t;
 
+    typedef struct packed {
+        logic master;
+        logic slave;
+        logic[7:0] length;
+    } read_route_t;
+
+    // Number of read bursts whose address has been accepted, but whose data
+    // has not been completely transferred.
+    localparam MAX_OUTSTANDING_READS = 4;
+
     burst_state_t write_state;
     logic[31:0] write_burst_address;
     logic[7:0] write_burst_length;    // Like axi_awlen, this is number of transfers minus 1
@@ -56,6 +66,12 @@ module axi_interconnect
     logic[31:0] read_burst_address;
     burst_state_t read_state;
     logic axi_arready_m;
+    logic read_address_accepted;
+    logic read_route_full;
+    logic read_route_empty;
+    logic read_data_last;
+    read_route_t read_route;
+    logic[7:0] read_data_count;
     logic axi_rready_m;
     logic axi_rvalid_m;
 
@@ -142,11 +158,38 @@ module axi_interconnect
     end
 
     //
-    // Read handling.  Slave interface 1 has priority.
+    // Read handling. The address and data phases are decoupled, so this can
+    // issue the address for another burst while data is being transferred
+    // for earlier ones. read_route_fifo records where the data for each
+    // accepted burst goes. Slaves return data in the order addresses were
+    // accepted, and this routes it from the slave at the head of the FIFO.
+    // If bursts are outstanding to both slaves, the other slave waits until
+    // the earlier burst is finished.
+    // Master interface 1 has priority.
     //
     assign axi_arready_m = read_selected_slave ? axi_bus_s[1].s_arready : axi_bus_s[0].s_arready;
-    assign axi_rready_m = read_selected_slave ? axi_bus_s[1].m_rready : axi_bus_s[0].m_rready;
-    assign axi_rvalid_m = read_selected_slave ? axi_bus_s[1].s_rvalid : axi_bus_s[0].s_rvalid;
+    assign read_address_accepted = read_state == STATE_ISSUE_ADDRESS && axi_arready_m;
+
+    sync_fifo #(
+        .WIDTH($bits(read_route_t)),
+        .SIZE(MAX_OUTSTANDING_READS)
+    ) read_route_fifo(
+        .clk(clk),
+        .reset(reset),
+        .flush_en(1'b0),
+        .full(read_route_full),
+        .almost_full(),
+        .enqueue_en(read_address_accepted),
+        .enqueue_value({read_selected_master, read_selected_slave, read_burst_length}),
+        .empty(read_route_empty),
+        .almost_empty(),
+        .dequeue_en(read_data_last),
+        .dequeue_value(read_route));
+
+    assign axi_rready_m = read_route.master ? axi_bus_m[1].m_rready : axi_bus_m[0].m_rready;
+    assign axi_rvalid_m = read_route.slave ? axi_bus_s[1].s_rvalid : axi_bus_s[0].s_rvalid;
+    assign read_data_last = !read_route_empty && axi_rready_m && axi_rvalid_m
+        && read_data_count == read_route.length;
 
     always_ff @(posedge clk, posedge reset)
     begin
@@ -158,90 +201,70 @@ module axi_interconnect
             // Beginning of autoreset for uninitialized flops
             read_burst_address <= '0;
             read_burst_length <= '0;
+            read_data_count <= '0;
             read_selected_master <= '0;
             read_selected_slave <= '0;
             // End of automatics
         end
-        else if (read_state == STATE_ACTIVE_BURST)
+        else
         begin
-            // Burst is active.  Check to see when it is finished.
-            if (axi_rready_m && axi_rvalid_m)
+            if (read_state == STATE_ISSUE_ADDRESS)
             begin
-                read_burst_length <= read_burst_length - 8'd1;
-                if (read_burst_length == 0)
+                // Wait for the slave to accept the address and length
+                if (axi_arready_m)
                     read_state <= STATE_ARBITRATE;
             end
-        end
-        else if (read_state == STATE_ISSUE_ADDRESS)
-        begin
-            // Wait for the slave to accept the address and length
-            if (axi_arready_m)
-                read_state <= STATE_ACTIVE_BURST;
-        end
-        else if (axi_bus_m[1].m_arvalid)
-        begin
-            // Start a read burst from slave 1
-            read_state <= STATE_ISSUE_ADDRESS;
-            read_burst_address <= axi_bus_m[1].m_araddr;
-            read_burst_length <= axi_bus_m[1].m_arlen;
-            read_selected_master <= 1'b1;
-            read_selected_slave <= axi_bus_m[1].m_araddr >= M1_BASE_ADDRESS;
-        end
-        else if (axi_bus_m[0].m_arvalid)
-        begin
-            // Start a read burst from slave 0
-            read_state <= STATE_ISSUE_ADDRESS;
-            read_burst_address <= axi_bus_m[0].m_araddr;
-            read_burst_length <= axi_bus_m[0].m_arlen;
-            read_selected_master <= 1'b0;
-            read_selected_slave <= axi_bus_m[0].m_araddr[31:28] != 0;
+            else if (read_route_full)
+            begin
+                // Wait for an earlier burst to finish
+            end
+            else if (axi_bus_m[1].m_arvalid)
+            begin
+                // Start a read burst from master 1
+                read_state <= STATE_ISSUE_ADDRESS;
+                read_burst_address <= axi_bus_m[1].m_araddr;
+                read_burst_length <= axi_bus_m[1].m_arlen;
+                read_selected_master <= 1'b1;
+                read_selected_slave <= axi_bus_m[1].m_araddr >= M1_BASE_ADDRESS;
+            end
+            else if (axi_bus_m[0].m_arvalid)
+            begin
+                // Start a read burst from master 0
+                read_state <= STATE_ISSUE_ADDRESS;
+                read_burst_address <= axi_bus_m[0].m_araddr;
+                read_burst_length <= axi_bus_m[0].m_arlen;
+                read_selected_master <= 1'b0;
+                read_selected_slave <= axi_bus_m[0].m_araddr[31:28] != 0;
+            end
+
+            if (read_data_last)
+                read_data_count <= '0;
+            else if (!read_route_empty && axi_rready_m && axi_rvalid_m)
+                read_data_count <= read_data_count + 8'd1;
         end
     end
 
     always_comb
     begin
-        if (read_state == STATE_ARBITRATE)
-        begin
-            axi_bus_m[0].s_rvalid = 0;
-            axi_bus_m[1].s_rvalid = 0;
-            axi_bus_s[0].m_rready = 0;
-            axi_bus_s[1].m_rready = 0;
-            axi_bus_m[0].s_arready = 0;
-            axi_bus_m[1].s_arready = 0;
-        end
-        else if (read_selected_master == 0)
-        begin
-            axi_bus_m[0].s_rvalid = axi_rvalid_m;
-            axi_bus_m[1].s_rvalid = 0;
-            axi_bus_s[0].m_rready = axi_bus_m[0].m_rready && read_selected_slave == 0;
-            axi_bus_s[1].m_rready = axi_bus_m[0].m_rready && read_selected_slave == 1;
-            axi_bus_m[0].s_arready = axi_arready_m && read_state == STATE_ISSUE_ADDRESS;
-            axi_bus_m[1].s_arready = 0;
-        end
-        else
-        begin
-            axi_bus_m[0].s_rvalid = 0;
-            axi_bus_m[1].s_rvalid = axi_rvalid_m;
-            axi_bus_s[0].m_rready = axi_bus_m[1].m_rready && read_selected_slave == 0;
-            axi_bus_s[1].m_rready = axi_bus_m[1].m_rready && read_selected_slave == 1;
-            axi_bus_m[0].s_arready = 0;
-            axi_bus_m[1].s_arready = axi_arready_m && read_state == STATE_ISSUE_ADDRESS;
-        end
+        axi_bus_m[0].s_arready = read_state == STATE_ISSUE_ADDRESS
+            && read_selected_master == 0 && axi_arready_m;
+        axi_bus_m[1].s_arready = read_state == STATE_ISSUE_ADDRESS
+            && read_selected_master == 1 && axi_arready_m;
+        axi_bus_m[0].s_rvalid = !read_route_empty && read_route.master == 0 && axi_rvalid_m;
+        axi_bus_m[1].s_rvalid = !read_route_empty && read_route.master == 1 && axi_rvalid_m;
+        axi_bus_s[0].m_rready = !read_route_empty && read_route.slave == 0 && axi_rready_m;
+        axi_bus_s[1].m_rready = !read_route_empty && read_route.slave == 1 && axi_rready_m;
     end
 
     assign axi_bus_s[0].m_arvalid = read_state == STATE_ISSUE_ADDRESS && read_selected_slave == 0;
     assign axi_bus_s[1].m_arvalid = read_state == STATE_ISSUE_ADDRESS && read_selected_slave == 1;
     assign axi_bus_s[0].m_araddr = read_burst_address;
     assign axi_bus_s[1].m_araddr = read_burst_address - M1_BASE_ADDRESS;
-    assign axi_bus_m[0].s_rdata = read_selected_slave ? axi_bus_s[1].s_rdata : axi_bus_s[0].s_rdata;
+    assign axi_bus_s[0].m_arlen = read_burst_length;
+    assign axi_bus_s[1].m_arlen = read_burst_length;
+    assign axi_bus_m[0].s_rdata = read_route.slave ? axi_bus_s[1].s_rdata : axi_bus_s[0].s_rdata;
     assign axi_bus_m[1].s_rdata = axi_bus_m[0].s_rdata;
     assign axi_bus_m[1].s_awready = '0;
     assign axi_bus_m[1].s_wready = '0;
     assign axi_bus_m[1].s_bvalid = '0;
-
-    // We end up reusing read_burst_length to track how many beats are left
-    // later.  At this point, the value of ARLEN should be ignored by slave
-    // we are driving, so it won't break anything.
-    assign axi_bus_s[0].m_arlen = read_burst_length;
-    assign axi_bus_s[1].m_arlen = read_burst_length;
 endmodule
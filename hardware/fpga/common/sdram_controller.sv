@@ -62,7 +62,9 @@ module sdram_controller
     output logic                            perf_dram_page_miss,
     output logic                            perf_dram_page_hit);
 
-    localparam SDRAM_BURST_LENGTH = 8;
+    // A cache line fill must be a whole number of SDRAM bursts.
+    localparam SDRAM_BURST_LENGTH = CACHE_LINE_BITS / DATA_WIDTH < 8
+        ? CACHE_LINE_BITS / DATA_WIDTH : 8;
     localparam SDRAM_BURST_IDX_WIDTH = $clog2(SDRAM_BURST_LENGTH);
     localparam NUM_BANKS = 4;
     localparam MEMORY_SIZE = (1 << (ROW_ADDR_WIDTH + COL_ADDR_WIDTH)) * NUM_BANKS
@@ -119,6 +121,7 @@ module sdram_controller
     logic[7:0] read_length;    // Like axi_bus.m_arlen, is num_transfers - 1
     logic read_pending;
     logic lfifo_empty;
+    logic lfifo_burst_space;
     logic sfifo_full;
     logic[$clog2(NUM_BANKS) - 1:0] write_bank;
     logic[COL_ADDR_WIDTH - 1:0] write_column;
@@ -137,14 +140,19 @@ module sdram_controller
     assign axi_bus.s_bvalid = !reset;    // Hack: pretend we always have a write result
 
     // Each fifo can hold an entire SDRAM burst to avoid delays due
-    // to the external bus.
-
-    sync_fifo #(.WIDTH(DATA_WIDTH), .SIZE(SDRAM_BURST_LENGTH)) load_fifo(
+    // to the external bus. The load FIFO holds two, so the next read burst
+    // can start while the bus is still transferring data from the last one.
+
+    sync_fifo #(
+        .WIDTH(DATA_WIDTH),
+        .SIZE(SDRAM_BURST_LENGTH * 2),
+        .ALMOST_EMPTY_THRESHOLD(SDRAM_BURST_LENGTH)
+    ) load_fifo(
         .clk(clk),
         .reset(reset),
         .flush_en(1'b0),
         .full(),
-        .almost_empty(),
+        .almost_empty(lfifo_burst_space),
         .almost_full(),
         .empty(lfifo_empty),
         .enqueue_value(dram_dq),
@@ -246,7 +254,8 @@ module sdram_controller
                     // Step 3: set the mode register
                     // CAS latency is hardcoded to 2 clocks
                     command = CMD_MODE_REGISTER_SET;
-                    dram_addr = SDRAM_ADDR_WIDTH'('b000_0_00_010_0_011);
+                    dram_addr = SDRAM_ADDR_WIDTH'({6'b000_0_00, 3'b010, 1'b0,
+                        3'($clog2(SDRAM_BURST_LENGTH))});
                     dram_ba = 2'b00;
                     state_nxt = STATE_IDLE;
                 end
@@ -263,7 +272,7 @@ module sdram_controller
                         else
                             state_nxt = STATE_AUTO_REFRESH1;
                     end
-                    else if (lfifo_empty && read_pending
+                    else if (lfifo_burst_space && read_pending
                         && (!write_pending || write_address != read_address))
                     begin
                         // Start a read burst. Reads have priority to avoid starving
@@ -47,9 +47,15 @@ module vga_controller
     output logic                vga_sync_n);
 
     // The burst length is twice that of a CPU cache line fill to ensure
-    // sufficient memory bandwidth even when ping-ponging.
+    // sufficient memory bandwidth even when ping-ponging. Lengths are in
+    // pixels. When the bus is wider than a pixel, each beat (and FIFO entry)
+    // holds several, with the lowest address in the most significant bits.
     localparam BURST_LENGTH = 64;
     localparam PIXEL_FIFO_LENGTH = 128;
+    localparam PIXELS_PER_BEAT = `AXI_DATA_WIDTH / 32;
+    localparam BURST_BEATS = BURST_LENGTH / PIXELS_PER_BEAT;
+    localparam FIFO_BEATS = PIXEL_FIFO_LENGTH / PIXELS_PER_BEAT;
+    localparam PIXEL_IDX_WIDTH = PIXELS_PER_BEAT > 1 ? $clog2(PIXELS_PER_BEAT) : 1;
 
     typedef enum {
         STATE_WAIT_FRAME_START,
@@ -68,6 +74,10 @@ module vga_controller
     logic[7:0] _ignore_alpha;
     logic pixel_fifo_empty;
     logic pixel_fifo_almost_empty;
+    logic[`AXI_DATA_WIDTH - 1:0] pixel_beat;
+    logic[PIXEL_IDX_WIDTH - 1:0] pixel_idx;
+    logic pixel_dequeue;
+    logic last_pixel_in_beat;
     logic[31:0] fb_base_address;
     logic[31:0] fb_length;
     dma_state_t axi_state;
@@ -85,20 +95,34 @@ module vga_controller
     // beginning of the vblank period so it will resynchronize if there was
     // an underrun.
     sync_fifo #(
-        .WIDTH(24),
-        .SIZE(PIXEL_FIFO_LENGTH),
-        .ALMOST_EMPTY_THRESHOLD(PIXEL_FIFO_LENGTH - BURST_LENGTH - 1)) pixel_fifo(
+        .WIDTH(`AXI_DATA_WIDTH),
+        .SIZE(FIFO_BEATS),
+        .ALMOST_EMPTY_THRESHOLD(FIFO_BEATS - BURST_BEATS - 1)) pixel_fifo(
         .clk(clk),
         .reset(reset),
         .flush_en(start_frame),
         .almost_full(),
         .empty(pixel_fifo_empty),
         .almost_empty(pixel_fifo_almost_empty),
-        .dequeue_value({vga_r, vga_g, vga_b}),
-        .enqueue_value(axi_bus.s_rdata[31:8]),
+        .dequeue_value(pixel_beat),
+        .enqueue_value(axi_bus.s_rdata),
         .enqueue_en(axi_bus.s_rvalid),
         .full(),
-        .dequeue_en(pixel_en && in_visible_region && !pixel_fifo_empty));
+        .dequeue_en(pixel_dequeue && last_pixel_in_beat));
+
+    assign pixel_dequeue = pixel_en && in_visible_region && !pixel_fifo_empty;
+    assign last_pixel_in_beat = pixel_idx == PIXEL_IDX_WIDTH'(PIXELS_PER_BEAT - 1);
+    assign {vga_r, vga_g, vga_b} = pixel_beat[(PIXELS_PER_BEAT - 1 - int'(pixel_idx)) * 32 + 8+:24];
+
+    always_ff @(posedge clk, posedge reset)
+    begin
+        if (reset)
+            pixel_idx <= '0;
+        else if (start_frame || (pixel_dequeue && last_pixel_in_beat))
+            pixel_idx <= '0;
+        else if (pixel_dequeue)
+            pixel_idx <= pixel_idx + 1'b1;
+    end
 
     // DMA state machine
     always_ff @(posedge clk, posedge reset)
@@ -155,7 +179,7 @@ module vga_controller
                 begin
                     if (axi_bus.s_rvalid)
                     begin
-                        if (burst_count == BURST_LENGTH - 1)
+                        if (burst_count == 8'(BURST_BEATS - 1))
                         begin
                             // Burst complete
                             burst_count <= 0;
@@ -188,7 +212,7 @@ module vga_controller
     end
 
     assign axi_bus.m_rready = 1'b1;    // The request is only made when there is enough room.
-    assign axi_bus.m_arlen = 8'(BURST_LENGTH - 1);
+    assign axi_bus.m_arlen = 8'(BURST_BEATS - 1);
     assign axi_bus.m_arvalid = axi_state == STATE_ISSUE_ADDR;
     assign axi_bus.m_araddr = vram_addr;
     assign axi_bus.m_awaddr = '0;
@@ -14,6 +14,8 @@ module TOP();
 
    logic clk;
    logic reset;
+   logic waveform_en;
+   logic checkpoint_req;
 
    initial
      begin
@@ -46,4 +48,15 @@ module TOP();
 `endif
      end
 
+`ifdef DUMP_FSDB
+   // Honor the same trace window plusargs as the Verilator model.
+   always @(waveform_en)
+     begin
+        if (waveform_en)
+          $fsdbDumpon;
+        else
+          $fsdbDumpoff;
+     end
+`endif
+
 endmodule
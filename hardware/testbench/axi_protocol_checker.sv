@@ -19,11 +19,16 @@
 import defines::*;
 
 // Ensure AXI protocol transactions conform to the specification.
-// This primarily validates the master. It assumes only one transaction
-// is outstanding.
+// This primarily validates the master. It assumes only one write
+// transaction is outstanding. Multiple reads may be outstanding. They all
+// use the same ID, so their data must arrive in the order the addresses
+// were accepted.
 module axi_protocol_checker(
     axi4_interface.slave        axi_bus);
 
+    localparam BYTES_PER_BEAT = `AXI_DATA_WIDTH / 8;
+    localparam MAX_OUTSTANDING_READS = 8;
+
     typedef enum int {
         IDLE,
         ADDRESS_ASSERTED,
@@ -73,7 +78,7 @@ module axi_protocol_checker(
 
                         // A3.4.1 Ensure this transaction doesn't cross a 4k boundary
                         assert ((int'(axi_bus.m_awaddr) / 4096) ==
-                            ((int'(axi_bus.m_awaddr) + int'(axi_bus.m_awlen) * 4) / 4096));
+                            ((int'(axi_bus.m_awaddr) + int'(axi_bus.m_awlen) * BYTES_PER_BEAT) / 4096));
 
                         write_count <= 0;
                         if (axi_bus.s_awready)
@@ -135,13 +140,27 @@ module axi_protocol_checker(
     burst_state_t read_burst_state;
     logic[AXI_ADDR_WIDTH - 1:0] araddr;
     logic [7:0] arlen;
+    logic [7:0] read_lengths[MAX_OUTSTANDING_READS];
+    int read_head;
+    int read_tail;
+    int reads_outstanding;
     int read_count;
+    logic read_address_accepted;
+    logic read_data_last;
+
+    assign read_address_accepted = axi_bus.m_arvalid && axi_bus.s_arready;
+    assign read_data_last = axi_bus.s_rvalid && axi_bus.m_rready
+        && read_count == int'(read_lengths[read_head]);
 
     always @(posedge axi_bus.m_aclk, negedge axi_bus.m_aresetn)
     begin
         if (!axi_bus.m_aresetn)
         begin
             read_burst_state <= IDLE;
+            read_head <= 0;
+            read_tail <= 0;
+            reads_outstanding <= 0;
+            read_count <= 0;
 
             // A3.1.2: The master must drive ARVALID low in reset.
             // The slave must drive RVALID low.
@@ -157,6 +176,7 @@ module axi_protocol_checker(
         end
         else
         begin
+            // Address channel
             case (read_burst_state)
                 IDLE:
                 begin
@@ -167,12 +187,9 @@ module axi_protocol_checker(
 
                         // A3.4.1 Ensure this transaction doesn't cross a 4k boundary
                         assert ((int'(axi_bus.m_araddr) / 4096) ==
-                            ((int'(axi_bus.m_araddr) + int'(axi_bus.m_arlen) * 4) / 4096));
+                            ((int'(axi_bus.m_araddr) + int'(axi_bus.m_arlen) * BYTES_PER_BEAT) / 4096));
 
-                        read_count <= 0;
-                        if (axi_bus.s_arready)
-                            read_burst_state <= ADDRESS_ACCEPTED;
-                        else
+                        if (!axi_bus.s_arready)
                             read_burst_state <= ADDRESS_ASSERTED;
                     end
                 end
@@ -186,24 +203,38 @@ module axi_protocol_checker(
                     assert(axi_bus.m_arlen === arlen);
 
                     if (axi_bus.s_arready)
-                        read_burst_state <= ADDRESS_ACCEPTED;
+                        read_burst_state <= IDLE;
                 end
 
-                ADDRESS_ACCEPTED:
+                default:
+                    read_burst_state <= IDLE;
+            endcase
+
+            if (read_address_accepted)
+            begin
+                // Not a spec constraint, but ensures this can track them.
+                assert(reads_outstanding < MAX_OUTSTANDING_READS);
+                read_lengths[read_tail] <= axi_bus.m_arlen;
+                read_tail <= (read_tail + 1) % MAX_OUTSTANDING_READS;
+            end
+
+            // Data channel
+            if (axi_bus.s_rvalid && axi_bus.m_rready)
+            begin
+                // A3.3.1: The slave must wait for the address handshake
+                // before returning read data.
+                assert(reads_outstanding > 0);
+                if (read_data_last)
                 begin
-                    if (axi_bus.s_rvalid && axi_bus.m_rready)
-                    begin
-                        assert(read_count <= int'(arlen));
-
-                        // Check that only a single transaction is pending (not
-                        // a spec constraint)
-                        assert(!axi_bus.m_arvalid);
-                        read_count <= read_count + 1;
-                        if (read_count == int'(arlen))
-                            read_burst_state <= IDLE;
-                    end
+                    read_count <= 0;
+                    read_head <= (read_head + 1) % MAX_OUTSTANDING_READS;
                 end
-            endcase
+                else
+                    read_count <= read_count + 1;
+            end
+
+            reads_outstanding <= reads_outstanding + int'(read_address_accepted)
+                - int'(read_data_last);
         end
     end
 endmodule
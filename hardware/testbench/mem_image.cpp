@@ -0,0 +1,197 @@
+//
+// Copyright 2018 Jeff Bush
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "svdpi.h"
+#include "Vsoc_tb__Dpi.h"
+
+//
+// Loads a binary program image for the testbench. This is much faster than
+// parsing a text file with $readmemh for large programs. The image is read
+// into a host buffer, then soc_tb.sv calls memory_image_word via DPI to copy
+// it into the simulated SDRAM array.
+//
+// If the file is an ELF executable, each loadable segment is copied to its
+// physical address and the remainder of the segment is zero filled. Otherwise
+// the file is treated as a raw memory image starting at address 0.
+//
+
+namespace
+{
+// The ELF definitions are declared here rather than using the system elf.h,
+// which is not available on all hosts.
+const unsigned int EI_NIDENT = 16;
+const uint8_t ELFCLASS32 = 1;
+const uint8_t ELFDATA2LSB = 1;
+const uint32_t PT_LOAD = 1;
+
+struct Elf32Header
+{
+    uint8_t e_ident[EI_NIDENT];
+    uint16_t e_type;
+    uint16_t e_machine;
+    uint32_t e_version;
+    uint32_t e_entry;
+    uint32_t e_phoff;
+    uint32_t e_shoff;
+    uint32_t e_flags;
+    uint16_t e_ehsize;
+    uint16_t e_phentsize;
+    uint16_t e_phnum;
+    uint16_t e_shentsize;
+    uint16_t e_shnum;
+    uint16_t e_shstrndx;
+};
+
+struct Elf32ProgramHeader
+{
+    uint32_t p_type;
+    uint32_t p_offset;
+    uint32_t p_vaddr;
+    uint32_t p_paddr;
+    uint32_t p_filesz;
+    uint32_t p_memsz;
+    uint32_t p_flags;
+    uint32_t p_align;
+};
+
+std::vector<uint8_t> imageBytes;
+
+bool isElfFile(const std::vector<uint8_t> &contents)
+{
+    return contents.size() >= sizeof(Elf32Header)
+        && memcmp(contents.data(), "\177ELF", 4) == 0;
+}
+
+// XXX assumes a little endian host, like the ELF file.
+bool loadElfImage(const char *filename, const std::vector<uint8_t> &contents,
+                  uint32_t maxBytes)
+{
+    Elf32Header header;
+    memcpy(&header, contents.data(), sizeof(header));
+    if (header.e_ident[4] != ELFCLASS32 || header.e_ident[5] != ELFDATA2LSB)
+    {
+        fprintf(stderr, "load_memory_image: %s is not a 32-bit little endian ELF file\n",
+                filename);
+        return false;
+    }
+
+    for (int segment = 0; segment < header.e_phnum; segment++)
+    {
+        Elf32ProgramHeader phdr;
+        size_t phdrOffset = header.e_phoff + segment * header.e_phentsize;
+        if (phdrOffset + sizeof(phdr) > contents.size())
+        {
+            fprintf(stderr, "load_memory_image: %s: bad program header offset\n",
+                    filename);
+            return false;
+        }
+
+        memcpy(&phdr, contents.data() + phdrOffset, sizeof(phdr));
+        if (phdr.p_type != PT_LOAD || phdr.p_memsz == 0)
+            continue;
+
+        if (static_cast<uint64_t>(phdr.p_offset) + phdr.p_filesz > contents.size()
+                || phdr.p_filesz > phdr.p_memsz)
+        {
+            fprintf(stderr, "load_memory_image: %s: segment %d is truncated\n",
+                    filename, segment);
+            return false;
+        }
+
+        uint64_t segmentEnd = static_cast<uint64_t>(phdr.p_paddr) + phdr.p_memsz;
+        if (segmentEnd > maxBytes)
+        {
+            fprintf(stderr, "load_memory_image: %s: segment %d (%08x-%08x) is outside memory\n",
+                    filename, segment, phdr.p_paddr,
+                    static_cast<uint32_t>(segmentEnd - 1));
+            return false;
+        }
+
+        if (segmentEnd > imageBytes.size())
+            imageBytes.resize(segmentEnd);
+
+        memcpy(imageBytes.data() + phdr.p_paddr, contents.data() + phdr.p_offset,
+               phdr.p_filesz);
+        memset(imageBytes.data() + phdr.p_paddr + phdr.p_filesz, 0,
+               phdr.p_memsz - phdr.p_filesz);
+    }
+
+    return true;
+}
+}
+
+//
+// Read the file into the host buffer. Returns the number of 32-bit words
+// that need to be copied into memory (starting at address 0), or -1 if there
+// was an error.
+//
+extern int load_memory_image(const char *filename, int maxBytes)
+{
+    FILE *file = fopen(filename, "rb");
+    if (file == nullptr)
+    {
+        perror("load_memory_image: error opening file");
+        return -1;
+    }
+
+    std::vector<uint8_t> contents;
+    uint8_t buffer[0x10000];
+    size_t got;
+    while ((got = fread(buffer, 1, sizeof(buffer), file)) > 0)
+        contents.insert(contents.end(), buffer, buffer + got);
+
+    fclose(file);
+
+    imageBytes.clear();
+    if (isElfFile(contents))
+    {
+        if (!loadElfImage(filename, contents, static_cast<uint32_t>(maxBytes)))
+            return -1;
+    }
+    else
+    {
+        if (contents.size() > static_cast<size_t>(maxBytes))
+        {
+            fprintf(stderr, "load_memory_image: %s is larger than memory\n", filename);
+            return -1;
+        }
+
+        imageBytes.swap(contents);
+    }
+
+    // Pad to a whole number of words
+    imageBytes.resize((imageBytes.size() + 3) & ~3);
+
+    return static_cast<int>(imageBytes.size() / 4);
+}
+
+//
+// Return a word from the loaded image. Memory words are stored with the
+// lowest addressed byte in the most significant bits, matching the hex
+// files that $readmemh loads.
+//
+extern int memory_image_word(int index)
+{
+    const uint8_t *ptr = imageBytes.data() + index * 4;
+    return static_cast<int>((static_cast<uint32_t>(ptr[0]) << 24)
+        | (static_cast<uint32_t>(ptr[1]) << 16)
+        | (static_cast<uint32_t>(ptr[2]) << 8)
+        | ptr[3]);
+}
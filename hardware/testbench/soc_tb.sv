@@ -18,6 +18,12 @@
 
 import defines::*;
 
+`ifdef VERILATOR
+// Native functions defined in mem_image.cpp
+import "DPI-C" function int load_memory_image(input string filename, input int max_bytes);
+import "DPI-C" function int memory_image_word(input int index);
+`endif
+
 //
 // Top module for simulating a system on chip, which includes the Nyuzi
 // core and peripherals like an SDRAM controller, virtual MMC storage
@@ -26,10 +32,14 @@ import defines::*;
 
 module soc_tb(
     input       clk,
-    input       reset);
+    input       reset,
+    output      waveform_en,
+    output logic checkpoint_req);
 
     localparam MEM_SIZE = 'h1000000;
     localparam NUM_PERIPHERALS = 6;
+    localparam TOTAL_THREADS = `NUM_CORES * `THREADS_PER_CORE;
+    localparam DEFAULT_PROFILE_INTERVAL = 97;
 
     int total_cycles;
     string filename;
@@ -38,6 +48,21 @@ module soc_tb(
     int finish_cycles;
     bit profile_en;
     int profile_fd;
+    int profile_interval;
+    int profile_countdown;
+    scalar_t profile_pc[TOTAL_THREADS];
+    logic[7:0] profile_state[TOTAL_THREADS];
+    int waveform_start_cycle;
+    int waveform_length;
+    bit waveform_pc_en;
+    scalar_t waveform_pc;
+    logic[`NUM_CORES - 1:0] waveform_pc_hit;
+    logic waveform_start_hit;
+    logic waveform_triggered;
+    logic waveform_done;
+    int waveform_cycle_count;
+    int image_words;
+    int l2_perf_count[`L2_BANKS][L2_PERF_EVENTS];
     axi4_interface axi_bus_s[1:0]();
     axi4_interface axi_bus_m[1:0]();
     scalar_t loopback_uart_read_data;
@@ -79,7 +104,9 @@ module soc_tb(
     logic uart_rx_interrupt;
     logic ps2_rx_interrupt;
 
-    localparam SDRAM_DATA_WIDTH = 32; // declare before use
+    localparam SDRAM_DATA_WIDTH = `AXI_DATA_WIDTH; // declare before use
+    localparam SDRAM_WORDS = SDRAM_DATA_WIDTH / 32;
+    scalar_t bin_words[SDRAM_WORDS == 1 ? 1 : MEM_SIZE / 4];
     wire [SDRAM_DATA_WIDTH-1:0] dram_dq; // inout fix: change from logic to wire to comply with commercial simulator and SystemVerilog standard
     logic processor_halt;
 
@@ -293,9 +320,11 @@ module soc_tb(
         begin
             loopback_uart_mask <= 1;
             cosim_timer_interval <= 1000;
+            checkpoint_req <= 0;
         end
         else
         begin
+            checkpoint_req <= 0;
             if (nyuzi_io_bus.write_en)
             begin
                 case (nyuzi_io_bus.address)
@@ -311,6 +340,9 @@ module soc_tb(
 
                     // Set timer interval
                     'h20: cosim_timer_interval <= nyuzi_io_bus.write_data;
+
+                    // Request simulator checkpoint (see verilator_main.cpp)
+                    'h24: checkpoint_req <= 1;
                 endcase
             end
 
@@ -353,7 +385,10 @@ module soc_tb(
         .ix_instruction_trap_cause(`CORE0.ix_instruction.trap_cause),
         .dd_instruction_valid(`CORE0.dd_instruction_valid),
         .dd_instruction_pc(`CORE0.dd_instruction.pc),
-        .dd_store_en(`CORE0.dd_store_en),
+        // Scratchpad stores don't go through the store queue, and
+        // synchronized stores to it always succeed.
+        .dd_store_en(`CORE0.dd_store_en
+            || `CORE0.dcache_data_stage.scratchpad_store_en),
         .dd_store_mask(`CORE0.dd_store_mask),
         .dd_store_data(`CORE0.dd_store_data),
         .dd_instruction_memory_access_type(`CORE0.dd_instruction.memory_access_type),
@@ -362,69 +397,236 @@ module soc_tb(
         .dt_thread_idx(`CORE0.dt_thread_idx),
         .dt_request_virt_addr(`CORE0.dt_request_vaddr),
         .sq_rollback_en(`CORE0.sq_rollback_en),
-        .sq_store_sync_success(`CORE0.sq_store_sync_success),
+        .sq_store_sync_success(`CORE0.sq_store_sync_success
+            || `CORE0.dd_scratchpad_access),
         .wb_trap_pc(`CORE0.wb_trap_pc),
         .*);
 
+    //
+    // Waveform trace window. verilator_main.cpp only writes waveform data for
+    // cycles where waveform_en is asserted. Tracing starts once total_cycles
+    // reaches +waveform_start (default 0) and, if +waveform_pc is specified, a
+    // thread on any core issues an instruction at that address. It continues
+    // for +waveform_cycles cycles (default: until the simulation ends).
+    //
+    genvar waveform_core_idx;
+    generate
+        for (waveform_core_idx = 0; waveform_core_idx < `NUM_CORES; waveform_core_idx++)
+        begin : waveform_pc_gen
+            assign waveform_pc_hit[waveform_core_idx] = nyuzi.core_gen[waveform_core_idx].core.ts_instruction_valid
+                && nyuzi.core_gen[waveform_core_idx].core.ts_instruction.pc == waveform_pc;
+        end
+    endgenerate
+
+    assign waveform_start_hit = total_cycles >= waveform_start_cycle
+        && (!waveform_pc_en || waveform_pc_hit != 0);
+    assign waveform_en = !waveform_done && (waveform_triggered || waveform_start_hit);
+
+    always_ff @(posedge clk, posedge reset)
+    begin
+        if (reset)
+        begin
+            waveform_triggered <= 0;
+            waveform_done <= 0;
+            waveform_cycle_count <= 0;
+        end
+        else if (waveform_en)
+        begin
+            waveform_triggered <= 1;
+            waveform_cycle_count <= waveform_cycle_count + 1;
+            if (waveform_length != 0 && waveform_cycle_count == waveform_length - 1)
+                waveform_done <= 1;
+        end
+    end
+
+    //
+    // Sampling profiler. Every +profile_interval cycles, this records the
+    // program counter and scheduling state of every thread on every core.
+    // tools/profile/profile.cpp documents the file format and processes it.
+    // The state encoding must match ThreadState in that file.
+    //
+    typedef enum logic[7:0] {
+        PROF_ISSUE = 0,
+        PROF_READY = 1,
+        PROF_WAIT_ICACHE = 2,
+        PROF_WAIT_DCACHE = 3,
+        PROF_WAIT_RAW = 4,
+        PROF_WAIT_WRITEBACK = 5,
+        PROF_DISABLED = 6
+    } profile_state_t;
+
+    genvar profile_core_idx;
+    genvar profile_thread_idx;
+    generate
+        for (profile_core_idx = 0; profile_core_idx < `NUM_CORES; profile_core_idx++)
+        begin : profile_core_gen
+            for (profile_thread_idx = 0; profile_thread_idx < `THREADS_PER_CORE; profile_thread_idx++)
+            begin : profile_thread_gen
+                localparam THREAD_IDX = profile_core_idx * `THREADS_PER_CORE + profile_thread_idx;
+
+                // If the instruction FIFO is empty, the thread is waiting
+                // for fetch, so report the fetch PC. Otherwise report the
+                // next instruction to issue.
+                always_comb
+                begin
+                    if (nyuzi.core_gen[profile_core_idx].core.thread_select_stage.thread_state[profile_thread_idx] == 0)
+                        profile_pc[THREAD_IDX] = nyuzi.core_gen[profile_core_idx].core.ifetch_tag_stage.next_program_counter[profile_thread_idx];
+                    else
+                        profile_pc[THREAD_IDX] = nyuzi.core_gen[profile_core_idx].core.thread_select_stage.thread_instr[profile_thread_idx].pc;
+
+                    if (!nyuzi.thread_en[THREAD_IDX])
+                        profile_state[THREAD_IDX] = PROF_DISABLED;
+                    else if (nyuzi.core_gen[profile_core_idx].core.thread_select_stage.thread_issue_oh[profile_thread_idx])
+                        profile_state[THREAD_IDX] = PROF_ISSUE;
+                    else
+                    begin
+                        case (nyuzi.core_gen[profile_core_idx].core.thread_select_stage.thread_state[profile_thread_idx])
+                            0: profile_state[THREAD_IDX] = PROF_WAIT_ICACHE;
+                            1: profile_state[THREAD_IDX] = PROF_WAIT_DCACHE;
+                            2: profile_state[THREAD_IDX] = PROF_WAIT_RAW;
+                            3: profile_state[THREAD_IDX] = PROF_WAIT_WRITEBACK;
+                            default: profile_state[THREAD_IDX] = PROF_READY;
+                        endcase
+                    end
+                end
+            end
+        end
+    endgenerate
+
+    task write_profile_byte;
+        input logic[7:0] value;
+    begin
+`ifdef VERILATOR
+        // See comment in final block about fwrite
+        $c("fputc(", value, ", VL_CVT_I_FP(", profile_fd, "));");
+`else
+        $fwrite(profile_fd, "%c", value);
+`endif
+    end
+    endtask
+
+    // Little endian, to match the host tool
+    task write_profile_word;
+        input scalar_t value;
+    begin
+        write_profile_byte(value[7:0]);
+        write_profile_byte(value[15:8]);
+        write_profile_byte(value[23:16]);
+        write_profile_byte(value[31:24]);
+    end
+    endtask
+
+    // Accessors for memory contents as 32-bit words. Each SDRAM location holds
+    // SDRAM_WORDS words, with the lowest address in the most significant bits
+    // (the same order as AXI beats).
+    function scalar_t read_memory_word(input int index);
+        return memory.sdram_data[index / SDRAM_WORDS][(SDRAM_WORDS - 1 - index % SDRAM_WORDS) * 32+:32];
+    endfunction
+
+    task write_memory_word;
+        input int index;
+        input scalar_t value;
+    begin
+        memory.sdram_data[index / SDRAM_WORDS][(SDRAM_WORDS - 1 - index % SDRAM_WORDS) * 32+:32] = value;
+    end
+    endtask
+
     task flush_l2_line;
         input l2_tag_t tag;
         input l2_set_idx_t set;
-        input l2_way_idx_t way;
+        input int bank;
+        input cache_line_data_t data;
     begin
         for (int line_offset = 0; line_offset < CACHE_LINE_WORDS; line_offset++)
         begin
-            memory.sdram_data[(int'(tag) * `L2_SETS + int'(set)) * CACHE_LINE_WORDS + line_offset] =
-                int'(nyuzi.l2_cache.l2_cache_read_stage.sram_l2_data.data[{way, set}]
-                 >> ((CACHE_LINE_WORDS - 1 - line_offset) * 32));
+            write_memory_word(((int'(tag) * `L2_SETS + int'(set)) * `L2_BANKS + bank)
+                * CACHE_LINE_WORDS + line_offset,
+                scalar_t'(data >> ((CACHE_LINE_WORDS - 1 - line_offset) * 32)));
         end
     end
     endtask
 
     // Manually copy lines from the L2 cache back to memory so we can
-    // validate it there.
-    `define L2_TAG_WAY nyuzi.l2_cache.l2_cache_tag_stage.way_tags_gen
+    // validate it there. Lines are interleaved between banks, and each bank
+    // stores the line address with the bank index removed.
+    `define L2_BANK nyuzi.l2_cache.bank_gen[flush_bank_idx].l2_cache_bank
+    `define L2_TAG_WAY `L2_BANK.l2_cache_tag_stage.way_tags_gen
+    `define L2_DATA(way, set) `L2_BANK.l2_cache_read_stage.sram_l2_data.data[{l2_way_idx_t'(way), l2_set_idx_t'(set)}]
 
-    task flush_l2_cache;
-    begin
-        for (int set = 0; set < `L2_SETS; set++)
-        begin
-            // XXX these need to be manually commented out when changing
-            // the number of L2 ways, since (per IEEE 1800-2012) an
-            // instance select must be a constant expression.
-            if (`L2_TAG_WAY[0].line_valid[set])
-                flush_l2_line(`L2_TAG_WAY[0].sram_tags.data[set], l2_set_idx_t'(set), l2_way_idx_t'(0));
+    genvar flush_bank_idx;
+    generate
+        for (flush_bank_idx = 0; flush_bank_idx < `L2_BANKS; flush_bank_idx++)
+        begin : flush_l2_bank_gen
+            task flush_l2_bank;
+            begin
+                for (int set = 0; set < `L2_SETS; set++)
+                begin
+                    // XXX these need to be manually commented out when changing
+                    // the number of L2 ways, since (per IEEE 1800-2012) an
+                    // instance select must be a constant expression.
+                    if (`L2_TAG_WAY[0].line_valid[set])
+                        flush_l2_line(`L2_TAG_WAY[0].sram_tags.data[set], l2_set_idx_t'(set), flush_bank_idx, `L2_DATA(0, set));
 
-            if (`L2_TAG_WAY[1].line_valid[set])
-                flush_l2_line(`L2_TAG_WAY[1].sram_tags.data[set], l2_set_idx_t'(set), l2_way_idx_t'(1));
+                    if (`L2_TAG_WAY[1].line_valid[set])
+                        flush_l2_line(`L2_TAG_WAY[1].sram_tags.data[set], l2_set_idx_t'(set), flush_bank_idx, `L2_DATA(1, set));
 
-            if (`L2_TAG_WAY[2].line_valid[set])
-                flush_l2_line(`L2_TAG_WAY[2].sram_tags.data[set], l2_set_idx_t'(set), l2_way_idx_t'(2));
+                    if (`L2_TAG_WAY[2].line_valid[set])
+                        flush_l2_line(`L2_TAG_WAY[2].sram_tags.data[set], l2_set_idx_t'(set), flush_bank_idx, `L2_DATA(2, set));
 
-            if (`L2_TAG_WAY[3].line_valid[set])
-                flush_l2_line(`L2_TAG_WAY[3].sram_tags.data[set], l2_set_idx_t'(set), l2_way_idx_t'(3));
+                    if (`L2_TAG_WAY[3].line_valid[set])
+                        flush_l2_line(`L2_TAG_WAY[3].sram_tags.data[set], l2_set_idx_t'(set), flush_bank_idx, `L2_DATA(3, set));
 
-            if (`L2_TAG_WAY[4].line_valid[set])
-                flush_l2_line(`L2_TAG_WAY[4].sram_tags.data[set], l2_set_idx_t'(set), l2_way_idx_t'(4));
+                    if (`L2_TAG_WAY[4].line_valid[set])
+                        flush_l2_line(`L2_TAG_WAY[4].sram_tags.data[set], l2_set_idx_t'(set), flush_bank_idx, `L2_DATA(4, set));
 
-            if (`L2_TAG_WAY[5].line_valid[set])
-                flush_l2_line(`L2_TAG_WAY[5].sram_tags.data[set], l2_set_idx_t'(set), l2_way_idx_t'(5));
+                    if (`L2_TAG_WAY[5].line_valid[set])
+                        flush_l2_line(`L2_TAG_WAY[5].sram_tags.data[set], l2_set_idx_t'(set), flush_bank_idx, `L2_DATA(5, set));
 
-            if (`L2_TAG_WAY[6].line_valid[set])
-                flush_l2_line(`L2_TAG_WAY[6].sram_tags.data[set], l2_set_idx_t'(set), l2_way_idx_t'(6));
+                    if (`L2_TAG_WAY[6].line_valid[set])
+                        flush_l2_line(`L2_TAG_WAY[6].sram_tags.data[set], l2_set_idx_t'(set), flush_bank_idx, `L2_DATA(6, set));
 
-            if (`L2_TAG_WAY[7].line_valid[set])
-                flush_l2_line(`L2_TAG_WAY[7].sram_tags.data[set], l2_set_idx_t'(set), l2_way_idx_t'(7));
+                    if (`L2_TAG_WAY[7].line_valid[set])
+                        flush_l2_line(`L2_TAG_WAY[7].sram_tags.data[set], l2_set_idx_t'(set), flush_bank_idx, `L2_DATA(7, set));
+                end
+            end
+            endtask
+
+            // Flush this bank and the ones above it. flush_l2_cache can't
+            // loop over the banks because the instance select must be
+            // constant, so each bank calls the next one.
+            if (flush_bank_idx < `L2_BANKS - 1)
+            begin : flush_chain_gen
+                task flush_l2_banks;
+                begin
+                    flush_l2_bank;
+                    flush_l2_bank_gen[flush_bank_idx + 1].flush_chain_gen.flush_l2_banks;
+                end
+                endtask
+            end
+            else
+            begin : flush_chain_gen
+                task flush_l2_banks;
+                begin
+                    flush_l2_bank;
+                end
+                endtask
+            end
         end
+    endgenerate
+
+    task flush_l2_cache;
+    begin
+        flush_l2_bank_gen[0].flush_chain_gen.flush_l2_banks;
     end
     endtask
 
     initial
     begin
-        $display("cores %0d|threads per core %0d|l1i$ %0dk %0d ways|l1d$ %0dk %0d ways|l2$ %0dk %0d ways|itlb %0d entries|dtlb %0d entries",
+        $display("cores %0d|threads per core %0d|l1i$ %0dk %0d ways|l1d$ %0dk %0d ways|l2$ %0dk %0d ways %0d banks|itlb %0d entries|dtlb %0d entries",
             `NUM_CORES, `THREADS_PER_CORE,
             `L1I_WAYS * `L1I_SETS * CACHE_LINE_BYTES / 1024, `L1I_WAYS,
             `L1D_WAYS * `L1D_SETS * CACHE_LINE_BYTES / 1024, `L1D_WAYS,
-            `L2_WAYS * `L2_SETS * CACHE_LINE_BYTES / 1024, `L2_WAYS,
+            `L2_BANKS * `L2_WAYS * `L2_SETS * CACHE_LINE_BYTES / 1024, `L2_WAYS, `L2_BANKS,
             `ITLB_ENTRIES, `DTLB_ENTRIES);
 
         if ($test$plusargs("statetrace") != 0)
@@ -435,22 +637,75 @@ module soc_tb(
         else
             state_dump_en = 0;
 
+        if ($value$plusargs("profile_interval=%d", profile_interval) == 0)
+            profile_interval = DEFAULT_PROFILE_INTERVAL;
+
         if ($value$plusargs("profile=%s", filename) != 0)
         begin
             profile_en = 1;
-            profile_fd = $fopen(filename, "w");
+            profile_fd = $fopen(filename, "wb");
+            write_profile_byte("N");
+            write_profile_byte("P");
+            write_profile_byte("R");
+            write_profile_byte("F");
+            write_profile_word(1);  // Version
+            write_profile_word(`NUM_CORES);
+            write_profile_word(`THREADS_PER_CORE);
+            write_profile_word(profile_interval);
         end
         else
             profile_en = 0;
 
-        for (int i = 0; i < MEM_SIZE; i++)
+        if ($value$plusargs("waveform_start=%d", waveform_start_cycle) == 0)
+            waveform_start_cycle = 0;
+
+        if ($value$plusargs("waveform_cycles=%d", waveform_length) == 0)
+            waveform_length = 0;
+
+        if ($value$plusargs("waveform_pc=%x", waveform_pc) != 0)
+            waveform_pc_en = 1;
+        else
+            waveform_pc_en = 0;
+
+        for (int i = 0; i < MEM_SIZE / (SDRAM_DATA_WIDTH / 8); i++)
             memory.sdram_data[i] = 0;
 
         if ($value$plusargs("bin=%s", filename) != 0)
-            $readmemh(filename, memory.sdram_data);
+        begin
+            if (SDRAM_WORDS == 1)
+                $readmemh(filename, memory.sdram_data);
+            else
+            begin
+                // The hex file has one 32-bit word per line.
+                $readmemh(filename, bin_words);
+                for (int i = 0; i < MEM_SIZE / 4; i++)
+                    write_memory_word(i, bin_words[i]);
+            end
+        end
+`ifdef VERILATOR
+        else if ($value$plusargs("image=%s", filename) != 0)
+        begin
+            image_words = load_memory_image(filename, MEM_SIZE * 4);
+            if (image_words < 0)
+                $finish;
+
+            for (int i = 0; i < image_words; i++)
+                write_memory_word(i, memory_image_word(i));
+        end
+`ifdef ENABLE_CHECKPOINT
+        else if ($test$plusargs("restore_checkpoint") != 0)
+        begin
+            // verilator_main.cpp restores memory along with the rest of the
+            // model state.
+        end
+`else
+        else if ($test$plusargs("restore_checkpoint") != 0)
+            $fatal(1, "+restore_checkpoint requires a model built with ENABLE_CHECKPOINT");
+`endif
+`endif
         else
         begin
-            $display("No memory image file specified with +bin");
+            $display("No memory image file specified with +bin or +image");
             $finish;
         end
     end
@@ -460,8 +715,21 @@ module soc_tb(
         int mem_dump_start;
         int mem_dump_length;
         int dump_fp;
+        scalar_t dump_word;
 
         $display("ran for %0d cycles", total_cycles);
+
+        // Events are in the order of the assignment to l2_perf_events in
+        // l2_cache_bank.sv.
+        for (int bank = 0; bank < `L2_BANKS; bank++)
+        begin
+            $display("l2 bank %0d|writeback %0d|miss %0d|hit %0d|prefetch useful %0d|prefetch useless %0d|snoop sent %0d|snoop filtered %0d",
+                bank, l2_perf_count[bank][0], l2_perf_count[bank][1],
+                l2_perf_count[bank][2], l2_perf_count[bank][3],
+                l2_perf_count[bank][4], l2_perf_count[bank][5],
+                l2_perf_count[bank][6]);
+        end
+
         if ($value$plusargs("memdumpbase=%x", mem_dump_start) != 0
             && $value$plusargs("memdumplen=%x", mem_dump_length) != 0
             && $value$plusargs("memdumpfile=%s", filename) != 0)
@@ -472,19 +740,20 @@ module soc_tb(
             dump_fp = $fopen(filename, "wb");
             for (int i = 0; i < mem_dump_length; i += 4)
             begin
+                dump_word = read_memory_word((mem_dump_start + i) / 4);
 `ifdef VERILATOR
                 // -verilator doesn't support fwrite with the %c modifier, so
                 // emit code directly in the generated C files to call fputc.
-                $c("fputc(", memory.sdram_data[(mem_dump_start + i) / 4][31:24], ", VL_CVT_I_FP(", dump_fp, "));");
-                $c("fputc(", memory.sdram_data[(mem_dump_start + i) / 4][23:16], ", VL_CVT_I_FP(", dump_fp, "));");
-                $c("fputc(", memory.sdram_data[(mem_dump_start + i) / 4][15:8], ", VL_CVT_I_FP(", dump_fp, "));");
-                $c("fputc(", memory.sdram_data[(mem_dump_start + i) / 4][7:0], ", VL_CVT_I_FP(", dump_fp, "));");
+                $c("fputc(", dump_word[31:24], ", VL_CVT_I_FP(", dump_fp, "));");
+                $c("fputc(", dump_word[23:16], ", VL_CVT_I_FP(", dump_fp, "));");
+                $c("fputc(", dump_word[15:8], ", VL_CVT_I_FP(", dump_fp, "));");
+                $c("fputc(", dump_word[7:0], ", VL_CVT_I_FP(", dump_fp, "));");
 `else
                 $fwrite(dump_fp,"%c%c%c%c",
-                        memory.sdram_data[(mem_dump_start + i) / 4][31:24],
-                        memory.sdram_data[(mem_dump_start + i) / 4][23:16],
-                        memory.sdram_data[(mem_dump_start + i) / 4][15:8],
-                        memory.sdram_data[(mem_dump_start + i) / 4][7:0]);
+                        dump_word[31:24],
+                        dump_word[23:16],
+                        dump_word[15:8],
+                        dump_word[7:0]);
 `endif // !`ifdef VERILATOR
             end
 
@@ -508,9 +777,24 @@ module soc_tb(
         begin
             finish_cycles <= '0;
             total_cycles <= '0;
+            profile_countdown <= 0;
+            for (int bank = 0; bank < `L2_BANKS; bank++)
+            begin
+                for (int event_idx = 0; event_idx < L2_PERF_EVENTS; event_idx++)
+                    l2_perf_count[bank][event_idx] <= 0;
+            end
         end
         else
         begin
+            for (int bank = 0; bank < `L2_BANKS; bank++)
+            begin
+                for (int event_idx = 0; event_idx < L2_PERF_EVENTS; event_idx++)
+                begin
+                    if (nyuzi.l2_perf_events[bank * L2_PERF_EVENTS + event_idx])
+                        l2_perf_count[bank][event_idx] <= l2_perf_count[bank][event_idx] + 1;
+                end
+            end
+
             if (processor_halt)
             begin
                 // Run some number of cycles after halt is triggered to flush pending
@@ -538,9 +822,21 @@ module soc_tb(
                 $fwrite(state_dump_fd, "\n");
             end
 
-            // Randomly sample a program counter for a thread and output to profile file
-            if (profile_en && ($random() & 63) == 0)
-                $fwrite(profile_fd, "%x\n", `CORE0.ifetch_tag_stage.next_program_counter[$random() % `THREADS_PER_CORE]);
+            if (profile_en && !processor_halt)
+            begin
+                if (profile_countdown == 0)
+                begin
+                    for (int i = 0; i < TOTAL_THREADS; i++)
+                    begin
+                        write_profile_word(profile_pc[i]);
+                        write_profile_byte(profile_state[i]);
+                    end
+
+                    profile_countdown <= profile_interval - 1;
+                end
+                else
+                    profile_countdown <= profile_countdown - 1;
+            end
         end
     end
 endmodule
@@ -16,10 +16,16 @@
 
 #include <iostream>
 #include <cstdlib>
+#include <cstring>
 #include "Vsoc_tb.h"
 #include "verilated.h"
 #include "verilated_vpi.h"
-#if VM_TRACE
+#if ENABLE_CHECKPOINT
+#include "verilated_save.h"
+#endif
+#if VM_TRACE_FST
+#include <verilated_fst_c.h>
+#elif VM_TRACE
 #include <verilated_vcd_c.h>
 #endif
 
@@ -32,6 +38,68 @@
 namespace
 {
 vluint64_t currentTime = 0;
+
+#if VM_TRACE_FST
+typedef VerilatedFstC TraceFile;
+const char * const DEFAULT_TRACE_FILE = "trace.fst";
+#elif VM_TRACE
+typedef VerilatedVcdC TraceFile;
+const char * const DEFAULT_TRACE_FILE = "trace.vcd";
+#endif
+
+#if VM_TRACE
+TraceFile *traceFile = nullptr;
+
+void closeTrace()
+{
+    if (traceFile)
+    {
+        traceFile->close();
+        delete traceFile;
+        traceFile = nullptr;
+    }
+}
+#endif
+
+const char *plusArgValue(const char *name)
+{
+    const char *match = Verilated::commandArgsPlusMatch(name);
+    if (match[0] == '\0')
+        return nullptr;
+
+    return match + strlen(name) + 1;
+}
+
+#if ENABLE_CHECKPOINT
+//
+// Checkpoints contain the entire state of the Verilated model, including
+// simulated memory, so a run can skip a long setup phase by restoring a
+// checkpoint taken after it. Host side resources (open files, sockets) are
+// not part of the checkpoint, and the initial blocks that open them don't
+// run again after a restore.
+//
+void saveCheckpoint(const char *filename, Vsoc_tb *testbench)
+{
+    VL_PRINTF("Saving checkpoint to %s at cycle %llu\n", filename,
+              static_cast<unsigned long long>(currentTime / 2));
+    VerilatedSave os;
+    os.open(filename);
+    os << currentTime;
+    os << *testbench;
+    os.close();
+}
+
+void restoreCheckpoint(const char *filename, Vsoc_tb *testbench)
+{
+    VerilatedRestore is;
+    is.open(filename);
+    is >> currentTime;
+    is >> *testbench;
+    is.close();
+    VL_PRINTF("Restored checkpoint from %s at cycle %llu\n", filename,
+              static_cast<unsigned long long>(currentTime / 2));
+}
+#endif
 }
 
 // Called whenever the $time variable is accessed.
@@ -40,6 +108,19 @@ double sc_time_stamp()
     return currentTime;
 }
 
+// Verilator calls this when an assertion fails (this file is compiled with
+// VL_USER_STOP, which replaces the default implementation). The default
+// aborts immediately, which leaves compressed FST files unreadable, so close
+// the trace first. The waveform then ends on the cycle that failed.
+void vl_stop(const char *filename, int linenum, const char *hier)
+{
+#if VM_TRACE
+    closeTrace();
+#endif
+    Verilated::gotFinish(true);
+    vl_fatal(filename, linenum, hier, "Verilog $stop");
+}
+
 int main(int argc, char **argv, char **env)
 {
     Verilated::commandArgs(argc, argv);
@@ -58,17 +139,46 @@ int main(int argc, char **argv, char **env)
     // This is a bit of a hack, set the 'last' state of reset to zero and reset to one.
     // This will cause a positive edge event on the next eval() that will trigger
     // all reset blocks. Reset will be deasserted in the main loop below.
-    testbench->__Vclklast__TOP__reset = 0;
-    testbench->reset = 1;
-    testbench->clk = 0;
-    testbench->eval();
+#if ENABLE_CHECKPOINT
+    const char *saveCheckpointFile = plusArgValue("save_checkpoint=");
+    const char *saveCheckpointCycleStr = plusArgValue("save_checkpoint_cycle=");
+    vluint64_t saveCheckpointCycle = saveCheckpointCycleStr
+        ? strtoull(saveCheckpointCycleStr, nullptr, 10) : 0;
+    const char *restoreCheckpointFile = plusArgValue("restore_checkpoint=");
+    if (restoreCheckpointFile)
+        restoreCheckpoint(restoreCheckpointFile, testbench);
+    else
+#endif
+    {
+        testbench->__Vclklast__TOP__reset = 0;
+        testbench->reset = 1;
+        testbench->clk = 0;
+        testbench->eval();
+    }
 
-#if VM_TRACE // If verilator was invoked with --trace
+#if VM_TRACE // If verilator was invoked with --trace or --trace-fst
     Verilated::traceEverOn(true);
-    VL_PRINTF("Writing waveform to trace.vcd\n");
-    VerilatedVcdC* tfp = new VerilatedVcdC;
-    testbench->trace(tfp, 99);
-    tfp->open("trace.vcd");
+    const char *traceFilename = plusArgValue("waveform_file=");
+    if (traceFilename == nullptr)
+        traceFilename = DEFAULT_TRACE_FILE;
+
+    VL_PRINTF("Writing waveform to %s\n", traceFilename);
+    traceFile = new TraceFile;
+    testbench->trace(traceFile, 99);
+
+    // +waveform_scope=<hierarchy> restricts the trace to signals under one
+    // module instance, e.g. +waveform_scope=soc_tb.nyuzi.l2_cache
+    const char *traceScope = plusArgValue("waveform_scope=");
+    if (traceScope)
+    {
+#if defined(VERILATOR_VERSION_INTEGER) && VERILATOR_VERSION_INTEGER >= 4210000
+        traceFile->dumpvars(0, std::string("TOP.") + traceScope);
+#else
+        VL_PRINTF("+waveform_scope requires Verilator 4.210 or later, ignoring\n");
+#endif
+    }
+
+    traceFile->open(traceFilename);
 #endif
 
     while (!Verilated::gotFinish())
@@ -82,16 +192,30 @@ int main(int argc, char **argv, char **env)
         testbench->clk = !testbench->clk;
         testbench->eval();
 #if VM_TRACE
-        tfp->dump(currentTime); // Create waveform trace for this timestamp
+        // soc_tb decides which cycles to record, based on the trace
+        // window plusargs (see hardware/README.md)
+        if (testbench->waveform_en)
+            traceFile->dump(currentTime);
 #endif
 
         currentTime++;
+
+#if ENABLE_CHECKPOINT
+        // Save on the rising edge, either at a fixed cycle or when the
+        // program requests it by writing to the checkpoint device register.
+        if (saveCheckpointFile && testbench->clk
+                && ((saveCheckpointCycle != 0 && currentTime / 2 == saveCheckpointCycle)
+                || testbench->checkpoint_req))
+        {
+            saveCheckpoint(saveCheckpointFile, testbench);
+        }
+#endif
     }
 
     testbench->final();
 
 #if VM_TRACE
-    tfp->close();
+    closeTrace();
 #endif
 
     delete testbench;
@@ -16,6 +16,8 @@
 
 #pragma once
 
+#include <nyuzi.h>
+
 //
 // Each thread that calls wait() will wait until all threads have called it.
 // At that point, they are all released.
@@ -39,7 +41,10 @@ public:
         else
         {
             while (fWaitCount)
-                ;	// Wait busily
+            {
+                if (load_and_watch(&fWaitCount))
+                    wait_for_write();
+            }
         }
     }
 
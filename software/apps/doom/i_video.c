@@ -26,6 +26,7 @@ rcsid[] = "$Id: i_x.c,v 1.6 1997/02/03 22:45:10 b1 Exp $";
 
 #include <stdint.h>
 #include <time.h>
+#include <dma.h>
 #include <keyboard.h>
 #include <vga.h>
 #include "doomstat.h"
@@ -36,6 +37,9 @@ rcsid[] = "$Id: i_x.c,v 1.6 1997/02/03 22:45:10 b1 Exp $";
 
 #include "doomdef.h"
 
+// Each pixel is doubled horizontally and vertically
+#define FB_ROW_BYTES (SCREENWIDTH * 2 * 4)
+
 static unsigned int gPalette[256];
 static clock_t lastFrameTime = 0;
 static int frameCount = 0;
@@ -165,7 +169,10 @@ void I_FinishUpdate (void)
     veci16_t pixelVals;
     int mask;
 
-    // Copy to framebuffer and expand palette
+    // The previous frame may still be copying odd rows
+    dma_wait();
+
+    // Copy even rows to framebuffer and expand palette
     for (y = 0; y < SCREENHEIGHT; y++)
     {
         for (x = 0; x < SCREENWIDTH; x += 8)
@@ -178,15 +185,17 @@ void I_FinishUpdate (void)
             }
 
             dest[0] = pixelVals;
-            dest[40] = pixelVals;
             asm("dflush %0" : : "s" (dest));
-            asm("dflush %0" : : "s" (dest + 40));
             dest++;
         }
 
         dest += 40;
     }
 
+    // Double each row into the odd rows below it.
+    dma_copy_2d((char*) fb_base + FB_ROW_BYTES, FB_ROW_BYTES * 2, fb_base,
+                FB_ROW_BYTES * 2, FB_ROW_BYTES, SCREENHEIGHT, DMA_FLUSH);
+
     // Print some statistics
     if (++frameCount == 20)
     {
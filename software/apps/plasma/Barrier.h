@@ -18,6 +18,8 @@
 #ifndef __BARRIER_H
 #define __BARRIER_H
 
+#include <nyuzi.h>
+
 //
 // Each thread that calls wait() will wait until all threads have called it.
 // At that point, they are all released.
@@ -41,7 +43,10 @@ public:
         else
         {
             while (fWaitCount)
-                ;	// Wait busily
+            {
+                if (load_and_watch(&fWaitCount))
+                    wait_for_write();
+            }
         }
     }
 
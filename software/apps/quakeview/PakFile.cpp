@@ -338,6 +338,7 @@ void PakFile::loadTextureAtlas(const bspheader_t *bspHeader, const uint8_t *data
 
     fTextureAtlasTexture = new Texture();
     fTextureAtlasTexture->enableBilinearFiltering(true);
+    fTextureAtlasTexture->enableHardwareSampling(true);
     for (int mipLevel = 0; mipLevel < kNumMipLevels; mipLevel++)
         fTextureAtlasTexture->setMipSurface(mipLevel, atlasSurfaces[mipLevel]);
 
@@ -472,6 +473,7 @@ void PakFile::loadLightmaps(const bspheader_t *bspHeader, const uint8_t *data)
 
     fLightmapAtlasTexture = new Texture();
     fLightmapAtlasTexture->enableBilinearFiltering(true);
+    fLightmapAtlasTexture->enableHardwareSampling(true);
     fLightmapAtlasTexture->setMipSurface(0, lightmapSurface);
 }
 
@@ -198,6 +198,7 @@ int main()
     renderTarget->setDepthBuffer(zBuffer);
     context->bindTarget(renderTarget);
     context->enableDepthBuffer(true);
+    context->enableIndexedVertexShading(true);
     context->bindShader(new TextureShader());
 
     // Read resources
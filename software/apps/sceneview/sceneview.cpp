@@ -169,6 +169,7 @@ int main()
 #else
         textures[textureIndex] = new Texture();
         textures[textureIndex]->enableBilinearFiltering(true);
+        textures[textureIndex]->enableHardwareSampling(true);
         int offset = texHeader[textureIndex].offset;
         for (unsigned int mipLevel = 0; mipLevel < texHeader[textureIndex].mipLevels; mipLevel++)
         {
@@ -203,6 +204,7 @@ int main()
     renderTarget->setDepthBuffer(depthBuffer);
     context->bindTarget(renderTarget);
     context->enableDepthBuffer(true);
+    context->enableIndexedVertexShading(true);
 #if SHOW_DEPTH
     context->bindShader(new DepthShader());
 #else
@@ -17,11 +17,15 @@
 
 float total(const vecf16 &v1)
 {
+#ifdef __NYUZI__
+    return reduce_add_f((vecf16_t) v1);
+#else
     int i;
     float sum = 0;
     for (i = 0; i < 16; i++)
         sum += v1[i];
     return sum;
+#endif
 }
 
 float dot(const vecf16 &v1, const vecf16 &v2)
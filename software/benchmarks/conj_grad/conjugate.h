@@ -19,6 +19,7 @@
 #ifdef __NYUZI__
 #include <stdio.h>
 #include <stdlib.h>
+#include <nyuzi_intrinsics.h>
 #else /* !__NYUZI__ */
 #include <cstdio>
 #include <cstdlib>
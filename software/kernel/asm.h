@@ -39,6 +39,9 @@
 #define CR_SYSCALL_INDEX 19
 #define CR_SUSPEND_THREAD 20
 #define CR_RESUME_THREAD 21
+#define CR_PERF_INDEX 28
+#define CR_PERF_DATA 29
+#define CR_WAIT_FOR_WRITE 31
 
 // Flag register bits
 #define FLAG_INTERRUPT_EN (1 << 0)
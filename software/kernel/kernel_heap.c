@@ -46,6 +46,7 @@ void *kmalloc(unsigned int size)
     unsigned int grow_size;
     void *result = 0;
     unsigned int va;
+    unsigned int pa;
     int old_flags;
 
     old_flags = acquire_spinlock_int(&heap_lock);
@@ -79,18 +80,31 @@ void *kmalloc(unsigned int size)
         if (grow_size < 0x10000)
             grow_size = 0x10000;
 
-        // Wire in pages
-        for (va = wilderness_ptr; va < wilderness_ptr + grow_size; va += PAGE_SIZE)
+        grow_size = (grow_size + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+
+        // Prefer physically contiguous memory, which can be accessed
+        // through the physical memory alias. That is mapped with superpages,
+        // so heap accesses don't need their own TLB entries.
+        pa = allocate_contiguous_memory(grow_size);
+        if (pa != 0xffffffff)
+            va = PA_TO_VA(pa);
+        else
         {
-            vm_map_page(0, va, page_to_pa(vm_allocate_page())
-                        | PAGE_PRESENT | PAGE_WRITABLE | PAGE_SUPERVISOR
-                        | PAGE_GLOBAL);
+            // Wire in pages
+            for (va = wilderness_ptr; va < wilderness_ptr + grow_size; va += PAGE_SIZE)
+            {
+                vm_map_page(0, va, page_to_pa(vm_allocate_page())
+                            | PAGE_PRESENT | PAGE_WRITABLE | PAGE_SUPERVISOR
+                            | PAGE_GLOBAL);
+            }
+
+            va = wilderness_ptr;
+            wilderness_ptr += grow_size;
         }
 
-        result = (void*) wilderness_ptr;
-        new_range = (struct free_range*) (wilderness_ptr + size);
+        result = (void*) va;
+        new_range = (struct free_range*) (va + size);
         new_range->size = grow_size - size;
-        wilderness_ptr += grow_size;
         insert_free_range(new_range);
     }
 
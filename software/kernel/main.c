@@ -17,6 +17,7 @@
 #include "asm.h"
 #include "kernel_heap.h"
 #include "libc.h"
+#include "perf_counters.h"
 #include "rwlock.h"
 #include "registers.h"
 #include "slab.h"
@@ -47,6 +48,7 @@ void __attribute__((noreturn)) kernel_main(unsigned int _memory_size)
     bootstrap_vm_cache();
     bool_init_kernel_process();
     boot_init_thread();
+    boot_init_perf_counters();
 
     // Start other threads
     __builtin_nyuzi_write_control_reg(CR_RESUME_THREAD, 0xffffffff);
@@ -72,6 +74,7 @@ void __attribute__((noreturn)) thread_n_main(void)
 {
     boot_init_thread();
     unmask_interrupt(1);    // Enable timer interrupt
+    boot_init_perf_counters();
 
     // Idle task
     for (;;)
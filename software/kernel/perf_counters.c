@@ -0,0 +1,186 @@
+//
+// Copyright 2018 Jeff Bush
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "asm.h"
+#include "errno.h"
+#include "libc.h"
+#include "perf_counters.h"
+#include "spinlock.h"
+#include "trap.h"
+
+//
+// Performance counters are shared by all threads on a core. The kernel
+// configures them to count events from every thread, so a profile covers
+// everything running on the core. Sampling counters raise the overflow
+// interrupt on all threads; whichever thread takes it first records its
+// interrupted PC and reloads the counter.
+//
+
+#define INT_PERF_COUNTER 15
+#define MAX_PERF_SAMPLES 4096
+#define COPY_CHUNK 32
+
+#define PERF_FIELD_CONTROL 0
+#define PERF_FIELD_COUNT_L 1
+#define PERF_FIELD_COUNT_H 2
+#define PERF_CONTROL_ALL_THREADS (0xff << 8)
+#define PERF_CONTROL_INT_EN 0x40000000
+#define PERF_CONTROL_OVERFLOW 0x80000000
+
+extern int user_copy(void *dest, const void *src, int count);
+
+static unsigned int sample_interval[NUM_PERF_COUNTERS];
+static unsigned int samples[MAX_PERF_SAMPLES];
+static int sample_count;
+static spinlock_t perf_lock;
+
+// CR_PERF_INDEX is per thread, but the interrupt handler may change it, so
+// interrupts must be disabled around these.
+static unsigned int read_perf_field(int counter, int field)
+{
+    __builtin_nyuzi_write_control_reg(CR_PERF_INDEX, (field << 8) | counter);
+    return __builtin_nyuzi_read_control_reg(CR_PERF_DATA);
+}
+
+static void write_perf_field(int counter, int field, unsigned int value)
+{
+    __builtin_nyuzi_write_control_reg(CR_PERF_INDEX, (field << 8) | counter);
+    __builtin_nyuzi_write_control_reg(CR_PERF_DATA, value);
+}
+
+static void reload_counter(int counter)
+{
+    write_perf_field(counter, PERF_FIELD_COUNT_H, 0xffffffff);
+    write_perf_field(counter, PERF_FIELD_COUNT_L, -sample_interval[counter]);
+}
+
+static void perf_counter_interrupt(void)
+{
+    unsigned int old_index = __builtin_nyuzi_read_control_reg(CR_PERF_INDEX);
+    unsigned int pc = __builtin_nyuzi_read_control_reg(CR_TRAP_PC);
+
+    // Holding the lock while checking ensures only one thread handles each
+    // overflow.
+    acquire_spinlock(&perf_lock);
+    for (int counter = 0; counter < NUM_PERF_COUNTERS; counter++)
+    {
+        unsigned int control = read_perf_field(counter, PERF_FIELD_CONTROL);
+        if ((control & (PERF_CONTROL_OVERFLOW | PERF_CONTROL_INT_EN))
+                != (PERF_CONTROL_OVERFLOW | PERF_CONTROL_INT_EN))
+            continue;
+
+        write_perf_field(counter, PERF_FIELD_CONTROL,
+                         control & ~PERF_CONTROL_OVERFLOW);
+        reload_counter(counter);
+        if (sample_count < MAX_PERF_SAMPLES)
+            samples[sample_count++] = pc;
+    }
+
+    release_spinlock(&perf_lock);
+    __builtin_nyuzi_write_control_reg(CR_PERF_INDEX, old_index);
+}
+
+void boot_init_perf_counters(void)
+{
+    register_interrupt_handler(INT_PERF_COUNTER, perf_counter_interrupt);
+}
+
+int set_perf_counter_event(int counter, int event)
+{
+    if (counter < 0 || counter >= NUM_PERF_COUNTERS)
+        return -EINVAL;
+
+    int old_flags = acquire_spinlock_int(&perf_lock);
+    write_perf_field(counter, PERF_FIELD_CONTROL, event
+                     | PERF_CONTROL_ALL_THREADS);
+    release_spinlock_int(&perf_lock, old_flags);
+
+    return 0;
+}
+
+unsigned int read_perf_counter(int counter)
+{
+    if (counter < 0 || counter >= NUM_PERF_COUNTERS)
+        return 0;
+
+    int old_flags = disable_interrupts();
+    unsigned int value = read_perf_field(counter, PERF_FIELD_COUNT_L);
+    restore_interrupts(old_flags);
+
+    return value;
+}
+
+int start_perf_sampling(int counter, int event, unsigned int interval)
+{
+    if (counter < 0 || counter >= NUM_PERF_COUNTERS || interval == 0)
+        return -EINVAL;
+
+    int old_flags = acquire_spinlock_int(&perf_lock);
+    sample_interval[counter] = interval;
+    reload_counter(counter);
+    write_perf_field(counter, PERF_FIELD_CONTROL, event
+                     | PERF_CONTROL_ALL_THREADS | PERF_CONTROL_INT_EN);
+    release_spinlock_int(&perf_lock, old_flags);
+
+    return 0;
+}
+
+int stop_perf_sampling(int counter)
+{
+    if (counter < 0 || counter >= NUM_PERF_COUNTERS)
+        return -EINVAL;
+
+    int old_flags = acquire_spinlock_int(&perf_lock);
+    write_perf_field(counter, PERF_FIELD_CONTROL, 0);
+    release_spinlock_int(&perf_lock, old_flags);
+
+    return 0;
+}
+
+//
+// Copy samples to user space in chunks, since user_copy may fault and
+// can't be called with the lock held. Samples are removed from the end of
+// the buffer, because order doesn't matter for a profile.
+//
+int read_perf_samples(unsigned int *user_buffer, int max_samples)
+{
+    unsigned int tmp[COPY_CHUNK];
+    int total = 0;
+
+    while (total < max_samples)
+    {
+        int old_flags = acquire_spinlock_int(&perf_lock);
+        int count = max_samples - total;
+        if (count > COPY_CHUNK)
+            count = COPY_CHUNK;
+
+        if (count > sample_count)
+            count = sample_count;
+
+        sample_count -= count;
+        memcpy(tmp, samples + sample_count, count * sizeof(unsigned int));
+        release_spinlock_int(&perf_lock, old_flags);
+        if (count == 0)
+            break;
+
+        if (user_copy(user_buffer + total, tmp, count * sizeof(unsigned int)) < 0)
+            return -EFAULT;
+
+        total += count;
+    }
+
+    return total;
+}
@@ -0,0 +1,28 @@
+//
+// Copyright 2018 Jeff Bush
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#pragma once
+
+#define NUM_PERF_COUNTERS 8
+
+// Called on each hardware thread at boot to enable the overflow interrupt.
+void boot_init_perf_counters(void);
+
+int set_perf_counter_event(int counter, int event);
+unsigned int read_perf_counter(int counter);
+int start_perf_sampling(int counter, int event, unsigned int interval);
+int stop_perf_sampling(int counter);
+int read_perf_samples(unsigned int *user_buffer, int max_samples);
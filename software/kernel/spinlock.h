@@ -16,18 +16,34 @@
 
 #pragma once
 
+#include "asm.h"
 #include "trap.h"
 
 typedef volatile int spinlock_t;
 
+// Read the lock with a synchronized load, which makes this thread watch its
+// cache line. Writing CR_WAIT_FOR_WRITE then suspends the thread until the
+// line is written (or it takes an interrupt).
+static inline int load_and_watch(spinlock_t *sp)
+{
+    int value;
+    asm volatile("load_sync %0, (%1)" : "=s" (value) : "s" (sp) : "memory");
+    return value;
+}
+
 static inline void acquire_spinlock(spinlock_t *sp)
 {
     do
     {
         // Wait while local copy of sp is locked, to avoid creating traffic on
-        // the L2 interconnect.
+        // the L2 interconnect. Suspend rather than spinning until the lock
+        // is released. Checking the value from the synchronized load ensures
+        // a release before the wait isn't missed.
         while (*sp)
-            ;
+        {
+            if (load_and_watch(sp))
+                __builtin_nyuzi_write_control_reg(CR_WAIT_FOR_WRITE, 0);
+        }
 
         // Attempt to grab lock
     }
@@ -17,12 +17,11 @@
 #include "errno.h"
 #include "thread.h"
 #include "libc.h"
+#include "perf_counters.h"
 #include "registers.h"
 #include "syscalls.h"
 #include "vga.h"
 
-#define NUM_PERF_COUNTERS 4
-
 extern int user_copy(void *dest, const void *src, int count);
 extern int user_strlcpy(char *dest, const char *src, int count);
 
@@ -108,19 +107,26 @@ int handle_syscall(int index, int arg0, int arg1, int arg2, int arg3, int arg4,
             return area->low_address;
         }
 
-        // void set_perf_counter_event(int counter, enum performance_event event)
-        case SYS_set_perf_counter:
-            if (arg0 >= 0 && arg0 < NUM_PERF_COUNTERS)
-                REGISTERS[REG_PERF0_SEL + arg0] = arg1;
-
-            return 0;
+        // int set_perf_counter_event(int counter, enum performance_event event)
+        case SYS_set_perf_counter_event:
+            return set_perf_counter_event(arg0, arg1);
 
         // unsigned int read_perf_counter(int counter)
         case SYS_read_perf_counter:
-            if (arg0 >= 0 && arg0 < NUM_PERF_COUNTERS)
-                return REGISTERS[REG_PERF0_VAL + arg0];
-            else
-                return 0;
+            return read_perf_counter(arg0);
+
+        // int start_perf_sampling(int counter, enum performance_event event,
+        //                         unsigned int interval)
+        case SYS_start_perf_sampling:
+            return start_perf_sampling(arg0, arg1, (unsigned int) arg2);
+
+        // int stop_perf_sampling(int counter)
+        case SYS_stop_perf_sampling:
+            return stop_perf_sampling(arg0);
+
+        // int read_perf_samples(unsigned int *samples, int max_samples)
+        case SYS_read_perf_samples:
+            return read_perf_samples((unsigned int*) arg0, arg1);
 
         case SYS_get_cycle_count:
             return __builtin_nyuzi_read_control_reg(6);
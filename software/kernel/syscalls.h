@@ -22,7 +22,10 @@
 #define SYS_thread_exit 4
 #define SYS_init_vga 5
 #define SYS_create_area 6
-#define SYS_set_perf_counter 7
+#define SYS_set_perf_counter_event 7
 #define SYS_read_perf_counter 8
 #define SYS_get_cycle_count 9
 #define SYS_write_console 10
+#define SYS_start_perf_sampling 11
+#define SYS_stop_perf_sampling 12
+#define SYS_read_perf_samples 13
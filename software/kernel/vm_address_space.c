@@ -170,11 +170,25 @@ struct vm_area *map_contiguous_memory(struct vm_address_space *space, unsigned i
     if (space == &kernel_address_space)
         page_flags |= PAGE_SUPERVISOR | PAGE_GLOBAL;
 
-    // Map the pages
-    for (offset = 0; offset < size; offset += PAGE_SIZE)
+    // Map the pages. Use superpages where both addresses are aligned and a
+    // full superpage remains, which reduces TLB misses for large buffers.
+    offset = 0;
+    while (offset < size)
     {
-        vm_map_page(space->translation_map, area->low_address + offset,
-                    (phys_addr + offset) | page_flags);
+        if (((area->low_address + offset) & (SUPERPAGE_SIZE - 1)) == 0
+                && ((phys_addr + offset) & (SUPERPAGE_SIZE - 1)) == 0
+                && size - offset >= SUPERPAGE_SIZE
+                && vm_map_superpage(space->translation_map, area->low_address + offset,
+                                    (phys_addr + offset) | page_flags))
+        {
+            offset += SUPERPAGE_SIZE;
+        }
+        else
+        {
+            vm_map_page(space->translation_map, area->low_address + offset,
+                        (phys_addr + offset) | page_flags);
+            offset += PAGE_SIZE;
+        }
     }
 
 error1:
@@ -66,6 +66,17 @@ void boot_vm_map_pages(struct boot_page_setup *bps, unsigned int va,
 
     while (length > 0)
     {
+        // If this covers an entire page directory entry, map it as a
+        // superpage so it only needs one TLB entry.
+        if (bps->pgdir[pgdindex] == 0 && pgtindex == 0 && length >= SUPERPAGE_SIZE
+                && (pa & (SUPERPAGE_SIZE - 1)) == 0)
+        {
+            bps->pgdir[pgdindex++] = pa | flags | PAGE_SUPERPAGE;
+            length -= SUPERPAGE_SIZE;
+            pa += SUPERPAGE_SIZE;
+            continue;
+        }
+
         // Allocate page table if necessary
         if (bps->pgdir[pgdindex] == 0)
             bps->pgdir[pgdindex] = boot_vm_allocate_pages(bps, 1) | PAGE_PRESENT;
@@ -173,11 +184,11 @@ void destroy_translation_map(struct vm_translation_map *map)
     if (map->asid >= 0)
         bitmap_free(asid_alloc, map->asid);
 
-    // Free user space page tables
+    // Free user space page tables. Superpage entries don't have one.
     pgdir = (unsigned int*) PA_TO_VA(map->page_dir);
     for (i = 0; i < 768; i++)
     {
-        if (pgdir[i] & PAGE_PRESENT)
+        if ((pgdir[i] & (PAGE_PRESENT | PAGE_SUPERPAGE)) == PAGE_PRESENT)
             dec_page_ref(pa_to_page(PAGE_ALIGN(pgdir[i])));
     }
 
@@ -215,6 +226,8 @@ void vm_map_page(struct vm_translation_map *map, unsigned int va, unsigned int p
             }
         }
 
+        assert((pgdir[pgdindex] & PAGE_SUPERPAGE) == 0);
+
         // Now add entry to the page table
         pgtbl = (unsigned int*) PAGE_ALIGN(pgdir[pgdindex]);
         ((unsigned int*)PA_TO_VA(pgtbl))[pgtindex] = pa;
@@ -232,6 +245,7 @@ void vm_map_page(struct vm_translation_map *map, unsigned int va, unsigned int p
         if ((pgdir[pgdindex] & PAGE_PRESENT) == 0)
             pgdir[pgdindex] = page_to_pa(vm_allocate_page()) | PAGE_PRESENT;
 
+        assert((pgdir[pgdindex] & PAGE_SUPERPAGE) == 0);
         pgtbl = (unsigned int*) PAGE_ALIGN(pgdir[pgdindex]);
         ((unsigned int*)PA_TO_VA(pgtbl))[pgtindex] = pa;
         __asm__("tlbinval %0" : : "s" (va));
@@ -242,50 +256,98 @@ void vm_map_page(struct vm_translation_map *map, unsigned int va, unsigned int p
     }
 }
 
-unsigned int query_translation_map(struct vm_translation_map *map, unsigned int va)
+int vm_map_superpage(struct vm_translation_map *map, unsigned int va, unsigned int pa)
 {
-    int vpindex = va / PAGE_SIZE;
-    int pgdindex = vpindex / 1024;
-    int pgtindex = vpindex % 1024;
+    int pgdindex = va / SUPERPAGE_SIZE;
     unsigned int *pgdir;
-    unsigned int *pgtbl;
+    struct list_node *other_map;
     int old_flags;
-    unsigned int ptentry;
+    int mapped = 0;
+
+    assert((va & (SUPERPAGE_SIZE - 1)) == 0);
+    assert((pa & (SUPERPAGE_SIZE - 1) & ~(PAGE_SIZE - 1)) == 0);
 
     if (va >= KERNEL_BASE)
     {
-        // Check kernel space
+        // Map into kernel space. As with page tables, the entry is
+        // shared by all page directories.
         old_flags = acquire_spinlock_int(&kernel_space_lock);
-
-        // The page tables for kernel space are shared by all page directories.
-        // Check the first page directory to see if this is present.
         pgdir = (unsigned int*) PA_TO_VA(kernel_map.page_dir);
         if ((pgdir[pgdindex] & PAGE_PRESENT) == 0)
-            ptentry = 0;
-        else
         {
-            pgtbl = (unsigned int*) PAGE_ALIGN(pgdir[pgdindex]);
-            ptentry = ((unsigned int*)PA_TO_VA(pgtbl))[pgtindex];
+            pgdir[pgdindex] = pa | PAGE_SUPERPAGE;
+            list_for_each(&map_list, other_map, struct list_node)
+            {
+                pgdir = (unsigned int*) PA_TO_VA(((struct vm_translation_map*)other_map)->page_dir);
+                pgdir[pgdindex] = pa | PAGE_SUPERPAGE;
+            }
+
+            __asm__("tlbinval %0" : : "s" (va));
+            mapped = 1;
         }
 
         release_spinlock_int(&kernel_space_lock, old_flags);
     }
     else
     {
-        // Check this user space
+        // Map only into this address space
         old_flags = acquire_spinlock_int(&map->lock);
         pgdir = (unsigned int*) PA_TO_VA(map->page_dir);
         if ((pgdir[pgdindex] & PAGE_PRESENT) == 0)
-            ptentry = 0;
-        else
         {
-            pgtbl = (unsigned int*) PAGE_ALIGN(pgdir[pgdindex]);
-            ptentry = ((unsigned int*)PA_TO_VA(pgtbl))[pgtindex];
+            pgdir[pgdindex] = pa | PAGE_SUPERPAGE;
+            __asm__("tlbinval %0" : : "s" (va));
+            mapped = 1;
         }
 
         release_spinlock_int(&map->lock, old_flags);
     }
 
+    // XXX need to invalidate on other cores
+
+    return mapped;
+}
+
+// Returns the page table entry for va. For a superpage, this constructs
+// the entry that a 4k page at the same address would have.
+static unsigned int lookup_page_entry(const unsigned int *pgdir, unsigned int va)
+{
+    unsigned int pgdentry = pgdir[va / SUPERPAGE_SIZE];
+    const unsigned int *pgtbl;
+
+    if ((pgdentry & PAGE_PRESENT) == 0)
+        return 0;
+
+    if (pgdentry & PAGE_SUPERPAGE)
+        return (pgdentry & ~PAGE_SUPERPAGE) + PAGE_ALIGN(va & (SUPERPAGE_SIZE - 1));
+
+    pgtbl = (const unsigned int*) PA_TO_VA(PAGE_ALIGN(pgdentry));
+    return pgtbl[(va / PAGE_SIZE) % 1024];
+}
+
+unsigned int query_translation_map(struct vm_translation_map *map, unsigned int va)
+{
+    int old_flags;
+    unsigned int ptentry;
+
+    if (va >= KERNEL_BASE)
+    {
+        // Check kernel space
+        old_flags = acquire_spinlock_int(&kernel_space_lock);
+
+        // The page tables for kernel space are shared by all page directories.
+        // Check the first page directory to see if this is present.
+        ptentry = lookup_page_entry((unsigned int*) PA_TO_VA(kernel_map.page_dir), va);
+        release_spinlock_int(&kernel_space_lock, old_flags);
+    }
+    else
+    {
+        // Check this user space
+        old_flags = acquire_spinlock_int(&map->lock);
+        ptentry = lookup_page_entry((unsigned int*) PA_TO_VA(map->page_dir), va);
+        release_spinlock_int(&map->lock, old_flags);
+    }
+
     return ptentry;
 }
 
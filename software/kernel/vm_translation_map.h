@@ -32,6 +32,11 @@
 #define PAGE_SUPERVISOR 8
 #define PAGE_GLOBAL 16
 
+// A page directory entry with this bit set maps a whole 4 MB superpage
+// rather than pointing to a page table.
+#define PAGE_SUPERPAGE 32
+#define SUPERPAGE_SIZE 0x400000
+
 struct vm_translation_map
 {
     struct list_node list_entry;
@@ -44,6 +49,11 @@ struct vm_translation_map *vm_translation_map_init(void);
 struct vm_translation_map *create_translation_map(void);
 void destroy_translation_map(struct vm_translation_map*);
 void vm_map_page(struct vm_translation_map *map, unsigned int va, unsigned int pa);
+
+// Map a 4 MB aligned region with a single page directory entry. Returns 0
+// without mapping anything if a page table already covers this region, in
+// which case the caller must map it with vm_map_page.
+int vm_map_superpage(struct vm_translation_map *map, unsigned int va, unsigned int pa);
 unsigned int query_translation_map(struct vm_translation_map *map, unsigned int va);
 
 // Switch to a new address space
@@ -33,6 +33,7 @@ double sqrt(double value);
 float sqrtf(float value);
 float floorf(float value);
 float ceilf(float value);
+float fmaf(float a, float b, float c);
 
 #ifdef __cplusplus
 }
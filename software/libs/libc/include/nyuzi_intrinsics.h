@@ -0,0 +1,142 @@
+//
+// Copyright 2019 Jeff Bush
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#pragma once
+
+#include <stdint.h>
+
+//
+// Fused multiply-add and horizontal reduction instructions. The compiler
+// doesn't have builtins for these and the assembler doesn't know them yet,
+// so these bind operands to fixed registers and emit the encoded instruction.
+// Once the toolchain supports them, these can be replaced with
+// __builtin_nyuzi_* calls without changing callers.
+//
+// Floating point results that would be subnormal are flushed to zero.
+//
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Returns a * b + acc, rounded once.
+static inline float mla_f(float a, float b, float acc)
+{
+    register float a_reg asm("s0") = a;
+    register float b_reg asm("s1") = b;
+    register float acc_reg asm("s2") = acc;
+    asm(".long 0xc2308040" // mla_f s2, s0, s1
+        : "+s" (acc_reg) : "s" (a_reg), "s" (b_reg));
+    return acc_reg;
+}
+
+static inline vecf16_t mla_fv(vecf16_t a, vecf16_t b, vecf16_t acc)
+{
+    register vecf16_t a_reg asm("v0") = a;
+    register vecf16_t b_reg asm("v1") = b;
+    register vecf16_t acc_reg asm("v2") = acc;
+    asm(".long 0xd2308040" // mla_f v2, v0, v1
+        : "+v" (acc_reg) : "v" (a_reg), "v" (b_reg));
+    return acc_reg;
+}
+
+// Lanes that are not set in mask are returned unchanged from acc.
+static inline vecf16_t mla_fv_masked(vmask_t mask, vecf16_t a, vecf16_t b, vecf16_t acc)
+{
+    register int mask_reg asm("s3") = mask;
+    register vecf16_t a_reg asm("v0") = a;
+    register vecf16_t b_reg asm("v1") = b;
+    register vecf16_t acc_reg asm("v2") = acc;
+    asm(".long 0xd6308c40" // mla_f_mask v2, s3, v0, v1
+        : "+v" (acc_reg) : "s" (mask_reg), "v" (a_reg), "v" (b_reg));
+    return acc_reg;
+}
+
+//
+// Horizontal reductions combine the lanes of a vector into a scalar value.
+// The _masked versions only use lanes that are set in the mask. If no lanes
+// are set, the sum is 0, min returns the largest value (NaN for floating
+// point) and max the smallest.
+//
+// Floating point sums are exact for values within 2^8 of the one with the
+// largest exponent. Bits below that are truncated before adding, so the
+// result doesn't depend on lane order, but may differ slightly from adding
+// the lanes one at a time. Floating point min/max order NaNs above infinity
+// (or below negative infinity, for a negative sign bit).
+//
+#define __NYUZI_REDUCTION(name, type, vector_type, encoding, masked_encoding) \
+    static inline type name(vector_type value) \
+    { \
+        register vector_type value_reg asm("v0") = value; \
+        register type result_reg asm("s0"); \
+        asm(".long " #encoding : "=s" (result_reg) : "v" (value_reg)); \
+        return result_reg; \
+    } \
+    \
+    static inline type name##_masked(vmask_t mask, vector_type value) \
+    { \
+        register int mask_reg asm("s1") = mask; \
+        register vector_type value_reg asm("v0") = value; \
+        register type result_reg asm("s0"); \
+        asm(".long " #masked_encoding : "=s" (result_reg) : "s" (mask_reg), "v" (value_reg)); \
+        return result_reg; \
+    }
+
+__NYUZI_REDUCTION(reduce_add_f, float, vecf16_t, 0xd2400000, 0xd6400400)
+__NYUZI_REDUCTION(reduce_min_f, float, vecf16_t, 0xd2500000, 0xd6500400)
+__NYUZI_REDUCTION(reduce_max_f, float, vecf16_t, 0xd2600000, 0xd6600400)
+__NYUZI_REDUCTION(reduce_add_i, int, veci16_t, 0xd2700000, 0xd6700400)
+__NYUZI_REDUCTION(reduce_min_i, int, veci16_t, 0xd2800000, 0xd6800400)
+__NYUZI_REDUCTION(reduce_max_i, int, veci16_t, 0xd2900000, 0xd6900400)
+
+#undef __NYUZI_REDUCTION
+
+//
+// Integer divide and remainder. These are multi-cycle instructions, but are
+// much faster than the software routines the compiler calls for / and %.
+// Division by zero returns a quotient with all bits set and a remainder equal
+// to the dividend. Dividing INT_MIN by -1 returns INT_MIN with a remainder of
+// zero. Signed remainders have the sign of the dividend, like C.
+//
+#define __NYUZI_DIVIDE(name, type, vector_type, encoding, vector_encoding) \
+    static inline type name(type a, type b) \
+    { \
+        register type a_reg asm("s0") = a; \
+        register type b_reg asm("s1") = b; \
+        register type result_reg asm("s2"); \
+        asm(".long " #encoding : "=s" (result_reg) : "s" (a_reg), "s" (b_reg)); \
+        return result_reg; \
+    } \
+    \
+    static inline vector_type name##v(vector_type a, vector_type b) \
+    { \
+        register vector_type a_reg asm("v0") = a; \
+        register vector_type b_reg asm("v1") = b; \
+        register vector_type result_reg asm("v2"); \
+        asm(".long " #vector_encoding : "=v" (result_reg) : "v" (a_reg), "v" (b_reg)); \
+        return result_reg; \
+    }
+
+__NYUZI_DIVIDE(div_i, int, veci16_t, 0xc3208040, 0xd3208040)
+__NYUZI_DIVIDE(div_u, unsigned int, vecu16_t, 0xc3308040, 0xd3308040)
+__NYUZI_DIVIDE(rem_i, int, veci16_t, 0xc3408040, 0xd3408040)
+__NYUZI_DIVIDE(rem_u, unsigned int, vecu16_t, 0xc3508040, 0xd3508040)
+
+#undef __NYUZI_DIVIDE
+
+#ifdef __cplusplus
+}
+#endif
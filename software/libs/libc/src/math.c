@@ -15,6 +15,7 @@
 //
 
 #include <math.h>
+#include <nyuzi_intrinsics.h>
 
 //
 // Standard library math functions
@@ -124,3 +125,8 @@ float ceilf(float value)
     return floorval;
 }
 
+
+float fmaf(float a, float b, float c)
+{
+    return mla_f(a, b, c);
+}
@@ -0,0 +1,106 @@
+//
+// Copyright 2019 Jeff Bush
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <string.h>
+#include "dma.h"
+#include "registers.h"
+
+#define DMA_CONTROL_FILL 1
+#define DMA_CONTROL_FLUSH 4
+#define DMA_STATUS_BUSY 1
+#define CACHE_LINE_SIZE 64
+
+static void start_transfer(unsigned int control)
+{
+    // Make sure stores from this thread have reached the L2 cache, where the
+    // engine reads.
+    __sync_synchronize();
+    REGISTERS[REG_DMA_CONTROL] = control;
+}
+
+static void set_rows(unsigned int row_bytes, unsigned int rows)
+{
+    dma_wait();
+    REGISTERS[REG_DMA_ROW_BYTES] = row_bytes;
+    REGISTERS[REG_DMA_ROWS] = rows;
+}
+
+void dma_copy(void *dest, const void *src, unsigned int length)
+{
+    dma_copy_2d(dest, 0, src, 0, length, 1, 0);
+}
+
+void dma_copy_2d(void *dest, unsigned int dest_stride, const void *src,
+                 unsigned int src_stride, unsigned int row_bytes,
+                 unsigned int rows, unsigned int flags)
+{
+    unsigned int row;
+    unsigned int row_start;
+    unsigned int addr;
+
+    if ((((unsigned int) dest ^ (unsigned int) src) & (CACHE_LINE_SIZE - 1)) != 0
+        || (dest_stride & (CACHE_LINE_SIZE - 1)) != (src_stride & (CACHE_LINE_SIZE - 1)))
+    {
+        // Rows would have different offsets into cache lines.
+        for (row = 0; row < rows; row++)
+        {
+            memcpy((char*) dest + row * dest_stride, (const char*) src + row * src_stride,
+                   row_bytes);
+            if (flags & DMA_FLUSH)
+            {
+                row_start = (unsigned int) dest + row * dest_stride;
+                for (addr = row_start & ~(CACHE_LINE_SIZE - 1); addr < row_start + row_bytes;
+                        addr += CACHE_LINE_SIZE)
+                    asm("dflush %0" : : "s" (addr));
+            }
+        }
+
+        return;
+    }
+
+    set_rows(row_bytes, rows);
+    REGISTERS[REG_DMA_SRC] = (unsigned int) src;
+    REGISTERS[REG_DMA_DEST] = (unsigned int) dest;
+    REGISTERS[REG_DMA_SRC_STRIDE] = src_stride;
+    REGISTERS[REG_DMA_DEST_STRIDE] = dest_stride;
+    start_transfer((flags & DMA_FLUSH) ? DMA_CONTROL_FLUSH : 0);
+}
+
+void dma_fill(void *dest, unsigned int value, unsigned int length)
+{
+    dma_fill_2d(dest, 0, value, length, 1, 0);
+}
+
+void dma_fill_2d(void *dest, unsigned int dest_stride, unsigned int value,
+                 unsigned int row_bytes, unsigned int rows, unsigned int flags)
+{
+    set_rows(row_bytes, rows);
+    REGISTERS[REG_DMA_DEST] = (unsigned int) dest;
+    REGISTERS[REG_DMA_DEST_STRIDE] = dest_stride;
+    REGISTERS[REG_DMA_FILL_VALUE] = value;
+    start_transfer(DMA_CONTROL_FILL | ((flags & DMA_FLUSH) ? DMA_CONTROL_FLUSH : 0));
+}
+
+int dma_busy(void)
+{
+    return (REGISTERS[REG_DMA_STATUS] & DMA_STATUS_BUSY) != 0;
+}
+
+void dma_wait(void)
+{
+    while (dma_busy())
+        ;
+}
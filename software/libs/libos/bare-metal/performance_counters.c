@@ -15,19 +15,134 @@
 //
 
 #include "performance_counters.h"
-#include "registers.h"
+
+#define CR_CURRENT_HW_THREAD 0
+#define CR_TRAP_HANDLER 1
+#define CR_FLAGS 4
+#define CR_INTERRUPT_ENABLE 14
+#define CR_PERF_INDEX 28
+#define CR_PERF_DATA 29
+
+#define FLAG_INTERRUPT_EN 1
+#define INT_PERF_COUNTER 15
+
+#define PERF_FIELD_CONTROL 0
+#define PERF_FIELD_COUNT_L 1
+#define PERF_FIELD_COUNT_H 2
+#define PERF_CONTROL_THREAD_SHIFT 8
+#define PERF_CONTROL_INT_EN 0x40000000
+
+#define PERF_MAX_SAMPLES 4096
+
+// These are shared with the interrupt handler in perf_sample.S
+extern void __perf_sample_handler(void);
+unsigned int __perf_sample_interval[NUM_COUNTERS];
+unsigned int __perf_samples[PERF_MAX_SAMPLES];
+int __perf_sample_count;
+volatile int __perf_sample_lock;
+unsigned int __perf_thread_id_mask;
+
+static unsigned int read_perf_field(int counter, int field)
+{
+    __builtin_nyuzi_write_control_reg(CR_PERF_INDEX, (field << 8) | counter);
+    return __builtin_nyuzi_read_control_reg(CR_PERF_DATA);
+}
+
+static void write_perf_field(int counter, int field, unsigned int value)
+{
+    __builtin_nyuzi_write_control_reg(CR_PERF_INDEX, (field << 8) | counter);
+    __builtin_nyuzi_write_control_reg(CR_PERF_DATA, value);
+}
+
+//
+// Software doesn't know how many threads each core has, but the thread mask
+// in the control register only implements one bit per thread. Write all
+// ones and read it back to find out. This assumes the thread count is a
+// power of two, which the hardware requires.
+//
+static unsigned int local_thread_bit(int counter)
+{
+    if (__perf_thread_id_mask == 0)
+    {
+        unsigned int old_control = read_perf_field(counter, PERF_FIELD_CONTROL);
+        write_perf_field(counter, PERF_FIELD_CONTROL,
+                         0xff << PERF_CONTROL_THREAD_SHIFT);
+        __perf_thread_id_mask = (read_perf_field(counter, PERF_FIELD_CONTROL)
+                                 >> PERF_CONTROL_THREAD_SHIFT) >> 1;
+        write_perf_field(counter, PERF_FIELD_CONTROL, old_control);
+    }
+
+    return 1 << (__builtin_nyuzi_read_control_reg(CR_CURRENT_HW_THREAD)
+                 & __perf_thread_id_mask);
+}
 
 void set_perf_counter_event(int counter, enum performance_event event)
 {
     if (counter >= 0 && counter < NUM_COUNTERS)
-        REGISTERS[REG_PERF0_SEL + counter] = event;
+    {
+        write_perf_field(counter, PERF_FIELD_CONTROL, event
+                         | (local_thread_bit(counter) << PERF_CONTROL_THREAD_SHIFT));
+    }
 }
 
 unsigned int read_perf_counter(int counter)
 {
     if (counter >= 0 && counter < NUM_COUNTERS)
-        return REGISTERS[REG_PERF0_VAL + counter];
+        return read_perf_field(counter, PERF_FIELD_COUNT_L);
     else
         return 0;
 }
 
+void start_perf_sampling(int counter, enum performance_event event,
+                         unsigned int interval)
+{
+    if (counter < 0 || counter >= NUM_COUNTERS || interval == 0)
+        return;
+
+    __perf_sample_interval[counter] = interval;
+
+    // Preload the count so it wraps after 'interval' events.
+    write_perf_field(counter, PERF_FIELD_COUNT_H, 0xffffffff);
+    write_perf_field(counter, PERF_FIELD_COUNT_L, -interval);
+    write_perf_field(counter, PERF_FIELD_CONTROL, event | PERF_CONTROL_INT_EN
+                     | (local_thread_bit(counter) << PERF_CONTROL_THREAD_SHIFT));
+
+    __builtin_nyuzi_write_control_reg(CR_TRAP_HANDLER,
+                                      (unsigned int) __perf_sample_handler);
+    __builtin_nyuzi_write_control_reg(CR_INTERRUPT_ENABLE,
+        __builtin_nyuzi_read_control_reg(CR_INTERRUPT_ENABLE)
+        | (1 << INT_PERF_COUNTER));
+    __builtin_nyuzi_write_control_reg(CR_FLAGS,
+        __builtin_nyuzi_read_control_reg(CR_FLAGS) | FLAG_INTERRUPT_EN);
+}
+
+void stop_perf_sampling(int counter)
+{
+    if (counter >= 0 && counter < NUM_COUNTERS)
+        write_perf_field(counter, PERF_FIELD_CONTROL, 0);
+}
+
+int read_perf_samples(unsigned int *samples, int max_samples)
+{
+    // The interrupt handler on any thread may append to the buffer, so
+    // hold the lock it uses. Interrupts must be disabled on this thread
+    // while it is held, or the handler would deadlock waiting for it.
+    int old_flags = __builtin_nyuzi_read_control_reg(CR_FLAGS);
+    __builtin_nyuzi_write_control_reg(CR_FLAGS, old_flags & ~FLAG_INTERRUPT_EN);
+    while (!__sync_bool_compare_and_swap(&__perf_sample_lock, 0, 1))
+        ;
+
+    // Remove from the end of the buffer, since order doesn't matter for
+    // a profile.
+    int count = __perf_sample_count < max_samples ? __perf_sample_count
+        : max_samples;
+    __perf_sample_count -= count;
+    for (int i = 0; i < count; i++)
+        samples[i] = __perf_samples[__perf_sample_count + i];
+
+    __sync_synchronize();
+    __perf_sample_lock = 0;
+    __builtin_nyuzi_write_control_reg(CR_FLAGS, old_flags);
+
+    return count;
+}
@@ -42,12 +42,16 @@ enum register_index
     REG_VGA_MICROCODE       = 0x0184 / 4,
     REG_VGA_BASE            = 0x0188 / 4,
     REG_VGA_LENGTH          = 0x018c / 4,
-    REG_PERF0_SEL           = 0x0200 / 4,
-    REG_PERF1_SEL           = 0x0204 / 4,
-    REG_PERF2_SEL           = 0x0208 / 4,
-    REG_PERF3_SEL           = 0x020c / 4,
-    REG_PERF0_VAL           = 0x0210 / 4,
-    REG_PERF1_VAL           = 0x0214 / 4,
-    REG_PERF2_VAL           = 0x0218 / 4,
-    REG_PERF3_VAL           = 0x021c / 4
+    REG_DMA_SRC             = 0x0300 / 4,
+    REG_DMA_DEST            = 0x0304 / 4,
+    REG_DMA_ROW_BYTES       = 0x0308 / 4,
+    REG_DMA_ROWS            = 0x030c / 4,
+    REG_DMA_SRC_STRIDE      = 0x0310 / 4,
+    REG_DMA_DEST_STRIDE     = 0x0314 / 4,
+    REG_DMA_FILL_VALUE      = 0x0318 / 4,
+    REG_DMA_CONTROL         = 0x031c / 4,
+    REG_DMA_STATUS          = 0x0320 / 4,
+    REG_TEXTURE_JOB         = 0x0400 / 4,
+    REG_TEXTURE_STATUS      = 0x0404 / 4,
+    REG_TEXTURE_ID          = 0x0408 / 4,
 };
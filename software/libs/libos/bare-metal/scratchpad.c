@@ -0,0 +1,58 @@
+//
+// Copyright 2019 Jeff Bush
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include <stddef.h>
+#include "nyuzi.h"
+#include "scratchpad.h"
+
+#define MAX_CORES 16
+#define THREADS_PER_CORE 4  // Must match config.svh
+#define CACHE_LINE_SIZE 64
+
+// The allocation state is in main memory rather than the scratchpad, so
+// updating it can use atomic operations (synchronized stores to the scratchpad
+// are not atomic).
+static volatile unsigned int next_offset[MAX_CORES];
+
+static volatile unsigned int *get_core_next_offset(void)
+{
+    return &next_offset[get_current_thread_id() / THREADS_PER_CORE];
+}
+
+void *scratchpad_alloc(unsigned int size)
+{
+    volatile unsigned int *next = get_core_next_offset();
+    unsigned int offset;
+
+    if (size > SCRATCHPAD_SIZE)
+        return NULL;
+
+    size = (size + CACHE_LINE_SIZE - 1) & ~(CACHE_LINE_SIZE - 1);
+    do
+    {
+        offset = *next;
+        if (offset + size > SCRATCHPAD_SIZE)
+            return NULL;
+    }
+    while (!__sync_bool_compare_and_swap(next, offset, offset + size));
+
+    return (void*) (SCRATCHPAD_BASE + offset);
+}
+
+void scratchpad_reset(void)
+{
+    *get_core_next_offset() = 0;
+}
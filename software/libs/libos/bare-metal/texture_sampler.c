@@ -0,0 +1,45 @@
+//
+// Copyright 2019 Jeff Bush
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "nyuzi.h"
+#include "registers.h"
+#include "texture_sampler.h"
+
+#define MAX_THREADS 64
+#define TEXTURE_SAMPLER_ID 0x54455831
+#define TEXTURE_STATUS_BUSY 1
+
+static struct texture_job jobs[MAX_THREADS];
+
+int texture_sampler_present(void)
+{
+    return REGISTERS[REG_TEXTURE_ID] == TEXTURE_SAMPLER_ID;
+}
+
+struct texture_job *texture_sampler_job(void)
+{
+    return &jobs[get_current_thread_id()];
+}
+
+void texture_sampler_run(struct texture_job *job)
+{
+    // Make sure stores to the job have reached the L2 cache, where the
+    // sampler reads it.
+    __sync_synchronize();
+    REGISTERS[REG_TEXTURE_JOB] = (unsigned int) job;
+    while (REGISTERS[REG_TEXTURE_STATUS] & TEXTURE_STATUS_BUSY)
+        ;
+}
@@ -0,0 +1,65 @@
+//
+// Copyright 2019 Jeff Bush
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//
+// The DMA engine copies or fills memory without using a hardware thread.
+// These functions start a transfer and return immediately. Call dma_wait
+// before using the destination. Starting a transfer waits for the previous
+// one to finish. There is one engine shared by all threads, so only one
+// thread should use it at a time. These functions are only available to
+// bare metal programs (addresses are physical).
+//
+// Addresses and lengths must be multiples of four bytes. The engine can't
+// access the scratchpad or device registers. The source and destination
+// must not overlap.
+//
+// The "2d" versions transfer a number of rows of row_bytes bytes. Each row
+// starts stride bytes after the previous one. If flags contains DMA_FLUSH,
+// the destination is written back to memory, so other bus masters like the
+// display controller can read it (otherwise it may stay in the L2 cache).
+//
+
+#define DMA_FLUSH 4
+
+// Copies that can't be done by the engine (because the source and
+// destination have different offsets into a cache line) are done by the
+// calling thread with memcpy before this returns. With DMA_FLUSH, the
+// destination is flushed.
+void dma_copy(void *dest, const void *src, unsigned int length);
+void dma_copy_2d(void *dest, unsigned int dest_stride, const void *src,
+                 unsigned int src_stride, unsigned int row_bytes,
+                 unsigned int rows, unsigned int flags);
+
+// Store value to each 32-bit word.
+void dma_fill(void *dest, unsigned int value, unsigned int length);
+void dma_fill_2d(void *dest, unsigned int dest_stride, unsigned int value,
+                 unsigned int row_bytes, unsigned int rows, unsigned int flags);
+
+// Returns nonzero if a transfer is in progress.
+int dma_busy(void);
+
+// Wait for the current transfer to finish.
+void dma_wait(void);
+
+#ifdef __cplusplus
+}
+#endif
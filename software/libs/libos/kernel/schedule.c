@@ -51,8 +51,12 @@ void parallel_execute(parallel_func_t func, void *_context, int num_elements)
     while (current_index != max_index)
         dispatch_job();
 
+    // Wait for threads to finish
     while (active_jobs)
-        ; // Wait for threads to finish
+    {
+        if (load_and_watch(&active_jobs))
+            wait_for_write();
+    }
 }
 
 void worker_thread(void)
@@ -60,7 +64,10 @@ void worker_thread(void)
     while (1)
     {
         while (current_index == max_index)
-            ;
+        {
+            if (load_and_watch(&current_index) == max_index)
+                wait_for_write();
+        }
 
         __sync_fetch_and_add(&active_jobs, 1);
         dispatch_job();
@@ -28,6 +28,8 @@ extern "C" {
 #define AREA_WRITABLE 2
 #define AREA_EXECUTABLE 4
 
+#define CR_WAIT_FOR_WRITE 31
+
 int get_current_thread_id(void);
 unsigned int get_cycle_count(void);
 void *create_area(unsigned int address, unsigned int size, int placement,
@@ -38,6 +40,29 @@ int spawn_thread(const char *name, int (*start)(void*), void *param);
 
 int write_console(const char *str, int length);
 
+// Read a variable with a synchronized load. This also makes the thread
+// watch the variable's cache line for wait_for_write.
+static inline int load_and_watch(const volatile int *ptr)
+{
+    int value;
+    asm volatile("load_sync %0, (%1)" : "=s" (value) : "s" (ptr) : "memory");
+    return value;
+}
+
+// Suspend this thread until another thread writes the cache line passed to
+// the last load_and_watch call, or it takes an interrupt. This may return
+// early, so callers must check the variable again. To avoid missing a write,
+// check the value load_and_watch returned before calling this, e.g.:
+//     while (flag == 0)
+//     {
+//         if (load_and_watch(&flag) == 0)
+//             wait_for_write();
+//     }
+static inline void wait_for_write(void)
+{
+    __builtin_nyuzi_write_control_reg(CR_WAIT_FOR_WRITE, 0);
+}
+
 #ifdef __cplusplus
 }
 #endif
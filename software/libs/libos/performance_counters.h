@@ -20,13 +20,12 @@
 extern "C" {
 #endif
 
-#define NUM_COUNTERS 4
+#define NUM_COUNTERS 8
+#define PERF_L2_BANK_EVENTS 7
 
+// Must match the event order in core.sv
 enum performance_event
 {
-    PERF_L2_WRITEBACK,
-    PERF_L2_MISS,
-    PERF_L2_HIT,
     PERF_INTERRUPT,
     PERF_STORE_ROLLBACK,
     PERF_STORE,
@@ -41,11 +40,45 @@ enum performance_event
     PERF_UNCOND_BRANCH,
     PERF_COND_BRANCH_TAKEN,
     PERF_COND_BRANCH_NOT_TAKEN,
+    PERF_DCACHE_PREFETCH,
+    PERF_DCACHE_PREFETCH_HIT,
+    PERF_ICACHE_PREFETCH,
+    PERF_ICACHE_PREFETCH_HIT,
+    PERF_BRANCH_PREDICTED,      // PC relative branch fetched as predicted taken
+    PERF_BRANCH_MISPREDICTED,   // PC relative branch rolled back
+
+    // L2 cache events. The L2 cache is shared, so these count activity from
+    // all cores, and aren't restricted to the calling thread. These are for
+    // bank 0. The same event for bank b is PERF_L2_BANK_EVENTS * b after it.
+    PERF_L2_WRITEBACK,
+    PERF_L2_MISS,
+    PERF_L2_HIT,
+    PERF_L2_PREFETCH_USEFUL,
+    PERF_L2_PREFETCH_USELESS,
+    PERF_L2_SNOOP_SENT,
+    PERF_L2_SNOOP_FILTERED,
 };
 
+//
+// Counters belong to the core the caller is running on. On bare metal, a
+// counter only counts events from the calling hardware thread. Under the
+// kernel, it counts events from all threads on the core.
+//
 void set_perf_counter_event(int counter, enum performance_event event);
 unsigned int read_perf_counter(int counter);
 
+//
+// Event based sampling. Every 'interval' occurrences of the event, the counter
+// overflows and raises an interrupt, which records the interrupted PC into a
+// sample buffer. read_perf_samples removes up to max_samples PCs from the
+// buffer and returns the number copied. Samples are dropped if the buffer
+// fills before they are read.
+//
+void start_perf_sampling(int counter, enum performance_event event,
+                         unsigned int interval);
+void stop_perf_sampling(int counter);
+int read_perf_samples(unsigned int *samples, int max_samples);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,43 @@
+//
+// Copyright 2019 Jeff Bush
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//
+// Each core has a private scratchpad memory at SCRATCHPAD_BASE. Loads and
+// stores to it never miss and don't use space in the caches, but other cores
+// can't see it (they each have their own at the same address). These
+// functions are only available to bare metal programs.
+//
+
+#define SCRATCHPAD_BASE 0xfffe0000
+#define SCRATCHPAD_SIZE 0x4000  // Must match SCRATCHPAD_LINES in config.svh
+
+// Allocate size bytes from the current core's scratchpad. The returned
+// pointer is cache line aligned. The contents are not cleared. Returns NULL
+// if there isn't enough space.
+void *scratchpad_alloc(unsigned int size);
+
+// Free all scratchpad allocations for the current core.
+void scratchpad_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
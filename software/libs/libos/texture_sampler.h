@@ -0,0 +1,70 @@
+//
+// Copyright 2019 Jeff Bush
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//
+// Each core has a texture sampler, which reads and filters the texels for 16
+// coordinates without using a hardware thread. A job describes the texture
+// and the coordinates, and the sampler writes the colors back into it. The
+// threads on a core share its sampler, which runs one job at a time. These
+// functions are only available to bare metal programs (addresses are
+// physical).
+//
+
+#define TEXTURE_RGBA8888 0  // 32 bits per texel, red in the lowest byte
+#define TEXTURE_GRAY8 1     // Returned in all four channels
+#define TEXTURE_BILINEAR 1
+
+struct texture_job
+{
+    unsigned int base;      // Must be a multiple of 4 for TEXTURE_RGBA8888
+    unsigned int width;     // In texels, 65535 or fewer
+    unsigned int height;
+    unsigned int stride;    // Bytes between rows, multiple of 4 for TEXTURE_RGBA8888
+    unsigned int format;
+    unsigned int flags;
+    unsigned int lane_mask; // Bit n enables lane n
+    unsigned int reserved[9];
+
+    // Coordinates in texels, 16.16 fixed point. They must be less than the
+    // width and height. With TEXTURE_BILINEAR, the texels to the right and
+    // below are blended using the top 8 bits of the fraction (wrapping around
+    // the edges).
+    unsigned int u[16];
+    unsigned int v[16];
+
+    // Written by the sampler, in TEXTURE_RGBA8888 format. Lanes that aren't
+    // enabled are not modified.
+    unsigned int result[16];
+} __attribute__((aligned(64)));
+
+// Returns nonzero if the processor has texture samplers.
+int texture_sampler_present(void);
+
+// Returns the calling thread's job. Each thread has one.
+struct texture_job *texture_sampler_job(void);
+
+// Run a job on the current core's sampler and wait for it to finish.
+void texture_sampler_run(struct texture_job *job);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,99 @@
+//
+// Copyright 2011-2015 Jeff Bush
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#pragma once
+
+#include <nyuzi_intrinsics.h>
+#include <stdint.h>
+#include "Surface.h"
+
+namespace librender
+{
+
+//
+// Low resolution copy of the depth buffer for one tile, used to reject
+// geometry before it is rasterized. This tracks the farthest depth value in
+// each 4x4 and 16x16 block of the tile. A pixel passes the depth test if its
+// Z value is greater than the one in the depth buffer, so values only move
+// closer as triangles are drawn, and a triangle whose nearest point is closer
+// than the farthest value of a block is hidden everywhere in that block.
+//
+// 16x16 blocks are numbered the same way as the lanes in the rasterizer's
+// top level masks: block n is at column n & 3, row n >> 2.
+//
+class CoarseDepth
+{
+public:
+    static_assert(kTileSize == 64, "Coarse depth blocks assume 64x64 tiles");
+
+    // Set every block to value. Blocks that are completely outside the
+    // render target are never drawn, so they are set to +infinity so they
+    // don't prevent the rest of their 16x16 block from being occluded.
+    void clear(int tileLeft, int tileTop, int clipRight, int clipBottom, float value)
+    {
+        fTileLeft = tileLeft;
+        fTileTop = tileTop;
+        for (int block = 0; block < 16; block++)
+        {
+            for (int subBlock = 0; subBlock < 16; subBlock++)
+            {
+                int left = tileLeft + (block & 3) * 16 + (subBlock & 3) * 4;
+                int top = tileTop + (block >> 2) * 16 + (subBlock >> 2) * 4;
+                if (left >= clipRight || top >= clipBottom)
+                    f4x4Farthest[block][subBlock] = __builtin_inff();
+                else
+                    f4x4Farthest[block][subBlock] = value;
+            }
+
+            fBlockFarthest[block] = reduce_min_f(f4x4Farthest[block]);
+        }
+    }
+
+    // Called after the depth buffer for the 4x4 block at left, top (raster
+    // coordinates) has been written. depthValues contains the new contents
+    // of the depth buffer for all 16 pixels.
+    void update(int left, int top, vecf16_t depthValues)
+    {
+        int tileX = left - fTileLeft;
+        int tileY = top - fTileTop;
+        int block = ((tileY >> 4) << 2) | (tileX >> 4);
+        int subBlock = (((tileY >> 2) & 3) << 2) | ((tileX >> 2) & 3);
+        f4x4Farthest[block][subBlock] = reduce_min_f(depthValues);
+        fBlockFarthest[block] = reduce_min_f(f4x4Farthest[block]);
+    }
+
+    // Return a mask with a bit set for each 16x16 block where a triangle
+    // with no point nearer than nearestZ would fail the depth test
+    // for every pixel.
+    vmask_t occludedBlocks(float nearestZ) const
+    {
+        return __builtin_nyuzi_mask_cmpf_gt(fBlockFarthest, vecf16_t(nearestZ));
+    }
+
+private:
+    int fTileLeft = 0;
+    int fTileTop = 0;
+
+    // Lane n is the farthest depth value in 16x16 block n.
+    vecf16_t fBlockFarthest;
+
+    // Lane n of entry m is the farthest depth value in the 4x4 block at
+    // column n & 3, row n >> 2 of 16x16 block m.
+    vecf16_t f4x4Farthest[16];
+};
+
+} // namespace librender
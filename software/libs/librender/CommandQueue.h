@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <nyuzi.h>
 #include "RegionAllocator.h"
 
 namespace librender
@@ -34,6 +35,8 @@ private:
     struct Bucket;
 
 public:
+    typedef T value_type;
+
     CommandQueue() = default;
     CommandQueue(const CommandQueue&) = delete;
     CommandQueue& operator=(const CommandQueue&) = delete;
@@ -87,31 +90,11 @@ public:
         fNextBucketIndex = 0;
     }
 
-    // Sort all items in queue. This is not thread safe.
-    void sort()
-    {
-        if (!fFirstBucket)
-            return;		// Empty
-
-        // Insertion sort.  This is fairly efficient when the array
-        // is already mostly sorted, which is usually the case.
-        for (iterator i = begin().next(), e = end(); i != e; ++i)
-        {
-            iterator j = i;
-            while (j != begin() && *j.prev() > *j)
-            {
-                // swap
-                T temp = *j;
-                *j = *j.prev();
-                *j.prev() = temp;
-                --j;
-            }
-        }
-    }
-
     class iterator
     {
     public:
+        iterator() = default;
+
         bool operator!=(const iterator &iter) const
         {
             return fBucket != iter.fBucket || fIndex != iter.fIndex;
@@ -174,8 +157,8 @@ public:
                 fIndex(index)
         {}
 
-        Bucket *fBucket;
-        int fIndex;	// Index in current bucket
+        Bucket *fBucket = nullptr;
+        int fIndex = 0;	// Index in current bucket
     };
 
     iterator begin() const
@@ -201,13 +184,17 @@ private:
         // Acquire spinlock
         do
         {
-            // Busy wait without calling the sync version of compare and swap.
+            // Wait without calling the sync version of compare and swap.
             // This avoids creating traffic on the L2 interface, because it
             // only reads the L1 cached copy of the variable. When another thread
             // writes to the lock, the coherence broadcast will update the L1
-            // cache and knock this out of the loop.
+            // cache and knock this out of the loop. While the lock is held,
+            // the thread is suspended instead of spinning.
             while (fSpinLock)
-                ;
+            {
+                if (load_and_watch(&fSpinLock))
+                    wait_for_write();
+            }
         }
         while (!__sync_bool_compare_and_swap(&fSpinLock, 0, 1));
 
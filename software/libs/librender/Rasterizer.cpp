@@ -98,6 +98,7 @@ void setupRecurseEdge(int tileLeft, int tileTop, int x1, int y1,
 }
 
 // Workhorse of recursive rasterization.  Subdivides tile into 4x4 grids.
+// Blocks with bits set in skipMask are ignored.
 void subdivideTile(
     TriangleFiller &filler,
     const int acceptCornerValue1,
@@ -116,7 +117,8 @@ void subdivideTile(
     const int tileLeft,
     const int tileTop,
     const int clipRight,
-    const int clipBottom)
+    const int clipBottom,
+    const unsigned int skipMask)
 {
     // Compute accept masks
     const veci16_t acceptEdgeValue1 = acceptStep1 + acceptCornerValue1;
@@ -139,9 +141,9 @@ void subdivideTile(
     const int subTileSizeBits = tileSizeBits - 2;
 
     // Process all trivially accepted blocks
-    if (trivialAcceptMask != 0)
+    if ((trivialAcceptMask & ~skipMask) != 0)
     {
-        unsigned int currentMask = trivialAcceptMask;
+        unsigned int currentMask = trivialAcceptMask & ~skipMask;
 
         while (currentMask)
         {
@@ -171,7 +173,7 @@ void subdivideTile(
 
     // Recurse into blocks that are neither trivially rejected or accepted.
     // They are partially overlapped and need to be further subdivided.
-    unsigned int recurseMask = (trivialAcceptMask | trivialRejectMask) ^ 0xffff;
+    unsigned int recurseMask = ((trivialAcceptMask | trivialRejectMask) ^ 0xffff) & ~skipMask;
     if (recurseMask)
     {
         // Divide each step matrix by 4
@@ -209,14 +211,16 @@ void subdivideTile(
                 x,
                 y,
                 clipRight,
-                clipBottom);
+                clipBottom,
+                0);
         }
     }
 }
 
 void rasterizeRecursive(TriangleFiller &filler,
                         int tileLeft, int tileTop, int clipRight, int clipBottom,
-                        int x1, int y1, int x2, int y2, int x3, int y3)
+                        int x1, int y1, int x2, int y2, int x3, int y3,
+                        vmask_t occludedBlocks)
 {
     int acceptValue1;
     int rejectValue1;
@@ -258,7 +262,8 @@ void rasterizeRecursive(TriangleFiller &filler,
         tileLeft,
         tileTop,
         clipRight,
-        clipBottom);
+        clipBottom,
+        occludedBlocks);
 }
 
 inline int min3(int a, int b, int c)
@@ -353,7 +358,7 @@ void rasterizeSweep(TriangleFiller &filler,
 void fillTriangle(TriangleFiller &filler,
                   int tileLeft, int tileTop,
                   int x1, int y1, int x2, int y2, int x3, int y3,
-                  int clipRight, int clipBottom)
+                  int clipRight, int clipBottom, vmask_t occludedBlocks)
 {
     int bbLeft = max(min3(x1, x2, x3) & ~3, tileLeft);
     int bbTop = max(min3(y1, y2, y3) & ~3, tileTop);
@@ -365,7 +370,7 @@ void fillTriangle(TriangleFiller &filler,
     else
     {
         rasterizeRecursive(filler, tileLeft, tileTop, clipRight, clipBottom,
-                           x1, y1, x2, y2, x3, y3);
+                           x1, y1, x2, y2, x3, y3, occludedBlocks);
     }
 }
 
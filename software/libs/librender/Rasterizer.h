@@ -26,10 +26,12 @@ namespace librender
 // Determine all pixels covered by a triangle and call
 // TriangleFiller::fillMasked.
 // Triangles are wound counter-clockwise
+// Bits in occludedBlocks are 16x16 blocks of the tile (numbered as in
+// CoarseDepth) that the triangle is hidden in. These are skipped.
 void fillTriangle(TriangleFiller &filler,
                   int left, int top,
                   int x1, int y1, int x2, int y2, int x3, int y3,
-                  int clipRight, int clipBottom);
+                  int clipRight, int clipBottom, vmask_t occludedBlocks = 0);
 
 } // namespace librender
 
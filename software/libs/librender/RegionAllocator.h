@@ -18,7 +18,9 @@
 #pragma once
 
 #include <assert.h>
+#include <nyuzi.h>
 #include <stddef.h>
+#include <stdlib.h>
 
 namespace librender
 {
@@ -31,15 +33,25 @@ namespace librender
 //   to minimize synchronization overhead.
 // - It doesn't have any internal fragmentation.
 //
+// The arena is a chain of blocks. When the current block fills up, this
+// allocates another one, so there is no fixed limit. reset() replaces the
+// chain with one block that is big enough for all of them, so later frames
+// of a similar size don't need to grow it again.
+//
+// So threads don't all contend for the shared allocation pointer, each
+// hardware thread carves slabs off the arena and makes small allocations
+// from its own slab without synchronizing.
+//
 
 class RegionAllocator
 {
 public:
     explicit RegionAllocator(unsigned int arenaSize)
-        :	fArenaBase(new char[arenaSize]),
-            fTotalSize(arenaSize),
-            fNextAlloc(fArenaBase)
+        :	fBlockSize(arenaSize),
+            fSlabs(static_cast<Slab*>(memalign(kCacheLineSize, sizeof(Slab) * kMaxThreads)))
     {
+        fCurrentBlock = newBlock(arenaSize, nullptr);
+        clearSlabs();
     }
 
     RegionAllocator(const RegionAllocator&) = delete;
@@ -47,24 +59,32 @@ public:
 
     ~RegionAllocator()
     {
-        delete [] fArenaBase;
+        freeBlocks();
+        free(fSlabs);
     }
 
-    // This is reentrant and lock-free. Alignment must be a power of 2
+    // This is reentrant and lock-free unless it needs to grow the arena.
+    // Alignment must be a power of 2.
+    // This looks up the thread's slab on every call. That assumes bare metal
+    // (libos-bare), where get_current_thread_id() reads a control register.
+    // Under libos-kern it is a system call. librender already requires bare
+    // metal because it uses the hardware texture sampler.
     void *alloc(size_t size, size_t alignment = 4)
     {
-        char *nextAlloc;
-        char *alignedAlloc;
+        unsigned int threadId = static_cast<unsigned int>(get_current_thread_id());
+        if (threadId >= kMaxThreads || size > kMaxSlabAlloc || alignment > kCacheLineSize)
+            return allocShared(size, alignment);
 
-        do
+        // Only this thread uses its slab, so this doesn't need to synchronize.
+        Slab &slab = fSlabs[threadId];
+        char *alignedAlloc = alignUp(slab.next, alignment);
+        if (slab.next == nullptr || alignedAlloc + size > slab.end)
         {
-            nextAlloc = fNextAlloc;
-            alignedAlloc = reinterpret_cast<char*>((reinterpret_cast<unsigned int>(nextAlloc)
-                                                    + alignment - 1) & ~(alignment - 1));
-            assert(alignedAlloc + size < fArenaBase + fTotalSize);
+            alignedAlloc = static_cast<char*>(allocShared(kSlabSize, kCacheLineSize));
+            slab.end = alignedAlloc + kSlabSize;
         }
-        while (!__sync_bool_compare_and_swap(&fNextAlloc, nextAlloc, alignedAlloc + size));
 
+        slab.next = alignedAlloc + size;
         return alignedAlloc;
     }
 
@@ -72,18 +92,166 @@ public:
     // are calling other methods on the allocator when this is called
     void reset()
     {
-        fNextAlloc = fArenaBase;
+        size_t used = bytesUsed();
+        if (used > fPeakBytesUsed)
+            fPeakBytesUsed = used;
+
+        if (fCurrentBlock->next)
+        {
+            // The arena grew. Replace it with one block that is large enough
+            // to hold everything.
+            freeBlocks();
+            fBlockSize = fTotalSize;
+            fTotalSize = 0;
+            fCurrentBlock = newBlock(fBlockSize, nullptr);
+        }
+        else
+            fCurrentBlock->nextAlloc = fCurrentBlock->base();
+
+        clearSlabs();
     }
 
+    // This is not thread safe. Space at the end of slabs that hasn't been
+    // used yet counts as used.
     size_t bytesUsed() const
     {
-        return static_cast<size_t>(fNextAlloc - fArenaBase);
+        size_t used = 0;
+        for (const Block *block = fCurrentBlock; block; block = block->next)
+            used += static_cast<size_t>(block->nextAlloc - block->base());
+
+        return used;
+    }
+
+    // The largest value of bytesUsed() when reset() was called.
+    size_t peakBytesUsed() const
+    {
+        return fPeakBytesUsed;
     }
 
 private:
-    char *fArenaBase;
-    unsigned int fTotalSize;
-    char * volatile fNextAlloc;
+    static const unsigned int kMaxThreads = 64;
+    static const size_t kCacheLineSize = 64;
+    static const size_t kSlabSize = 8192;
+    static const size_t kMaxSlabAlloc = 1024;
+
+    struct Block
+    {
+        Block *next;
+        char * volatile nextAlloc;
+        char *end;
+
+        char *base()
+        {
+            return reinterpret_cast<char*>(this + 1);
+        }
+
+        const char *base() const
+        {
+            return reinterpret_cast<const char*>(this + 1);
+        }
+    };
+
+    struct Slab
+    {
+        char *next;
+        char *end;
+        char padding[kCacheLineSize - sizeof(char*) * 2];
+    };
+
+    static char *alignUp(char *ptr, size_t alignment)
+    {
+        return reinterpret_cast<char*>((reinterpret_cast<unsigned int>(ptr)
+                                        + alignment - 1) & ~(alignment - 1));
+    }
+
+    void *allocShared(size_t size, size_t alignment)
+    {
+        while (true)
+        {
+            Block *block = fCurrentBlock;
+            char *nextAlloc = block->nextAlloc;
+            char *alignedAlloc = alignUp(nextAlloc, alignment);
+            if (alignedAlloc + size > block->end)
+            {
+                growArena(block, size + alignment);
+                continue;
+            }
+
+            if (__sync_bool_compare_and_swap(&block->nextAlloc, nextAlloc, alignedAlloc + size))
+                return alignedAlloc;
+        }
+    }
+
+    // Add a new block to the chain if fullBlock is still the current one.
+    // fSpinLock keeps two threads that both found fullBlock full from each
+    // adding a block for it.
+    void growArena(Block *fullBlock, size_t minSize)
+    {
+        // Acquire spinlock
+        do
+        {
+            while (fSpinLock)
+            {
+                if (load_and_watch(&fSpinLock))
+                    wait_for_write();
+            }
+        }
+        while (!__sync_bool_compare_and_swap(&fSpinLock, 0, 1));
+
+        // Check that someone didn't beat us to allocating the block.
+        if (fCurrentBlock == fullBlock)
+        {
+            Block *block = newBlock(fBlockSize > minSize ? fBlockSize : minSize, fullBlock);
+
+            // Make sure the new block is initialized before other threads
+            // can see it.
+            __sync_synchronize();
+            fCurrentBlock = block;
+        }
+
+        fSpinLock = 0;
+        __sync_synchronize();
+    }
+
+    Block *newBlock(size_t size, Block *next)
+    {
+        Block *block = static_cast<Block*>(malloc(sizeof(Block) + size));
+        assert(block);
+        block->next = next;
+        block->nextAlloc = block->base();
+        block->end = block->base() + size;
+        fTotalSize += size;
+        return block;
+    }
+
+    void freeBlocks()
+    {
+        Block *block = fCurrentBlock;
+        while (block)
+        {
+            Block *next = block->next;
+            free(block);
+            block = next;
+        }
+
+        fCurrentBlock = nullptr;
+    }
+
+    void clearSlabs()
+    {
+        for (unsigned int i = 0; i < kMaxThreads; i++)
+        {
+            fSlabs[i].next = nullptr;
+            fSlabs[i].end = nullptr;
+        }
+    }
+
+    Block * volatile fCurrentBlock = nullptr;
+    size_t fBlockSize;
+    size_t fTotalSize = 0;
+    size_t fPeakBytesUsed = 0;
+    Slab *fSlabs;
+    volatile int fSpinLock = 0;
 };
 
 } // namespace librender
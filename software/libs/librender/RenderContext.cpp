@@ -14,6 +14,8 @@
 // limitations under the License.
 //
 
+#include <limits.h>
+#include <nyuzi_intrinsics.h>
 #include <schedule.h>
 #include <string.h>
 #include "line.h"
@@ -80,9 +82,14 @@ void RenderContext::_shadeVertices(void *_castToContext, int index)
     static_cast<RenderContext*>(_castToContext)->shadeVertices(index);
 }
 
-void RenderContext::_setUpTriangle(void *_castToContext, int index)
+void RenderContext::_shadeIndexedVertices(void *_castToContext, int index)
 {
-    static_cast<RenderContext*>(_castToContext)->setUpTriangle(index);
+    static_cast<RenderContext*>(_castToContext)->shadeIndexedVertices(index);
+}
+
+void RenderContext::_setUpTriangles(void *_castToContext, int index)
+{
+    static_cast<RenderContext*>(_castToContext)->setUpTriangles(index);
 }
 
 void RenderContext::_fillTile(void *_castToContext, int index)
@@ -98,8 +105,8 @@ void RenderContext::_wireframeTile(void *_castToContext, int index)
 void RenderContext::finish()
 {
     unsigned int kMaxTiles = static_cast<unsigned int>(fTileColumns * fTileRows);
-    fTiles = new (fAllocator) TriangleArray[kMaxTiles];
-    for (int i = 0; i < kMaxTiles; i++)
+    fTiles = new (fAllocator) TriangleArray[kMaxTiles * kBinRanges];
+    for (int i = 0; i < kMaxTiles * kBinRanges; i++)
         fTiles[i].setAllocator(&fAllocator);
 
     // Geometry phase.  Walk through each draw command and perform two steps
@@ -113,12 +120,21 @@ void RenderContext::finish()
         RenderState &state = *fRenderCommandIterator;
         int numVertices = state.fVertexAttrBuffer->getNumElements();
         int numTriangles = state.fIndexBuffer->getNumElements() / 3;
-        state.fVertexParams = static_cast<float*>(fAllocator.alloc(
-                                  static_cast<unsigned int>(numVertices)
-                                  * static_cast<unsigned int>(state.fShader->getNumParams())
-                                  * sizeof(int)));
-        parallel_execute(_shadeVertices, this, (numVertices + 15) / 16);
-        parallel_execute(_setUpTriangle, this, numTriangles);
+        if (fIndexedVertexShading)
+        {
+            int numToShade = findVerticesToShade(state);
+            parallel_execute(_shadeIndexedVertices, this, (numToShade + 15) / 16);
+        }
+        else
+        {
+            state.fVertexParams = static_cast<float*>(fAllocator.alloc(
+                                      static_cast<unsigned int>(numVertices)
+                                      * static_cast<unsigned int>(state.fShader->getNumParams())
+                                      * sizeof(int)));
+            parallel_execute(_shadeVertices, this, (numVertices + 15) / 16);
+        }
+
+        parallel_execute(_setUpTriangles, this, kBinRanges);
         fBaseSequenceNumber += numTriangles;
     }
 
@@ -137,9 +153,16 @@ void RenderContext::finish()
     // First reset draw queue to clean up, then allocator, which frees
     // memory it is using.
     fDrawQueue.reset();
+    for (int i = 0; i < kShadedVerticesHashSize; i++)
+        fShadedVertices[i] = nullptr;
+
     fAllocator.reset();
     fCurrentState.fUniforms = nullptr;	// Remove dangling pointer
     fClearColorBuffer = false;
+
+#if DISPLAY_STATS
+    printf("peak %zu bytes\n", fAllocator.peakBytesUsed());
+#endif
 }
 
 //
@@ -156,12 +179,34 @@ void RenderContext::shadeVertices(int index)
     else
         mask = 0xffff;
 
+    const veci16_t kStepVector = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 };
+    shadeVertexBlock(kStepVector + index * 16, mask);
+}
+
+//
+// Compute vertex parameters for the vertices findVerticesToShade collected.
+//
+void RenderContext::shadeIndexedVertices(int index)
+{
+    int numVertices = fNumVerticesToShade - index * 16;
+    vmask_t mask;
+    if (numVertices < 16)
+        mask = (1 << numVertices) - 1;
+    else
+        mask = 0xffff;
+
+    shadeVertexBlock(*reinterpret_cast<const veci16_t*>(fVerticesToShade + index * 16), mask);
+}
+
+// Run the vertex shader on up to 16 vertices with arbitrary indices.
+void RenderContext::shadeVertexBlock(veci16_t vertexIndices, vmask_t mask)
+{
+    const RenderState &state = *fRenderCommandIterator;
     int attribsPerVertex = state.fShader->getNumAttribs();
     vecf16_t packedAttribs[attribsPerVertex];
-    int startIndex = index * 16;
     for (int attrib = 0; attrib < attribsPerVertex; attrib++)
     {
-        packedAttribs[attrib] = vecf16_t(state.fVertexAttrBuffer->gatherElements(startIndex,
+        packedAttribs[attrib] = vecf16_t(state.fVertexAttrBuffer->gatherElements(vertexIndices,
                                          attrib, mask));
     }
 
@@ -169,10 +214,8 @@ void RenderContext::shadeVertices(int index)
     vecf16_t packedParams[paramsPerVertex];
     state.fShader->shadeVertices(packedParams, packedAttribs, state.fUniforms, mask);
 
-    const veci16_t kStepVector = { 0, 4, 8, 12, 16, 20, 24, 28, 32, 36, 40, 44, 48, 52, 56, 60 };
-    const veci16_t paramStepVector = kStepVector * paramsPerVertex;
-    float *outBuf = state.fVertexParams + paramsPerVertex * index * 16;
-    veci16_t paramPtr = paramStepVector + reinterpret_cast<int>(outBuf);
+    veci16_t paramPtr = vertexIndices * (paramsPerVertex * 4)
+                        + reinterpret_cast<int>(state.fVertexParams);
     for (int param = 0; param < paramsPerVertex; param++)
     {
         __builtin_nyuzi_scatter_storef_masked(paramPtr, packedParams[param], mask);
@@ -180,6 +223,64 @@ void RenderContext::shadeVertices(int index)
     }
 }
 
+//
+// For indexed vertex shading. Find the parameter array for this draw call's
+// vertex attributes, shader, and uniforms, creating it if no earlier draw
+// call used the same ones. Then collect the vertices the index buffer
+// references that haven't been shaded yet into fVerticesToShade, and return
+// how many there are. This is not thread safe.
+//
+int RenderContext::findVerticesToShade(RenderState &state)
+{
+    int numVertices = state.fVertexAttrBuffer->getNumElements();
+    unsigned int bucket = (reinterpret_cast<unsigned int>(state.fVertexAttrBuffer) >> 4)
+                          % kShadedVerticesHashSize;
+    ShadedVertices *shaded = fShadedVertices[bucket];
+    while (shaded && (shaded->vertexAttrs != state.fVertexAttrBuffer
+                      || shaded->shader != state.fShader || shaded->uniforms != state.fUniforms))
+    {
+        shaded = shaded->hashNext;
+    }
+
+    if (!shaded)
+    {
+        unsigned int vertexCount = static_cast<unsigned int>(numVertices);
+        shaded = new (fAllocator) ShadedVertices;
+        shaded->vertexAttrs = state.fVertexAttrBuffer;
+        shaded->shader = state.fShader;
+        shaded->uniforms = state.fUniforms;
+        shaded->params = static_cast<float*>(fAllocator.alloc(vertexCount
+                         * static_cast<unsigned int>(state.fShader->getNumParams())
+                         * sizeof(float)));
+        shaded->isShaded = static_cast<bool*>(fAllocator.alloc(vertexCount));
+        memset(shaded->isShaded, 0, vertexCount);
+        shaded->hashNext = fShadedVertices[bucket];
+        fShadedVertices[bucket] = shaded;
+    }
+
+    state.fVertexParams = shaded->params;
+
+    // shadeIndexedVertices reads the list 16 entries at a time, so pad it
+    // to a multiple of 16 and align it.
+    int numIndices = state.fIndexBuffer->getNumElements() / 3 * 3;
+    int maxToShade = min(numIndices, numVertices);
+    fVerticesToShade = static_cast<int*>(fAllocator.alloc(static_cast<unsigned int>(
+                           (maxToShade + 15) & ~15) * sizeof(int), sizeof(veci16_t)));
+    fNumVerticesToShade = 0;
+    const int *indices = static_cast<const int*>(state.fIndexBuffer->getData());
+    for (int i = 0; i < numIndices; i++)
+    {
+        int vertexIndex = indices[i];
+        if (!shaded->isShaded[vertexIndex])
+        {
+            shaded->isShaded[vertexIndex] = true;
+            fVerticesToShade[fNumVerticesToShade++] = vertexIndex;
+        }
+    }
+
+    return fNumVerticesToShade;
+}
+
 namespace
 {
 
@@ -192,6 +293,29 @@ void interpolate(float *outParams, const float *inParams0, const float *inParams
         outParams[i] = inParams0[i] * (1.0 - distance) + inParams1[i] * distance;
 }
 
+const veci16_t kTileLeftStep = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 };
+
+// These check a row of 16 tiles, starting with the one whose upper left
+// corner is at left, top. Lane n corresponds to the nth tile. They assume
+// counterclockwise winding.
+vmask_t edgeRejectedTiles(int left, int top, int x1, int y1, int x2, int y2)
+{
+    // Find the reject corner of each tile
+    veci16_t cx = kTileLeftStep * kTileSize + (y2 > y1 ? left + kTileSize : left);
+    int cy = x2 > x1 ? top : top + kTileSize;
+
+    return __builtin_nyuzi_mask_cmpi_sgt((x2 - x1) * (cy - y1) - (cx - x1) * (y2 - y1),
+                                         veci16_t(0));
+}
+
+vmask_t triangleRejectedTiles(int left, int top, int x1, int y1, int x2, int y2,
+                              int x3, int y3)
+{
+    return edgeRejectedTiles(left, top, x1, y1, x2, y2)
+           | edgeRejectedTiles(left, top, x2, y2, x3, y3)
+           | edgeRejectedTiles(left, top, x3, y3, x1, y1);
+}
+
 } // namespace
 
 //
@@ -210,8 +334,8 @@ void interpolate(float *outParams, const float *inParams0, const float *inParams
 //      0
 //
 
-void RenderContext::clipOne(int sequence, const RenderState &state, const float *params0,
-                            const float *params1, const float *params2)
+void RenderContext::clipOne(int sequence, int range, const RenderState &state,
+                            const float *params0, const float *params1, const float *params2)
 {
     float newPoint1[kMaxParams];
     float newPoint2[kMaxParams];
@@ -220,8 +344,8 @@ void RenderContext::clipOne(int sequence, const RenderState &state, const float
                 / (params1[kParamW] - params0[kParamW]));
     interpolate(newPoint2, params2, params0, state.fParamsPerVertex, (params2[kParamW] - kNearWClip)
                 / (params2[kParamW] - params0[kParamW]));
-    enqueueTriangle(sequence, state, newPoint1, params1, newPoint2);
-    enqueueTriangle(sequence, state, newPoint2, params1, params2);
+    enqueueTriangle(sequence, range, state, newPoint1, params1, newPoint2);
+    enqueueTriangle(sequence, range, state, newPoint2, params1, params2);
 }
 
 //
@@ -242,8 +366,8 @@ void RenderContext::clipOne(int sequence, const RenderState &state, const float
 //        1        0
 //
 
-void RenderContext::clipTwo(int sequence, const RenderState &state, const float *params0,
-                            const float *params1, const float *params2)
+void RenderContext::clipTwo(int sequence, int range, const RenderState &state,
+                            const float *params0, const float *params1, const float *params2)
 {
     float newPoint1[kMaxParams];
     float newPoint2[kMaxParams];
@@ -252,10 +376,25 @@ void RenderContext::clipTwo(int sequence, const RenderState &state, const float
                 / (params2[kParamW] - params1[kParamW]));
     interpolate(newPoint2, params2, params0, state.fParamsPerVertex, (params2[kParamW] - kNearWClip)
                 / (params2[kParamW] - params0[kParamW]));
-    enqueueTriangle(sequence, state, newPoint2, newPoint1, params2);
+    enqueueTriangle(sequence, range, state, newPoint2, newPoint1, params2);
+}
+
+//
+// Set up one of the kBinRanges contiguous ranges of triangles in the current
+// draw call. This processes the triangles in order, so the bins for this
+// range stay in submit order without sorting.
+//
+void RenderContext::setUpTriangles(int range)
+{
+    const RenderState &state = *fRenderCommandIterator;
+    int numTriangles = state.fIndexBuffer->getNumElements() / 3;
+    int first = numTriangles * range / kBinRanges;
+    int last = numTriangles * (range + 1) / kBinRanges;
+    for (int triangleIndex = first; triangleIndex < last; triangleIndex++)
+        setUpTriangle(range, triangleIndex);
 }
 
-void RenderContext::setUpTriangle(int triangleIndex)
+void RenderContext::setUpTriangle(int range, int triangleIndex)
 {
     RenderState &state = *fRenderCommandIterator;
     int vertexIndex = triangleIndex * 3;
@@ -278,32 +417,32 @@ void RenderContext::setUpTriangle(int triangleIndex)
     {
     case 0:
         // Not clipped at all.
-        enqueueTriangle(fBaseSequenceNumber + triangleIndex, state,
+        enqueueTriangle(fBaseSequenceNumber + triangleIndex, range, state,
                         params0, params1, params2);
         break;
 
     case 1:
-        clipOne(fBaseSequenceNumber + triangleIndex, state, params0, params1, params2);
+        clipOne(fBaseSequenceNumber + triangleIndex, range, state, params0, params1, params2);
         break;
 
     case 2:
-        clipOne(fBaseSequenceNumber + triangleIndex, state, params1, params2, params0);
+        clipOne(fBaseSequenceNumber + triangleIndex, range, state, params1, params2, params0);
         break;
 
     case 4:
-        clipOne(fBaseSequenceNumber + triangleIndex, state, params2, params0, params1);
+        clipOne(fBaseSequenceNumber + triangleIndex, range, state, params2, params0, params1);
         break;
 
     case 3:
-        clipTwo(fBaseSequenceNumber + triangleIndex, state, params0, params1, params2);
+        clipTwo(fBaseSequenceNumber + triangleIndex, range, state, params0, params1, params2);
         break;
 
     case 6:
-        clipTwo(fBaseSequenceNumber + triangleIndex, state, params1, params2, params0);
+        clipTwo(fBaseSequenceNumber + triangleIndex, range, state, params1, params2, params0);
         break;
 
     case 5:
-        clipTwo(fBaseSequenceNumber + triangleIndex, state, params2, params0, params1);
+        clipTwo(fBaseSequenceNumber + triangleIndex, range, state, params2, params0, params1);
         break;
 
         // Else is totally clipped, ignore
@@ -315,8 +454,9 @@ void RenderContext::setUpTriangle(int triangleIndex)
 // division, backface culling, and binning.
 //
 
-void RenderContext::enqueueTriangle(int sequence, const RenderState &state, const float *params0,
-                                    const float *params1, const float *params2)
+void RenderContext::enqueueTriangle(int sequence, int range, const RenderState &state,
+                                    const float *params0, const float *params1,
+                                    const float *params2)
 {
     Triangle tri;
     tri.sequenceNumber = sequence;
@@ -373,97 +513,204 @@ void RenderContext::enqueueTriangle(int sequence, const RenderState &state, cons
     if (bbRight < 0 || bbLeft >= fFbWidth || bbBottom < 0 || bbTop >= fFbHeight)
         return;
 
-    // Copy parameters into triangle structure, skipping position which is already
-    // in x0/y0/z0/x1...
-    unsigned int paramSize = sizeof(float) * static_cast<unsigned int>(state.fParamsPerVertex - 4);
-    float *params = static_cast<float*>(fAllocator.alloc(paramSize * 3));
-    memcpy(params, params0 + 4, paramSize);
-    memcpy(params + state.fParamsPerVertex - 4, params1 + 4, paramSize);
-    memcpy(params + (state.fParamsPerVertex - 4) * 2, params2 + 4, paramSize);
-    tri.params = params;
-
     // Determine which tiles this triangle may overlap with a simple
-    // bounding box check.  Enqueue it in the queues for each tile.
+    // bounding box check, then test the edges of the triangle against the
+    // tiles in each row, 16 at a time, to skip ones it doesn't touch. Long,
+    // thin diagonal triangles have many of those. Enqueue it in this range's
+    // bin for each tile. The bins share one copy of the triangle, which is
+    // made when the first tile is found, so a triangle that doesn't touch
+    // any tiles doesn't use any memory.
+    const Triangle *binnedTri = nullptr;
     int minTileX = max(bbLeft / kTileSize, 0);
     int maxTileX = min(bbRight / kTileSize, fTileColumns - 1);
     int minTileY = max(bbTop / kTileSize, 0);
     int maxTileY = min(bbBottom / kTileSize, fTileRows - 1);
     for (int tiley = minTileY; tiley <= maxTileY; tiley++)
     {
-        for (int tilex = minTileX; tilex <= maxTileX; tilex++)
-            fTiles[tiley * fTileColumns + tilex].append(tri);
+        for (int tilex = minTileX; tilex <= maxTileX; tilex += 16)
+        {
+            vmask_t rejected;
+            if (tri.woundCCW)
+            {
+                rejected = triangleRejectedTiles(tilex * kTileSize, tiley * kTileSize,
+                                                 tri.x0Rast, tri.y0Rast, tri.x1Rast,
+                                                 tri.y1Rast, tri.x2Rast, tri.y2Rast);
+            }
+            else
+            {
+                rejected = triangleRejectedTiles(tilex * kTileSize, tiley * kTileSize,
+                                                 tri.x0Rast, tri.y0Rast, tri.x2Rast,
+                                                 tri.y2Rast, tri.x1Rast, tri.y1Rast);
+            }
+
+            int numTiles = min(maxTileX - tilex + 1, 16);
+            unsigned int overlapMask = ((1u << numTiles) - 1)
+                                       & ~static_cast<unsigned int>(rejected);
+            if (overlapMask && binnedTri == nullptr)
+            {
+                // Copy parameters into triangle structure, skipping position
+                // which is already in x0/y0/z0/x1...
+                unsigned int paramSize = sizeof(float)
+                    * static_cast<unsigned int>(state.fParamsPerVertex - 4);
+                float *params = static_cast<float*>(fAllocator.alloc(paramSize * 3));
+                memcpy(params, params0 + 4, paramSize);
+                memcpy(params + state.fParamsPerVertex - 4, params1 + 4, paramSize);
+                memcpy(params + (state.fParamsPerVertex - 4) * 2, params2 + 4, paramSize);
+                tri.params = params;
+                binnedTri = new (fAllocator) Triangle(tri);
+            }
+
+            while (overlapMask)
+            {
+                int lane = __builtin_ctz(overlapMask);
+                overlapMask &= ~(1u << lane);
+                fTiles[(tiley * fTileColumns + tilex + lane) * kBinRanges + range]
+                    .append(binnedTri);
+            }
+        }
     }
 }
 
 namespace
 {
 
-// These assume counterclockwise winding
-bool edgeRejected(int left, int top, int right, int bottom,
-                  int x1, int y1, int x2, int y2)
+// Return a mask of the 16x16 blocks of a tile (numbered as in CoarseDepth)
+// that the bounding box of a triangle overlaps.
+vmask_t boundingBoxBlocks(int tileLeft, int tileTop, int x1, int y1, int x2, int y2,
+                          int x3, int y3)
 {
-    // Find a reject corner
-    int cx = y2 > y1 ? right : left;
-    int cy = x2 > x1 ? top : bottom;
-
-    return (x2 - x1) * (cy - y1) - (y2 - y1) * (cx - x1) > 0;
+    int left = max(min(min(x1, x2), x3) - tileLeft, 0) >> 4;
+    int top = max(min(min(y1, y2), y3) - tileTop, 0) >> 4;
+    int right = min(max(max(x1, x2), x3) - tileLeft, kTileSize - 1) >> 4;
+    int bottom = min(max(max(y1, y2), y3) - tileTop, kTileSize - 1) >> 4;
+    if (left > right || top > bottom)
+        return 0;
+
+    int rowMask = (2 << right) - (1 << left);
+    int mask = 0;
+    for (int row = top; row <= bottom; row++)
+        mask |= rowMask << (row * 4);
+
+    return static_cast<vmask_t>(mask);
 }
 
-bool triangleRejected(int left, int top, int right, int bottom,
-                      int x1, int y1, int x2, int y2, int x3, int y3)
+//
+// Returns the triangles in a tile's bins in submit order. Each bin is already
+// sorted by sequence number, so this merges them. Because each bin holds a
+// contiguous range of triangles from each draw call, it takes long runs from
+// one bin before it needs to look at the others again.
+//
+template <typename Queue, int NUM_QUEUES>
+class BinMerger
 {
-    return edgeRejected(left, top, right, bottom, x1, y1, x2, y2)
-           || edgeRejected(left, top, right, bottom, x2, y2, x3, y3)
-           || edgeRejected(left, top, right, bottom, x3, y3, x1, y1);
-}
+public:
+    explicit BinMerger(const Queue *queues)
+    {
+        for (int i = 0; i < NUM_QUEUES; i++)
+        {
+            fNext[i] = queues[i].begin();
+            fEnd[i] = queues[i].end();
+        }
+    }
+
+    // Returns nullptr after the last item.
+    typename Queue::value_type next()
+    {
+        if (fCurrent < 0 || fNext[fCurrent] == fEnd[fCurrent]
+                || (*fNext[fCurrent])->sequenceNumber >= fRunEnd)
+        {
+            if (!startRun())
+                return nullptr;
+        }
+
+        typename Queue::value_type item = *fNext[fCurrent];
+        ++fNext[fCurrent];
+        return item;
+    }
+
+private:
+    // Find the queue with the lowest sequence number. It can be read until
+    // reaching the lowest sequence number in any other queue.
+    bool startRun()
+    {
+        int currentSequence = 0;
+        fCurrent = -1;
+        fRunEnd = INT_MAX;
+        for (int i = 0; i < NUM_QUEUES; i++)
+        {
+            if (fNext[i] == fEnd[i])
+                continue;
+
+            int sequence = (*fNext[i])->sequenceNumber;
+            if (fCurrent < 0 || sequence < currentSequence)
+            {
+                if (fCurrent >= 0)
+                    fRunEnd = currentSequence;
+
+                fCurrent = i;
+                currentSequence = sequence;
+            }
+            else if (sequence < fRunEnd)
+                fRunEnd = sequence;
+        }
+
+        return fCurrent >= 0;
+    }
+
+    typename Queue::iterator fNext[NUM_QUEUES];
+    typename Queue::iterator fEnd[NUM_QUEUES];
+    int fCurrent = -1;
+    int fRunEnd = 0;
+};
 
 } // namespace
 
 void RenderContext::fillTile(int index)
 {
-    const int x = index % fTileColumns;
-    const int y = index / fTileColumns;
+    const int y = div_i(index, fTileColumns);
+    const int x = index - y * fTileColumns;
     const int tileX = x * kTileSize;
     const int tileY = y * kTileSize;
-    TriangleArray &tile = fTiles[y * fTileColumns + x];
+    const TriangleArray *bins = fTiles + (y * fTileColumns + x) * kBinRanges;
     Surface *colorBuffer = fRenderTarget->getColorBuffer();
 
     if (fClearColorBuffer)
         colorBuffer->clearTile(tileX, tileY, fClearColor);
 
+    TriangleFiller filler(fRenderTarget);
+    CoarseDepth coarseDepth;
+    bool hasDepthBuffer = fRenderTarget->getDepthBuffer() != nullptr;
+
     // Initialize Z-Buffer to -infinity
-    if (fRenderTarget->getDepthBuffer())
+    if (hasDepthBuffer)
+    {
         fRenderTarget->getDepthBuffer()->clearTile(tileX, tileY, 0xff800000);
+        coarseDepth.clear(tileX, tileY, fFbWidth, fFbHeight, -__builtin_inff());
+        filler.setCoarseDepth(&coarseDepth);
+    }
 
-    // The triangles may have been reordered during the parallel vertex shading
-    // phase.  Put them back in the order they were submitted.
-    tile.sort();
-
-    // Walk through all triangles that overlap this tile and render
-    TriangleFiller filler(fRenderTarget);
-    for (const Triangle &tri : tile)
+    // Walk through all triangles that overlap this tile in the order they
+    // were submitted and render.
+    BinMerger<TriangleArray, kBinRanges> merger(bins);
+    while (const Triangle *nextTri = merger.next())
     {
+        const Triangle &tri = *nextTri;
         const RenderState &state = *tri.state;
 
-        // Do a better check to see if this triangle overlaps the tile.
-        // If not, skip setting up interpolators.
-        if (tri.woundCCW)
-        {
-            if (triangleRejected(tileX, tileY, tileX + kTileSize,
-                                 tileY + kTileSize, tri.x0Rast, tri.y0Rast, tri.x1Rast,
-                                 tri.y1Rast, tri.x2Rast, tri.y2Rast))
-            {
-                continue;
-            }
-        }
-        else
+        // Hierarchical Z test. The interpolated depth of every pixel is
+        // between the vertex depths, as long as they are on the same side
+        // of the eye. If the nearest vertex is behind everything already drawn
+        // in the blocks the triangle's bounding box covers, skip it entirely.
+        // Otherwise have the rasterizer skip the blocks it is hidden in.
+        vmask_t occludedBlocks = 0;
+        if (hasDepthBuffer && state.fEnableDepthBuffer
+                && (tri.z0 < 0) == (tri.z1 < 0) && (tri.z0 < 0) == (tri.z2 < 0))
         {
-            if (triangleRejected(tileX, tileY, tileX + kTileSize,
-                                 tileY + kTileSize, tri.x0Rast, tri.y0Rast, tri.x2Rast,
-                                 tri.y2Rast, tri.x1Rast, tri.y1Rast))
-            {
+            occludedBlocks = coarseDepth.occludedBlocks(max(max(tri.z0, tri.z1), tri.z2));
+            vmask_t coveredBlocks = boundingBoxBlocks(tileX, tileY, tri.x0Rast, tri.y0Rast,
+                                    tri.x1Rast, tri.y1Rast, tri.x2Rast, tri.y2Rast);
+            if ((occludedBlocks & coveredBlocks) == coveredBlocks)
                 continue;
-            }
         }
 
         // Set up parameters and rasterize triangle.
@@ -480,13 +727,13 @@ void RenderContext::fillTile(int index)
         {
             fillTriangle(filler, tileX, tileY,
                          tri.x0Rast, tri.y0Rast, tri.x1Rast, tri.y1Rast, tri.x2Rast, tri.y2Rast,
-                         fFbWidth, fFbHeight);
+                         fFbWidth, fFbHeight, occludedBlocks);
         }
         else
         {
             fillTriangle(filler, tileX, tileY,
                          tri.x0Rast, tri.y0Rast, tri.x2Rast, tri.y2Rast, tri.x1Rast, tri.y1Rast,
-                         fFbWidth, fFbHeight);
+                         fFbWidth, fFbHeight, occludedBlocks);
         }
     }
 
@@ -499,11 +746,11 @@ void RenderContext::fillTile(int index)
 
 void RenderContext::wireframeTile(int index)
 {
-    const int x = index % fTileColumns;
-    const int y = index / fTileColumns;
+    const int y = div_i(index, fTileColumns);
+    const int x = index - y * fTileColumns;
     const int tileX = x * kTileSize;
     const int tileY = y * kTileSize;
-    const TriangleArray &tile = fTiles[y * fTileColumns + x];
+    const TriangleArray *bins = fTiles + (y * fTileColumns + x) * kBinRanges;
 
     Surface *colorBuffer = fRenderTarget->getColorBuffer();
     colorBuffer->clearTile(tileX, tileY, fClearColor);
@@ -515,14 +762,18 @@ void RenderContext::wireframeTile(int index)
     if (rightClip >= colorBuffer->getWidth())
         rightClip = colorBuffer->getWidth() - 1;
 
-    for (const Triangle &tri : tile)
+    // Order doesn't matter here, because all lines are the same color.
+    for (int range = 0; range < kBinRanges; range++)
     {
-        drawLineClipped(colorBuffer, tri.x0Rast, tri.y0Rast, tri.x1Rast, tri.y1Rast, 0xffffffff,
-                        tileX, tileY, rightClip, bottomClip);
-        drawLineClipped(colorBuffer, tri.x1Rast, tri.y1Rast, tri.x2Rast, tri.y2Rast, 0xffffffff,
-                        tileX, tileY, rightClip, bottomClip);
-        drawLineClipped(colorBuffer, tri.x2Rast, tri.y2Rast, tri.x0Rast, tri.y0Rast, 0xffffffff,
-                        tileX, tileY, rightClip, bottomClip);
+        for (const Triangle *tri : bins[range])
+        {
+            drawLineClipped(colorBuffer, tri->x0Rast, tri->y0Rast, tri->x1Rast, tri->y1Rast,
+                            0xffffffff, tileX, tileY, rightClip, bottomClip);
+            drawLineClipped(colorBuffer, tri->x1Rast, tri->y1Rast, tri->x2Rast, tri->y2Rast,
+                            0xffffffff, tileX, tileY, rightClip, bottomClip);
+            drawLineClipped(colorBuffer, tri->x2Rast, tri->y2Rast, tri->x0Rast, tri->y0Rast,
+                            0xffffffff, tileX, tileY, rightClip, bottomClip);
+        }
     }
 
     colorBuffer->flushTile(tileX, tileY);
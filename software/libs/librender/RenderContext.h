@@ -34,6 +34,8 @@ namespace librender
 class RenderContext
 {
 public:
+    // workingMemSize is the initial size of the memory used for temporary
+    // structures while rendering a frame. It grows if a frame needs more.
     explicit RenderContext(unsigned int workingMemSize = 0x400000);
     RenderContext(const RenderContext&) = delete;
     RenderContext& operator=(const RenderContext&) = delete;
@@ -99,11 +101,29 @@ public:
         fWireframeMode = enable;
     }
 
+    // The most working memory any frame has used, as of the last time finish()
+    // returned. Passing this to the constructor avoids growing the working
+    // memory while rendering.
+    size_t getPeakMemoryUsed() const
+    {
+        return fAllocator.peakBytesUsed();
+    }
+
     void setCulling(RenderState::CullingMode mode)
     {
         fCurrentState.cullingMode = mode;
     }
 
+    // If this is set, the vertex shader only processes vertices that the
+    // index buffer references. Draw calls that use the same vertex
+    // attributes, shader, and uniforms as an earlier draw call in the frame
+    // reuse the vertices it already shaded. Because bindUniforms copies the
+    // uniforms, they only match if it isn't called between the draw calls.
+    void enableIndexedVertexShading(bool enable)
+    {
+        fIndexedVertexShading = enable;
+    }
+
 private:
     struct Triangle
     {
@@ -113,33 +133,55 @@ private:
         int x0Rast, y0Rast, x1Rast, y1Rast, x2Rast, y2Rast;
         const float *params;
         bool woundCCW;
-        bool operator>(const Triangle &tri) const
-        {
-            return sequenceNumber > tri.sequenceNumber;
-        }
     };
 
+    // Triangle setup splits the triangles of each draw call into this many
+    // contiguous ranges, which threads process in parallel. Each range has
+    // its own bin in every tile, so the triangles in a bin are always in
+    // submit order.
+    static const int kBinRanges = 16;
+
+    // Shaded vertex parameters for a combination of vertex attributes,
+    // shader, and uniforms. Draw calls that use the same combination
+    // share these.
+    struct ShadedVertices
+    {
+        const RenderBuffer *vertexAttrs;
+        const Shader *shader;
+        const void *uniforms;
+        float *params;
+        bool *isShaded;
+        ShadedVertices *hashNext;
+    };
+
+    static const int kShadedVerticesHashSize = 64;
+
     void shadeVertices(int index);
-    void setUpTriangle(int triangleIndex);
+    void shadeIndexedVertices(int index);
+    void shadeVertexBlock(veci16_t vertexIndices, vmask_t mask);
+    int findVerticesToShade(RenderState &state);
+    void setUpTriangles(int range);
+    void setUpTriangle(int range, int triangleIndex);
     void fillTile(int index);
     void wireframeTile(int index);
     static void _shadeVertices(void *_castToContext, int index);
-    static void _setUpTriangle(void *_castToContext, int index);
+    static void _shadeIndexedVertices(void *_castToContext, int index);
+    static void _setUpTriangles(void *_castToContext, int index);
     static void _fillTile(void *_castToContext, int index);
     static void _wireframeTile(void *_castToContext, int index);
-    void clipOne(int sequence, const RenderState &command, const float *params0, const float *params1,
-                 const float *params2);
-    void clipTwo(int sequence, const RenderState &command, const float *params0, const float *params1,
-                 const float *params2);
-    void enqueueTriangle(int sequence, const RenderState &command, const float *params0,
-                         const float *params1, const float *params2);
-
-    typedef CommandQueue<Triangle, 64> TriangleArray;
+    void clipOne(int sequence, int range, const RenderState &command, const float *params0,
+                 const float *params1, const float *params2);
+    void clipTwo(int sequence, int range, const RenderState &command, const float *params0,
+                 const float *params1, const float *params2);
+    void enqueueTriangle(int sequence, int range, const RenderState &command,
+                         const float *params0, const float *params1, const float *params2);
+
+    typedef CommandQueue<const Triangle*, 32> TriangleArray;
     typedef CommandQueue<RenderState, 32> DrawQueue;
 
     bool fClearColorBuffer;
     RenderTarget *fRenderTarget = nullptr;
-    TriangleArray *fTiles = nullptr;
+    TriangleArray *fTiles = nullptr;   // kBinRanges bins for each tile
     int fFbWidth = 0;
     int fFbHeight = 0;
     int fTileColumns = 0;
@@ -151,6 +193,10 @@ private:
     int fBaseSequenceNumber = 0;
     unsigned int fClearColor = 0xff000000;
     bool fWireframeMode = false;
+    bool fIndexedVertexShading = false;
+    ShadedVertices *fShadedVertices[kShadedVerticesHashSize] = {};
+    int *fVerticesToShade = nullptr;
+    int fNumVerticesToShade = 0;
 };
 
 } // namespace librender
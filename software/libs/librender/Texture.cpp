@@ -18,6 +18,7 @@
 #include <assert.h>
 #include <math.h>
 #include <stdio.h>
+#include <texture_sampler.h>
 #include "Shader.h"
 #include "Texture.h"
 
@@ -75,6 +76,11 @@ void Texture::setMipSurface(int mipLevel, const Surface *surface)
     }
 }
 
+void Texture::enableHardwareSampling(bool enable)
+{
+    fEnableHardwareSampling = enable && texture_sampler_present();
+}
+
 void Texture::readPixels(vecf16_t u, vecf16_t v, vmask_t mask,
                          vecf16_t *outColor) const
 {
@@ -99,6 +105,12 @@ void Texture::readPixels(vecf16_t u, vecf16_t v, vmask_t mask,
     // to v of 1.0. Coordinates wrap.
     vecf16_t uRaster = wrapfv(fracfv(u)) * (mipWidth - 1);
     vecf16_t vRaster = (1.0 - wrapfv(fracfv(v))) * (mipHeight - 1);
+    if (fEnableHardwareSampling && surface->getColorSpace() != Surface::FLOAT)
+    {
+        readPixelsHardware(surface, uRaster, vRaster, mask, outColor);
+        return;
+    }
+
     veci16_t tx = __builtin_convertvector(uRaster, veci16_t);
     veci16_t ty = __builtin_convertvector(vRaster, veci16_t);
 
@@ -143,4 +155,37 @@ void Texture::readPixels(vecf16_t u, vecf16_t v, vmask_t mask,
     }
 }
 
+void Texture::readPixelsHardware(const Surface *surface, vecf16_t uRaster,
+                                 vecf16_t vRaster, vmask_t mask,
+                                 vecf16_t *outColor) const
+{
+    texture_job *job = texture_sampler_job();
+    job->base = reinterpret_cast<unsigned int>(surface->bits());
+    job->width = static_cast<unsigned int>(surface->getWidth());
+    job->height = static_cast<unsigned int>(surface->getHeight());
+    job->stride = static_cast<unsigned int>(surface->getStride());
+    job->format = surface->getColorSpace() == Surface::GRAY8 ? TEXTURE_GRAY8
+                  : TEXTURE_RGBA8888;
+    job->flags = fEnableBilinearFiltering ? TEXTURE_BILINEAR : 0;
+    job->lane_mask = static_cast<unsigned int>(mask);
+
+    // Raster coordinates are in range, so they don't need to wrap.
+    // Convert to 16.16 fixed point.
+    *reinterpret_cast<veci16_t*>(job->u) = __builtin_convertvector(uRaster
+                                           * 65536.0f, veci16_t);
+    *reinterpret_cast<veci16_t*>(job->v) = __builtin_convertvector(vRaster
+                                           * 65536.0f, veci16_t);
+    texture_sampler_run(job);
+
+    veci16_t packedColor = *reinterpret_cast<const veci16_t*>(job->result);
+    const float kOneOver255 = 1.0 / 255.0;
+    outColor[0] = __builtin_convertvector(packedColor & 255, vecf16_t) * kOneOver255;
+    outColor[1] = __builtin_convertvector((packedColor >> 8) & 255, vecf16_t)
+                  * kOneOver255;
+    outColor[2] = __builtin_convertvector((packedColor >> 16) & 255, vecf16_t)
+                  * kOneOver255;
+    outColor[3] = __builtin_convertvector((packedColor >> 24) & 255, vecf16_t)
+                  * kOneOver255;
+}
+
 } // namespace librender
@@ -55,9 +55,21 @@ public:
         fEnableBilinearFiltering = enable;
     }
 
+    // If enable is true and the processor has texture samplers, use them to
+    // read RGBA8888 and GRAY8 surfaces. Mip level selection and coordinate
+    // wrapping are still done in software. The hardware computes 8 bits per
+    // channel and uses 8 bit bilinear weights, so colors may differ slightly
+    // from the software path.
+    void enableHardwareSampling(bool enable);
+
 private:
+    void readPixelsHardware(const Surface *surface, vecf16_t uRaster,
+                            vecf16_t vRaster, vmask_t mask,
+                            vecf16_t *outColor) const;
+
     const Surface *fMipSurfaces[kMaxMipLevels];
     bool fEnableBilinearFiltering = false;
+    bool fEnableHardwareSampling = false;
     int fBaseMipBits = 0;
     int fMaxMipLevel = 0;
 };
@@ -157,6 +157,11 @@ void TriangleFiller::fillMasked(int left, int top, vmask_t mask)
             return; // All pixels are occluded
 
         fTarget->getDepthBuffer()->writeBlockMasked(left, top, mask, vecu16_t(zValues));
+        if (fCoarseDepth)
+        {
+            fCoarseDepth->update(left, top, __builtin_nyuzi_vector_mixf(mask, zValues,
+                                 depthBufferValues));
+        }
     }
 
     // Interpolate parameters
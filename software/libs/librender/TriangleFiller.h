@@ -18,6 +18,7 @@
 #pragma once
 
 #include <stdint.h>
+#include "CoarseDepth.h"
 #include "LinearInterpolator.h"
 #include "RenderState.h"
 #include "RenderTarget.h"
@@ -58,12 +59,20 @@ public:
     // parameter at each of the three triangle points.
     void setUpParam(float c1, float c2, float c3);
 
+    // If set, fillMasked records the depth values it writes here so the
+    // caller can reject occluded geometry before rasterizing it.
+    void setCoarseDepth(CoarseDepth *coarseDepth)
+    {
+        fCoarseDepth = coarseDepth;
+    }
+
 private:
     void setUpInterpolator(LinearInterpolator &interpolator, float c0, float c1,
                            float c2);
 
     const RenderState *fState = nullptr;
     RenderTarget *fTarget;
+    CoarseDepth *fCoarseDepth = nullptr;
 
     // 2.0 divided by the resolution of the screen in pixels. Used to convert
     // from raster coordinates to screen space (-1.0 to 1.0).
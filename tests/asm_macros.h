@@ -49,6 +49,21 @@
 #define CR_PERF_EVENT_COUNT0_H 25
 #define CR_PERF_EVENT_COUNT1_L 26
 #define CR_PERF_EVENT_COUNT1_H 27
+#define CR_PERF_INDEX 28
+#define CR_PERF_DATA 29
+#define CR_PREFETCH_CONTROL 30
+#define CR_WAIT_FOR_WRITE 31
+
+// Performance counter fields (CR_PERF_INDEX bits 9:8)
+#define PERF_FIELD_CONTROL 0
+#define PERF_FIELD_COUNT_L 1
+#define PERF_FIELD_COUNT_H 2
+
+// Performance counter control word bits
+#define PERF_CONTROL_THREAD_SHIFT 8
+#define PERF_CONTROL_INT_EN (1 << 30)
+#define PERF_CONTROL_OVERFLOW (1 << 31)
+#define INT_PERF_COUNTER 15
 
 // Trap types
 #define TT_RESET 0
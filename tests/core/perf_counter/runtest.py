@@ -20,6 +20,8 @@ import sys
 sys.path.insert(0, '../..')
 import test_harness
 
-test_harness.register_generic_assembly_tests(['perf_counter.S'],
-    ['verilator', 'fpga'])
+test_harness.register_generic_assembly_tests([
+    'perf_counter.S',
+    'perf_overflow.S'
+], ['emulator', 'verilator', 'fpga'])
 test_harness.execute_tests()
@@ -181,6 +181,50 @@ def generate_unary_arith(outfile):
             else:
                 outfile.write('        {} s{}, s{}\n'.format(mnemonic, dest, rega))
 
+# The assembler doesn't know the divide instructions yet, so these are
+# encoded directly. Values are the Format R fmt field and register prefixes.
+DIVIDE_FORMS = [
+    (0, 's', 's', 's', False),
+    (1, 'v', 'v', 's', False),
+    (2, 'v', 'v', 's', True),
+    (4, 'v', 'v', 'v', False),
+    (5, 'v', 'v', 'v', True)
+]
+
+DIVIDE_OPS = [
+    ('div_i', 0x32),
+    ('div_u', 0x33),
+    ('rem_i', 0x34),
+    ('rem_u', 0x35)
+]
+
+
+def generate_divide(outfile):
+    """Write a single integer divide or remainder instruction to a file.
+
+    Args:
+        outfile: File
+           File that the instruction should be appended to.
+
+    Returns:
+        Nothing
+    """
+
+    mnemonic, opcode = random.choice(DIVIDE_OPS)
+    fmt, typed, typea, typeb, masked = random.choice(DIVIDE_FORMS)
+    dest = generate_arith_reg()
+    rega = generate_arith_reg()
+    regb = generate_arith_reg()
+    maskreg = generate_arith_reg() if masked else 0
+    encoding = (0xc0000000 | (fmt << 26) | (opcode << 20) | (regb << 15)
+                | (maskreg << 10) | (dest << 5) | rega)
+    comment = '{}{} {}{}, '.format(mnemonic, '_mask' if masked else '', typed, dest)
+    if masked:
+        comment += 's{}, '.format(maskreg)
+
+    comment += '{}{}, {}{}'.format(typea, rega, typeb, regb)
+    outfile.write('        .long 0x{:08x}    # {}\n'.format(encoding, comment))
+
 COMPARE_FORMS = [
     ('v', 'v'),
     ('v', 's'),
@@ -397,7 +441,8 @@ def generate_cache_control(outfile):
 
 GENERATE_FUNCS = [
     (0.1, generate_computed_pointer),
-    (0.5, generate_binary_arith),
+    (0.48, generate_binary_arith),
+    (0.02, generate_divide),
     (0.05, generate_unary_arith),
     (0.1, generate_compare),
     (0.2, generate_memory_access),
@@ -0,0 +1,123 @@
+//
+// Copyright 2019 Jeff Bush
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include <dma.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+//
+// Check copies and fills by the DMA engine, including rows that aren't
+// aligned to cache lines, and that bytes outside the destination are not
+// modified.
+//
+
+#define BUF_SIZE 1024
+#define GUARD 0xa5a5a5a5
+
+static unsigned int src_buf[BUF_SIZE / 4] __attribute__((aligned(64)));
+static unsigned int dest_buf[BUF_SIZE / 4] __attribute__((aligned(64)));
+
+static void reset_buffers(void)
+{
+    for (int i = 0; i < BUF_SIZE / 4; i++)
+    {
+        src_buf[i] = i * 0x01010101 + 0x12345678;
+        dest_buf[i] = GUARD;
+    }
+}
+
+static void check_word(int index, unsigned int expected)
+{
+    if (dest_buf[index] != expected)
+    {
+        printf("FAIL: word %d want %08x got %08x\n", index, expected,
+               dest_buf[index]);
+        exit(1);
+    }
+}
+
+// Words are indices into the buffers. Strides are in words.
+static void check_copy(int dest_start, int dest_stride, int src_start,
+                       int src_stride, int row_words, int rows)
+{
+    for (int i = 0; i < BUF_SIZE / 4; i++)
+    {
+        int row = (i - dest_start) / dest_stride;
+        int col = (i - dest_start) % dest_stride;
+        if (i >= dest_start && row < rows && col < row_words)
+            check_word(i, src_buf[src_start + row * src_stride + col]);
+        else
+            check_word(i, GUARD);
+    }
+}
+
+static void check_fill(int dest_start, int dest_stride, unsigned int value,
+                       int row_words, int rows)
+{
+    for (int i = 0; i < BUF_SIZE / 4; i++)
+    {
+        int row = (i - dest_start) / dest_stride;
+        int col = (i - dest_start) % dest_stride;
+        if (i >= dest_start && row < rows && col < row_words)
+            check_word(i, value);
+        else
+            check_word(i, GUARD);
+    }
+}
+
+int main()
+{
+    // Linear copy, starts and ends in the middle of cache lines
+    reset_buffers();
+    dma_copy(dest_buf + 3, src_buf + 3, 200 * 4);
+    dma_wait();
+    check_copy(3, BUF_SIZE / 4, 3, BUF_SIZE / 4, 200, 1);
+
+    // Different offsets into cache lines (copied by the CPU)
+    reset_buffers();
+    dma_copy(dest_buf + 1, src_buf + 2, 20 * 4);
+    dma_wait();
+    check_copy(1, BUF_SIZE / 4, 2, BUF_SIZE / 4, 20, 1);
+
+    // 2D copy with different strides
+    reset_buffers();
+    dma_copy_2d(dest_buf + 18, 48 * 4, src_buf + 2, 32 * 4, 20 * 4, 4, 0);
+    dma_wait();
+    check_copy(18, 48, 2, 32, 20, 4);
+
+    // Linear fill
+    reset_buffers();
+    dma_fill(dest_buf + 5, 0xdeadbeef, 100 * 4);
+    dma_wait();
+    check_fill(5, BUF_SIZE / 4, 0xdeadbeef, 100, 1);
+
+    // 2D fill, rows narrower than a cache line
+    reset_buffers();
+    dma_fill_2d(dest_buf + 1, 40 * 4, 0x11223344, 6 * 4, 5, 0);
+    dma_wait();
+    check_fill(1, 40, 0x11223344, 6, 5);
+
+    // Empty transfer
+    reset_buffers();
+    dma_fill_2d(dest_buf, 16 * 4, 0, 16 * 4, 0, 0);
+    dma_wait();
+    check_fill(0, BUF_SIZE / 4, 0, 0, 0);
+
+    printf("PASS\n");
+
+    return 0;
+}
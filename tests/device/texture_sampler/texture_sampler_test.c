@@ -0,0 +1,139 @@
+//
+// Copyright 2019 Jeff Bush
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <texture_sampler.h>
+
+//
+// Run texture sampler jobs with pseudorandom coordinates and compare the
+// results to a model of the filter. The textures aren't powers of two in
+// size, and have padding at the end of each row.
+//
+
+#define WIDTH 13
+#define HEIGHT 7
+#define STRIDE 64
+#define GUARD 0xa5a5a5a5
+
+static unsigned char texture[HEIGHT * STRIDE] __attribute__((aligned(64)));
+static unsigned int seed = 1;
+
+static unsigned int next_random(void)
+{
+    seed = seed * 1103515245 + 12345;
+    return seed >> 8;
+}
+
+static unsigned int expected_color(const struct texture_job *job, int lane)
+{
+    unsigned int x[2];
+    unsigned int y[2];
+    unsigned int fu = (job->u[lane] >> 8) & 0xff;
+    unsigned int fv = (job->v[lane] >> 8) & 0xff;
+    unsigned int color = 0;
+
+    x[0] = job->u[lane] >> 16;
+    y[0] = job->v[lane] >> 16;
+    x[1] = x[0] + 1 == job->width ? 0 : x[0] + 1;
+    y[1] = y[0] + 1 == job->height ? 0 : y[0] + 1;
+    for (int channel = 0; channel < 4; channel++)
+    {
+        unsigned int sum = 0;
+        for (int texel = 0; texel < 4; texel++)
+        {
+            unsigned int weight;
+            unsigned int offset;
+
+            if (job->flags & TEXTURE_BILINEAR)
+                weight = ((texel & 1) ? fu : 256 - fu) * ((texel & 2) ? fv : 256 - fv);
+            else
+                weight = texel == 0 ? 0x10000 : 0;
+
+            offset = y[texel >> 1] * STRIDE;
+            if (job->format == TEXTURE_GRAY8)
+                offset += x[texel & 1];
+            else
+                offset += x[texel & 1] * 4 + channel;
+
+            sum += texture[offset] * weight;
+        }
+
+        color |= ((sum + 0x8000) >> 16) << (channel * 8);
+    }
+
+    return color;
+}
+
+static void run_job(unsigned int format, unsigned int flags, unsigned int lane_mask)
+{
+    struct texture_job *job = texture_sampler_job();
+
+    job->base = (unsigned int) texture;
+    job->width = format == TEXTURE_GRAY8 ? WIDTH * 4 : WIDTH;
+    job->height = HEIGHT;
+    job->stride = STRIDE;
+    job->format = format;
+    job->flags = flags;
+    job->lane_mask = lane_mask;
+    for (int lane = 0; lane < 16; lane++)
+    {
+        job->u[lane] = next_random() % (job->width << 16);
+        job->v[lane] = next_random() % (job->height << 16);
+        job->result[lane] = GUARD;
+    }
+
+    texture_sampler_run(job);
+
+    for (int lane = 0; lane < 16; lane++)
+    {
+        unsigned int expected = (lane_mask & (1 << lane)) ? expected_color(job, lane)
+                                : GUARD;
+        if (job->result[lane] != expected)
+        {
+            printf("FAIL: format %u flags %u lane %d (%08x, %08x) want %08x got %08x\n",
+                   format, flags, lane, job->u[lane], job->v[lane], expected,
+                   job->result[lane]);
+            exit(1);
+        }
+    }
+}
+
+int main()
+{
+    if (!texture_sampler_present())
+    {
+        printf("FAIL: no texture sampler\n");
+        return 1;
+    }
+
+    for (int i = 0; i < HEIGHT * STRIDE; i++)
+        texture[i] = next_random();
+
+    for (int i = 0; i < 4; i++)
+    {
+        run_job(TEXTURE_RGBA8888, TEXTURE_BILINEAR, 0xffff);
+        run_job(TEXTURE_RGBA8888, 0, 0xffff);
+        run_job(TEXTURE_GRAY8, TEXTURE_BILINEAR, 0xffff);
+        run_job(TEXTURE_GRAY8, 0, 0xffff);
+        run_job(TEXTURE_RGBA8888, TEXTURE_BILINEAR, next_random() & 0xffff);
+    }
+
+    printf("PASS\n");
+
+    return 0;
+}
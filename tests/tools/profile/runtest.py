@@ -33,29 +33,30 @@ def profile(*unused):
 
     test_harness.run_program(hexfile, 'verilator', profile_file=profile_file)
 
-    symbol_file = os.path.join(test_harness.WORK_DIR, 'symbols.txt')
-    objdump_args = [
-        os.path.join(test_harness.COMPILER_BIN_DIR, 'llvm-objdump'),
-        '-t', elffile
-    ]
-    symbols = subprocess.check_output(objdump_args)
-    with open(symbol_file, 'w') as f:
-        f.write(symbols.decode())
-
     profile_args = [
-        os.path.join(test_harness.TOOL_BIN_DIR, 'profile.py'),
-        symbol_file,
+        os.path.join(test_harness.TOOL_BIN_DIR, 'nyuzi_profile'),
+        '-t',
+        elffile,
         profile_file
     ]
-    profile_output = subprocess.check_output(' '.join(profile_args), shell=True)
-    profile_lines = profile_output.decode().split('\n')
-    profile_tuples = [line.split() for line in profile_lines if line]
-    profile_map = {func: int(count) for count, _, func in profile_tuples}
+    profile_output = subprocess.check_output(profile_args).decode()
+
+    # Function lines are: samples %total issue ready icache dcache depend wbconf name
+    # Only the main thread is running, so all other threads should show as halted.
+    profile_map = {}
+    thread_lines = []
+    for line in profile_output.split('\n'):
+        fields = line.split()
+        if len(fields) == 9 and fields[0].isdigit():
+            profile_map[fields[8]] = int(fields[0])
+        elif 'core 0 thread' in line:
+            thread_lines.append(line)
+
+    test_harness.assert_equal(1, len(thread_lines))
 
-    # These tests don't end up being exactly 2x the number of samples. Because
-    # the system samples randomly, it can vary. I could have ran the test longer
-    # to get more samples, but this is really just a smoke test and I didn't want
-    # to bloat the test time unnecessarily.
+    # These tests don't end up being exactly 2x the number of samples, because
+    # of the setup and call overhead in each function and samples that fall
+    # on the loop boundaries.
     loop5k = profile_map['loop5000']
     loop10k = profile_map['loop10000']
     loop20k = profile_map['loop20000']
@@ -46,7 +46,7 @@ module test_control_registers(input clk, input reset);
     localparam JTAG_DATA_VAL1 = 32'h7fc44607;
 
     localparam EVENT_IDX_WIDTH = $clog2(CORE_PERF_EVENTS);
-    localparam NUM_PERF_COUNTERS = 2;
+    localparam NUM_PERF_COUNTERS = 4;
 
     logic [NUM_INTERRUPTS - 1:0] interrupt_req;
     scalar_t cr_eret_address[`THREADS_PER_CORE];
@@ -77,16 +77,21 @@ module test_control_registers(input clk, input reset);
     syscall_index_t wb_syscall_index;
     logic[TOTAL_THREADS - 1:0] cr_suspend_thread;
     logic[TOTAL_THREADS - 1:0] cr_resume_thread;
-    logic[EVENT_IDX_WIDTH - 1:0] cr_perf_event_select0;
-    logic[EVENT_IDX_WIDTH - 1:0] cr_perf_event_select1;
-    logic[63:0] perf_event_count0;
-    logic[63:0] perf_event_count1;
+    logic[NUM_PERF_COUNTERS - 1:0][EVENT_IDX_WIDTH - 1:0] cr_perf_event_select;
+    local_thread_bitmap_t cr_perf_thread_mask[NUM_PERF_COUNTERS];
+    logic[NUM_PERF_COUNTERS - 1:0] cr_perf_count_write_en;
+    logic cr_perf_count_write_high;
+    scalar_t cr_perf_count_write_val;
+    logic[NUM_PERF_COUNTERS - 1:0][63:0] perf_event_count;
+    logic[NUM_PERF_COUNTERS - 1:0] perf_event_overflow;
+    prefetch_control_t cr_prefetch_control;
     int cycle;
 
     control_registers #(
         .CORE_ID(4'd0),
         .NUM_INTERRUPTS(NUM_INTERRUPTS),
-        .NUM_PERF_EVENTS(CORE_PERF_EVENTS)
+        .NUM_PERF_EVENTS(CORE_PERF_EVENTS),
+        .NUM_PERF_COUNTERS(NUM_PERF_COUNTERS)
     ) control_registers(.*);
 
     task write_creg(input control_register_t index, input int value);
@@ -117,6 +122,7 @@ module test_control_registers(input clk, input reset);
             cycle <= 0;
             dt_thread_idx <= 0;
             interrupt_req <= '0;
+            perf_event_overflow <= '0;
         end
         else
         begin
@@ -126,6 +132,7 @@ module test_control_registers(input clk, input reset);
             wb_trap <= 0;
             wb_eret <= 0;
             ocd_data_update <= 0;
+            perf_event_overflow <= '0;
 
             // There are deliberately gaps in the cycle count sequences below
             // to make it easier to add new actions to the test.
@@ -683,11 +690,12 @@ module test_control_registers(input clk, input reset);
 
                 183:
                 begin
-                    assert(cr_perf_event_select0 == 7);
-                    assert(cr_perf_event_select1 == 13);
+                    assert(cr_perf_event_select[0] == 7);
+                    assert(cr_perf_event_select[1] == 13);
 
-                    perf_event_count0 <= 64'he0e0f196_27c12181;
-                    perf_event_count1 <= 64'h9e4325b2_82300d10;
+                    perf_event_count[0] <= 64'he0e0f196_27c12181;
+                    perf_event_count[1] <= 64'h9e4325b2_82300d10;
+                    perf_event_count[3] <= 64'h5c8d1e07_a31b62f4;
                 end
 
                 // wait a cycle
@@ -726,8 +734,146 @@ module test_control_registers(input clk, input reset);
                     assert(cr_creg_read_val == 32'h9e4325b2);
                 end
 
+                ////////////////////////////////////////////////////////////
+                // Indirect performance counter access and overflow interrupt
+                ////////////////////////////////////////////////////////////
                 194:
                 begin
+                    assert(cr_perf_thread_mask[3] == '1);
+                    write_creg(CR_PERF_INDEX, 32'h003);   // Counter 3, control
+                end
+
+                // wait a cycle
+
+                // Event 9, threads 0 & 2, interrupt enable
+                196: write_creg(CR_PERF_DATA, 32'h40000509);
+
+                // wait a cycle
+
+                198:
+                begin
+                    assert(cr_perf_event_select[3] == 9);
+                    assert(cr_perf_thread_mask[3] == 4'b0101);
+                    assert(cr_perf_event_select[0] == 7);
+                    read_creg(CR_PERF_DATA);
+                end
+
+                // wait a cycle
+
+                200:
+                begin
+                    assert(cr_creg_read_val == 32'h40000509);
+                    write_creg(CR_PERF_INDEX, 32'h203);   // Counter 3, count high
+                end
+
+                // wait a cycle
+
+                202: read_creg(CR_PERF_DATA);
+
+                // wait a cycle
+
+                204:
+                begin
+                    assert(cr_creg_read_val == 32'h5c8d1e07);
+                    write_creg(CR_PERF_INDEX, 32'h103);   // Counter 3, count low
+                end
+
+                // wait a cycle
+
+                206: write_creg(CR_PERF_DATA, 32'hfffffffd);
+
+                207:
+                begin
+                    // Count writes are passed through to performance_counters
+                    assert(cr_perf_count_write_en == 4'b1000);
+                    assert(!cr_perf_count_write_high);
+                    assert(cr_perf_count_write_val == 32'hfffffffd);
+                    read_creg(CR_PERF_INDEX);
+                end
+
+                208:
+                begin
+                    assert(cr_perf_count_write_en == 4'b0000);
+                    write_creg(CR_INTERRUPT_ENABLE, 32'h8000);
+                end
+
+                209: assert(cr_creg_read_val == 32'h103);
+
+                210:
+                begin
+                    assert(cr_interrupt_pending[0] == 0);
+                    perf_event_overflow <= 4'b1000;
+                end
+
+                // wait two cycles for overflow to be latched
+
+                213:
+                begin
+                    assert(cr_interrupt_pending[0] == 1);
+                    read_creg(CR_INTERRUPT_PENDING);
+                end
+
+                // wait a cycle
+
+                215:
+                begin
+                    assert(cr_creg_read_val == 32'h8000);
+                    write_creg(CR_PERF_INDEX, 32'h003);
+                end
+
+                // wait a cycle
+
+                217: read_creg(CR_PERF_DATA);
+
+                // wait a cycle
+
+                219:
+                begin
+                    assert(cr_creg_read_val == 32'hc0000509);
+                    assert(cr_interrupt_pending[0] == 1);
+
+                    // Clear overflow
+                    write_creg(CR_PERF_DATA, 32'h40000509);
+                end
+
+                // wait a cycle
+
+                221: assert(cr_interrupt_pending[0] == 0);
+
+                ////////////////////////////////////////////////////////////
+                // Prefetch control
+                ////////////////////////////////////////////////////////////
+                222:
+                begin
+                    // Reset value
+                    assert(cr_prefetch_control.dcache_en);
+                    assert(cr_prefetch_control.dcache_distance == 2);
+                    assert(cr_prefetch_control.icache_en);
+                    read_creg(CR_PREFETCH_CONTROL);
+                end
+
+                // wait a cycle
+
+                224:
+                begin
+                    assert(cr_creg_read_val == 32'h121);
+
+                    // Undefined bits are ignored
+                    write_creg(CR_PREFETCH_CONTROL, 32'hfffffe50);
+                end
+
+                225: read_creg(CR_PREFETCH_CONTROL);
+
+                226:
+                begin
+                    assert(!cr_prefetch_control.dcache_en);
+                    assert(cr_prefetch_control.dcache_distance == 5);
+                    assert(!cr_prefetch_control.icache_en);
+                end
+
+                227:
+                begin
+                    assert(cr_creg_read_val == 32'h50);
                     $display("PASS");
                     $finish;
                 end
@@ -21,6 +21,7 @@ import defines::*;
 module test_dcache_data_stage(input clk, input reset);
     localparam NORMAL_ADDR = 'h80000020;
     localparam IO_ADDR = 'hffff0010;
+    localparam SCRATCHPAD_ADDR = 'hfffe0040;
 
     local_thread_bitmap_t dd_load_sync_pending;
     logic dt_instruction_valid;
@@ -35,10 +36,16 @@ module test_dcache_data_stage(input clk, input reset);
     logic dt_tlb_writable;
     vector_t dt_store_value;
     subcycle_t dt_subcycle;
+    vector_mask_t dt_scgath_lane_mask;
+    scgath_word_idx_t dt_scgath_word_idx;
+    logic dt_scgath_covered;
+    logic dt_scgath_run_done;
     logic dt_valid[`L1D_WAYS];
     l1d_tag_t dt_tag[`L1D_WAYS];
+    logic dt_prefetched[`L1D_WAYS];
     logic dd_update_lru_en;
     l1d_way_idx_t dd_update_lru_way;
+    logic dd_prefetch_hit;
     logic dd_io_write_en;
     logic dd_io_read_en;
     local_thread_idx_t dd_io_thread_idx;
@@ -50,11 +57,15 @@ module test_dcache_data_stage(input clk, input reset);
     local_thread_idx_t dd_thread_idx;
     l1d_addr_t dd_request_vaddr;
     subcycle_t dd_subcycle;
+    scgath_word_idx_t dd_scgath_word_idx;
+    logic dd_scgath_covered;
+    logic dd_scgath_run_done;
     logic dd_rollback_en;
     scalar_t dd_rollback_pc;
     cache_line_data_t dd_load_data;
     logic dd_suspend_thread;
     logic dd_io_access;
+    logic dd_scratchpad_access;
     logic dd_trap;
     trap_cause_t dd_trap_cause;
     logic cr_supervisor_en[`THREADS_PER_CORE];
@@ -73,6 +84,7 @@ module test_dcache_data_stage(input clk, input reset);
     cache_line_index_t dd_cache_miss_addr;
     local_thread_idx_t dd_cache_miss_thread_idx;
     logic dd_cache_miss_sync;
+    scalar_t dd_cache_miss_pc;
     logic dd_store_en;
     logic dd_flush_en;
     logic dd_membar_en;
@@ -85,12 +97,16 @@ module test_dcache_data_stage(input clk, input reset);
     logic dd_store_sync;
     cache_line_index_t dd_store_bypass_addr;
     local_thread_idx_t dd_store_bypass_thread_idx;
+    logic dd_wait_en;
+    local_thread_idx_t dd_wait_thread_idx;
     logic wb_rollback_en;
     local_thread_idx_t wb_rollback_thread_idx;
     pipeline_sel_t wb_rollback_pipeline;
     logic dd_perf_dcache_hit;
     logic dd_perf_dcache_miss;
     logic dd_perf_dtlb_miss;
+    logic dd_perf_dcache_prefetch_hit;
+    cache_line_data_t scratchpad_line;
     int cycle;
 
     dcache_data_stage dcache_data_stage(.*);
@@ -142,6 +158,10 @@ module test_dcache_data_stage(input clk, input reset);
             dt_thread_idx <= '0;
             dt_store_value <= '0;
             dt_subcycle <= '0;
+            dt_scgath_lane_mask <= '0;
+            dt_scgath_word_idx <= '0;
+            dt_scgath_covered <= '0;
+            dt_scgath_run_done <= '0;
 
             for (int i = 0; i < `THREADS_PER_CORE; i++)
                 cr_supervisor_en[i] <= '0;
@@ -171,6 +191,7 @@ module test_dcache_data_stage(input clk, input reset);
             begin
                 dt_valid[i] <= '0;
                 dt_tag[i] <= '0;
+                dt_prefetched[i] <= '0;
             end
 
             cycle <= cycle + 1;
@@ -1904,6 +1925,7 @@ module test_dcache_data_stage(input clk, input reset);
                     dt_instruction.memory_access <= 1;
                     dt_instruction.memory_access_type <= MEM_SCGATH_M;
                     dt_mask_value <= 16'h8000;
+                    dt_scgath_lane_mask <= 16'h8000;
                     dt_subcycle <= 15;
                 end
 
@@ -1931,6 +1953,44 @@ module test_dcache_data_stage(input clk, input reset);
                     assert(!dd_perf_dtlb_miss);
                 end
 
+                ////////////////////////////////////////////////////////////
+                // Scatter store with two lanes coalesced into one access.
+                // Lanes 1 and 2 write words 3 and 5 of the same line.
+                ////////////////////////////////////////////////////////////
+                235:
+                begin
+                    cache_hit(32'h80000000, 0);
+                    dt_instruction.memory_access_type <= MEM_SCGATH_M;
+                    dt_mask_value <= 16'h0006;
+                    dt_scgath_lane_mask <= 16'h0006;
+                    dt_scgath_word_idx[1] <= 3;
+                    dt_scgath_word_idx[2] <= 5;
+                    dt_store_value[14] <= 32'h11223344;
+                    dt_store_value[13] <= 32'h55667788;
+                    dt_subcycle <= 1;
+                end
+
+                236:
+                begin
+                    dt_instruction_valid <= 0;
+                    dt_scgath_lane_mask <= '0;
+                    assert(dd_store_en);
+                    assert(dd_store_mask == 64'h000f0f0000000000);
+                    assert(dd_store_data[384+:32] == 32'h44332211);
+                    assert(dd_store_data[320+:32] == 32'h88776655);
+                    assert(!dd_cache_miss);
+                    assert(!dd_trap);
+                end
+
+                237:
+                begin
+                    assert(dd_instruction_valid);
+                    assert(dd_lane_mask == 16'h0006);
+                    assert(dd_scgath_word_idx[1] == 3);
+                    assert(dd_scgath_word_idx[2] == 5);
+                    assert(!dd_rollback_en);
+                end
+
                 ////////////////////////////////////////////////////////////
                 // Cache near miss
                 ////////////////////////////////////////////////////////////
@@ -2062,7 +2122,153 @@ module test_dcache_data_stage(input clk, input reset);
                     assert(!dd_perf_dtlb_miss);
                 end
 
+                ////////////////////////////////////////////////////////////
+                // Load hits a prefetched line
+                ////////////////////////////////////////////////////////////
                 256:
+                begin
+                    cache_hit(NORMAL_ADDR, 1);
+                    for (int i = 0; i < `L1D_WAYS; i++)
+                        dt_prefetched[i] <= 1;
+                end
+
+                257:
+                begin
+                    assert(dd_update_lru_en);
+                    assert(dd_prefetch_hit);
+                    assert(!dd_cache_miss);
+                end
+
+                258:
+                begin
+                    assert(!dd_rollback_en);
+                    assert(dd_perf_dcache_hit);
+                    assert(dd_perf_dcache_prefetch_hit);
+
+                    // Line was not prefetched
+                    cache_hit(NORMAL_ADDR, 1);
+                end
+
+                259:
+                begin
+                    assert(dd_update_lru_en);
+                    assert(!dd_prefetch_hit);
+                end
+
+                260:
+                begin
+                    assert(dd_perf_dcache_hit);
+                    assert(!dd_perf_dcache_prefetch_hit);
+                end
+
+                ////////////////////////////////////////////////////////////
+                // Wait for write. Allowed in user mode, suspends the thread
+                // and resumes at the next instruction.
+                ////////////////////////////////////////////////////////////
+                261:
+                begin
+                    dt_instruction_valid <= 1;
+                    dt_instruction.memory_access <= 1;
+                    dt_instruction.memory_access_type <= MEM_CONTROL_REG;
+                    dt_instruction.creg_index <= CR_WAIT_FOR_WRITE;
+                    dt_instruction.pc <= 32'h1000;
+                    dt_thread_idx <= 2;
+                end
+
+                262:
+                begin
+                    assert(dd_wait_en);
+                    assert(dd_wait_thread_idx == 2);
+                    assert(!dd_cache_miss);
+                end
+
+                263:
+                begin
+                    assert(dd_instruction_valid);
+                    assert(!dd_trap);
+                    assert(dd_rollback_en);
+                    assert(dd_suspend_thread);
+                    assert(dd_rollback_pc == 32'h1004);
+
+                    // Other control registers are still privileged
+                    dt_instruction_valid <= 1;
+                    dt_instruction.memory_access <= 1;
+                    dt_instruction.memory_access_type <= MEM_CONTROL_REG;
+                    dt_instruction.creg_index <= CR_PREFETCH_CONTROL;
+                end
+
+                264:
+                begin
+                    assert(!dd_wait_en);
+                    assert(!dd_creg_write_en);
+                end
+
+                265:
+                begin
+                    assert(dd_trap);
+                    assert(!dd_rollback_en);
+                    assert(!dd_suspend_thread);
+                    dt_thread_idx <= 0;
+                end
+
+                ////////////////////////////////////////////////////////////
+                // Scratchpad block store and load. These don't use the
+                // cache or store queue and never roll back.
+                ////////////////////////////////////////////////////////////
+                266:
+                begin
+                    cache_miss(SCRATCHPAD_ADDR, 0);
+                    dt_instruction.memory_access_type <= MEM_BLOCK;
+                    dt_tlb_writable <= 1;
+                    for (int i = 0; i < NUM_VECTOR_LANES; i++)
+                        dt_store_value[i] <= 32'h01020304 * i;
+                end
+
+                267:
+                begin
+                    assert(!dd_store_en);
+                    assert(!dd_cache_miss);
+                    assert(!dd_update_lru_en);
+                    assert(!dd_io_write_en);
+                    scratchpad_line <= dd_store_data;
+
+                    cache_miss(SCRATCHPAD_ADDR, 1);
+                    dt_instruction.memory_access_type <= MEM_BLOCK;
+                end
+
+                268:
+                begin
+                    assert(dd_instruction_valid);
+                    assert(dd_scratchpad_access);
+                    assert(!dd_trap);
+                    assert(!dd_rollback_en);
+                    assert(!dd_suspend_thread);
+                    assert(!dd_cache_miss);
+                    assert(!dd_update_lru_en);
+                end
+
+                269:
+                begin
+                    assert(dd_instruction_valid);
+                    assert(dd_scratchpad_access);
+                    assert(!dd_trap);
+                    assert(!dd_rollback_en);
+                    assert(!dd_suspend_thread);
+                    assert(!dd_perf_dcache_miss);
+                    assert(dd_load_data == scratchpad_line);
+
+                    // Unaligned block access faults
+                    cache_miss(SCRATCHPAD_ADDR + 4, 1);
+                    dt_instruction.memory_access_type <= MEM_BLOCK;
+                end
+
+                271:
+                begin
+                    assert(dd_trap);
+                    assert(dd_trap_cause.trap_type == TT_UNALIGNED_ACCESS);
+                end
+
+                272:
                 begin
                     $display("PASS");
                     $finish;
@@ -0,0 +1,280 @@
+//
+// Copyright 2019 Jeff Bush
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+`include "defines.svh"
+
+import defines::*;
+
+//
+// Runs copies and fills against a simple model of the L2 cache, which
+// responds to each request on the cycle after it is accepted.
+//
+module test_dma_engine(input clk, input reset);
+    localparam NUM_LINES = 64;
+    localparam LINE_IDX_WIDTH = $clog2(NUM_LINES);
+    localparam REG_SRC = 0;
+    localparam REG_DEST = 1;
+    localparam REG_ROW_BYTES = 2;
+    localparam REG_ROWS = 3;
+    localparam REG_SRC_STRIDE = 4;
+    localparam REG_DEST_STRIDE = 5;
+    localparam REG_FILL_VALUE = 6;
+    localparam REG_CONTROL = 7;
+    localparam REG_STATUS = 8;
+
+    localparam COPY_SRC = 'h88;
+    localparam COPY_DEST = 'h288;
+    localparam COPY_ROW_BYTES = 'h50;
+    localparam COPY_STRIDE = 'h100;
+    localparam FILL_DEST = 'h804;
+    localparam FILL_VALUE = 32'h11223344;
+    localparam FLUSH_DEST = 'h900;
+
+    logic ii_dma_write_en;
+    logic[3:0] ii_dma_reg;
+    scalar_t ii_dma_write_data;
+    scalar_t dma_read_data;
+    logic dma_l2_request_valid;
+    l2req_packet_t dma_l2_request;
+    logic l2_dma_ready;
+    logic l2_response_valid;
+    l2rsp_packet_t l2_response;
+    logic dma_interrupt;
+    cache_line_data_t memory[NUM_LINES];
+    logic line_flushed[NUM_LINES];
+    int flush_count;
+    int state;
+
+    dma_engine dma_engine(.*);
+
+    assign l2_dma_ready = 1;
+
+    function logic[7:0] read_byte(input int address);
+        return memory[LINE_IDX_WIDTH'(address / CACHE_LINE_BYTES)][(CACHE_LINE_BYTES - 1
+            - (address % CACHE_LINE_BYTES)) * 8+:8];
+    endfunction
+
+    task write_reg(input int register_idx, input scalar_t value);
+        ii_dma_write_en <= 1;
+        ii_dma_reg <= 4'(register_idx);
+        ii_dma_write_data <= value;
+    endtask
+
+    // L2 cache model
+    always @(posedge clk, posedge reset)
+    begin
+        if (reset)
+        begin
+            // Each byte contains the low bits of its address
+            for (int line = 0; line < NUM_LINES; line++)
+            begin
+                for (int offset = 0; offset < CACHE_LINE_BYTES; offset++)
+                    memory[line][(CACHE_LINE_BYTES - 1 - offset) * 8+:8] <= 8'(line * CACHE_LINE_BYTES + offset);
+            end
+
+            for (int line = 0; line < NUM_LINES; line++)
+                line_flushed[line] <= 0;
+
+            l2_response_valid <= 0;
+            flush_count <= 0;
+        end
+        else
+        begin
+            l2_response_valid <= dma_l2_request_valid;
+            if (dma_l2_request_valid)
+            begin
+                assert(dma_l2_request.dma);
+                assert(dma_l2_request.cache_type == CT_DCACHE);
+                l2_response <= '0;
+                l2_response.dma <= 1;
+                l2_response.address <= dma_l2_request.address;
+                if (dma_l2_request.packet_type == L2REQ_LOAD)
+                begin
+                    l2_response.packet_type <= L2RSP_LOAD_ACK;
+                    l2_response.data <= memory[LINE_IDX_WIDTH'(dma_l2_request.address)];
+                end
+                else if (dma_l2_request.packet_type == L2REQ_FLUSH)
+                begin
+                    l2_response.packet_type <= L2RSP_FLUSH_ACK;
+                    line_flushed[LINE_IDX_WIDTH'(dma_l2_request.address)] <= 1;
+                    flush_count <= flush_count + 1;
+                end
+                else
+                begin
+                    assert(dma_l2_request.packet_type == L2REQ_STORE);
+
+                    // Stores must not happen after the flush
+                    assert(!line_flushed[LINE_IDX_WIDTH'(dma_l2_request.address)]);
+                    l2_response.packet_type <= L2RSP_STORE_ACK;
+                    for (int byte_lane = 0; byte_lane < CACHE_LINE_BYTES; byte_lane++)
+                    begin
+                        if (dma_l2_request.store_mask[byte_lane])
+                        begin
+                            memory[LINE_IDX_WIDTH'(dma_l2_request.address)][byte_lane * 8+:8]
+                                <= dma_l2_request.data[byte_lane * 8+:8];
+                        end
+                    end
+                end
+            end
+        end
+    end
+
+    always @(posedge clk, posedge reset)
+    begin
+        if (reset)
+        begin
+            state <= 0;
+            ii_dma_write_en <= 0;
+            ii_dma_reg <= '0;
+            ii_dma_write_data <= '0;
+        end
+        else
+        begin
+            ii_dma_write_en <= 0;
+            unique0 case (state)
+                ////////////////////////////////////////////////////////////
+                // 2D copy, rows span two cache lines
+                ////////////////////////////////////////////////////////////
+                0: write_reg(REG_SRC, COPY_SRC);
+                1: write_reg(REG_DEST, COPY_DEST);
+                2: write_reg(REG_ROW_BYTES, COPY_ROW_BYTES);
+                3: write_reg(REG_ROWS, 2);
+                4: write_reg(REG_SRC_STRIDE, COPY_STRIDE);
+                5: write_reg(REG_DEST_STRIDE, COPY_STRIDE);
+                6: write_reg(REG_CONTROL, 2);   // Copy, interrupt enabled
+                7:
+                begin
+                    assert(!dma_interrupt);
+                    ii_dma_reg <= REG_STATUS;
+                end
+
+                8: assert(!dma_interrupt);
+
+                // Busy
+                9: assert(dma_read_data == 1);
+
+                // Wait for completion
+                10:
+                begin
+                    if (dma_interrupt)
+                    begin
+                        for (int address = COPY_DEST - 8; address < COPY_DEST
+                            + COPY_STRIDE + COPY_ROW_BYTES + 8; address++)
+                        begin
+                            if (address >= COPY_DEST && (address - COPY_DEST) % COPY_STRIDE
+                                < COPY_ROW_BYTES)
+                                assert(read_byte(address) == 8'(address - COPY_DEST + COPY_SRC));
+                            else
+                                assert(read_byte(address) == 8'(address));
+                        end
+
+                        state <= state + 1;
+                    end
+                end
+
+                // Done. Writing the status register clears the interrupt.
+                11:
+                begin
+                    assert(dma_read_data == 2);
+                    write_reg(REG_STATUS, 0);
+                end
+
+                13: assert(!dma_interrupt);
+                14: assert(dma_read_data == 0);
+
+                ////////////////////////////////////////////////////////////
+                // Fill. Interrupt is not enabled
+                ////////////////////////////////////////////////////////////
+                15: write_reg(REG_DEST, FILL_DEST);
+                16: write_reg(REG_ROW_BYTES, 8);
+                17: write_reg(REG_ROWS, 3);
+                18: write_reg(REG_DEST_STRIDE, CACHE_LINE_BYTES);
+                19: write_reg(REG_FILL_VALUE, FILL_VALUE);
+                20: write_reg(REG_CONTROL, 1);
+
+                // Writes are ignored while a transfer is in progress
+                21: write_reg(REG_DEST, 0);
+                22: ii_dma_reg <= REG_STATUS;
+
+                // Wait for completion
+                24:
+                begin
+                    assert(!dma_interrupt);
+                    if (dma_read_data == 2)
+                    begin
+                        for (int row = 0; row < 3; row++)
+                        begin
+                            assert(read_byte(FILL_DEST + row * CACHE_LINE_BYTES - 1)
+                                == 8'(FILL_DEST + row * CACHE_LINE_BYTES - 1));
+                            for (int word = 0; word < 2; word++)
+                            begin
+                                assert({read_byte(FILL_DEST + row * CACHE_LINE_BYTES + word * 4 + 3),
+                                    read_byte(FILL_DEST + row * CACHE_LINE_BYTES + word * 4 + 2),
+                                    read_byte(FILL_DEST + row * CACHE_LINE_BYTES + word * 4 + 1),
+                                    read_byte(FILL_DEST + row * CACHE_LINE_BYTES + word * 4)}
+                                    == FILL_VALUE);
+                            end
+
+                            assert(read_byte(FILL_DEST + row * CACHE_LINE_BYTES + 8)
+                                == 8'(FILL_DEST + row * CACHE_LINE_BYTES + 8));
+                        end
+
+                        ii_dma_reg <= REG_DEST;
+                        state <= state + 1;
+                    end
+                end
+
+                27: assert(dma_read_data == FILL_DEST);
+
+                ////////////////////////////////////////////////////////////
+                // Fill with flush. Each line is flushed after it is written.
+                ////////////////////////////////////////////////////////////
+                28: write_reg(REG_DEST, FLUSH_DEST);
+                29: write_reg(REG_ROW_BYTES, CACHE_LINE_BYTES + 8);
+                30: write_reg(REG_ROWS, 1);
+                31: write_reg(REG_CONTROL, 5);
+                32: ii_dma_reg <= REG_STATUS;
+
+                // Wait for completion
+                34:
+                begin
+                    if (dma_read_data == 2)
+                    begin
+                        assert(flush_count == 2);
+                        assert(line_flushed[FLUSH_DEST / CACHE_LINE_BYTES]);
+                        assert(line_flushed[FLUSH_DEST / CACHE_LINE_BYTES + 1]);
+                        assert({read_byte(FLUSH_DEST + CACHE_LINE_BYTES + 7),
+                            read_byte(FLUSH_DEST + CACHE_LINE_BYTES + 6),
+                            read_byte(FLUSH_DEST + CACHE_LINE_BYTES + 5),
+                            read_byte(FLUSH_DEST + CACHE_LINE_BYTES + 4)} == FILL_VALUE);
+                        assert(read_byte(FLUSH_DEST + CACHE_LINE_BYTES + 8)
+                            == 8'(FLUSH_DEST + CACHE_LINE_BYTES + 8));
+                        state <= state + 1;
+                    end
+                end
+
+                35:
+                begin
+                    $display("PASS");
+                    $finish;
+                end
+            endcase
+
+            if (state != 10 && state != 24 && state != 34)
+                state <= state + 1;
+        end
+    end
+endmodule
@@ -36,9 +36,13 @@ module test_ifetch_data_stage(input clk, input reset);
     logic ift_tlb_supervisor;
     l1i_tag_t ift_tag[`L1D_WAYS];
     logic ift_valid[`L1D_WAYS];
+    logic ift_prefetched[`L1I_WAYS];
+    logic ift_branch_predicted;
+    scalar_t ift_predicted_target;
     logic ifd_update_lru_en;
     l1i_way_idx_t ifd_update_lru_way;
     logic ifd_near_miss;
+    logic ifd_prefetch_hit;
     logic l2i_idata_update_en;
     l1i_way_idx_t l2i_idata_update_way;
     l1i_set_idx_t l2i_idata_update_set;
@@ -60,11 +64,16 @@ module test_ifetch_data_stage(input clk, input reset);
     logic ifd_page_fault;
     logic ifd_executable_fault;
     logic ifd_inst_injected;
+    logic ifd_branch_predicted;
+    scalar_t ifd_predicted_target;
+    logic id_redirect_en;
+    local_thread_idx_t id_redirect_thread_idx;
     logic wb_rollback_en;
     local_thread_idx_t wb_rollback_thread_idx;
     logic ifd_perf_icache_hit;
     logic ifd_perf_icache_miss;
     logic ifd_perf_itlb_miss;
+    logic ifd_perf_icache_prefetch_hit;
     logic core_selected_debug;
     logic ocd_halt;
     scalar_t ocd_inject_inst;
@@ -86,6 +95,9 @@ module test_ifetch_data_stage(input clk, input reset);
         ift_valid[1] <= 0;
         ift_valid[2] <= 0;
         ift_valid[3] <= 0;
+        for (int i = 0; i < `L1I_WAYS; i++)
+            ift_prefetched[i] <= 0;
+
         ift_tlb_present <= 1;
         ift_tlb_executable <= 1;
         ift_tlb_supervisor <= 0;
@@ -125,6 +137,11 @@ module test_ifetch_data_stage(input clk, input reset);
             cr_supervisor_en[3] <= 0;
             ocd_halt <= 0;
             core_selected_debug <= 0;
+            for (int i = 0; i < `L1I_WAYS; i++)
+                ift_prefetched[i] <= 0;
+
+            ift_predicted_target <= 0;
+            id_redirect_thread_idx <= 0;
         end
         else
         begin
@@ -133,6 +150,8 @@ module test_ifetch_data_stage(input clk, input reset);
             l2i_idata_update_en <= 0;
             l2i_itag_update_en <= 0;
             wb_rollback_en <= 0;
+            id_redirect_en <= 0;
+            ift_branch_predicted <= 0;
             core_selected_debug <= 0;
             ocd_inject_en <= 0;
             ift_tlb_hit <= 0;
@@ -316,8 +335,29 @@ module test_ifetch_data_stage(input clk, input reset);
                     // Ensure no valid instruction comes out in this case
                     assert(!ifd_cache_miss);
                     assert(!ifd_instruction_valid);
+
+                    // Hit a line that was prefetched
+                    cache_hit(VADDR0, PADDR0);
+                    ift_prefetched[0] <= 1;
+                end
+
+                17:
+                begin
+                    assert(ifd_prefetch_hit);
+                    assert(!ifd_cache_miss);
+
+                    // Hit a line that was not prefetched
+                    cache_hit(VADDR0, PADDR0);
+                end
+
+                18:
+                begin
+                    assert(!ifd_prefetch_hit);
+                    assert(ifd_perf_icache_prefetch_hit);
                 end
 
+                19: assert(!ifd_perf_icache_prefetch_hit);
+
                 ////////////////////////////////////////////////////////////
                 // Test rollbacks
                 // When a rollback occurs, this should not raise any traps.
@@ -389,6 +429,39 @@ module test_ifetch_data_stage(input clk, input reset);
                     assert(!ifd_executable_fault);
                 end
 
+                ////////////////////////////////////////////////////////////
+                // Branch prediction
+                ////////////////////////////////////////////////////////////
+                31:
+                begin
+                    cache_hit(VADDR0, PADDR0);
+                    ift_branch_predicted <= 1;
+                    ift_predicted_target <= VADDR1;
+                end
+
+                33:
+                begin
+                    assert(ifd_instruction_valid);
+                    assert(ifd_branch_predicted);
+                    assert(ifd_predicted_target == VADDR1);
+
+                    // Decode stage redirects this thread the same cycle the
+                    // fetch misses. This squashes the fetch.
+                    cache_hit(VADDR0, PADDR0);
+                    ift_tag[0] <= l1i_tag_t'(PADDR1 >> (32 - ICACHE_TAG_BITS));
+                    ift_branch_predicted <= 1;
+                    id_redirect_en <= 1;
+                    id_redirect_thread_idx <= 0;
+                end
+
+                34: assert(!ifd_cache_miss);
+
+                35:
+                begin
+                    assert(!ifd_instruction_valid);
+                    assert(!ifd_branch_predicted);
+                end
+
                 ////////////////////////////////////////////////////////////
                 // Debug instruction injection
                 ////////////////////////////////////////////////////////////
@@ -457,7 +530,7 @@ module test_ifetch_data_stage(input clk, input reset);
                 begin
                     // Some final checks
 
-                    assert(cache_hit_count == 12);
+                    assert(cache_hit_count == 15);
                     assert(cache_miss_count == 2);
                     assert(tlb_miss_count == 2);
                 end
@@ -20,12 +20,14 @@ import defines::*;
 
 // Not covered:
 // - Multiple threads
+// - Branch predictor entry replacement
 // - Invalidate cache entry
 module test_ifetch_tag_stage(input clk, input reset);
     logic ifd_update_lru_en;
     l1i_way_idx_t ifd_update_lru_way;
     logic ifd_cache_miss;
     logic ifd_near_miss;
+    logic ifd_prefetch_hit;
     local_thread_idx_t ifd_cache_miss_thread_idx;
     logic ift_instruction_requested;
     l1i_addr_t ift_pc_paddr;
@@ -37,14 +39,22 @@ module test_ifetch_tag_stage(input clk, input reset);
     logic ift_tlb_supervisor;
     l1i_tag_t ift_tag[`L1I_WAYS];
     logic ift_valid[`L1I_WAYS];
+    logic ift_prefetched[`L1I_WAYS];
+    logic ift_branch_predicted;
+    scalar_t ift_predicted_target;
     logic l2i_icache_lru_fill_en;
     l1i_set_idx_t l2i_icache_lru_fill_set;
     logic[`L1I_WAYS - 1:0] l2i_itag_update_en;
     l1i_set_idx_t l2i_itag_update_set;
     l1i_tag_t l2i_itag_update_tag;
     logic l2i_itag_update_valid;
+    logic l2i_itag_update_prefetched;
     local_thread_bitmap_t l2i_icache_wake_bitmap;
+    logic l2i_isnoop_en;
+    l1i_set_idx_t l2i_isnoop_set;
     l1i_way_idx_t ift_fill_lru;
+    logic ift_snoop_valid[`L1I_WAYS];
+    l1i_tag_t ift_snoop_tag[`L1I_WAYS];
     logic cr_mmu_en[`THREADS_PER_CORE];
     logic[ASID_WIDTH - 1:0] cr_current_asid[`THREADS_PER_CORE];
     logic dt_invalidate_tlb_en;
@@ -54,9 +64,17 @@ module test_ifetch_tag_stage(input clk, input reset);
     logic dt_update_itlb_en;
     logic dt_update_itlb_supervisor;
     logic dt_update_itlb_global;
+    logic dt_update_itlb_superpage;
     logic dt_update_itlb_present;
     logic dt_update_itlb_executable;
     page_index_t dt_update_itlb_ppage_idx;
+    logic id_redirect_en;
+    local_thread_idx_t id_redirect_thread_idx;
+    scalar_t id_redirect_pc;
+    logic ix_branch_resolved;
+    logic ix_branch_taken;
+    decoded_instruction_t ix_instruction;
+    scalar_t ix_rollback_pc;
     logic wb_rollback_en;
     local_thread_idx_t wb_rollback_thread_idx;
     scalar_t wb_rollback_pc;
@@ -78,7 +96,9 @@ module test_ifetch_tag_stage(input clk, input reset);
             l2i_itag_update_set <= '0;
             l2i_itag_update_tag <= '0;
             l2i_itag_update_valid <= '0;
+            l2i_itag_update_prefetched <= '0;
             l2i_icache_wake_bitmap <= '0;
+            l2i_isnoop_set <= '0;
             for (int i = 0; i < `THREADS_PER_CORE; i++)
                 cr_mmu_en[i] <= '0;
 
@@ -89,11 +109,17 @@ module test_ifetch_tag_stage(input clk, input reset);
             dt_update_itlb_vpage_idx <= '0;
             dt_update_itlb_supervisor <= '0;
             dt_update_itlb_global <= '0;
+            dt_update_itlb_superpage <= '0;
             dt_update_itlb_present <= '0;
             dt_update_itlb_executable <= '0;
             dt_update_itlb_ppage_idx <= '0;
             wb_rollback_thread_idx <= '0;
             wb_rollback_pc <= '0;
+            id_redirect_thread_idx <= '0;
+            id_redirect_pc <= '0;
+            ix_branch_taken <= '0;
+            ix_instruction <= '0;
+            ix_rollback_pc <= '0;
             ocd_thread <= '0;
             ocd_halt <= '0;
         end
@@ -102,12 +128,16 @@ module test_ifetch_tag_stage(input clk, input reset);
             ifd_update_lru_en <= '0;
             l2i_icache_lru_fill_en <= '0;
             l2i_itag_update_en <= '0;
+            l2i_isnoop_en <= '0;
             dt_invalidate_tlb_en <= '0;
             dt_invalidate_tlb_all_en <= '0;
             dt_update_itlb_en <= '0;
             wb_rollback_en <= '0;
+            id_redirect_en <= '0;
+            ix_branch_resolved <= '0;
             ifd_cache_miss <= '0;
             ifd_near_miss <= '0;
+            ifd_prefetch_hit <= '0;
 
             cycle <= cycle + 1;
             unique0 case (cycle)
@@ -411,7 +441,124 @@ module test_ifetch_tag_stage(input clk, input reset);
                 63: assert(!ift_instruction_requested);
                 64: assert(!ift_instruction_requested);
 
+                ////////////////////////////////////////////////////////////
+                // Branch prediction
+                ////////////////////////////////////////////////////////////
                 65:
+                begin
+                    ocd_halt <= 0;
+                    wb_rollback_en <= 1;
+                    wb_rollback_thread_idx <= 0;
+                    wb_rollback_pc <= 'h1000;
+
+                    // Branch at 1008 is taken
+                    ix_branch_resolved <= 1;
+                    ix_branch_taken <= 1;
+                    ix_instruction.pc <= 'h1008;
+                    ix_rollback_pc <= 'h2000;
+                end
+
+                68:
+                begin
+                    assert(ift_instruction_requested);
+                    assert(ift_pc_vaddr == 'h1000);
+                    assert(!ift_branch_predicted);
+                end
+
+                69: assert(ift_pc_vaddr == 'h1004 && !ift_branch_predicted);
+
+                70:
+                begin
+                    assert(ift_pc_vaddr == 'h1008);
+                    assert(ift_branch_predicted);
+                    assert(ift_predicted_target == 'h2000);
+                end
+
+                71:
+                begin
+                    // Fetch continues at the predicted target
+                    assert(ift_instruction_requested);
+                    assert(ift_pc_vaddr == 'h2000);
+                    assert(!ift_branch_predicted);
+
+                    // Now it isn't taken, which makes it predict not taken
+                    ix_branch_resolved <= 1;
+                    ix_branch_taken <= 0;
+                    ix_instruction.pc <= 'h1008;
+                    wb_rollback_en <= 1;
+                    wb_rollback_thread_idx <= 0;
+                    wb_rollback_pc <= 'h1000;
+                end
+
+                74: assert(ift_pc_vaddr == 'h1000);
+                75: assert(ift_pc_vaddr == 'h1004);
+                76: assert(ift_pc_vaddr == 'h1008 && !ift_branch_predicted);
+
+                77:
+                begin
+                    assert(ift_pc_vaddr == 'h100c);
+
+                    // Taken again
+                    ix_branch_resolved <= 1;
+                    ix_branch_taken <= 1;
+                    ix_instruction.pc <= 'h1008;
+                    ix_rollback_pc <= 'h2000;
+                    wb_rollback_en <= 1;
+                    wb_rollback_thread_idx <= 0;
+                    wb_rollback_pc <= 'h1000;
+                end
+
+                80: assert(ift_pc_vaddr == 'h1000);
+                81: assert(ift_pc_vaddr == 'h1004);
+                82: assert(ift_pc_vaddr == 'h1008 && ift_branch_predicted);
+
+                83:
+                begin
+                    assert(ift_pc_vaddr == 'h2000);
+
+                    // Decode stage finds 1008 wasn't a branch
+                    id_redirect_en <= 1;
+                    id_redirect_thread_idx <= 0;
+                    id_redirect_pc <= 'h100c;
+                end
+
+                84: assert(ift_instruction_requested);  // this would be squashed
+                85: assert(!ift_instruction_requested);
+
+                86:
+                begin
+                    assert(ift_instruction_requested);
+                    assert(ift_pc_vaddr == 'h100c);
+
+                    wb_rollback_en <= 1;
+                    wb_rollback_thread_idx <= 0;
+                    wb_rollback_pc <= 'h1000;
+                end
+
+                89: assert(ift_pc_vaddr == 'h1000);
+
+                // Cache miss on the predicted branch. This retries the branch,
+                // not the instruction before the predicted target.
+                90:
+                begin
+                    assert(ift_pc_vaddr == 'h1004);
+                    ifd_cache_miss <= 1;
+                    ifd_cache_miss_thread_idx <= 0;
+                end
+
+                91: assert(ift_pc_vaddr == 'h1008 && ift_branch_predicted);
+                92: assert(!ift_instruction_requested);
+
+                93:
+                begin
+                    assert(ift_instruction_requested);
+                    assert(ift_pc_vaddr == 'h1008);
+                    assert(ift_branch_predicted);
+                end
+
+                94: assert(ift_pc_vaddr == 'h2000);
+
+                95:
                 begin
                     $display("PASS");
                     $finish;
@@ -33,12 +33,18 @@ module test_instruction_decode_stage(input clk, input reset);
     logic ifd_page_fault;
     logic ifd_executable_fault;
     logic ifd_tlb_miss;
+    logic ifd_branch_predicted;
+    scalar_t ifd_predicted_target;
+    logic id_redirect_en;
+    local_thread_idx_t id_redirect_thread_idx;
+    scalar_t id_redirect_pc;
     local_thread_bitmap_t dd_load_sync_pending;
     local_thread_bitmap_t sq_store_sync_pending;
     decoded_instruction_t id_instruction;
     logic id_instruction_valid;
     local_thread_idx_t id_thread_idx;
     local_thread_bitmap_t ior_pending;
+    local_thread_bitmap_t idv_pending;
     local_thread_bitmap_t cr_interrupt_en;
     local_thread_bitmap_t cr_interrupt_pending;
     logic wb_rollback_en;
@@ -55,6 +61,7 @@ module test_instruction_decode_stage(input clk, input reset);
             cycle <= 0;
             ifd_thread_idx <= 0;
             ifd_pc <= 0;
+            ifd_predicted_target <= 0;
         end
         else
         begin
@@ -65,9 +72,11 @@ module test_instruction_decode_stage(input clk, input reset);
             ifd_page_fault <= 0;
             ifd_executable_fault <= 0;
             ifd_tlb_miss <= 0;
+            ifd_branch_predicted <= 0;
             dd_load_sync_pending <= 0;
             sq_store_sync_pending <= 0;
             ior_pending <= 0;
+            idv_pending <= 0;
             ifd_instruction <= 0;
             cr_interrupt_en <= 0;
             cr_interrupt_pending <= 0;
@@ -346,6 +355,7 @@ module test_instruction_decode_stage(input clk, input reset);
                     // is only looking at its own bits.
                     ifd_instruction_valid <= 1;
                     ior_pending <= 4'b1101;
+                    idv_pending <= 4'b1101;
                     sq_store_sync_pending <= 4'b1101;
                     dd_load_sync_pending <= 4'b1101;
                 end
@@ -633,7 +643,155 @@ module test_instruction_decode_stage(input clk, input reset);
                     ifd_instruction <= 32'hc07400c7;
                 end
 
-                83:
+                ////////////////////////////////////////////////////////////
+                // Fused multiply-add reads the destination register
+                ////////////////////////////////////////////////////////////
+                84:
+                begin
+                    // mla_f v1, v2, s3
+                    ifd_instruction_valid <= 1;
+                    ifd_instruction <= 32'hc6318022;
+                end
+
+                // wait a cycle
+                85: assert(!id_instruction_valid);
+
+                86:
+                begin
+                    assert(id_instruction_valid);
+                    assert(!id_instruction.has_trap);
+                    assert(id_instruction.pipeline_sel == PIPE_FLOAT_ARITH);
+                    assert(id_instruction.alu_op == OP_MLA_F);
+                    assert(id_instruction.accumulate);
+                    assert(!id_instruction.reduce);
+                    assert(id_instruction.has_dest);
+                    assert(id_instruction.dest_vector);
+                    assert(id_instruction.dest_reg == 1);
+                    assert(id_instruction.has_vector1);
+                    assert(id_instruction.vector_sel1 == 2);
+                    assert(id_instruction.has_scalar2);
+                    assert(id_instruction.scalar_sel2 == 3);
+
+                    // reduce_add_f s4, v5
+                    ifd_instruction_valid <= 1;
+                    ifd_instruction <= 32'hd2428080;
+                end
+
+                // wait a cycle
+                87: assert(!id_instruction_valid);
+
+                ////////////////////////////////////////////////////////////
+                // Reductions have a vector source and a scalar destination
+                ////////////////////////////////////////////////////////////
+                88:
+                begin
+                    assert(id_instruction_valid);
+                    assert(!id_instruction.has_trap);
+                    assert(id_instruction.pipeline_sel == PIPE_FLOAT_ARITH);
+                    assert(id_instruction.alu_op == OP_REDUCE_ADD_F);
+                    assert(id_instruction.reduce);
+                    assert(!id_instruction.accumulate);
+                    assert(id_instruction.has_dest);
+                    assert(!id_instruction.dest_vector);
+                    assert(id_instruction.dest_reg == 4);
+                    assert(!id_instruction.has_vector1);
+                    assert(id_instruction.has_vector2);
+                    assert(id_instruction.vector_sel2 == 5);
+                    assert(id_instruction.op2_src == OP2_SRC_VECTOR2);
+                end
+
+                ////////////////////////////////////////////////////////////
+                // Branch prediction checks
+                ////////////////////////////////////////////////////////////
+                89:
+                begin
+                    // bz s1, 16 (predicted taken to the correct address)
+                    ifd_instruction_valid <= 1;
+                    ifd_instruction <= 32'hf2000081;
+                    ifd_branch_predicted <= 1;
+                    ifd_predicted_target <= ifd_pc + 16;
+                end
+
+                90: assert(!id_redirect_en);
+
+                91:
+                begin
+                    assert(id_instruction_valid);
+                    assert(id_instruction.branch);
+                    assert(id_instruction.branch_predicted);
+
+                    // Predicted target is not the branch destination
+                    ifd_instruction_valid <= 1;
+                    ifd_instruction <= 32'hf2000081;
+                    ifd_branch_predicted <= 1;
+                    ifd_predicted_target <= ifd_pc + 32;
+                end
+
+                92:
+                begin
+                    assert(id_redirect_en);
+                    assert(id_redirect_thread_idx == ifd_thread_idx);
+                    assert(id_redirect_pc == ifd_pc + 4);
+                end
+
+                93:
+                begin
+                    assert(id_instruction_valid);
+                    assert(!id_instruction.branch_predicted);
+
+                    // Instruction is not a branch
+                    ifd_instruction_valid <= 1;
+                    ifd_instruction <= 32'hc0018022;
+                    ifd_branch_predicted <= 1;
+                end
+
+                94: assert(id_redirect_en);
+
+                95:
+                begin
+                    assert(id_instruction_valid);
+                    assert(!id_instruction.branch_predicted);
+
+                    // Thread is rolled back the same cycle
+                    ifd_instruction_valid <= 1;
+                    ifd_instruction <= 32'hc0018022;
+                    ifd_branch_predicted <= 1;
+                    wb_rollback_en <= 1;
+                    wb_rollback_thread_idx <= ifd_thread_idx;
+                end
+
+                96: assert(!id_redirect_en);
+
+                ////////////////////////////////////////////////////////////
+                // Divides use the integer pipeline, even though the opcode
+                // is in the floating point range.
+                ////////////////////////////////////////////////////////////
+                97:
+                begin
+                    // div_i v1, v2, v3
+                    ifd_instruction_valid <= 1;
+                    ifd_instruction <= 32'hd3218022;
+                end
+
+                // wait a cycle
+                98: assert(!id_instruction_valid);
+
+                99:
+                begin
+                    assert(id_instruction_valid);
+                    assert(!id_instruction.has_trap);
+                    assert(id_instruction.pipeline_sel == PIPE_INT_ARITH);
+                    assert(id_instruction.alu_op == OP_DIV_I);
+                    assert(id_instruction.has_dest);
+                    assert(id_instruction.dest_vector);
+                    assert(id_instruction.dest_reg == 1);
+                    assert(id_instruction.has_vector1);
+                    assert(id_instruction.vector_sel1 == 2);
+                    assert(id_instruction.has_vector2);
+                    assert(id_instruction.vector_sel2 == 3);
+                end
+
+                100:
                 begin
                     $display("PASS");
                     $finish;
@@ -0,0 +1,295 @@
+//
+// Copyright 2019 Jeff Bush
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+`include "defines.svh"
+
+import defines::*;
+
+//
+// Run each divide operation on a set of lanes that includes sign
+// combinations, division by zero, and overflow, and check the results
+// against a model. While the first divide is in progress, another thread
+// tries to use the divider and is woken when the result is collected. Then
+// check that the divider is released if the owner is halted or takes a trap
+// before collecting its result.
+//
+module test_int_divider(input clk, input reset);
+    localparam OWNER_PC = 'h1000;
+    localparam WAITER_PC = 'h2000;
+
+    vector_t of_operand1;
+    vector_t of_operand2;
+    decoded_instruction_t of_instruction;
+    local_thread_idx_t of_thread_idx;
+    logic ix_divide_en;
+    logic wb_trap;
+    local_thread_idx_t wb_rollback_thread_idx;
+    local_thread_bitmap_t thread_en;
+    logic idv_result_valid;
+    vector_t idv_result;
+    local_thread_bitmap_t idv_pending;
+    local_thread_bitmap_t idv_wake_bitmap;
+    alu_op_t current_op;
+    int op_index;
+    int wait_cycles;
+    int state;
+    int release_case;
+
+    int_divider int_divider(.*);
+
+    function alu_op_t divide_op(input int index);
+        unique case (index)
+            0: return OP_DIV_I;
+            1: return OP_DIV_U;
+            2: return OP_REM_I;
+            default: return OP_REM_U;
+        endcase
+    endfunction
+
+    function scalar_t expected_result(input alu_op_t op, input scalar_t dividend,
+        input scalar_t divisor);
+
+        unique case (op)
+            OP_DIV_U: return divisor == 0 ? '1 : dividend / divisor;
+            OP_REM_U: return divisor == 0 ? dividend : dividend % divisor;
+            OP_DIV_I:
+            begin
+                if (divisor == 0)
+                    return '1;
+                else if (dividend == 32'h80000000 && divisor == '1)
+                    return dividend;
+                else
+                    return scalar_t'($signed(dividend) / $signed(divisor));
+            end
+
+            default:
+            begin
+                if (divisor == 0)
+                    return dividend;
+                else if (dividend == 32'h80000000 && divisor == '1)
+                    return '0;
+                else
+                    return scalar_t'($signed(dividend) % $signed(divisor));
+            end
+        endcase
+    endfunction
+
+    task issue_divide(input local_thread_idx_t thread_idx, input scalar_t pc);
+        ix_divide_en <= 1;
+        of_thread_idx <= thread_idx;
+        of_instruction.pc <= pc;
+        of_instruction.alu_op <= current_op;
+    endtask
+
+    task check_results;
+        assert(idv_result_valid);
+        for (int lane = 0; lane < NUM_VECTOR_LANES; lane++)
+        begin
+            assert(idv_result[lane] == expected_result(current_op, of_operand1[lane],
+                of_operand2[lane]));
+        end
+    endtask
+
+    always @(posedge clk, posedge reset)
+    begin
+        if (reset)
+        begin
+            state <= 0;
+            op_index <= 0;
+            wait_cycles <= 0;
+            release_case <= 0;
+            ix_divide_en <= 0;
+            wb_trap <= 0;
+            wb_rollback_thread_idx <= '0;
+            thread_en <= '1;
+            of_thread_idx <= '0;
+            of_instruction <= '0;
+            of_operand1 <= '0;
+            of_operand2 <= '0;
+            current_op <= OP_DIV_I;
+        end
+        else
+        begin
+            ix_divide_en <= 0;
+            wait_cycles <= wait_cycles + 1;
+
+            unique case (state)
+                0:
+                begin
+                    for (int lane = 0; lane < NUM_VECTOR_LANES; lane++)
+                    begin
+                        of_operand1[lane] <= $random();
+                        of_operand2[lane] <= scalar_t'($random()) >> lane;
+                    end
+
+                    of_operand1[0] <= 100;
+                    of_operand2[0] <= 7;
+                    of_operand1[1] <= -100;
+                    of_operand2[1] <= 7;
+                    of_operand1[2] <= 100;
+                    of_operand2[2] <= -7;
+                    of_operand1[3] <= -100;
+                    of_operand2[3] <= -7;
+                    of_operand1[4] <= 32'h80000000;
+                    of_operand2[4] <= 32'hffffffff;
+                    of_operand1[5] <= 12345;
+                    of_operand2[5] <= 0;
+                    of_operand1[6] <= -12345;
+                    of_operand2[6] <= 0;
+                    of_operand1[7] <= 32'hffffffff;
+                    of_operand2[7] <= 1;
+                    of_operand1[8] <= 5;
+                    of_operand2[8] <= 32'h80000000;
+                    state <= state + 1;
+                end
+
+                // Start a divide
+                1:
+                begin
+                    current_op <= divide_op(op_index);
+                    state <= state + 1;
+                end
+
+                2:
+                begin
+                    issue_divide(1, OWNER_PC);
+                    wait_cycles <= 0;
+                    state <= state + 1;
+                end
+
+                3:
+                begin
+                    assert(!idv_result_valid);
+                    if (op_index == 0)
+                    begin
+                        // Another thread tries to divide while this is busy
+                        issue_divide(2, WAITER_PC);
+                    end
+
+                    state <= state + 1;
+                end
+
+                4:
+                begin
+                    assert(!idv_result_valid);
+                    assert(idv_pending == 4'b0010);
+                    state <= state + 1;
+                end
+
+                // Wait for the owner to be woken, then collect the result
+                5:
+                begin
+                    if (idv_wake_bitmap != 0)
+                    begin
+                        assert(idv_wake_bitmap == 4'b0010);
+                        assert(wait_cycles >= 32);
+                        issue_divide(1, OWNER_PC);
+                        state <= state + 1;
+                    end
+                    else
+                        assert(wait_cycles < 64);
+                end
+
+                6:
+                begin
+                    check_results;
+                    state <= state + 1;
+                end
+
+                7:
+                begin
+                    assert(idv_pending == 0);
+                    if (op_index == 0)
+                        assert(idv_wake_bitmap == 4'b0100);
+                    else
+                        assert(idv_wake_bitmap == 0);
+
+                    if (op_index == 3)
+                        state <= state + 1;
+                    else
+                    begin
+                        op_index <= op_index + 1;
+                        state <= 1;
+                    end
+                end
+
+                // Finish a divide while another thread is waiting, but
+                // don't collect the result.
+                8:
+                begin
+                    current_op <= OP_DIV_U;
+                    issue_divide(1, OWNER_PC);
+                    wait_cycles <= 0;
+                    state <= state + 1;
+                end
+
+                9:
+                begin
+                    issue_divide(2, WAITER_PC);
+                    state <= state + 1;
+                end
+
+                10:
+                begin
+                    if (idv_wake_bitmap != 0)
+                    begin
+                        assert(idv_wake_bitmap == 4'b0010);
+                        if (release_case == 0)
+                            thread_en <= 4'b1101;
+                        else
+                        begin
+                            wb_trap <= 1;
+                            wb_rollback_thread_idx <= 1;
+                        end
+
+                        state <= state + 1;
+                    end
+                    else
+                        assert(wait_cycles < 64);
+                end
+
+                11:
+                begin
+                    assert(idv_pending == 4'b0010);
+                    thread_en <= '1;
+                    wb_trap <= 0;
+                    state <= state + 1;
+                end
+
+                // The divider is free and the waiting thread is woken
+                12:
+                begin
+                    assert(idv_pending == 0);
+                    assert(idv_wake_bitmap == 4'b0100);
+                    if (release_case == 0)
+                    begin
+                        release_case <= 1;
+                        state <= 8;
+                    end
+                    else
+                        state <= state + 1;
+                end
+
+                13:
+                begin
+                    $display("PASS");
+                    $finish;
+                end
+            endcase
+        end
+    end
+endmodule
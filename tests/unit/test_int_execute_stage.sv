@@ -41,14 +41,23 @@ module test_int_execute_stage(input clk, input reset);
     scalar_t ix_rollback_pc;
     subcycle_t ix_subcycle;
     logic ix_privileged_op_fault;
+    logic ix_suspend_thread;
+    logic ix_divide_en;
+    logic idv_result_valid;
+    vector_t idv_result;
+    logic ix_branch_resolved;
+    logic ix_branch_taken;
     scalar_t cr_eret_address[`THREADS_PER_CORE];
     logic cr_supervisor_en[`THREADS_PER_CORE];
     logic ix_perf_uncond_branch;
     logic ix_perf_cond_branch_taken;
     logic ix_perf_cond_branch_not_taken;
+    logic ix_perf_branch_predicted;
+    logic ix_perf_branch_mispredicted;
     int cycle;
     scalar_t last_branch_pc;
     scalar_t last_branch_offset;
+    scalar_t last_divide_pc;
 
     int_execute_stage int_execute_stage(.*);
 
@@ -66,11 +75,30 @@ module test_int_execute_stage(input clk, input reset);
         of_instruction.immediate_value <= offset;
     endtask
 
+    // Instruction fetch continued at the branch target
+    task predicted_branch(input branch_type_t branch_type, input scalar_t regval);
+        branch(branch_type, regval);
+        of_instruction.branch_predicted <= 1;
+    endtask
+
+    task divide(input logic result_valid);
+        scalar_t pc = $random() & ~3;
+        of_instruction_valid <= 1;
+        of_instruction.alu_op <= OP_DIV_I;
+        of_instruction.pipeline_sel <= PIPE_INT_ARITH;
+        of_instruction.pc <= pc;
+        last_divide_pc <= pc;
+        idv_result_valid <= result_valid;
+        for (int lane = 0; lane < NUM_VECTOR_LANES; lane++)
+            idv_result[lane] <= scalar_t'(lane * 3 + 1);
+    endtask
+
     always_ff @(posedge clk, posedge reset)
     begin
         if (reset)
         begin
             cycle <= 0;
+            idv_result <= '0;
             of_operand1 <= '0;
             of_operand2 <= '0;
             of_mask_value <= '0;
@@ -88,6 +116,7 @@ module test_int_execute_stage(input clk, input reset);
             wb_rollback_en <= '0;
             of_instruction <= '0;
             of_instruction_valid <= '0;
+            idv_result_valid <= '0;
 
             cycle <= cycle + 1;
             unique0 case (cycle)
@@ -357,7 +386,102 @@ module test_int_execute_stage(input clk, input reset);
                     assert(!ix_perf_cond_branch_not_taken);
                 end
 
-                32:
+                ////////////////////////////////////////////////////////////
+                // Branch prediction
+                ////////////////////////////////////////////////////////////
+
+                // Predicted taken and is taken
+                32: predicted_branch(BRANCH_ZERO, 0);
+
+                34:
+                begin
+                    assert(!ix_rollback_en);
+                    assert(ix_branch_resolved);
+                    assert(ix_branch_taken);
+                    assert(ix_rollback_pc == last_branch_pc + last_branch_offset);
+                    assert(ix_perf_cond_branch_taken);
+                    assert(ix_perf_branch_predicted);
+                    assert(!ix_perf_branch_mispredicted);
+
+                    // Predicted taken, but is not taken
+                    predicted_branch(BRANCH_ZERO, 1);
+                end
+
+                36:
+                begin
+                    assert(ix_rollback_en);
+                    assert(ix_rollback_pc == last_branch_pc + 4);
+                    assert(ix_branch_resolved);
+                    assert(!ix_branch_taken);
+                    assert(ix_perf_cond_branch_not_taken);
+                    assert(ix_perf_branch_predicted);
+                    assert(ix_perf_branch_mispredicted);
+
+                    // Not predicted, but is taken
+                    branch(BRANCH_NOT_ZERO, 1);
+                end
+
+                38:
+                begin
+                    assert(ix_rollback_en);
+                    assert(ix_rollback_pc == last_branch_pc + last_branch_offset);
+                    assert(ix_branch_resolved);
+                    assert(ix_branch_taken);
+                    assert(!ix_perf_branch_predicted);
+                    assert(ix_perf_branch_mispredicted);
+
+                    // Register branches are not predicted
+                    branch(BRANCH_REGISTER, BRANCH_ADDR0);
+                end
+
+                40:
+                begin
+                    assert(ix_rollback_en);
+                    assert(ix_rollback_pc == BRANCH_ADDR0);
+                    assert(!ix_branch_resolved);
+                    assert(!ix_perf_branch_predicted);
+                    assert(!ix_perf_branch_mispredicted);
+                end
+
+                ////////////////////////////////////////////////////////////
+                // Integer divide
+                ////////////////////////////////////////////////////////////
+
+                // Result isn't ready. Reissue this instruction when the
+                // divider wakes the thread.
+                41:
+                begin
+                    divide(0);
+                    assert(!ix_divide_en);
+                end
+
+                42:
+                begin
+                    assert(ix_divide_en);
+                    assert(!ix_suspend_thread);
+                end
+
+                43:
+                begin
+                    assert(ix_instruction_valid);
+                    assert(ix_rollback_en);
+                    assert(ix_suspend_thread);
+                    assert(ix_rollback_pc == last_divide_pc);
+                    assert(!ix_branch_resolved);
+                    divide(1);
+                end
+
+                // Result is ready
+                45:
+                begin
+                    assert(ix_instruction_valid);
+                    assert(!ix_rollback_en);
+                    assert(!ix_suspend_thread);
+                    for (int lane = 0; lane < NUM_VECTOR_LANES; lane++)
+                        assert(ix_result[lane] == scalar_t'(lane * 3 + 1));
+                end
+
+                46:
                 begin
                     $display("PASS");
                     $finish;
@@ -30,6 +30,15 @@ module test_io_interconnect(input clk, input reset);
     logic ii_response_valid;
     iorsp_packet_t ii_response;
     io_bus_interface io_bus();
+    logic ii_dma_write_en;
+    logic[3:0] ii_dma_reg;
+    scalar_t ii_dma_write_data;
+    scalar_t dma_read_data;
+    logic[`NUM_CORES - 1:0] ii_tex_write_en;
+    logic[3:0] ii_tex_reg;
+    local_thread_idx_t ii_tex_thread;
+    scalar_t ii_tex_write_data;
+    scalar_t tex_read_data[`NUM_CORES];
     int state;
 
     io_interconnect io_interconnect(.*);
@@ -130,7 +139,150 @@ module test_io_interconnect(input clk, input reset);
                     state <= state + 1;
                 end
 
+                // Store to a DMA engine register
                 8:
+                begin
+                    ior_request[0].store <= 1;
+                    ior_request[0].thread_idx <= 3;
+                    ior_request[0].address <= DMA_BASE + 8;
+                    ior_request[0].value <= DATA0;
+                    ior_request_valid[0] <= 1;
+                    state <= state + 1;
+                end
+
+                // Goes to the DMA engine instead of the I/O bus
+                9:
+                begin
+                    ior_request_valid[0] <= 0;
+
+                    assert(ii_ready[0]);
+                    assert(!io_bus.write_en);
+                    assert(!io_bus.read_en);
+                    assert(ii_dma_write_en);
+                    assert(ii_dma_reg == 2);
+                    assert(ii_dma_write_data == DATA0);
+                    state <= state + 1;
+                end
+
+                10: state <= state + 1;
+
+                11:
+                begin
+                    assert(!ii_dma_write_en);
+                    assert(ii_response_valid);
+                    assert(ii_response.thread_idx == 3);
+                    state <= state + 1;
+                end
+
+                // Load from a DMA engine register
+                12:
+                begin
+                    ior_request[0].store <= 0;
+                    ior_request[0].thread_idx <= 1;
+                    ior_request[0].address <= DMA_BASE + 'h20;
+                    ior_request_valid[0] <= 1;
+                    state <= state + 1;
+                end
+
+                13:
+                begin
+                    ior_request_valid[0] <= 0;
+
+                    assert(ii_ready[0]);
+                    assert(!io_bus.read_en);
+                    assert(!io_bus.write_en);
+                    assert(!ii_dma_write_en);
+                    assert(ii_dma_reg == 8);
+                    io_bus.read_data <= '0;
+                    dma_read_data <= DATA1;
+                    state <= state + 1;
+                end
+
+                14: state <= state + 1;
+
+                // Response has the value from the DMA engine
+                15:
+                begin
+                    assert(ii_response_valid);
+                    assert(ii_response.thread_idx == 1);
+                    assert(ii_response.read_value == DATA1);
+                    state <= state + 1;
+                end
+
+                // Store to a texture sampler register
+                16:
+                begin
+                    ior_request[0].store <= 1;
+                    ior_request[0].thread_idx <= 2;
+                    ior_request[0].address <= TEXTURE_BASE;
+                    ior_request[0].value <= DATA1;
+                    ior_request_valid[0] <= 1;
+                    state <= state + 1;
+                end
+
+                // Goes to core 0's sampler
+                17:
+                begin
+                    ior_request_valid[0] <= 0;
+
+                    assert(ii_ready[0]);
+                    assert(!io_bus.write_en);
+                    assert(!io_bus.read_en);
+                    assert(!ii_dma_write_en);
+                    assert(ii_tex_write_en == 1);
+                    assert(ii_tex_reg == 0);
+                    assert(ii_tex_thread == 2);
+                    assert(ii_tex_write_data == DATA1);
+                    state <= state + 1;
+                end
+
+                18: state <= state + 1;
+
+                19:
+                begin
+                    assert(ii_tex_write_en == 0);
+                    assert(ii_response_valid);
+                    assert(ii_response.thread_idx == 2);
+                    state <= state + 1;
+                end
+
+                // Load from a texture sampler register
+                20:
+                begin
+                    ior_request[0].store <= 0;
+                    ior_request[0].thread_idx <= 3;
+                    ior_request[0].address <= TEXTURE_BASE + 4;
+                    ior_request_valid[0] <= 1;
+                    state <= state + 1;
+                end
+
+                21:
+                begin
+                    ior_request_valid[0] <= 0;
+
+                    assert(ii_ready[0]);
+                    assert(!io_bus.read_en);
+                    assert(ii_tex_write_en == 0);
+                    assert(ii_tex_reg == 1);
+                    assert(ii_tex_thread == 3);
+                    io_bus.read_data <= '0;
+                    dma_read_data <= '0;
+                    tex_read_data[0] <= DATA0;
+                    state <= state + 1;
+                end
+
+                22: state <= state + 1;
+
+                // Response has the value from the sampler
+                23:
+                begin
+                    assert(ii_response_valid);
+                    assert(ii_response.thread_idx == 3);
+                    assert(ii_response.read_value == DATA0);
+                    state <= state + 1;
+                end
+
+                24:
                 begin
                     $display("PASS");
                     $finish;
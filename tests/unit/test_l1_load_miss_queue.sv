@@ -28,6 +28,10 @@ module test_load_miss_queue(input clk, input reset);
     cache_line_index_t cache_miss_addr;
     local_thread_idx_t cache_miss_thread_idx;
     logic cache_miss_sync;
+    logic prefetch_en;
+    cache_line_index_t prefetch_addr;
+    logic prefetch_ack;
+    logic prefetch_enqueued;
     logic dequeue_ready;
     logic dequeue_ack;
     cache_line_index_t dequeue_addr;
@@ -36,23 +40,26 @@ module test_load_miss_queue(input clk, input reset);
     logic l2_response_valid;
     l1_miss_entry_idx_t l2_response_idx;
     local_thread_bitmap_t wake_bitmap;
+    logic prefetch_fill;
     int cycle;
     l1_miss_entry_idx_t saved_request_idx0;
     l1_miss_entry_idx_t saved_request_idx1;
     logic l2_requests_in_order;
 
-    l1_load_miss_queue l1_load_miss_queue(.*);
+    l1_load_miss_queue #(.NUM_PREFETCH_ENTRIES(2)) l1_load_miss_queue(.*);
 
     always @(posedge clk, posedge reset)
     begin
         if (reset)
         begin
             cycle <= 0;
+            prefetch_en <= 0;
         end
         else
         begin
             // default values
             cache_miss <= 0;
+            prefetch_en <= 0;
             dequeue_ack <= 0;
             l2_response_valid <= 0;
 
@@ -361,7 +368,121 @@ module test_load_miss_queue(input clk, input reset);
                     assert(wake_bitmap == 4'b1000);
                 end
 
+                ////////////////////////////////////////////////////////////
+                // Prefetches
+                ////////////////////////////////////////////////////////////
                 27:
+                begin
+                    prefetch_en <= 1;
+                    prefetch_addr <= ADDR3;
+                end
+
+                28:
+                begin
+                    assert(prefetch_ack);
+                    assert(prefetch_enqueued);
+                    assert(!dequeue_ready);
+                end
+
+                29:
+                begin
+                    assert(dequeue_ready);
+                    assert(dequeue_addr == ADDR3);
+                    assert(!dequeue_sync);
+                    assert(dequeue_idx >= l1_miss_entry_idx_t'(`THREADS_PER_CORE));
+                    saved_request_idx0 <= dequeue_idx;
+                    dequeue_ack <= 1;
+
+                    // Prefetch the same line again
+                    prefetch_en <= 1;
+                    prefetch_addr <= ADDR3;
+                end
+
+                // The duplicate is consumed, but not enqueued.
+                30:
+                begin
+                    assert(prefetch_ack);
+                    assert(!prefetch_enqueued);
+
+                    // A miss on the same line is combined with the prefetch
+                    cache_miss <= 1;
+                    cache_miss_addr <= ADDR3;
+                    cache_miss_thread_idx <= 1;
+                    cache_miss_sync <= 0;
+                end
+
+                31: assert(!dequeue_ready);
+
+                32:
+                begin
+                    assert(!dequeue_ready);
+                    l2_response_valid <= 1;
+                    l2_response_idx <= saved_request_idx0;
+                end
+
+                33:
+                begin
+                    assert(wake_bitmap == 4'b0010);
+                    assert(!prefetch_fill);
+                end
+
+                // A prefetch that no thread is waiting for
+                34:
+                begin
+                    prefetch_en <= 1;
+                    prefetch_addr <= ADDR0;
+                end
+
+                35: assert(prefetch_enqueued);
+
+                36:
+                begin
+                    assert(dequeue_ready);
+                    assert(dequeue_addr == ADDR0);
+                    saved_request_idx0 <= dequeue_idx;
+                    dequeue_ack <= 1;
+                end
+
+                37: assert(wake_bitmap == 0);
+
+                38:
+                begin
+                    assert(!dequeue_ready);
+                    l2_response_valid <= 1;
+                    l2_response_idx <= saved_request_idx0;
+                end
+
+                39:
+                begin
+                    assert(wake_bitmap == 0);
+                    assert(prefetch_fill);
+                end
+
+                // Fill all prefetch entries
+                40:
+                begin
+                    prefetch_en <= 1;
+                    prefetch_addr <= ADDR1;
+                end
+
+                41:
+                begin
+                    assert(prefetch_enqueued);
+                    prefetch_en <= 1;
+                    prefetch_addr <= ADDR2;
+                end
+
+                42:
+                begin
+                    assert(prefetch_enqueued);
+                    prefetch_en <= 1;
+                    prefetch_addr <= ADDR3;
+                end
+
+                // No free entries. The request must wait.
+                43: assert(!prefetch_ack);
+
+                44:
                 begin
                     $display("PASS");
                     $finish;
@@ -612,7 +612,107 @@ module test_l1_store_queue(input clk, input reset);
                     storebuf_l2_response_idx <= sq_dequeue_idx;
                 end
 
-                85:
+                ////////////////////////////////////////////////////////////
+                // A partial line store is held to allow write combining.
+                // Stores that write new bytes restart the timer.
+                ////////////////////////////////////////////////////////////
+                90: store_request(ADDR1, 64'h00000000_0000000f, DATA2);
+                // wait a cycle
+
+                92:
+                begin
+                    assert(!sq_rollback_en);
+                    assert(!sq_dequeue_ready);
+                    store_request(ADDR1, 64'h00000000_000000f0, DATA0);
+                end
+
+                93, 100, 109:
+                begin
+                    assert(!sq_rollback_en);
+                    assert(!sq_dequeue_ready);
+                end
+
+                110:
+                begin
+                    assert(sq_dequeue_ready);
+                    assert(sq_dequeue_addr == ADDR1);
+                    assert(sq_dequeue_mask == 64'h00000000_000000ff);
+                    assert(sq_dequeue_data[63:0] == {DATA0[63:32], DATA2[31:0]});
+                    saved_request_idx <= sq_dequeue_idx;
+                    storebuf_dequeue_ack <= 1;
+                end
+
+                111:
+                begin
+                    storebuf_l2_response_valid <= 1;
+                    storebuf_l2_response_idx <= saved_request_idx;
+                end
+
+                ////////////////////////////////////////////////////////////
+                // A store to a different line rolls back and sends the
+                // held entry immediately.
+                ////////////////////////////////////////////////////////////
+                114: store_request(ADDR2, 64'h00000000_0000000f, DATA2);
+                // wait a cycle
+
+                116:
+                begin
+                    assert(!sq_dequeue_ready);
+                    store_request(ADDR3, MASK3, DATA3);
+                end
+                // wait a cycle
+
+                118:
+                begin
+                    assert(sq_rollback_en);
+                    assert(sq_dequeue_ready);
+                    assert(sq_dequeue_addr == ADDR2);
+                    assert(sq_dequeue_mask == 64'h00000000_0000000f);
+                    saved_request_idx <= sq_dequeue_idx;
+                    storebuf_dequeue_ack <= 1;
+                end
+
+                119:
+                begin
+                    storebuf_l2_response_valid <= 1;
+                    storebuf_l2_response_idx <= saved_request_idx;
+                end
+
+                120: assert(sq_wake_bitmap == 4'b0001);
+
+                ////////////////////////////////////////////////////////////
+                // A combined store that completes the line is sent without
+                // waiting for the rest of the timer.
+                ////////////////////////////////////////////////////////////
+                124: store_request(ADDR2, 64'h00000000_0000000f, DATA2);
+                // wait a cycle
+
+                126:
+                begin
+                    assert(!sq_rollback_en);
+                    assert(!sq_dequeue_ready);
+                    store_request(ADDR2, 64'hffffffff_fffffff0, DATA3);
+                end
+                // wait a cycle
+
+                128:
+                begin
+                    assert(!sq_rollback_en);
+                    assert(sq_dequeue_ready);
+                    assert(sq_dequeue_addr == ADDR2);
+                    assert(sq_dequeue_mask == 64'hffffffff_ffffffff);
+                    assert(sq_dequeue_data == {DATA3[511:32], DATA2[31:0]});
+                    saved_request_idx <= sq_dequeue_idx;
+                    storebuf_dequeue_ack <= 1;
+                end
+
+                129:
+                begin
+                    storebuf_l2_response_valid <= 1;
+                    storebuf_l2_response_idx <= saved_request_idx;
+                end
+
+                131:
                 begin
                     $display("PASS");
                     $finish;
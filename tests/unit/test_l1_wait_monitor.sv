@@ -0,0 +1,208 @@
+//
+// Copyright 2018 Jeff Bush
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+`include "defines.svh"
+
+import defines::*;
+
+module test_l1_wait_monitor(input clk, input reset);
+    localparam WATCH_LINE = cache_line_index_t'(32'h1234);
+    localparam OTHER_LINE = cache_line_index_t'(32'h5678);
+
+    logic dd_cache_miss;
+    cache_line_index_t dd_cache_miss_addr;
+    local_thread_idx_t dd_cache_miss_thread_idx;
+    logic dd_cache_miss_sync;
+    logic dd_wait_en;
+    local_thread_idx_t dd_wait_thread_idx;
+    local_thread_bitmap_t cr_interrupt_pending;
+    local_thread_bitmap_t cr_interrupt_en;
+    logic l2_response_valid;
+    l2rsp_packet_t l2_response;
+    local_thread_bitmap_t wake_bitmap;
+    int cycle;
+
+    l1_wait_monitor l1_wait_monitor(.*);
+
+    always @(posedge clk, posedge reset)
+    begin
+        if (reset)
+        begin
+            cycle <= 0;
+            dd_cache_miss <= '0;
+            dd_cache_miss_sync <= '0;
+            dd_wait_en <= '0;
+            l2_response_valid <= '0;
+            dd_cache_miss_addr <= '0;
+            dd_cache_miss_thread_idx <= '0;
+            dd_wait_thread_idx <= '0;
+            cr_interrupt_pending <= '0;
+            cr_interrupt_en <= '0;
+            l2_response <= '0;
+        end
+        else
+        begin
+            dd_cache_miss <= 0;
+            dd_cache_miss_sync <= 0;
+            dd_wait_en <= 0;
+            l2_response_valid <= 0;
+
+            cycle <= cycle + 1;
+            unique0 case (cycle)
+                ////////////////////////////////////////////////////////////
+                // Not watching a line, wakes right away
+                ////////////////////////////////////////////////////////////
+                0:
+                begin
+                    dd_wait_en <= 1;
+                    dd_wait_thread_idx <= 1;
+                end
+
+                1: assert(wake_bitmap == 0);
+                2: assert(wake_bitmap == 4'b0010);
+                3: assert(wake_bitmap == 0);
+
+                ////////////////////////////////////////////////////////////
+                // Wakes when the watched line is written
+                ////////////////////////////////////////////////////////////
+                4:
+                begin
+                    dd_cache_miss <= 1;
+                    dd_cache_miss_sync <= 1;
+                    dd_cache_miss_addr <= WATCH_LINE;
+                    dd_cache_miss_thread_idx <= 2;
+                end
+
+                5:
+                begin
+                    dd_wait_en <= 1;
+                    dd_wait_thread_idx <= 2;
+                end
+
+                // Writes to other lines, loads of the watched line, and
+                // interrupts that aren't enabled don't wake it.
+                6:
+                begin
+                    l2_response_valid <= 1;
+                    l2_response.packet_type <= L2RSP_STORE_ACK;
+                    l2_response.address <= OTHER_LINE;
+                end
+
+                7:
+                begin
+                    assert(wake_bitmap == 0);
+                    l2_response_valid <= 1;
+                    l2_response.packet_type <= L2RSP_LOAD_ACK;
+                    l2_response.address <= WATCH_LINE;
+                    cr_interrupt_pending <= 4'b0100;
+                end
+
+                8:
+                begin
+                    assert(wake_bitmap == 0);
+                    cr_interrupt_pending <= 0;
+
+                    // Written by another core
+                    l2_response_valid <= 1;
+                    l2_response.packet_type <= L2RSP_STORE_ACK;
+                    l2_response.core <= core_id_t'(1);
+                    l2_response.address <= WATCH_LINE;
+                end
+
+                9: assert(wake_bitmap == 0);
+                10: assert(wake_bitmap == 4'b0100);
+
+                // Waking stops the watch
+                11:
+                begin
+                    assert(wake_bitmap == 0);
+                    dd_wait_en <= 1;
+                    dd_wait_thread_idx <= 2;
+                end
+
+                13: assert(wake_bitmap == 4'b0100);
+
+                ////////////////////////////////////////////////////////////
+                // Write before the wait (wakes as soon as it waits)
+                ////////////////////////////////////////////////////////////
+                14:
+                begin
+                    dd_cache_miss <= 1;
+                    dd_cache_miss_sync <= 1;
+                    dd_cache_miss_addr <= WATCH_LINE;
+                    dd_cache_miss_thread_idx <= 3;
+                end
+
+                15:
+                begin
+                    l2_response_valid <= 1;
+                    l2_response.packet_type <= L2RSP_DINVALIDATE_ACK;
+                    l2_response.address <= WATCH_LINE;
+                end
+
+                17:
+                begin
+                    assert(wake_bitmap == 0);
+                    dd_wait_en <= 1;
+                    dd_wait_thread_idx <= 3;
+                end
+
+                19: assert(wake_bitmap == 4'b1000);
+
+                ////////////////////////////////////////////////////////////
+                // Enabled interrupt wakes thread. A non-sync miss doesn't
+                // change the watch.
+                ////////////////////////////////////////////////////////////
+                20:
+                begin
+                    dd_cache_miss <= 1;
+                    dd_cache_miss_sync <= 1;
+                    dd_cache_miss_addr <= WATCH_LINE;
+                    dd_cache_miss_thread_idx <= 0;
+                end
+
+                21:
+                begin
+                    dd_cache_miss <= 1;
+                    dd_cache_miss_addr <= OTHER_LINE;
+                    dd_cache_miss_thread_idx <= 0;
+                end
+
+                22:
+                begin
+                    dd_wait_en <= 1;
+                    dd_wait_thread_idx <= 0;
+                end
+
+                24:
+                begin
+                    assert(wake_bitmap == 0);
+                    cr_interrupt_pending <= 4'b0001;
+                    cr_interrupt_en <= 4'b0001;
+                end
+
+                25: assert(wake_bitmap == 4'b0001);
+
+                26:
+                begin
+                    assert(wake_bitmap == 0);
+                    $display("PASS");
+                    $finish;
+                end
+            endcase
+        end
+    end
+endmodule
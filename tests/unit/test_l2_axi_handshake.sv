@@ -25,6 +25,7 @@ import defines::*;
 
 module test_l2_cache_wait_state(input clk, input reset);
     localparam DELAY = 3;
+    localparam BURST_BEATS = CACHE_LINE_BITS / `AXI_DATA_WIDTH;
     localparam ADDR0 = 'h12;
     localparam DATA0 = 512'h88a84df3d616f6e7701e6461010a1f3f2c931fb4b396d059d177c51b3b17c82ad26c90f1f7040331efd466bde698718ec430b97e0c9241b9a57322c9b092bf3e;
     localparam DATA1 = 512'h8ddc6625b5f211958e5d77eea014d0500f39ab63bc3cc75f360bf2961bef34ec8f095b878488ed87bc3d499699660adbd5b3a99e8e5fd7a6092dd003dc960d31;
@@ -32,8 +33,15 @@ module test_l2_cache_wait_state(input clk, input reset);
     logic[`NUM_CORES - 1:0] l2i_request_valid;
     l2req_packet_t l2i_request[`NUM_CORES];
     logic l2_ready[`NUM_CORES];
+    logic l2_core_response_valid[`NUM_CORES];
+    l2rsp_packet_t l2_core_response[`NUM_CORES];
+    logic l2_dma_response_valid;
+    l2rsp_packet_t l2_dma_response;
     logic l2_response_valid;
     l2rsp_packet_t l2_response;
+    logic dma_l2_request_valid;
+    l2req_packet_t dma_l2_request;
+    logic l2_dma_ready;
     axi4_interface axi_bus();
     logic[L2_PERF_EVENTS - 1:0] l2_perf_events;
     int state;
@@ -42,12 +50,22 @@ module test_l2_cache_wait_state(input clk, input reset);
     int wait_count;
 
     always_comb
-        axi_bus.s_rdata = axi_bus.s_rvalid ? 32'(DATA0 >> ((15 - axi_burst_offset) * 32)) : $random();
+        axi_bus.s_rdata = axi_bus.s_rvalid ? `AXI_DATA_WIDTH'(DATA0
+            >> ((BURST_BEATS - 1 - axi_burst_offset) * `AXI_DATA_WIDTH)) : $random();
 
     assign l2i_request[0].id = 0;
 
     l2_cache l2_cache(.*);
 
+    // All requests are from core 0
+    assign l2_response_valid = l2_core_response_valid[0];
+    assign l2_response = l2_core_response[0];
+
+    // No DMA requests
+    assign dma_l2_request_valid = 0;
+    assign dma_l2_request = '0;
+    assign l2i_request[0].dma = 0;
+
     always @(posedge clk, posedge reset)
     begin
         if (reset)
@@ -86,7 +104,7 @@ module test_l2_cache_wait_state(input clk, input reset);
                     if (axi_bus.m_arvalid)
                     begin
                         assert(axi_bus.m_araddr == ADDR0 * CACHE_LINE_BYTES);
-                        assert(axi_bus.m_arlen == 15);
+                        assert(axi_bus.m_arlen == 8'(BURST_BEATS - 1));
                         wait_count <= DELAY;
                         state <= state + 1;
                     end
@@ -109,7 +127,7 @@ module test_l2_cache_wait_state(input clk, input reset);
                     // A3.2.1 "...the source must keep its information stable until the transfer
                     // occurs..."
                     assert(axi_bus.m_araddr == ADDR0 * CACHE_LINE_BYTES);
-                    assert(axi_bus.m_arlen == 15);
+                    assert(axi_bus.m_arlen == 8'(BURST_BEATS - 1));
 
                     if (wait_count == 0)
                     begin
@@ -149,7 +167,7 @@ module test_l2_cache_wait_state(input clk, input reset);
 
                     if (axi_bus.m_rready && axi_bus.s_rvalid)
                     begin
-                        if (axi_burst_offset == 15)
+                        if (axi_burst_offset == BURST_BEATS - 1)
                         begin
                             axi_bus.s_rvalid <= 0;
                             state <= state + 1;
@@ -218,7 +236,7 @@ module test_l2_cache_wait_state(input clk, input reset);
                     if (axi_bus.m_awvalid)
                     begin
                         assert(axi_bus.m_awaddr == ADDR0 * CACHE_LINE_BYTES);
-                        assert(axi_bus.m_awlen == 15);
+                        assert(axi_bus.m_awlen == 8'(BURST_BEATS - 1));
                         state <= state + 1;
                         wait_count <= DELAY;
                     end
@@ -240,7 +258,7 @@ module test_l2_cache_wait_state(input clk, input reset);
                     // A3.2.1 "...the source must keep its information stable until the transfer
                     // occurs..."
                     assert(axi_bus.m_awaddr == ADDR0 * CACHE_LINE_BYTES);
-                    assert(axi_bus.m_awlen == 15);
+                    assert(axi_bus.m_awlen == 8'(BURST_BEATS - 1));
 
                     if (wait_count == 0)
                     begin
@@ -281,12 +299,13 @@ module test_l2_cache_wait_state(input clk, input reset);
 
                     // A3.2.2 "The master must assert the WLAST signal while
                     // it is driving the final write transfer in the burst."
-                    assert(axi_bus.m_wlast == (axi_burst_offset == 15));
+                    assert(axi_bus.m_wlast == (axi_burst_offset == BURST_BEATS - 1));
 
                     if (axi_bus.m_wvalid && axi_bus.s_wready)
                     begin
-                        assert(axi_bus.m_wdata == 32'(DATA1 >> ((15 - axi_burst_offset) * 32)));
-                        if (axi_burst_offset == 15)
+                        assert(axi_bus.m_wdata == `AXI_DATA_WIDTH'(DATA1
+                            >> ((BURST_BEATS - 1 - axi_burst_offset) * `AXI_DATA_WIDTH)));
+                        if (axi_burst_offset == BURST_BEATS - 1)
                             state <= state + 1;
                         else
                             axi_burst_offset <= axi_burst_offset + 1;
@@ -22,6 +22,7 @@ import defines::*;
 // Validate basic level two cache transactions.
 //
 module test_l2_cache(input clk, input reset);
+    localparam BURST_BEATS = CACHE_LINE_BITS / `AXI_DATA_WIDTH;
     localparam ADDR0 = 'h7;
     localparam DATA0 = 512'h88a84df3d616f6e7701e6461010a1f3f2c931fb4b396d059d177c51b3b17c82ad26c90f1f7040331efd466bde698718ec430b97e0c9241b9a57322c9b092bf3e;
 
@@ -50,8 +51,15 @@ module test_l2_cache(input clk, input reset);
     logic[`NUM_CORES - 1:0] l2i_request_valid;
     l2req_packet_t l2i_request[`NUM_CORES];
     logic l2_ready[`NUM_CORES];
+    logic l2_core_response_valid[`NUM_CORES];
+    l2rsp_packet_t l2_core_response[`NUM_CORES];
+    logic l2_dma_response_valid;
+    l2rsp_packet_t l2_dma_response;
     logic l2_response_valid;
     l2rsp_packet_t l2_response;
+    logic dma_l2_request_valid;
+    l2req_packet_t dma_l2_request;
+    logic l2_dma_ready;
     axi4_interface axi_bus();
     logic[L2_PERF_EVENTS - 1:0] l2_perf_events;
     int state;
@@ -61,9 +69,19 @@ module test_l2_cache(input clk, input reset);
 
     l2_cache l2_cache(.*);
 
+    // All requests are from core 0
+    assign l2_response_valid = l2_core_response_valid[0];
+    assign l2_response = l2_core_response[0];
+
+    // No DMA requests
+    assign dma_l2_request_valid = 0;
+    assign dma_l2_request = '0;
+    assign l2i_request[0].dma = 0;
+
     assign axi_bus.s_arready = 1;
     assign axi_bus.s_rvalid = 1;
-    assign axi_bus.s_rdata = 32'(axi_data >> ((15 - axi_burst_offset) * 32));
+    assign axi_bus.s_rdata = `AXI_DATA_WIDTH'(axi_data
+        >> ((BURST_BEATS - 1 - axi_burst_offset) * `AXI_DATA_WIDTH));
     assign axi_bus.s_bvalid = 1;
     assign axi_bus.s_awready = 1;
     assign axi_bus.s_wready = 1;
@@ -119,7 +137,7 @@ module test_l2_cache(input clk, input reset);
                     if (axi_bus.m_arvalid)
                     begin
                         assert(axi_bus.m_araddr == ADDR0 * CACHE_LINE_BYTES);
-                        assert(axi_bus.m_arlen == 15);
+                        assert(axi_bus.m_arlen == 8'(BURST_BEATS - 1));
                         state <= state + 1;
                         axi_burst_offset <= 0;
                     end
@@ -131,7 +149,7 @@ module test_l2_cache(input clk, input reset);
                     assert(!l2_response_valid);
                     if (axi_bus.m_rready)
                     begin
-                        if (axi_burst_offset == 15)
+                        if (axi_burst_offset == BURST_BEATS - 1)
                             state <= state + 1;
                         else
                             axi_burst_offset <= axi_burst_offset + 1;
@@ -173,7 +191,7 @@ module test_l2_cache(input clk, input reset);
                     if (axi_bus.m_arvalid)
                     begin
                         assert(axi_bus.m_araddr == ADDR1 * CACHE_LINE_BYTES);
-                        assert(axi_bus.m_arlen == 15);
+                        assert(axi_bus.m_arlen == 8'(BURST_BEATS - 1));
                         state <= state + 1;
                         axi_burst_offset <= 0;
                     end
@@ -185,7 +203,7 @@ module test_l2_cache(input clk, input reset);
                     assert(!l2_response_valid);
                     if (axi_bus.m_rready)
                     begin
-                        if (axi_burst_offset == 15)
+                        if (axi_burst_offset == BURST_BEATS - 1)
                             state <= state + 1;
                         else
                             axi_burst_offset <= axi_burst_offset + 1;
@@ -257,7 +275,7 @@ module test_l2_cache(input clk, input reset);
                     if (l2_response_valid)
                     begin
                         assert(l2_response.core == 0);
-                        assert(l2_response.id == 0);
+                        assert(l2_response.id == 4);
                         assert(l2_response.packet_type == L2RSP_STORE_ACK);
                         assert(l2_response.cache_type == CT_DCACHE);
                         assert(l2_response.address == ADDR0);
@@ -306,7 +324,7 @@ module test_l2_cache(input clk, input reset);
                     if (axi_bus.m_arvalid)
                     begin
                         assert(axi_bus.m_araddr == ADDR3 * CACHE_LINE_BYTES);
-                        assert(axi_bus.m_arlen == 15);
+                        assert(axi_bus.m_arlen == 8'(BURST_BEATS - 1));
                         state <= state + 1;
                         axi_burst_offset <= 0;
                     end
@@ -318,7 +336,7 @@ module test_l2_cache(input clk, input reset);
                     assert(!l2_response_valid);
                     if (axi_bus.m_rready)
                     begin
-                        if (axi_burst_offset == 15)
+                        if (axi_burst_offset == BURST_BEATS - 1)
                             state <= state + 1;
                         else
                             axi_burst_offset <= axi_burst_offset + 1;
@@ -383,7 +401,7 @@ module test_l2_cache(input clk, input reset);
                     if (axi_bus.m_awvalid)
                     begin
                         assert(axi_bus.m_awaddr == ADDR1 * CACHE_LINE_BYTES);
-                        assert(axi_bus.m_arlen == 15);
+                        assert(axi_bus.m_arlen == 8'(BURST_BEATS - 1));
                         state <= state + 1;
                         axi_burst_offset <= 0;
                     end
@@ -395,9 +413,10 @@ module test_l2_cache(input clk, input reset);
                     assert(!l2_response_valid);
                     if (axi_bus.m_wvalid)
                     begin
-                        assert(axi_bus.m_wdata == 32'(STORE_RESULT1 >> ((15 - axi_burst_offset) * 32)));
+                        assert(axi_bus.m_wdata == `AXI_DATA_WIDTH'(STORE_RESULT1
+                            >> ((BURST_BEATS - 1 - axi_burst_offset) * `AXI_DATA_WIDTH)));
 
-                        if (axi_burst_offset == 15)
+                        if (axi_burst_offset == BURST_BEATS - 1)
                             state <= state + 1;
                         else
                             axi_burst_offset <= axi_burst_offset + 1;
@@ -607,7 +626,7 @@ module test_l2_cache(input clk, input reset);
                     if (axi_bus.m_arvalid)
                     begin
                         assert(axi_bus.m_araddr == ADDR0 * CACHE_LINE_BYTES);
-                        assert(axi_bus.m_arlen == 15);
+                        assert(axi_bus.m_arlen == 8'(BURST_BEATS - 1));
                         state <= state + 1;
                         axi_burst_offset <= 0;
                         axi_data <= DATA4;
@@ -620,7 +639,7 @@ module test_l2_cache(input clk, input reset);
                     assert(!l2_response_valid);
                     if (axi_bus.m_rready)
                     begin
-                        if (axi_burst_offset == 15)
+                        if (axi_burst_offset == BURST_BEATS - 1)
                             state <= state + 1;
                         else
                             axi_burst_offset <= axi_burst_offset + 1;
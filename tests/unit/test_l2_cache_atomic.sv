@@ -31,17 +31,33 @@ module test_l2_cache_atomic(input clk, input reset);
     logic[`NUM_CORES - 1:0] l2i_request_valid;
     l2req_packet_t l2i_request[`NUM_CORES];
     logic l2_ready[`NUM_CORES];
+    logic l2_core_response_valid[`NUM_CORES];
+    l2rsp_packet_t l2_core_response[`NUM_CORES];
+    logic l2_dma_response_valid;
+    l2rsp_packet_t l2_dma_response;
     logic l2_response_valid;
     l2rsp_packet_t l2_response;
+    logic dma_l2_request_valid;
+    l2req_packet_t dma_l2_request;
+    logic l2_dma_ready;
     axi4_interface axi_bus();
     logic[L2_PERF_EVENTS - 1:0] l2_perf_events;
     int state;
 
     l2_cache l2_cache(.*);
 
+    // All requests are from core 0
+    assign l2_response_valid = l2_core_response_valid[0];
+    assign l2_response = l2_core_response[0];
+
+    // No DMA requests
+    assign dma_l2_request_valid = 0;
+    assign dma_l2_request = '0;
+    assign l2i_request[0].dma = 0;
+
     assign axi_bus.s_arready = 1;
     assign axi_bus.s_rvalid = 1;
-    assign axi_bus.s_rdata = 32'd0;
+    assign axi_bus.s_rdata = '0;
     assign axi_bus.s_bvalid = 1;
     assign axi_bus.s_awready = 1;
     assign axi_bus.s_wready = 1;
@@ -0,0 +1,288 @@
+//
+// Copyright 2019 Jeff Bush
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+`include "defines.svh"
+
+import defines::*;
+
+//
+// Check that a two bank L2 cache routes requests and responses by address,
+// and translates the addresses it puts on the AXI bus back from bank local
+// addresses. The core and DMA engine access lines in different banks.
+//
+module test_l2_cache_banks(input clk, input reset);
+    localparam NUM_BANKS = 2;
+    localparam BURST_BEATS = CACHE_LINE_BITS / `AXI_DATA_WIDTH;
+    localparam BEAT_IDX_WIDTH = $clog2(BURST_BEATS);
+    localparam ADDR0 = 'h10;    // Bank 0
+    localparam ADDR1 = 'h21;    // Bank 1
+    localparam STORE_DATA = 512'h100f067188502a5f107a9279dca9d1602d911573b3e5a87665e910df1cdf8389f7e8152e39d1366560ea3682a380645ff34dbe5ee0f5ced5b28f1b2f3b846865;
+    localparam STORE_MASK = 64'h00000000_0000ff00;
+
+    logic[`NUM_CORES - 1:0] l2i_request_valid;
+    l2req_packet_t l2i_request[`NUM_CORES];
+    logic l2_ready[`NUM_CORES];
+    logic l2_core_response_valid[`NUM_CORES];
+    l2rsp_packet_t l2_core_response[`NUM_CORES];
+    logic dma_l2_request_valid;
+    l2req_packet_t dma_l2_request;
+    logic l2_dma_ready;
+    logic l2_dma_response_valid;
+    l2rsp_packet_t l2_dma_response;
+    axi4_interface axi_bus();
+    logic[L2_PERF_EVENTS * NUM_BANKS - 1:0] l2_perf_events;
+    logic[AXI_ADDR_WIDTH - 1:0] read_address[8];
+    logic[2:0] read_head;
+    logic[2:0] read_tail;
+    logic[BEAT_IDX_WIDTH - 1:0] read_beat;
+    logic[AXI_ADDR_WIDTH - 1:0] write_address;
+    cache_line_data_t write_data;
+    logic[BEAT_IDX_WIDTH - 1:0] write_beat;
+    int write_count;
+    cache_line_data_t store_result;
+    logic got_core_response;
+    logic got_dma_response;
+    int state;
+
+    l2_cache #(.NUM_BANKS(NUM_BANKS)) l2_cache(.*);
+
+    // The contents of memory depend on the address, so any read from the
+    // wrong address returns the wrong data.
+    function cache_line_data_t memory_line(input cache_line_index_t line);
+        cache_line_data_t data;
+
+        for (int word = 0; word < CACHE_LINE_WORDS; word++)
+            data[word * 32+:32] = {16'(line), 16'(word)};
+
+        return data;
+    endfunction
+
+    function cache_line_data_t read_line(input logic[AXI_ADDR_WIDTH - 1:0] address);
+        return memory_line(address[AXI_ADDR_WIDTH - 1:CACHE_LINE_OFFSET_WIDTH]);
+    endfunction
+
+    always_comb
+    begin
+        cache_line_data_t original;
+
+        original = memory_line(ADDR1);
+        for (int byte_lane = 0; byte_lane < CACHE_LINE_BYTES; byte_lane++)
+        begin
+            store_result[byte_lane * 8+:8] = STORE_MASK[byte_lane]
+                ? STORE_DATA[byte_lane * 8+:8] : original[byte_lane * 8+:8];
+        end
+    end
+
+    task send_core_request(input l2req_packet_type_t packet_type,
+        input l2_addr_t address);
+
+        l2i_request_valid <= 1;
+        l2i_request[0] <= '0;
+        l2i_request[0].packet_type <= packet_type;
+        l2i_request[0].cache_type <= CT_DCACHE;
+        l2i_request[0].address <= address;
+        l2i_request[0].store_mask <= STORE_MASK;
+        l2i_request[0].data <= STORE_DATA;
+    endtask
+
+    task send_dma_load(input l2_addr_t address);
+        dma_l2_request_valid <= 1;
+        dma_l2_request <= '0;
+        dma_l2_request.dma <= 1;
+        dma_l2_request.packet_type <= L2REQ_LOAD;
+        dma_l2_request.cache_type <= CT_DCACHE;
+        dma_l2_request.address <= address;
+    endtask
+
+    // Memory model. Returns read data in the order addresses are accepted.
+    assign axi_bus.s_arready = 1;
+    assign axi_bus.s_rvalid = read_head != read_tail;
+    assign axi_bus.s_rdata = `AXI_DATA_WIDTH'(read_line(read_address[read_head])
+        >> ((BURST_BEATS - 1 - int'(read_beat)) * `AXI_DATA_WIDTH));
+    assign axi_bus.s_awready = 1;
+    assign axi_bus.s_wready = 1;
+
+    always @(posedge clk, posedge reset)
+    begin
+        if (reset)
+        begin
+            read_head <= '0;
+            read_tail <= '0;
+            read_beat <= '0;
+            write_beat <= '0;
+            write_count <= 0;
+            axi_bus.s_bvalid <= 0;
+        end
+        else
+        begin
+            if (axi_bus.m_arvalid)
+            begin
+                assert(axi_bus.m_arlen == 8'(BURST_BEATS - 1));
+                read_address[read_tail] <= axi_bus.m_araddr;
+                read_tail <= read_tail + 3'd1;
+            end
+
+            if (axi_bus.s_rvalid && axi_bus.m_rready)
+            begin
+                read_beat <= read_beat + BEAT_IDX_WIDTH'(1);
+                if (read_beat == BEAT_IDX_WIDTH'(BURST_BEATS - 1))
+                    read_head <= read_head + 3'd1;
+            end
+
+            if (axi_bus.m_awvalid)
+                write_address <= axi_bus.m_awaddr;
+
+            axi_bus.s_bvalid <= 0;
+            if (axi_bus.m_wvalid)
+            begin
+                write_data[(BURST_BEATS - 1 - int'(write_beat)) * `AXI_DATA_WIDTH+:`AXI_DATA_WIDTH]
+                    <= axi_bus.m_wdata;
+                write_beat <= write_beat + BEAT_IDX_WIDTH'(1);
+                if (axi_bus.m_wlast)
+                begin
+                    write_count <= write_count + 1;
+                    axi_bus.s_bvalid <= 1;
+                end
+            end
+        end
+    end
+
+    always @(posedge clk, posedge reset)
+    begin
+        if (reset)
+        begin
+            state <= 0;
+            l2i_request_valid <= '0;
+            l2i_request[0] <= '0;
+            dma_l2_request_valid <= 0;
+            dma_l2_request <= '0;
+            got_core_response <= 0;
+            got_dma_response <= 0;
+        end
+        else
+        begin
+            l2i_request_valid <= '0;
+            dma_l2_request_valid <= 0;
+
+            // Requests to different banks are accepted in the same cycle
+            if (l2i_request_valid[0])
+                assert(l2_ready[0]);
+
+            if (dma_l2_request_valid)
+                assert(l2_dma_ready);
+
+            unique case (state)
+                // Load misses in both banks
+                0:
+                begin
+                    send_core_request(L2REQ_LOAD, ADDR0);
+                    send_dma_load(ADDR1);
+                    state <= state + 1;
+                end
+
+                1:
+                begin
+                    if (l2_core_response_valid[0])
+                    begin
+                        assert(l2_core_response[0].packet_type == L2RSP_LOAD_ACK);
+                        assert(!l2_core_response[0].dma);
+                        assert(l2_core_response[0].address == ADDR0);
+                        assert(l2_core_response[0].data == memory_line(ADDR0));
+                        got_core_response <= 1;
+                    end
+
+                    if (l2_dma_response_valid)
+                    begin
+                        assert(l2_dma_response.packet_type == L2RSP_LOAD_ACK);
+                        assert(l2_dma_response.dma);
+                        assert(l2_dma_response.address == ADDR1);
+                        assert(l2_dma_response.data == memory_line(ADDR1));
+                        got_dma_response <= 1;
+                    end
+
+                    if (got_core_response && got_dma_response)
+                        state <= state + 1;
+                end
+
+                // Store to the line in bank 1, then flush it
+                2:
+                begin
+                    send_core_request(L2REQ_STORE, ADDR1);
+                    state <= state + 1;
+                end
+
+                3:
+                begin
+                    assert(!l2_dma_response_valid);
+                    if (l2_core_response_valid[0])
+                    begin
+                        assert(l2_core_response[0].packet_type == L2RSP_STORE_ACK);
+                        assert(l2_core_response[0].address == ADDR1);
+                        assert(l2_core_response[0].data == store_result);
+                        state <= state + 1;
+                    end
+                end
+
+                4:
+                begin
+                    send_core_request(L2REQ_FLUSH, ADDR1);
+                    state <= state + 1;
+                end
+
+                5:
+                begin
+                    if (l2_core_response_valid[0])
+                    begin
+                        assert(l2_core_response[0].packet_type == L2RSP_FLUSH_ACK);
+                        assert(write_count == 1);
+                        assert(write_address == ADDR1 * CACHE_LINE_BYTES);
+                        assert(write_data == store_result);
+                        state <= state + 1;
+                    end
+                end
+
+                // Hits in both banks. The responses go to different
+                // destinations, so they are delivered in the same cycle.
+                6:
+                begin
+                    send_core_request(L2REQ_LOAD, ADDR0);
+                    send_dma_load(ADDR1);
+                    state <= state + 1;
+                end
+
+                7:
+                begin
+                    if (l2_core_response_valid[0] || l2_dma_response_valid)
+                    begin
+                        assert(l2_core_response_valid[0]);
+                        assert(l2_dma_response_valid);
+                        assert(l2_core_response[0].address == ADDR0);
+                        assert(l2_core_response[0].data == memory_line(ADDR0));
+                        assert(l2_dma_response.address == ADDR1);
+                        assert(l2_dma_response.data == store_result);
+                        state <= state + 1;
+                    end
+                end
+
+                8:
+                begin
+                    $display("PASS");
+                    $finish;
+                end
+            endcase
+        end
+    end
+endmodule
@@ -0,0 +1,121 @@
+//
+// Copyright 2018 Jeff Bush
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+`include "defines.svh"
+
+import defines::*;
+
+//
+// Check stride detection in the L2 prefetcher. This assumes the default
+// L2_PREFETCH_DISTANCE of 4.
+//
+module test_l2_cache_prefetcher(input clk, input reset);
+    logic l2r_prefetch_trigger;
+    l2req_packet_t l2r_request;
+    logic l2pf_request_valid;
+    cache_line_index_t l2pf_address;
+    logic l2a_prefetch_accepted;
+    int cycle;
+
+    l2_cache_prefetcher l2_cache_prefetcher(.*);
+
+    task trigger(input l1_miss_entry_idx_t thread_idx, input cache_line_index_t line);
+        l2r_prefetch_trigger <= 1;
+        l2r_request.core <= 0;
+        l2r_request.id <= thread_idx;
+        l2r_request.address <= l2_addr_t'(line);
+    endtask
+
+    always @(posedge clk, posedge reset)
+    begin
+        if (reset)
+        begin
+            cycle <= 0;
+            l2r_prefetch_trigger <= 0;
+            l2r_request <= '0;
+            l2a_prefetch_accepted <= 0;
+        end
+        else
+        begin
+            // Default values
+            l2r_prefetch_trigger <= 0;
+            l2a_prefetch_accepted <= 0;
+
+            cycle <= cycle + 1;
+            unique0 case (cycle)
+                ////////////////////////////////////////////////////////////
+                // Sequential stream, interleaved with another thread
+                ////////////////////////////////////////////////////////////
+                0: trigger(0, 'h100);
+                1: trigger(0, 'h101);
+                2: trigger(1, 'h200);
+                3: trigger(0, 'h102);
+                4: assert(!l2pf_request_valid);
+
+                5:
+                begin
+                    assert(l2pf_request_valid);
+                    assert(l2pf_address == 'h106);
+                    l2a_prefetch_accepted <= 1;
+                end
+
+                6: assert(l2pf_request_valid);
+
+                ////////////////////////////////////////////////////////////
+                // Negative stride
+                ////////////////////////////////////////////////////////////
+                7:
+                begin
+                    assert(!l2pf_request_valid);
+                    trigger(1, 'h1fe);
+                end
+
+                8: trigger(1, 'h1fc);
+
+                10:
+                begin
+                    assert(l2pf_request_valid);
+                    assert(l2pf_address == 'h1f4);
+                    l2a_prefetch_accepted <= 1;
+                end
+
+                ////////////////////////////////////////////////////////////
+                // Don't prefetch across a page boundary
+                ////////////////////////////////////////////////////////////
+                12: trigger(2, 'h13c);
+                13: trigger(2, 'h13d);
+                14: trigger(2, 'h13e);
+                16: assert(!l2pf_request_valid);
+
+                ////////////////////////////////////////////////////////////
+                // A repeated trigger for the same line (a collided miss)
+                // doesn't break the stream.
+                ////////////////////////////////////////////////////////////
+                17: trigger(0, 'h102);
+                18: trigger(0, 'h103);
+                19: assert(!l2pf_request_valid);
+
+                20:
+                begin
+                    assert(l2pf_request_valid);
+                    assert(l2pf_address == 'h107);
+                    $display("PASS");
+                    $finish;
+                end
+            endcase
+        end
+    end
+endmodule
@@ -0,0 +1,137 @@
+//
+// Copyright 2019 Jeff Bush
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+`include "defines.svh"
+
+import defines::*;
+
+//
+// Check which requests mark a core as a sharer. Each state sends a request
+// and checks the sharers the filter returned for the previous one, which
+// don't include the update that request makes.
+//
+module test_l2_cache_snoop_filter(input clk, input reset);
+    localparam ADDR0 = 'h1234;
+    localparam ADDR1 = 'h1235;
+    localparam ADDR2 = 'h1236;
+
+    logic l2r_request_valid;
+    l2req_packet_t l2r_request;
+    logic[`NUM_CORES - 1:0] l2sf_sharers;
+    int state;
+
+    l2_cache_snoop_filter l2_cache_snoop_filter(.*);
+
+    task send_request(input l2req_packet_type_t packet_type,
+        input cache_type_t cache_type,
+        input logic dma,
+        input cache_line_index_t address,
+        input logic valid = 1);
+
+        l2r_request_valid <= valid;
+        l2r_request <= '0;
+        l2r_request.dma <= dma;
+        l2r_request.packet_type <= packet_type;
+        l2r_request.cache_type <= cache_type;
+        l2r_request.address <= address;
+    endtask
+
+    always @(posedge clk, posedge reset)
+    begin
+        if (reset)
+        begin
+            state <= 0;
+            l2r_request_valid <= 0;
+            l2r_request <= '0;
+        end
+        else
+        begin
+            unique case (state)
+                // Requests that don't fill the L1 data cache
+                0: send_request(L2REQ_STORE, CT_DCACHE, 1, ADDR0);
+                1:
+                begin
+                    assert(l2sf_sharers == '0);
+                    send_request(L2REQ_LOAD, CT_ICACHE, 0, ADDR0);
+                end
+
+                2:
+                begin
+                    assert(l2sf_sharers == '0);
+                    send_request(L2REQ_FLUSH, CT_DCACHE, 0, ADDR0);
+                end
+
+                3:
+                begin
+                    assert(l2sf_sharers == '0);
+                    send_request(L2REQ_LOAD, CT_DCACHE, 0, ADDR0);
+                end
+
+                // Data load from a core
+                4:
+                begin
+                    assert(l2sf_sharers == '0);
+                    send_request(L2REQ_STORE, CT_DCACHE, 1, ADDR0);
+                end
+
+                5:
+                begin
+                    assert(l2sf_sharers == 1);
+
+                    // This line shares the entry with ADDR0
+                    send_request(L2REQ_STORE, CT_DCACHE, 1,
+                        cache_line_index_t'(ADDR0 + `L2_SNOOP_FILTER_ENTRIES));
+                end
+
+                6:
+                begin
+                    assert(l2sf_sharers == 1);
+                    send_request(L2REQ_STORE, CT_DCACHE, 1, ADDR1);
+                end
+
+                // Data store from a core
+                7:
+                begin
+                    assert(l2sf_sharers == '0);
+                    send_request(L2REQ_STORE, CT_DCACHE, 0, ADDR1);
+                end
+
+                8:
+                begin
+                    assert(l2sf_sharers == '0);
+                    send_request(L2REQ_STORE, CT_DCACHE, 1, ADDR1);
+                end
+
+                // Request that isn't valid
+                9:
+                begin
+                    assert(l2sf_sharers == 1);
+                    send_request(L2REQ_LOAD, CT_DCACHE, 0, ADDR2, 0);
+                end
+
+                10: send_request(L2REQ_STORE, CT_DCACHE, 1, ADDR2);
+                11:
+                begin
+                    assert(l2sf_sharers == '0);
+                    $display("PASS");
+                    $finish;
+                end
+            endcase
+
+            state <= state + 1;
+        end
+    end
+endmodule
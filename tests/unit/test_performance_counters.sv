@@ -0,0 +1,187 @@
+//
+// Copyright 2018 Jeff Bush
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+`include "defines.svh"
+
+import defines::*;
+
+module test_performance_counters(input clk, input reset);
+    localparam NUM_EVENTS = 4;
+    localparam NUM_THREAD_EVENTS = 3;
+    localparam EVENT_IDX_WIDTH = $clog2(NUM_EVENTS);
+    localparam NUM_COUNTERS = 2;
+
+    logic[NUM_EVENTS - 1:0] perf_events;
+    local_thread_idx_t[NUM_THREAD_EVENTS - 1:0] perf_event_thread;
+    logic[NUM_COUNTERS - 1:0][EVENT_IDX_WIDTH - 1:0] cr_perf_event_select;
+    local_thread_bitmap_t cr_perf_thread_mask[NUM_COUNTERS];
+    logic[NUM_COUNTERS - 1:0] cr_perf_count_write_en;
+    logic cr_perf_count_write_high;
+    scalar_t cr_perf_count_write_val;
+    logic[NUM_COUNTERS - 1:0][63:0] perf_event_count;
+    logic[NUM_COUNTERS - 1:0] perf_event_overflow;
+    int cycle;
+
+    performance_counters #(
+        .NUM_EVENTS(NUM_EVENTS),
+        .NUM_THREAD_EVENTS(NUM_THREAD_EVENTS),
+        .NUM_COUNTERS(NUM_COUNTERS)
+    ) performance_counters(.*);
+
+    always @(posedge clk, posedge reset)
+    begin
+        if (reset)
+        begin
+            cycle <= 0;
+            perf_events <= '0;
+            perf_event_thread <= '0;
+            cr_perf_event_select <= '0;
+            for (int i = 0; i < NUM_COUNTERS; i++)
+                cr_perf_thread_mask[i] <= '0;
+
+            cr_perf_count_write_en <= '0;
+            cr_perf_count_write_high <= '0;
+            cr_perf_count_write_val <= '0;
+        end
+        else
+        begin
+            cycle <= cycle + 1;
+            unique0 case (cycle)
+                ////////////////////////////////////////////////////////////
+                // Thread filtering
+                ////////////////////////////////////////////////////////////
+                0:
+                begin
+                    cr_perf_event_select[0] <= 1;
+                    cr_perf_event_select[1] <= 2;
+                    cr_perf_thread_mask[0] <= '1;
+                    cr_perf_thread_mask[1] <= 4'b0010;
+                    perf_events <= 4'b0110;
+                    perf_event_thread[1] <= 3;
+                    perf_event_thread[2] <= 1;
+                end
+
+                // Event 2 is now from a thread that counter 1 ignores
+                1: perf_event_thread[2] <= 2;
+
+                2:
+                begin
+                    assert(perf_event_count[0] == 1);
+                    assert(perf_event_count[1] == 1);
+                    perf_events <= '0;
+                end
+
+                3:
+                begin
+                    assert(perf_event_count[0] == 2);
+                    assert(perf_event_count[1] == 1);
+
+                    cr_perf_count_write_en <= 2'b10;
+                    cr_perf_count_write_high <= 1;
+                    cr_perf_count_write_val <= 32'hffffffff;
+                end
+
+                4:
+                begin
+                    cr_perf_count_write_high <= 0;
+                    cr_perf_count_write_val <= 32'hfffffffe;
+                end
+
+                ////////////////////////////////////////////////////////////
+                // Overflow
+                ////////////////////////////////////////////////////////////
+                5:
+                begin
+                    assert(perf_event_count[1] == 64'hffffffff_00000001);
+                    cr_perf_count_write_en <= '0;
+                    perf_events <= 4'b0100;
+                    perf_event_thread[2] <= 1;
+                end
+
+                6:
+                begin
+                    assert(perf_event_count[1] == 64'hffffffff_fffffffe);
+                    assert(perf_event_count[0] == 2);
+                end
+
+                7:
+                begin
+                    assert(perf_event_count[1] == 64'hffffffff_ffffffff);
+                    assert(perf_event_overflow == 2'b00);
+                    perf_events <= '0;
+                end
+
+                8:
+                begin
+                    assert(perf_event_count[1] == 0);
+                    assert(perf_event_overflow == 2'b10);
+                end
+
+                9:
+                begin
+                    assert(perf_event_count[1] == 0);
+                    assert(perf_event_overflow == 2'b00);
+                end
+
+                ////////////////////////////////////////////////////////////
+                // A write takes precedence over an event in the same cycle
+                ////////////////////////////////////////////////////////////
+                10:
+                begin
+                    perf_events <= 4'b0100;
+                    cr_perf_count_write_en <= 2'b10;
+                    cr_perf_count_write_val <= 5;
+                end
+
+                11: cr_perf_count_write_en <= '0;
+
+                12: assert(perf_event_count[1] == 5);
+
+                13:
+                begin
+                    assert(perf_event_count[1] == 6);
+                    perf_events <= '0;
+                    cr_perf_event_select[1] <= 3;
+                    cr_perf_count_write_en <= 2'b10;
+                    cr_perf_count_write_val <= 0;
+                end
+
+                ////////////////////////////////////////////////////////////
+                // The thread mask doesn't apply to events past
+                // NUM_THREAD_EVENTS. Counter 1 only counts thread 1.
+                ////////////////////////////////////////////////////////////
+                14:
+                begin
+                    cr_perf_count_write_en <= '0;
+                    perf_events <= 4'b1000;
+                end
+
+                15:
+                begin
+                    assert(perf_event_count[1] == 0);
+                    perf_events <= '0;
+                end
+
+                16:
+                begin
+                    assert(perf_event_count[1] == 1);
+                    $display("PASS");
+                    $finish;
+                end
+            endcase
+        end
+    end
+endmodule
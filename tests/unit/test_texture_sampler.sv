@@ -0,0 +1,351 @@
+//
+// Copyright 2019 Jeff Bush
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+`include "defines.svh"
+
+import defines::*;
+
+//
+// Run a bilinear job with 32-bit texels and a nearest neighbor job with gray
+// texels, and check the results against a model of the filter. Texture rows
+// are in different cache lines and coordinates wrap around the edges, which
+// checks that the line buffers are reused.
+//
+module test_texture_sampler(input clk, input reset);
+    localparam CORE_ID = 2;
+    localparam JOB_LINE = 'h200;
+    localparam TEX_BASE = 'h4000;
+    localparam TEX_WIDTH = 4;
+    localparam TEX_HEIGHT = 4;
+    localparam TEX_STRIDE = 64;
+    localparam L2_LATENCY = 3;
+
+    logic ii_tex_write_en;
+    logic[3:0] ii_tex_reg;
+    local_thread_idx_t ii_tex_thread;
+    scalar_t ii_tex_write_data;
+    scalar_t tex_read_data;
+    logic tex_l2_request_valid;
+    l2req_packet_t tex_l2_request;
+    logic l2_tex_ready;
+    logic l2_response_valid;
+    l2rsp_packet_t l2_response;
+    l2req_packet_t pending_request;
+    int response_delay;
+    int load_count;
+    logic job_gray;
+    logic job_bilinear;
+    vector_mask_t job_mask;
+    vector_t job_u;
+    vector_t job_v;
+    int state;
+
+    texture_sampler #(.CORE_ID(core_id_t'(CORE_ID))) texture_sampler(.*);
+
+    function logic[7:0] texture_byte(input int address);
+        return 8'((address * 7) ^ (address >> 6));
+    endfunction
+
+    // Words are little endian, byte lanes are in reverse order of address.
+    function cache_line_data_t to_line(input vector_t words);
+        cache_line_data_t line;
+
+        for (int i = 0; i < NUM_VECTOR_LANES; i++)
+        begin
+            line[(CACHE_LINE_WORDS - 1 - i) * 32+:32] = {words[i][7:0], words[i][15:8],
+                words[i][23:16], words[i][31:24]};
+        end
+
+        return line;
+    endfunction
+
+    function scalar_t line_word(input cache_line_data_t line, input int index);
+        scalar_t word;
+
+        word = line[(CACHE_LINE_WORDS - 1 - index) * 32+:32];
+        return {word[7:0], word[15:8], word[23:16], word[31:24]};
+    endfunction
+
+    function cache_line_data_t memory_line(input cache_line_index_t line);
+        vector_t words;
+        cache_line_data_t data;
+
+        if (line == cache_line_index_t'(JOB_LINE))
+        begin
+            words = '0;
+            words[0] = TEX_BASE;
+            words[1] = TEX_WIDTH;
+            words[2] = TEX_HEIGHT;
+            words[3] = TEX_STRIDE;
+            words[4] = scalar_t'(job_gray);
+            words[5] = scalar_t'(job_bilinear);
+            words[6] = scalar_t'(job_mask);
+            return to_line(words);
+        end
+        else if (line == cache_line_index_t'(JOB_LINE + 1))
+            return to_line(job_u);
+        else if (line == cache_line_index_t'(JOB_LINE + 2))
+            return to_line(job_v);
+
+        for (int i = 0; i < CACHE_LINE_BYTES; i++)
+        begin
+            data[(CACHE_LINE_BYTES - 1 - i) * 8+:8] = texture_byte(int'(line)
+                * CACHE_LINE_BYTES + i);
+        end
+
+        return data;
+    endfunction
+
+    function scalar_t expected_color(input int lane);
+        int x0;
+        int y0;
+        int x1;
+        int y1;
+        int fu;
+        int fv;
+        scalar_t color;
+
+        x0 = int'(job_u[lane] >> 16);
+        y0 = int'(job_v[lane] >> 16);
+        x1 = x0 + 1 == TEX_WIDTH ? 0 : x0 + 1;
+        y1 = y0 + 1 == TEX_HEIGHT ? 0 : y0 + 1;
+        fu = int'(job_u[lane][15:8]);
+        fv = int'(job_v[lane][15:8]);
+        for (int channel = 0; channel < 4; channel++)
+        begin
+            int sum;
+
+            sum = 0;
+            for (int texel = 0; texel < 4; texel++)
+            begin
+                int x;
+                int y;
+                int weight;
+                int address;
+
+                x = texel[0] ? x1 : x0;
+                y = texel[1] ? y1 : y0;
+                if (job_bilinear)
+                    weight = (texel[0] ? fu : 256 - fu) * (texel[1] ? fv : 256 - fv);
+                else
+                    weight = texel == 0 ? 65536 : 0;
+
+                address = TEX_BASE + y * TEX_STRIDE + (job_gray ? x : x * 4 + channel);
+                sum += int'(texture_byte(address)) * weight;
+            end
+
+            color[channel * 8+:8] = 8'((sum + 'h8000) >> 16);
+        end
+
+        return color;
+    endfunction
+
+    // L2 cache model, one request at a time
+    assign l2_tex_ready = response_delay == 0 && !l2_response_valid;
+
+    always @(posedge clk, posedge reset)
+    begin
+        if (reset)
+        begin
+            response_delay <= 0;
+            load_count <= 0;
+            l2_response_valid <= 0;
+        end
+        else
+        begin
+            l2_response_valid <= 0;
+            if (ii_tex_write_en)
+                load_count <= 0;
+
+            if (tex_l2_request_valid && l2_tex_ready)
+            begin
+                assert(tex_l2_request.dma);
+                assert(tex_l2_request.core == core_id_t'(CORE_ID));
+                assert(tex_l2_request.id == L2_DMA_ID_TEXTURE);
+                pending_request <= tex_l2_request;
+                response_delay <= L2_LATENCY;
+                if (tex_l2_request.packet_type == L2REQ_LOAD)
+                    load_count <= load_count + 1;
+            end
+            else if (response_delay != 0)
+            begin
+                response_delay <= response_delay - 1;
+                if (response_delay == 1)
+                begin
+                    l2_response_valid <= 1;
+                    l2_response <= '0;
+                    l2_response.core <= pending_request.core;
+                    l2_response.dma <= 1;
+                    l2_response.id <= pending_request.id;
+                    l2_response.address <= pending_request.address;
+                    if (pending_request.packet_type == L2REQ_LOAD)
+                    begin
+                        l2_response.packet_type <= L2RSP_LOAD_ACK;
+                        l2_response.data <= memory_line(pending_request.address);
+                    end
+                    else
+                        l2_response.packet_type <= L2RSP_STORE_ACK;
+                end
+            end
+        end
+    end
+
+    task start_job(input local_thread_idx_t thread);
+        ii_tex_write_en <= 1;
+        ii_tex_reg <= 0;
+        ii_tex_thread <= thread;
+        ii_tex_write_data <= JOB_LINE * CACHE_LINE_BYTES;
+    endtask
+
+    task check_results;
+        assert(tex_l2_request.packet_type == L2REQ_STORE);
+        assert(tex_l2_request.address == cache_line_index_t'(JOB_LINE + 3));
+        for (int lane = 0; lane < NUM_VECTOR_LANES; lane++)
+        begin
+            assert(tex_l2_request.store_mask[(CACHE_LINE_WORDS - 1 - lane) * 4+:4]
+                == {4{job_mask[lane]}});
+            if (job_mask[lane])
+                assert(line_word(tex_l2_request.data, lane) == expected_color(lane));
+        end
+    endtask
+
+    always @(posedge clk, posedge reset)
+    begin
+        if (reset)
+        begin
+            state <= 0;
+            ii_tex_write_en <= 0;
+            ii_tex_reg <= 0;
+            ii_tex_thread <= 0;
+            ii_tex_write_data <= 0;
+        end
+        else
+        begin
+            ii_tex_write_en <= 0;
+
+            unique case (state)
+                // Bilinear job. Lane 2 wraps in both directions.
+                0:
+                begin
+                    job_u <= '0;
+                    job_v <= '0;
+                    job_gray <= 0;
+                    job_bilinear <= 1;
+                    job_mask <= 16'h0005;
+                    job_u[0] <= 32'h00018000;    // 1.5
+                    job_v[0] <= 32'h00024000;    // 2.25
+                    job_u[2] <= 32'h00038000;    // 3.5
+                    job_v[2] <= 32'h000300c0;    // 3.0, fraction below the weight bits
+                    start_job(1);
+                    state <= state + 1;
+                end
+
+                // Check status for the thread that started the job and another one
+                1:
+                begin
+                    ii_tex_reg <= 1;
+                    ii_tex_thread <= 1;
+                    state <= state + 1;
+                end
+
+                2:
+                begin
+                    ii_tex_thread <= 0;
+                    state <= state + 1;
+                end
+
+                3:
+                begin
+                    assert(tex_read_data == 1);
+                    ii_tex_reg <= 2;
+                    state <= state + 1;
+                end
+
+                4:
+                begin
+                    assert(tex_read_data == 0);
+                    state <= state + 1;
+                end
+
+                5:
+                begin
+                    assert(tex_read_data == 32'h54455831);
+                    state <= state + 1;
+                end
+
+                6:
+                begin
+                    if (tex_l2_request_valid && tex_l2_request.packet_type == L2REQ_STORE)
+                    begin
+                        check_results;
+
+                        // Three job lines, texel rows 2 and 3, then row 0 when
+                        // lane 2 wraps.
+                        assert(load_count == 6);
+                        state <= state + 1;
+                    end
+                end
+
+                // Status is cleared when the store is acknowledged
+                7:
+                begin
+                    ii_tex_reg <= 1;
+                    ii_tex_thread <= 1;
+                    if (l2_response_valid)
+                        state <= state + 1;
+                end
+
+                8: state <= state + 1;
+
+                9:
+                begin
+                    assert(tex_read_data == 0);
+                    state <= state + 1;
+                end
+
+                // Nearest neighbor job with gray texels
+                10:
+                begin
+                    job_gray <= 1;
+                    job_bilinear <= 0;
+                    job_mask <= 16'h8002;
+                    job_u[1] <= 32'h0002ffff;
+                    job_v[1] <= 32'h00010000;
+                    job_u[15] <= 32'h00030000;
+                    job_v[15] <= 32'h00038000;
+                    start_job(3);
+                    state <= state + 1;
+                end
+
+                11:
+                begin
+                    if (tex_l2_request_valid && tex_l2_request.packet_type == L2REQ_STORE)
+                    begin
+                        check_results;
+                        assert(load_count == 5);
+                        state <= state + 1;
+                    end
+                end
+
+                12:
+                begin
+                    $display("PASS");
+                    $finish;
+                end
+            endcase
+        end
+    end
+endmodule
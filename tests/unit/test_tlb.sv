@@ -33,6 +33,11 @@ module test_tlb(input clk, input reset);
     localparam PPAGE5 = 20'h72682;
     localparam PPAGE6 = 20'h366ac;
 
+    // Superpages only use the upper bits of these
+    localparam SUPER_VPAGE = 20'h12345;
+    localparam SUPER_PPAGE1 = 20'h6a8f3;
+    localparam SUPER_PPAGE2 = 20'h7fc00;
+
     logic lookup_en;
     logic update_en;
     logic invalidate_en;
@@ -44,6 +49,7 @@ module test_tlb(input clk, input reset);
     logic update_exe_writable;
     logic update_supervisor;
     logic update_global;
+    logic update_superpage;
     page_index_t lookup_ppage_idx;
     logic lookup_hit;
     logic lookup_present;
@@ -77,6 +83,21 @@ module test_tlb(input clk, input reset);
         update_exe_writable <= writable;
         update_supervisor <= supervisor;
         update_global <= global;
+        update_superpage <= 0;
+    endtask
+
+    task update_super_page(input page_index_t vpageidx, input page_index_t ppageidx,
+        input logic [ASID_WIDTH - 1:0] asid, logic writable);
+
+        update_en <= 1;
+        request_vpage_idx <= vpageidx;
+        request_asid <= asid;
+        update_ppage_idx <= ppageidx;
+        update_present <= 1;
+        update_exe_writable <= writable;
+        update_supervisor <= 0;
+        update_global <= 0;
+        update_superpage <= 1;
     endtask
 
     always @(posedge clk, posedge reset)
@@ -95,6 +116,7 @@ module test_tlb(input clk, input reset);
             update_exe_writable <= 0;
             update_supervisor <= 0;
             update_global <= 0;
+            update_superpage <= 0;
         end
         else
         begin
@@ -306,7 +328,69 @@ module test_tlb(input clk, input reset);
                 41: update_page(VPAGE6, PPAGE1, 2, 1, 1, 0, 0); // ASID 2, present, global
                 43: lookup_page(VPAGE6, 1);
 
-                50:
+                ///////////////////////////////////////////////////////////
+                // Superpages
+                ///////////////////////////////////////////////////////////
+                50: invalidate_all_en <= 1;
+                51: update_super_page(SUPER_VPAGE, SUPER_PPAGE1, 0, 1);
+
+                // Last page in the superpage
+                52: lookup_page(SUPER_VPAGE | 20'h3ff, 0);
+                54:
+                begin
+                    assert(lookup_hit);
+                    assert(lookup_ppage_idx == ((SUPER_PPAGE1 & 20'hffc00) | 20'h3ff));
+                    assert(lookup_present);
+                    assert(lookup_exe_writable);
+                    assert(!lookup_supervisor);
+
+                    // Page after the superpage
+                    lookup_page((SUPER_VPAGE | 20'h3ff) + 20'h1, 0);
+                end
+
+                56:
+                begin
+                    assert(!lookup_hit);
+
+                    // Other ASID
+                    lookup_page(SUPER_VPAGE, 1);
+                end
+
+                58:
+                begin
+                    assert(!lookup_hit);
+
+                    // A 4k page inside the superpage takes priority
+                    update_page(SUPER_VPAGE, PPAGE3, 0, 1, 0, 1, 0);
+                end
+
+                59: lookup_page(SUPER_VPAGE, 0);
+                61:
+                begin
+                    assert(lookup_hit);
+                    assert(lookup_ppage_idx == PPAGE3);
+
+                    // Replacing the superpage removes the 4k page
+                    update_super_page(SUPER_VPAGE, SUPER_PPAGE2, 0, 0);
+                end
+
+                62: lookup_page(SUPER_VPAGE, 0);
+                64:
+                begin
+                    assert(lookup_hit);
+                    assert(lookup_ppage_idx == (SUPER_PPAGE2 | (SUPER_VPAGE & 20'h3ff)));
+                    assert(!lookup_exe_writable);
+
+                    // Invalidating any page in the superpage removes it
+                    invalidate_en <= 1;
+                    request_vpage_idx <= SUPER_VPAGE & 20'hffc00;
+                    request_asid <= 0;
+                end
+
+                65: lookup_page(SUPER_VPAGE, 0);
+                67: assert(!lookup_hit);
+
+                70:
                 begin
                     $display("PASS");
                     $finish;
@@ -61,17 +61,22 @@ module test_writeback_stage(input clk, input reset);
     scalar_t ix_rollback_pc;
     subcycle_t ix_subcycle;
     logic ix_privileged_op_fault;
+    logic ix_suspend_thread;
     logic dd_instruction_valid;
     decoded_instruction_t dd_instruction;
     vector_mask_t dd_lane_mask;
     local_thread_idx_t dd_thread_idx;
     l1d_addr_t dd_request_vaddr;
     subcycle_t dd_subcycle;
+    scgath_word_idx_t dd_scgath_word_idx;
+    logic dd_scgath_covered;
+    logic dd_scgath_run_done;
     logic dd_rollback_en;
     scalar_t dd_rollback_pc;
     cache_line_data_t dd_load_data;
     logic dd_suspend_thread;
     logic dd_io_access;
+    logic dd_scratchpad_access;
     logic dd_trap;
     trap_cause_t dd_trap_cause;
     logic[CACHE_LINE_BYTES - 1:0] sq_store_bypass_mask;
@@ -133,9 +138,13 @@ module test_writeback_stage(input clk, input reset);
             dd_thread_idx <= '0;
             dd_request_vaddr <= '0;
             dd_subcycle <= '0;
+            dd_scgath_word_idx <= '0;
+            dd_scgath_covered <= '0;
+            dd_scgath_run_done <= '0;
             dd_rollback_pc <= '0;
             dd_load_data <= '0;
             dd_io_access <= '0;
+            dd_scratchpad_access <= '0;
             dd_trap_cause <= '0;
             sq_store_bypass_mask <= '0;
             sq_store_bypass_data <= '0;
@@ -162,6 +171,7 @@ module test_writeback_stage(input clk, input reset);
             fx5_instruction <= '0;
             dd_instruction <= '0;
             ix_privileged_op_fault <= '0;
+            ix_suspend_thread <= '0;
 
             cycle <= cycle + 1;
             unique0 case (cycle)
@@ -22,6 +22,15 @@
 
 #define KEY_BUFFER_SIZE 64
 #define SERIAL_BUFFER_SIZE 64
+#define DMA_CONTROL_FILL 1
+#define DMA_CONTROL_INT_EN 2
+#define DMA_STATUS_DONE 2
+#define TEXTURE_SAMPLER_ID 0x54455831
+#define TEXTURE_GRAY8 1
+#define TEXTURE_BILINEAR 1
+#define TEXTURE_JOB_U 64
+#define TEXTURE_JOB_V 128
+#define TEXTURE_JOB_RESULT 192
 
 extern void send_host_interrupt(uint32_t num);
 
@@ -33,12 +42,128 @@ static int serial_read_buf_head;
 static int serial_read_buf_tail;
 static struct processor *proc;
 static int last_sdmmc_response;
+static uint32_t dma_src;
+static uint32_t dma_dest;
+static uint32_t dma_row_bytes;
+static uint32_t dma_rows;
+static uint32_t dma_src_stride;
+static uint32_t dma_dest_stride;
+static uint32_t dma_fill_value;
+static uint32_t dma_control;
+static bool dma_done;
 
 void init_device(struct processor *_proc)
 {
     proc = _proc;
 }
 
+// The emulated DMA engine finishes the transfer before the register write
+// returns, so software never sees it busy. Unlike the hardware, copies don't
+// require the source and destination to have the same cache line offset.
+static void start_dma(uint32_t control)
+{
+    uint32_t row;
+    uint32_t offset;
+    uint32_t value;
+
+    dma_control = control;
+    for (row = 0; row < dma_rows; row++)
+    {
+        for (offset = 0; offset < dma_row_bytes; offset += 4)
+        {
+            if (control & DMA_CONTROL_FILL)
+                value = dma_fill_value;
+            else
+                value = read_memory_word(proc, dma_src + row * dma_src_stride + offset);
+
+            write_memory_word(proc, dma_dest + row * dma_dest_stride + offset, value);
+        }
+    }
+
+    dma_done = true;
+    if (control & DMA_CONTROL_INT_EN)
+        raise_interrupt(proc, INT_DMA);
+}
+
+static uint32_t read_texel_byte(uint32_t address)
+{
+    return (read_memory_word(proc, address & ~3u) >> ((address & 3) * 8)) & 0xff;
+}
+
+// Like the DMA engine, the emulated texture sampler finishes the job before
+// the register write returns. This computes the same values as the hardware
+// (see hardware/core/texture_sampler.sv for the job format).
+static void run_texture_job(uint32_t job)
+{
+    uint32_t base = read_memory_word(proc, job);
+    uint32_t width = read_memory_word(proc, job + 4) & 0xffff;
+    uint32_t height = read_memory_word(proc, job + 8) & 0xffff;
+    uint32_t stride = read_memory_word(proc, job + 12);
+    bool gray = read_memory_word(proc, job + 16) & TEXTURE_GRAY8;
+    bool bilinear = read_memory_word(proc, job + 20) & TEXTURE_BILINEAR;
+    uint32_t lane_mask = read_memory_word(proc, job + 24);
+    uint32_t lane;
+    uint32_t channel;
+    uint32_t texel;
+
+    for (lane = 0; lane < 16; lane++)
+    {
+        uint32_t u;
+        uint32_t v;
+        uint32_t x[2];
+        uint32_t y[2];
+        uint32_t fu;
+        uint32_t fv;
+        uint32_t color = 0;
+
+        if ((lane_mask & (1 << lane)) == 0)
+            continue;
+
+        u = read_memory_word(proc, job + TEXTURE_JOB_U + lane * 4);
+        v = read_memory_word(proc, job + TEXTURE_JOB_V + lane * 4);
+        x[0] = u >> 16;
+        y[0] = v >> 16;
+        x[1] = (x[0] + 1) & 0xffff;
+        y[1] = (y[0] + 1) & 0xffff;
+        if (x[1] == width)
+            x[1] = 0;
+
+        if (y[1] == height)
+            y[1] = 0;
+
+        fu = (u >> 8) & 0xff;
+        fv = (v >> 8) & 0xff;
+        for (channel = 0; channel < 4; channel++)
+        {
+            uint32_t sum = 0;
+            for (texel = 0; texel < (bilinear ? 4 : 1); texel++)
+            {
+                uint32_t tx = x[texel & 1];
+                uint32_t ty = y[texel >> 1];
+                uint32_t weight = 0x10000;
+                uint32_t address;
+
+                if (bilinear)
+                {
+                    weight = ((texel & 1) ? fu : 256 - fu)
+                             * ((texel & 2) ? fv : 256 - fv);
+                }
+
+                if (gray)
+                    address = base + ty * stride + tx;
+                else
+                    address = ((base + ty * stride + tx * 4) & ~3u) + channel;
+
+                sum += read_texel_byte(address) * weight;
+            }
+
+            color |= ((sum + 0x8000) >> 16) << (channel * 8);
+        }
+
+        write_memory_word(proc, job + TEXTURE_JOB_RESULT + lane * 4, color);
+    }
+}
+
 void write_device_register(uint32_t address, uint32_t value)
 {
     switch (address)
@@ -67,6 +192,49 @@ void write_device_register(uint32_t address, uint32_t value)
         case REG_HOST_INTERRUPT:
             send_host_interrupt(value);
             break;
+
+        // The low bits of addresses, lengths, and strides are ignored, like
+        // the hardware.
+        case REG_DMA_SRC:
+            dma_src = value & ~3u;
+            break;
+
+        case REG_DMA_DEST:
+            dma_dest = value & ~3u;
+            break;
+
+        case REG_DMA_ROW_BYTES:
+            dma_row_bytes = value & ~3u;
+            break;
+
+        case REG_DMA_ROWS:
+            dma_rows = value;
+            break;
+
+        case REG_DMA_SRC_STRIDE:
+            dma_src_stride = value & ~3u;
+            break;
+
+        case REG_DMA_DEST_STRIDE:
+            dma_dest_stride = value & ~3u;
+            break;
+
+        case REG_DMA_FILL_VALUE:
+            dma_fill_value = value;
+            break;
+
+        case REG_DMA_CONTROL:
+            start_dma(value);
+            break;
+
+        case REG_DMA_STATUS:
+            dma_done = false;
+            clear_interrupt(proc, INT_DMA);
+            break;
+
+        case REG_TEXTURE_JOB:
+            run_texture_job(value & ~63u);
+            break;
     }
 }
 
@@ -121,6 +289,39 @@ uint32_t read_device_register(uint32_t address)
         case REG_SD_STATUS:
             return 1;
 
+        case REG_DMA_SRC:
+            return dma_src;
+
+        case REG_DMA_DEST:
+            return dma_dest;
+
+        case REG_DMA_ROW_BYTES:
+            return dma_row_bytes;
+
+        case REG_DMA_ROWS:
+            return dma_rows;
+
+        case REG_DMA_SRC_STRIDE:
+            return dma_src_stride;
+
+        case REG_DMA_DEST_STRIDE:
+            return dma_dest_stride;
+
+        case REG_DMA_FILL_VALUE:
+            return dma_fill_value;
+
+        case REG_DMA_CONTROL:
+            return dma_control;
+
+        case REG_DMA_STATUS:
+            return dma_done ? DMA_STATUS_DONE : 0;
+
+        case REG_TEXTURE_STATUS:
+            return 0;
+
+        case REG_TEXTURE_ID:
+            return TEXTURE_SAMPLER_ID;
+
         default:
             return 0xffffffff;
     }
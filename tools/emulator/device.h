@@ -35,6 +35,18 @@
 #define REG_VGA_ENABLE      0xffff0180
 #define REG_VGA_BASE        0xffff0188
 #define REG_TIMER_INT       0xffff0240
+#define REG_DMA_SRC         0xffff0300
+#define REG_DMA_DEST        0xffff0304
+#define REG_DMA_ROW_BYTES   0xffff0308
+#define REG_DMA_ROWS        0xffff030c
+#define REG_DMA_SRC_STRIDE  0xffff0310
+#define REG_DMA_DEST_STRIDE 0xffff0314
+#define REG_DMA_FILL_VALUE  0xffff0318
+#define REG_DMA_CONTROL     0xffff031c
+#define REG_DMA_STATUS      0xffff0320
+#define REG_TEXTURE_JOB     0xffff0400
+#define REG_TEXTURE_STATUS  0xffff0404
+#define REG_TEXTURE_ID      0xffff0408
 
 // Interrupt bitmask
 #define INT_COSIM 0x00000001
@@ -42,6 +54,8 @@
 #define INT_UART_RX 0x00000004
 #define INT_PS2_RX 0x00000008
 #define INT_VGA_FRAME 0x00000010
+#define INT_DMA 0x00000020
+#define INT_PERF_COUNTER 0x00008000 // Raised by the core, not a device
 
 struct processor;
 
@@ -25,6 +25,7 @@
 #define TLB_EXECUTABLE 4
 #define TLB_SUPERVISOR 8
 #define TLB_GLOBAL 16
+#define TLB_SUPERPAGE 32
 
 enum arithmetic_op
 {
@@ -62,6 +63,13 @@ enum arithmetic_op
     OP_ADD_F = 32,
     OP_SUB_F = 33,
     OP_MUL_F = 34,
+    OP_MLA_F = 35,
+    OP_REDUCE_ADD_F = 36,
+    OP_REDUCE_MIN_F = 37,
+    OP_REDUCE_MAX_F = 38,
+    OP_REDUCE_ADD_I = 39,
+    OP_REDUCE_MIN_I = 40,
+    OP_REDUCE_MAX_I = 41,
     OP_ITOF	= 42,
     OP_CMPGT_F = 44,
     OP_CMPGE_F = 45,
@@ -69,6 +77,10 @@ enum arithmetic_op
     OP_CMPLE_F = 47,
     OP_CMPEQ_F = 48,
     OP_CMPNE_F = 49,
+    OP_DIV_I = 50,
+    OP_DIV_U = 51,
+    OP_REM_I = 52,
+    OP_REM_U = 53,
     OP_BREAKPOINT = 62
 };
 
@@ -138,7 +150,66 @@ enum control_register
     CR_JTAG_DATA = 18,
     CR_SYSCALL_INDEX = 19,
     CR_SUSPEND_THREAD = 20,
-    CR_RESUME_THREAD = 21
+    CR_RESUME_THREAD = 21,
+    CR_PERF_EVENT_SELECT0 = 22,
+    CR_PERF_EVENT_SELECT1 = 23,
+    CR_PERF_EVENT_COUNT0_L = 24,
+    CR_PERF_EVENT_COUNT0_H = 25,
+    CR_PERF_EVENT_COUNT1_L = 26,
+    CR_PERF_EVENT_COUNT1_H = 27,
+    CR_PERF_INDEX = 28,
+    CR_PERF_DATA = 29,
+    CR_PREFETCH_CONTROL = 30,
+    CR_WAIT_FOR_WRITE = 31
+};
+
+// Field of a performance counter accessed through CR_PERF_DATA, selected by
+// bits 9:8 of CR_PERF_INDEX (bits 7:0 are the counter number).
+enum perf_field
+{
+    PERF_FIELD_CONTROL = 0,
+    PERF_FIELD_COUNT_L = 1,
+    PERF_FIELD_COUNT_H = 2
+};
+
+#define PERF_CONTROL_EVENT_MASK 0xff
+#define PERF_CONTROL_THREAD_SHIFT 8
+#define PERF_CONTROL_THREAD_MASK 0xff00
+#define PERF_CONTROL_INT_EN 0x40000000
+#define PERF_CONTROL_OVERFLOW 0x80000000
+
+// CR_PREFETCH_CONTROL. The emulator doesn't prefetch, but preserves the
+// value so software can read it back.
+#define PREFETCH_CONTROL_DCACHE_EN 1
+#define PREFETCH_CONTROL_DCACHE_DISTANCE_MASK 0xf0
+#define PREFETCH_CONTROL_ICACHE_EN 0x100
+#define PREFETCH_CONTROL_RESET (PREFETCH_CONTROL_DCACHE_EN | (2 << 4) \
+    | PREFETCH_CONTROL_ICACHE_EN)
+
+// Performance events. These are the same indices as the hardware
+// (perf_events in core.sv).
+enum perf_event
+{
+    PERF_INTERRUPT = 0,
+    PERF_STORE_ROLLBACK = 1,
+    PERF_STORE = 2,
+    PERF_INSTRUCTION_RETIRE = 3,
+    PERF_INSTRUCTION_ISSUE = 4,
+    PERF_ICACHE_MISS = 5,
+    PERF_ICACHE_HIT = 6,
+    PERF_ITLB_MISS = 7,
+    PERF_DCACHE_MISS = 8,
+    PERF_DCACHE_HIT = 9,
+    PERF_DTLB_MISS = 10,
+    PERF_UNCOND_BRANCH = 11,
+    PERF_COND_BRANCH_TAKEN = 12,
+    PERF_COND_BRANCH_NOT_TAKEN = 13,
+    PERF_DCACHE_PREFETCH = 14,
+    PERF_DCACHE_PREFETCH_HIT = 15,
+    PERF_ICACHE_PREFETCH = 16,
+    PERF_ICACHE_PREFETCH_HIT = 17,
+    PERF_BRANCH_PREDICTED = 18,
+    PERF_BRANCH_MISPREDICTED = 19
 };
 
 enum trap_type
@@ -162,6 +233,8 @@ enum cache_control_op
     CC_DTLB_INSERT = 0,
     CC_DINVALIDATE = 1,
     CC_DFLUSH = 2,
+    CC_IINVALIDATE = 3,
+    CC_MEMBAR = 4,
     CC_INVALIDATE_TLB = 5,
     CC_INVALIDATE_TLB_ALL = 6,
     CC_ITLB_INSERT = 7
@@ -17,6 +17,7 @@
 #include <assert.h>
 #include <fcntl.h>
 #include <inttypes.h>
+#include <float.h>
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -31,11 +32,22 @@
 
 #define TLB_SETS 16
 #define TLB_WAYS 4
+#define TLB_SUPERPAGE_ENTRIES 4
 #define PAGE_SIZE 0x1000u
 #define ROUND_TO_PAGE(addr) ((addr) & ~(PAGE_SIZE - 1u))
 #define PAGE_OFFSET(addr) ((addr) & (PAGE_SIZE - 1u))
+#define SUPERPAGE_SIZE 0x400000u
+#define ROUND_TO_SUPERPAGE(addr) ((addr) & ~(SUPERPAGE_SIZE - 1u))
+#define SUPERPAGE_OFFSET(addr) ((addr) & (SUPERPAGE_SIZE - 1u))
 #define TRAP_LEVELS 2
 
+// Each core has a private scratchpad memory at this physical address. Its
+// size matches SCRATCHPAD_LINES in hardware/core/config.svh. Addresses past
+// the end of the scratchpad, up to DEVICE_BASE_ADDRESS, wrap around.
+#define SCRATCHPAD_BASE 0xfffe0000u
+#define SCRATCHPAD_SIZE 0x4000u
+#define NUM_PERF_COUNTERS 8
+
 #ifdef DUMP_INSTRUCTION_STATS
 #define TALLY_INSTRUCTION(type) thread->core->proc->stat ## type++
 #else
@@ -56,6 +68,7 @@ struct thread
     struct core *core;
     uint32_t id;
     uint32_t last_sync_load_addr; // Cache line number (addr / 64)
+    uint32_t combined_store_line; // Cache line number, see count_store
     uint32_t pc;
     uint32_t asid;
     uint32_t page_dir;
@@ -64,7 +77,9 @@ struct thread
     bool enable_interrupt;
     bool enable_mmu;
     bool enable_supervisor;
+    bool waiting_for_write; // Wrote CR_WAIT_FOR_WRITE, see execute_instruction
     uint32_t subcycle;
+    uint32_t perf_index;
     uint32_t scalar_reg[NUM_REGISTERS];
     uint32_t vector_reg[NUM_REGISTERS][NUM_VECTOR_LANES];
 
@@ -92,6 +107,13 @@ struct tlb_entry
     uint32_t phys_addr_and_flags;
 };
 
+// Cache events are never counted, since the emulator doesn't model caches.
+struct perf_counter
+{
+    uint64_t count;
+    uint32_t control;
+};
+
 struct core
 {
     struct processor *proc;
@@ -104,6 +126,20 @@ struct core
     uint32_t next_itlb_way;
     struct tlb_entry *dtlb;
     uint32_t next_dtlb_way;
+
+    // Superpage translations are fully associative, like the hardware.
+    struct tlb_entry itlb_superpages[TLB_SUPERPAGE_ENTRIES];
+    uint32_t next_itlb_superpage;
+    struct tlb_entry dtlb_superpages[TLB_SUPERPAGE_ENTRIES];
+    uint32_t next_dtlb_superpage;
+    struct perf_counter perf_counters[NUM_PERF_COUNTERS];
+    uint32_t perf_selected_events;  // Bitmap, avoids scanning counters
+
+    // Set when a counter with interrupts enabled overflows. Interrupts are
+    // dispatched before the next instruction executes on this core.
+    bool perf_interrupt_check;
+    uint32_t prefetch_control;
+    uint32_t *scratchpad;
 };
 
 struct processor
@@ -150,8 +186,16 @@ static void set_scalar_reg(struct thread*, uint32_t reg, uint32_t value);
 static void set_vector_reg(struct thread*, uint32_t reg, uint32_t mask,
                            uint32_t *values);
 static void invalidate_sync_address(struct core*, uint32_t address);
+static void *get_data_ptr(struct thread*, uint32_t physical_address);
 static void try_to_dispatch_interrupt(struct thread*);
 static uint32_t get_pending_interrupts(struct thread*);
+static void count_perf_event(struct thread*, enum perf_event);
+static void count_store(struct thread*, uint32_t physical_address, bool can_combine);
+static uint32_t get_perf_interrupt(const struct thread*);
+static void dispatch_perf_interrupts(struct core*);
+static void update_perf_selected_events(struct core*);
+static uint32_t read_perf_data(struct thread*);
+static void write_perf_data(struct thread*, uint32_t value);
 static const char *get_trap_name(enum trap_type);
 static void raise_trap(struct thread*, uint32_t address, enum trap_type type, bool is_store,
                        bool is_data_cache, uint32_t syscall_index);
@@ -161,8 +205,16 @@ static void raise_trap(struct thread*, uint32_t address, enum trap_type type, bo
 // will also raise a trap or print an error as a side effect).
 static bool translate_address(struct thread*, uint32_t virtual_address, uint32_t
                               *physical_address, bool is_store, bool is_data_cache);
+
+// Returns the TLB entry that maps the address, or NULL if there is none.
+// A 4k entry takes priority over a superpage entry that contains it.
+static struct tlb_entry *lookup_tlb_entry(struct thread*, uint32_t virtual_address,
+        bool is_data_cache);
 static uint32_t scalar_arithmetic_op(enum arithmetic_op, uint32_t value1, uint32_t value2);
 static bool is_compare_op(uint32_t op);
+static bool is_reduce_op(uint32_t op);
+static uint32_t fused_multiply_add(uint32_t value1, uint32_t value2, uint32_t value3);
+static uint32_t reduce_lanes(enum arithmetic_op, const uint32_t *values, uint32_t mask);
 static struct breakpoint *lookup_breakpoint(struct processor*, uint32_t pc);
 static void execute_register_arith_inst(struct thread*, uint32_t instruction);
 static void execute_immediate_arith_inst(struct thread*, uint32_t instruction);
@@ -259,17 +311,33 @@ struct processor *init_processor(uint32_t memory_size, uint32_t num_cores,
             core->dtlb[i].virtual_address = INVALID_ADDR;
         }
 
+        for (i = 0; i < TLB_SUPERPAGE_ENTRIES; i++)
+        {
+            core->itlb_superpages[i].virtual_address = INVALID_ADDR;
+            core->dtlb_superpages[i].virtual_address = INVALID_ADDR;
+        }
+
         core->threads = (struct thread*) calloc(sizeof(struct thread), threads_per_core);
         for (thread_id = 0; thread_id < threads_per_core; thread_id++)
         {
             core->threads[thread_id].core = core;
             core->threads[thread_id].id = core_id * threads_per_core + thread_id;
             core->threads[thread_id].last_sync_load_addr = INVALID_ADDR;
+            core->threads[thread_id].combined_store_line = INVALID_ADDR;
             core->threads[thread_id].enable_supervisor = true;
             core->threads[thread_id].saved_trap_state[0].enable_supervisor = true;
         }
 
         core->trap_handler_pc = 0;
+        for (i = 0; i < NUM_PERF_COUNTERS; i++)
+        {
+            core->perf_counters[i].control = ((1u << threads_per_core) - 1)
+                                             << PERF_CONTROL_THREAD_SHIFT;
+        }
+
+        update_perf_selected_events(core);
+        core->prefetch_control = PREFETCH_CONTROL_RESET;
+        core->scratchpad = (uint32_t*) calloc(SCRATCHPAD_SIZE, 1);
     }
 
     proc->total_threads = threads_per_core * num_cores;
@@ -490,6 +558,26 @@ void dbg_set_vector_reg(struct processor *proc, uint32_t thread_id,
            NUM_VECTOR_LANES * sizeof(int));
 }
 
+uint32_t read_memory_word(const struct processor *proc, uint32_t address)
+{
+    if (address >= proc->memory_size)
+        return 0xffffffff;
+
+    return proc->memory[address / 4];
+}
+
+void write_memory_word(struct processor *proc, uint32_t address, uint32_t value)
+{
+    uint32_t core_id;
+
+    if (address >= proc->memory_size)
+        return;
+
+    proc->memory[address / 4] = value;
+    for (core_id = 0; core_id < proc->num_cores; core_id++)
+        invalidate_sync_address(&proc->cores[core_id], address);
+}
+
 // XXX This does not perform address translation.
 // We can't handle TLB misses properly when the fault is caused by debugger.
 // Should either do a best effort, returning nothing if the TLB entry is missing,
@@ -675,13 +763,27 @@ static void invalidate_sync_address(struct core *core, uint32_t address)
 {
     uint32_t thread_id;
 
-    for (thread_id = 0; thread_id < core->proc->total_threads; thread_id++)
+    for (thread_id = 0; thread_id < core->proc->threads_per_core; thread_id++)
     {
         if (core->threads[thread_id].last_sync_load_addr == address / CACHE_LINE_LENGTH)
             core->threads[thread_id].last_sync_load_addr = INVALID_ADDR;
     }
 }
 
+// Returns a pointer to the data at a physical address, which is either in
+// system memory or this core's scratchpad. This doesn't handle device
+// registers.
+static void *get_data_ptr(struct thread *thread, uint32_t physical_address)
+{
+    if (physical_address >= SCRATCHPAD_BASE)
+    {
+        return UINT8_PTR(thread->core->scratchpad, physical_address
+                         & (SCRATCHPAD_SIZE - 1));
+    }
+
+    return UINT8_PTR(thread->core->proc->memory, physical_address);
+}
+
 static void try_to_dispatch_interrupt(struct thread *thread)
 {
     uint32_t pending = get_pending_interrupts(thread);
@@ -703,7 +805,95 @@ static void try_to_dispatch_interrupt(struct thread *thread)
 static uint32_t get_pending_interrupts(struct thread *thread)
 {
     return (thread->core->is_level_triggered & thread->core->proc->interrupt_levels)
-           | (~thread->core->is_level_triggered & thread->latched_interrupts);
+           | (~thread->core->is_level_triggered & thread->latched_interrupts)
+           | get_perf_interrupt(thread);
+}
+
+static void count_perf_event(struct thread *thread, enum perf_event event)
+{
+    struct core *core = thread->core;
+    uint32_t thread_bit = 1u << (PERF_CONTROL_THREAD_SHIFT
+                                 + thread->id % core->proc->threads_per_core);
+    struct perf_counter *counter;
+    int i;
+
+    if ((core->perf_selected_events & (1u << event)) == 0)
+        return;
+
+    for (i = 0; i < NUM_PERF_COUNTERS; i++)
+    {
+        counter = &core->perf_counters[i];
+        if ((counter->control & PERF_CONTROL_EVENT_MASK) == event
+                && (counter->control & thread_bit) != 0
+                && ++counter->count == 0)
+        {
+            counter->control |= PERF_CONTROL_OVERFLOW;
+            if (counter->control & PERF_CONTROL_INT_EN)
+                core->perf_interrupt_check = true;
+        }
+    }
+}
+
+// The hardware write combines stores from a thread to the same cache line
+// into one L2 request, which is what PERF_STORE counts, so a store to the
+// line of the previous one is not counted again. This doesn't model the
+// timeout that sends a held store, so stores to the same line that are far
+// apart may count fewer requests than the hardware.
+static void count_store(struct thread *thread, uint32_t physical_address, bool can_combine)
+{
+    uint32_t line = physical_address / CACHE_LINE_LENGTH;
+
+    if (!can_combine || line != thread->combined_store_line)
+        count_perf_event(thread, PERF_STORE);
+
+    thread->combined_store_line = can_combine ? line : INVALID_ADDR;
+}
+
+// The overflow interrupt is level triggered and goes to every thread that
+// the counter is counting events for. In cosimulation mode, the hardware
+// model reports the interrupts it takes, so don't raise them here.
+static uint32_t get_perf_interrupt(const struct thread *thread)
+{
+    const struct core *core = thread->core;
+    uint32_t thread_bit = 1u << (PERF_CONTROL_THREAD_SHIFT
+                                 + thread->id % core->proc->threads_per_core);
+    uint32_t control;
+    int i;
+
+    if (core->proc->enable_cosim)
+        return 0;
+
+    for (i = 0; i < NUM_PERF_COUNTERS; i++)
+    {
+        control = core->perf_counters[i].control;
+        if ((control & PERF_CONTROL_OVERFLOW) != 0
+                && (control & PERF_CONTROL_INT_EN) != 0
+                && (control & thread_bit) != 0)
+            return INT_PERF_COUNTER;
+    }
+
+    return 0;
+}
+
+static void update_perf_selected_events(struct core *core)
+{
+    int i;
+
+    core->perf_selected_events = 0;
+    for (i = 0; i < NUM_PERF_COUNTERS; i++)
+    {
+        core->perf_selected_events |= 1u << (core->perf_counters[i].control
+                                             & PERF_CONTROL_EVENT_MASK & 31);
+    }
+}
+
+static void dispatch_perf_interrupts(struct core *core)
+{
+    uint32_t thread_id;
+
+    core->perf_interrupt_check = false;
+    for (thread_id = 0; thread_id < core->proc->threads_per_core; thread_id++)
+        try_to_dispatch_interrupt(&core->threads[thread_id]);
 }
 
 static const char *get_trap_name(enum trap_type type)
@@ -783,6 +973,7 @@ static void raise_trap(struct thread *thread, uint32_t trap_address, enum trap_t
 
     // Update thread state
     thread->enable_interrupt = false;
+    thread->waiting_for_write = false;
     if (type == TT_TLB_MISS)
     {
         thread->pc = thread->core->tlb_miss_handler_pc;
@@ -793,20 +984,51 @@ static void raise_trap(struct thread *thread, uint32_t trap_address, enum trap_t
 
     thread->subcycle = 0;
     thread->enable_supervisor = true;
+    if (type == TT_INTERRUPT)
+        count_perf_event(thread, PERF_INTERRUPT);
+}
+
+static struct tlb_entry *lookup_tlb_entry(struct thread *thread, uint32_t virtual_address,
+        bool is_data_access)
+{
+    int tlb_set;
+    int way;
+    struct tlb_entry *entries;
+
+    tlb_set = (virtual_address / PAGE_SIZE) % TLB_SETS;
+    entries = (is_data_access ? thread->core->dtlb : thread->core->itlb)
+              + tlb_set * TLB_WAYS;
+    for (way = 0; way < TLB_WAYS; way++)
+    {
+        if (entries[way].virtual_address == ROUND_TO_PAGE(virtual_address)
+                && ((entries[way].phys_addr_and_flags & TLB_GLOBAL) != 0
+                    || entries[way].asid == thread->asid))
+            return &entries[way];
+    }
+
+    entries = is_data_access ? thread->core->dtlb_superpages
+              : thread->core->itlb_superpages;
+    for (way = 0; way < TLB_SUPERPAGE_ENTRIES; way++)
+    {
+        if (entries[way].virtual_address == ROUND_TO_SUPERPAGE(virtual_address)
+                && ((entries[way].phys_addr_and_flags & TLB_GLOBAL) != 0
+                    || entries[way].asid == thread->asid))
+            return &entries[way];
+    }
+
+    return NULL;
 }
 
 static bool translate_address(struct thread *thread, uint32_t virtual_address,
                               uint32_t *out_physical_address, bool is_store,
                               bool is_data_access)
 {
-    int tlb_set;
-    int way;
-    struct tlb_entry *set_entries;
+    struct tlb_entry *entry;
 
     if (!thread->enable_mmu)
     {
         if (virtual_address >= thread->core->proc->memory_size
-            && virtual_address < DEVICE_BASE_ADDRESS)
+            && virtual_address < SCRATCHPAD_BASE)
         {
             // This isn't an actual fault supported by the hardware, but a debugging
             // aid only available in the emulator.
@@ -821,65 +1043,67 @@ static bool translate_address(struct thread *thread, uint32_t virtual_address,
         return true;
     }
 
-    tlb_set = (virtual_address / PAGE_SIZE) % TLB_SETS;
-    set_entries = (is_data_access ? thread->core->dtlb : thread->core->itlb)
-                  + tlb_set * TLB_WAYS;
-    for (way = 0; way < TLB_WAYS; way++)
+    entry = lookup_tlb_entry(thread, virtual_address, is_data_access);
+    if (entry != NULL)
     {
-        if (set_entries[way].virtual_address == ROUND_TO_PAGE(virtual_address)
-                && ((set_entries[way].phys_addr_and_flags & TLB_GLOBAL) != 0
-                    || set_entries[way].asid == thread->asid))
+        if ((entry->phys_addr_and_flags & TLB_PRESENT) == 0)
         {
-            if ((set_entries[way].phys_addr_and_flags & TLB_PRESENT) == 0)
-            {
-                raise_trap(thread, virtual_address, TT_PAGE_FAULT, is_store,
-                           is_data_access, 0);
-                return false;
-            }
+            raise_trap(thread, virtual_address, TT_PAGE_FAULT, is_store,
+                       is_data_access, 0);
+            return false;
+        }
 
-            if ((set_entries[way].phys_addr_and_flags & TLB_SUPERVISOR) != 0
-                    && !thread->enable_supervisor)
-            {
-                raise_trap(thread, virtual_address, TT_SUPERVISOR_ACCESS, is_store,
-                           is_data_access, 0);
-                return false;
-            }
+        if ((entry->phys_addr_and_flags & TLB_SUPERVISOR) != 0
+                && !thread->enable_supervisor)
+        {
+            raise_trap(thread, virtual_address, TT_SUPERVISOR_ACCESS, is_store,
+                       is_data_access, 0);
+            return false;
+        }
 
-            if ((set_entries[way].phys_addr_and_flags & TLB_EXECUTABLE) == 0
-                    && !is_data_access)
-            {
-                raise_trap(thread, virtual_address, TT_NOT_EXECUTABLE, false,
-                    false, 0);
-                return false;
-            }
+        if ((entry->phys_addr_and_flags & TLB_EXECUTABLE) == 0
+                && !is_data_access)
+        {
+            raise_trap(thread, virtual_address, TT_NOT_EXECUTABLE, false,
+                false, 0);
+            return false;
+        }
 
-            if (is_store && (set_entries[way].phys_addr_and_flags & TLB_WRITE_ENABLE) == 0)
-            {
-                raise_trap(thread, virtual_address, TT_ILLEGAL_STORE, true,
-                           is_data_access, 0);
-                return false;
-            }
+        if (is_store && (entry->phys_addr_and_flags & TLB_WRITE_ENABLE) == 0)
+        {
+            raise_trap(thread, virtual_address, TT_ILLEGAL_STORE, true,
+                       is_data_access, 0);
+            return false;
+        }
 
-            *out_physical_address = ROUND_TO_PAGE(set_entries[way].phys_addr_and_flags)
+        if (entry->phys_addr_and_flags & TLB_SUPERPAGE)
+        {
+            *out_physical_address = ROUND_TO_SUPERPAGE(entry->phys_addr_and_flags)
+                                    | SUPERPAGE_OFFSET(virtual_address);
+        }
+        else
+        {
+            *out_physical_address = ROUND_TO_PAGE(entry->phys_addr_and_flags)
                                     | PAGE_OFFSET(virtual_address);
+        }
 
-            if (*out_physical_address >= thread->core->proc->memory_size
-                && *out_physical_address < DEVICE_BASE_ADDRESS)
-            {
-                // This isn't an actual fault supported by the hardware, but a debugging
-                // aid only available in the emulator.
-                printf("Translated physical address out of range. va %08x pa %08x\n",
-                       virtual_address, *out_physical_address);
-                print_thread_registers(thread);
-                thread->core->proc->crashed = true;
-                return false;
-            }
-
-            return true;
+        if (*out_physical_address >= thread->core->proc->memory_size
+            && *out_physical_address < SCRATCHPAD_BASE)
+        {
+            // This isn't an actual fault supported by the hardware, but a debugging
+            // aid only available in the emulator.
+            printf("Translated physical address out of range. va %08x pa %08x\n",
+                   virtual_address, *out_physical_address);
+            print_thread_registers(thread);
+            thread->core->proc->crashed = true;
+            return false;
         }
+
+        return true;
     }
 
     // No translation found
+    count_perf_event(thread, is_data_access ? PERF_DTLB_MISS : PERF_ITLB_MISS);
     raise_trap(thread, virtual_address, TT_TLB_MISS, is_store, is_data_access, 0);
     return false;
 }
@@ -973,6 +1197,27 @@ static uint32_t scalar_arithmetic_op(enum arithmetic_op operation, uint32_t valu
             return value_as_float(value1) == value_as_float(value2);
         case OP_CMPNE_F:
             return value_as_float(value1) != value_as_float(value2);
+
+        // Division by zero and overflow have defined results, which match
+        // the hardware divider.
+        case OP_DIV_I:
+            if (value2 == 0)
+                return 0xffffffff;
+            else if (value1 == 0x80000000 && value2 == 0xffffffff)
+                return value1;
+
+            return (uint32_t)((int32_t)value1 / (int32_t)value2);
+        case OP_DIV_U:
+            return value2 == 0 ? 0xffffffff : value1 / value2;
+        case OP_REM_I:
+            if (value2 == 0)
+                return value1;
+            else if (value1 == 0x80000000 && value2 == 0xffffffff)
+                return 0;
+
+            return (uint32_t)((int32_t)value1 % (int32_t)value2);
+        case OP_REM_U:
+            return value2 == 0 ? value1 : value1 % value2;
         default:
             return 0u;
     }
@@ -983,6 +1228,204 @@ static bool is_compare_op(uint32_t op)
     return (op >= OP_CMPEQ_I && op <= OP_CMPLE_U) || (op >= OP_CMPGT_F && op <= OP_CMPNE_F);
 }
 
+static bool is_reduce_op(uint32_t op)
+{
+    return op >= OP_REDUCE_ADD_F && op <= OP_REDUCE_MAX_I;
+}
+
+// Results that are subnormal before rounding flush to a zero with the same
+// sign, as in the hardware. This includes ones that round up to FLT_MIN, so
+// it can't check the result of fmaf. The product of two floats is exact as a
+// double. The sum isn't necessarily, so this also computes its rounding error
+// (Knuth's TwoSum) to check the case where the sum rounds to FLT_MIN.
+static uint32_t fused_multiply_add(uint32_t value1, uint32_t value2, uint32_t value3)
+{
+    float multiplicand = value_as_float(value1);
+    float multiplier = value_as_float(value2);
+    float addend = value_as_float(value3);
+    double product = (double) multiplicand * multiplier;
+    double sum = product + addend;
+    double addend_part = sum - product;
+    double error = (product - (sum - addend_part)) + (addend - addend_part);
+
+    if (sum != 0.0 && (fabs(sum) < FLT_MIN || (fabs(sum) == FLT_MIN
+            && error != 0.0 && (error < 0.0) != (sum < 0.0))))
+        return sum < 0.0 ? 0x80000000 : 0;
+
+    return value_as_int(fmaf(multiplicand, multiplier, addend));
+}
+
+// Map floating point values to keys that have the same order when compared
+// as unsigned integers. Negative values sort below positive ones and NaNs
+// sort at the ends (depending on their sign bit).
+static uint32_t float_order_key(uint32_t value)
+{
+    return (value & 0x80000000) ? ~value : (value | 0x80000000);
+}
+
+static uint32_t float_from_order_key(uint32_t key)
+{
+    return (key & 0x80000000) ? (key & 0x7fffffff) : ~key;
+}
+
+// This matches the hardware exactly: each enabled lane is converted to a
+// fixed point value with 8 bits below the significand of the lane with the
+// largest exponent, truncating any bits below that. These are added exactly,
+// then the sum is rounded to nearest even. Because the fixed point sum is
+// exact, the result doesn't depend on the order of the lanes. Results that
+// are subnormal before rounding flush to a zero with the sign of the sum.
+static uint32_t reduce_add_float(const uint32_t *values, uint32_t mask)
+{
+    int lane;
+    uint32_t max_exponent = 1;
+    bool has_nan = false;
+    bool has_pos_inf = false;
+    bool has_neg_inf = false;
+    int64_t sum = 0;
+    uint64_t magnitude;
+    uint64_t normalized;
+    uint32_t norm_shift;
+    uint32_t significand;
+    int exponent;
+    bool round;
+
+    for (lane = 0; lane < NUM_VECTOR_LANES; lane++)
+    {
+        uint32_t exponent_bits = (values[lane] >> 23) & 0xff;
+        if ((mask & (1 << lane)) == 0)
+            continue;
+
+        if (exponent_bits == 0xff)
+        {
+            if (values[lane] & 0x7fffff)
+                has_nan = true;
+            else if (values[lane] & 0x80000000)
+                has_neg_inf = true;
+            else
+                has_pos_inf = true;
+        }
+
+        if (exponent_bits > max_exponent)
+            max_exponent = exponent_bits;
+    }
+
+    if (has_nan || (has_pos_inf && has_neg_inf))
+        return 0x7fffffff;
+
+    if (has_pos_inf || has_neg_inf)
+        return has_neg_inf ? 0xff800000 : 0x7f800000;
+
+    for (lane = 0; lane < NUM_VECTOR_LANES; lane++)
+    {
+        uint32_t exponent_bits = (values[lane] >> 23) & 0xff;
+        uint32_t lane_significand;
+        uint32_t shift;
+        int64_t aligned;
+
+        if ((mask & (1 << lane)) == 0)
+            continue;
+
+        if (exponent_bits == 0)
+        {
+            lane_significand = values[lane] & 0x7fffff;
+            shift = max_exponent - 1;
+        }
+        else
+        {
+            lane_significand = (values[lane] & 0x7fffff) | 0x800000;
+            shift = max_exponent - exponent_bits;
+        }
+
+        aligned = shift >= 32 ? 0 : (lane_significand << 8) >> shift;
+        sum += (values[lane] & 0x80000000) ? -aligned : aligned;
+    }
+
+    if (sum == 0)
+        return 0;
+
+    magnitude = (uint64_t) (sum < 0 ? -sum : sum);
+    norm_shift = 35;
+    while (norm_shift > 0 && (magnitude >> (35 - norm_shift)) != 1)
+        norm_shift--;
+
+    normalized = (magnitude << norm_shift) & 0xfffffffffull;
+    significand = (normalized >> 12) & 0x7fffff;
+    round = (normalized & 0x800) && ((normalized & 0x7ff) || (significand & 1));
+    exponent = (int) max_exponent + 4 - (int) norm_shift;
+    if (exponent <= 0)
+        return sum < 0 ? 0x80000000 : 0;
+
+    if (round)
+    {
+        significand = (significand + 1) & 0x7fffff;
+        if (significand == 0)
+            exponent++;
+    }
+
+    if (exponent >= 255)
+        return (sum < 0 ? 0x80000000 : 0) | 0x7f800000;
+
+    return (sum < 0 ? 0x80000000 : 0) | ((uint32_t) exponent << 23) | significand;
+}
+
+// Combine the lanes that are enabled in mask. If no lanes are enabled, the
+// result is the identity for addition or the value that sorts last for
+// min/max.
+static uint32_t reduce_lanes(enum arithmetic_op op, const uint32_t *values, uint32_t mask)
+{
+    int lane;
+    uint32_t result;
+
+    switch (op)
+    {
+        case OP_REDUCE_ADD_F:
+            return reduce_add_float(values, mask);
+
+        case OP_REDUCE_ADD_I:
+            result = 0;
+            for (lane = 0; lane < NUM_VECTOR_LANES; lane++)
+            {
+                if (mask & (1 << lane))
+                    result += values[lane];
+            }
+
+            return result;
+
+        case OP_REDUCE_MIN_I:
+        case OP_REDUCE_MAX_I:
+            result = op == OP_REDUCE_MIN_I ? 0x7fffffff : 0x80000000;
+            for (lane = 0; lane < NUM_VECTOR_LANES; lane++)
+            {
+                if ((mask & (1 << lane)) == 0)
+                    continue;
+
+                if (op == OP_REDUCE_MIN_I ? (int32_t) values[lane] < (int32_t) result
+                        : (int32_t) values[lane] > (int32_t) result)
+                    result = values[lane];
+            }
+
+            return result;
+
+        case OP_REDUCE_MIN_F:
+        case OP_REDUCE_MAX_F:
+            result = op == OP_REDUCE_MIN_F ? 0xffffffff : 0;
+            for (lane = 0; lane < NUM_VECTOR_LANES; lane++)
+            {
+                uint32_t key = float_order_key(values[lane]);
+                if ((mask & (1 << lane)) == 0)
+                    continue;
+
+                if (op == OP_REDUCE_MIN_F ? key < result : key > result)
+                    result = key;
+            }
+
+            return float_from_order_key(result);
+
+        default:
+            return 0;
+    }
+}
+
 static struct breakpoint *lookup_breakpoint(struct processor *proc, uint32_t pc)
 {
     struct breakpoint *breakpoint;
@@ -1019,6 +1462,28 @@ static void execute_register_arith_inst(struct thread *thread, uint32_t instruct
         set_scalar_reg(thread, destreg, thread->vector_reg[op1reg]
                        [thread->scalar_reg[op2reg] & 0xf]);
     }
+    else if (is_reduce_op(op))
+    {
+        // Source is a vector register in the second operand, result is scalar
+        switch (fmt)
+        {
+            case FMT_RA_VV:
+                set_scalar_reg(thread, destreg, reduce_lanes(op, thread->vector_reg[op2reg],
+                               0xffff));
+                break;
+
+            case FMT_RA_VV_M:
+                set_scalar_reg(thread, destreg, reduce_lanes(op, thread->vector_reg[op2reg],
+                               thread->scalar_reg[maskreg]));
+                break;
+
+            default:
+                raise_trap(thread, 0, TT_ILLEGAL_INSTRUCTION, false, false, 0);
+                return;
+        }
+
+        TALLY_INSTRUCTION(vector_inst);
+    }
     else if (is_compare_op(op))
     {
         uint32_t result = 0;
@@ -1069,8 +1534,19 @@ static void execute_register_arith_inst(struct thread *thread, uint32_t instruct
     }
     else if (fmt == FMT_RA_SS)
     {
-        uint32_t result = scalar_arithmetic_op(op, thread->scalar_reg[op1reg],
-                                               thread->scalar_reg[op2reg]);
+        uint32_t result;
+        if (op == OP_MLA_F)
+        {
+            result = fused_multiply_add(thread->scalar_reg[op1reg],
+                                        thread->scalar_reg[op2reg],
+                                        thread->scalar_reg[destreg]);
+        }
+        else
+        {
+            result = scalar_arithmetic_op(op, thread->scalar_reg[op1reg],
+                                          thread->scalar_reg[op2reg]);
+        }
+
         set_scalar_reg(thread, destreg, result);
     }
     else
@@ -1111,8 +1587,17 @@ static void execute_register_arith_inst(struct thread *thread, uint32_t instruct
             uint32_t scalar_value = thread->scalar_reg[op2reg];
             for (lane = 0; lane < NUM_VECTOR_LANES; lane++)
             {
-                result[lane] = scalar_arithmetic_op(op, thread->vector_reg[op1reg][lane],
-                                                    scalar_value);
+                if (op == OP_MLA_F)
+                {
+                    result[lane] = fused_multiply_add(thread->vector_reg[op1reg][lane],
+                                                      scalar_value,
+                                                      thread->vector_reg[destreg][lane]);
+                }
+                else
+                {
+                    result[lane] = scalar_arithmetic_op(op, thread->vector_reg[op1reg][lane],
+                                                        scalar_value);
+                }
             }
         }
         else
@@ -1120,8 +1605,17 @@ static void execute_register_arith_inst(struct thread *thread, uint32_t instruct
             // Vector/Vector operands
             for (lane = 0; lane < NUM_VECTOR_LANES; lane++)
             {
-                result[lane] = scalar_arithmetic_op(op, thread->vector_reg[op1reg][lane],
-                                                    thread->vector_reg[op2reg][lane]);
+                if (op == OP_MLA_F)
+                {
+                    result[lane] = fused_multiply_add(thread->vector_reg[op1reg][lane],
+                                                      thread->vector_reg[op2reg][lane],
+                                                      thread->vector_reg[destreg][lane]);
+                }
+                else
+                {
+                    result[lane] = scalar_arithmetic_op(op, thread->vector_reg[op1reg][lane],
+                                                        thread->vector_reg[op2reg][lane]);
+                }
             }
         }
 
@@ -1296,28 +1790,28 @@ static void execute_scalar_load_store_inst(struct thread *thread, uint32_t instr
                 if (is_device_access)
                     value = read_device_register(physical_address);
                 else
-                    value = (uint32_t) *UINT32_PTR(thread->core->proc->memory, physical_address);
+                    value = (uint32_t) *(uint32_t*) get_data_ptr(thread, physical_address);
 
                 break;
 
             case MEM_BYTE:
-                value = (uint32_t) *UINT8_PTR(thread->core->proc->memory, physical_address);
+                value = (uint32_t) *(uint8_t*) get_data_ptr(thread, physical_address);
                 break;
 
             case MEM_BYTE_SEXT:
-                value = (uint32_t)(int32_t) *INT8_PTR(thread->core->proc->memory, physical_address);
+                value = (uint32_t)(int32_t) *(int8_t*) get_data_ptr(thread, physical_address);
                 break;
 
             case MEM_SHORT:
-                value = (uint32_t) *UINT16_PTR(thread->core->proc->memory, physical_address);
+                value = (uint32_t) *(uint16_t*) get_data_ptr(thread, physical_address);
                 break;
 
             case MEM_SHORT_EXT:
-                value = (uint32_t)(int32_t) *INT16_PTR(thread->core->proc->memory, physical_address);
+                value = (uint32_t)(int32_t) *(int16_t*) get_data_ptr(thread, physical_address);
                 break;
 
             case MEM_SYNC:
-                value = *UINT32_PTR(thread->core->proc->memory, physical_address);
+                value = *(uint32_t*) get_data_ptr(thread, physical_address);
                 thread->last_sync_load_addr = physical_address / CACHE_LINE_LENGTH;
                 break;
 
@@ -1337,6 +1831,8 @@ static void execute_scalar_load_store_inst(struct thread *thread, uint32_t instr
         // Store
         uint32_t value_to_store = thread->scalar_reg[destsrcreg];
 
+        count_store(thread, physical_address, op != MEM_SYNC && !is_device_access);
+
         // Some instruction don't update memory, for example: a synchronized store
         // that fails or writes to device memory. This tracks whether they
         // did for the cosimulation code below.
@@ -1345,13 +1841,13 @@ static void execute_scalar_load_store_inst(struct thread *thread, uint32_t instr
         {
             case MEM_BYTE:
             case MEM_BYTE_SEXT:
-                *UINT8_PTR(thread->core->proc->memory, physical_address) = (uint8_t) value_to_store;
+                *(uint8_t*) get_data_ptr(thread, physical_address) = (uint8_t) value_to_store;
                 did_write = true;
                 break;
 
             case MEM_SHORT:
             case MEM_SHORT_EXT:
-                *UINT16_PTR(thread->core->proc->memory, physical_address) = (uint16_t) value_to_store;
+                *(uint16_t*) get_data_ptr(thread, physical_address) = (uint16_t) value_to_store;
                 did_write = true;
                 break;
 
@@ -1368,12 +1864,15 @@ static void execute_scalar_load_store_inst(struct thread *thread, uint32_t instr
                     return;
                 }
 
-                *UINT32_PTR(thread->core->proc->memory, physical_address) = value_to_store;
+                *(uint32_t*) get_data_ptr(thread, physical_address) = value_to_store;
                 did_write = true;
                 break;
 
             case MEM_SYNC:
-                if (physical_address / CACHE_LINE_LENGTH == thread->last_sync_load_addr)
+                // Synchronized stores to the scratchpad always succeed,
+                // because other cores can't access it.
+                if (physical_address / CACHE_LINE_LENGTH == thread->last_sync_load_addr
+                    || physical_address >= SCRATCHPAD_BASE)
                 {
                     // Success
 
@@ -1384,7 +1883,7 @@ static void execute_scalar_load_store_inst(struct thread *thread, uint32_t instr
                     // a side effect), set the value explicitly here.
                     thread->scalar_reg[destsrcreg] = 1;
 
-                    *UINT32_PTR(thread->core->proc->memory, physical_address) = value_to_store;
+                    *(uint32_t*) get_data_ptr(thread, physical_address) = value_to_store;
                     did_write = true;
                 }
                 else
@@ -1473,7 +1972,7 @@ static void execute_block_load_store_inst(struct thread *thread, uint32_t instru
         return;
     }
 
-    block_ptr = UINT32_PTR(thread->core->proc->memory, physical_address);
+    block_ptr = (uint32_t*) get_data_ptr(thread, physical_address);
     if (is_load)
     {
         uint32_t load_value[NUM_VECTOR_LANES];
@@ -1489,6 +1988,7 @@ static void execute_block_load_store_inst(struct thread *thread, uint32_t instru
         if ((mask & 0xffff) == 0)
             return;	// Hardware ignores block stores with a mask of zero
 
+        count_store(thread, physical_address, true);
         if (thread->core->proc->enable_tracing)
         {
             printf("%08x [th %u] write_mem_block %08x\n", thread->pc - 4, thread->id,
@@ -1517,9 +2017,12 @@ static void execute_scatter_gather_inst(struct thread *thread, uint32_t instruct
     bool is_load = extract_unsigned_bits(instruction, 29, 1);
     uint32_t offset;
     uint32_t lane;
+    uint32_t last_lane;
     uint32_t mask;
+    uint32_t run_mask;
     uint32_t virtual_address;
     uint32_t physical_address;
+    uint32_t line_address;
 
     TALLY_INSTRUCTION(vector_inst);
 
@@ -1540,8 +2043,25 @@ static void execute_scatter_gather_inst(struct thread *thread, uint32_t instruct
             assert(0);
     }
 
+    // The hardware services a run of lanes that access the same cache line
+    // (or are masked off) with one pass. Model the same runs, because a
+    // pass is one cosimulation event.
     lane = thread->subcycle;
     virtual_address = thread->vector_reg[ptrreg][lane] + offset;
+    run_mask = 1 << lane;
+    for (last_lane = lane + 1; last_lane < NUM_VECTOR_LANES; last_lane++)
+    {
+        uint32_t lane_address = thread->vector_reg[ptrreg][last_lane] + offset;
+        if ((mask & (1 << last_lane))
+                && (!(mask & (1 << lane))
+                || (lane_address & 3) != 0
+                || (lane_address & ~CACHE_LINE_MASK) != (virtual_address & ~CACHE_LINE_MASK)))
+            break;
+
+        run_mask |= 1 << last_lane;
+    }
+
+    last_lane--;
     if ((mask & (1 << lane)) && (virtual_address & 3) != 0)
     {
         raise_trap(thread, virtual_address, TT_UNALIGNED_ACCESS, !is_load,
@@ -1560,35 +2080,62 @@ static void execute_scatter_gather_inst(struct thread *thread, uint32_t instruct
         return;
     }
 
+    // Lanes in the same line are in the same page, so they use the
+    // translation for the first one.
+    line_address = physical_address & ~CACHE_LINE_MASK;
     if (is_load)
     {
         uint32_t load_value[NUM_VECTOR_LANES];
         memset(load_value, 0, NUM_VECTOR_LANES * sizeof(uint32_t));
-        if (mask & (1 << lane))
-            load_value[lane] = *UINT32_PTR(thread->core->proc->memory, physical_address);
+        for (lane = thread->subcycle; lane <= last_lane; lane++)
+        {
+            if (mask & (1 << lane))
+            {
+                load_value[lane] = *(uint32_t*) get_data_ptr(thread, line_address
+                    | ((thread->vector_reg[ptrreg][lane] + offset) & CACHE_LINE_MASK));
+            }
+        }
 
-        set_vector_reg(thread, destsrcreg, mask & (1 << lane), load_value);
+        set_vector_reg(thread, destsrcreg, mask & run_mask, load_value);
     }
-    else if (mask & (1 << lane))
+    else if (mask & run_mask)
     {
-        if (thread->core->proc->enable_tracing)
+        uint32_t store_value[NUM_VECTOR_LANES];
+        uint32_t word_mask = 0;
+
+        count_store(thread, line_address, true);
+        memset(store_value, 0, NUM_VECTOR_LANES * sizeof(uint32_t));
+        for (lane = thread->subcycle; lane <= last_lane; lane++)
         {
-            printf("%08x [th %u] store_scatter (%u) %08x %08x\n", thread->pc - 4,
-                   thread->id, thread->subcycle, virtual_address,
-                   thread->vector_reg[destsrcreg][lane]);
+            uint32_t lane_address = thread->vector_reg[ptrreg][lane] + offset;
+            uint32_t word = (lane_address & CACHE_LINE_MASK) / 4;
+
+            if ((mask & (1 << lane)) == 0)
+                continue;
+
+            if (thread->core->proc->enable_tracing)
+            {
+                printf("%08x [th %u] store_scatter (%u) %08x %08x\n", thread->pc - 4,
+                       thread->id, lane, lane_address,
+                       thread->vector_reg[destsrcreg][lane]);
+            }
+
+            *(uint32_t*) get_data_ptr(thread, line_address | word * 4)
+                = thread->vector_reg[destsrcreg][lane];
+            store_value[word] = thread->vector_reg[destsrcreg][lane];
+            word_mask |= 1 << word;
         }
 
-        *UINT32_PTR(thread->core->proc->memory, physical_address)
-            = thread->vector_reg[destsrcreg][lane];
-        invalidate_sync_address(thread->core, physical_address);
+        invalidate_sync_address(thread->core, line_address);
         if (thread->core->proc->enable_cosim)
         {
-            cosim_check_scalar_store(thread->core->proc, thread->pc - 4, virtual_address, 4,
-                                     thread->vector_reg[destsrcreg][lane]);
+            cosim_check_vector_store(thread->core->proc, thread->pc - 4, virtual_address,
+                                     word_mask, store_value);
         }
     }
 
-    if (++thread->subcycle == NUM_VECTOR_LANES)
+    thread->subcycle = last_lane + 1;
+    if (thread->subcycle == NUM_VECTOR_LANES)
         thread->subcycle = 0; // Finish
     else
         thread->pc -= 4;	// repeat current instruction
@@ -1599,8 +2146,10 @@ static void execute_control_register_inst(struct thread *thread, uint32_t instru
     uint32_t cr_index = extract_unsigned_bits(instruction, 0, 5);
     uint32_t dst_src_reg = extract_unsigned_bits(instruction, 5, 5);
 
-    // Only threads in supervisor mode can access control registers.
-    if (!thread->enable_supervisor)
+    // Only threads in supervisor mode can access control registers, except
+    // for writing CR_WAIT_FOR_WRITE.
+    if (!thread->enable_supervisor && (extract_unsigned_bits(instruction, 29, 1)
+        || cr_index != CR_WAIT_FOR_WRITE))
     {
         raise_trap(thread, 0, TT_PRIVILEGED_OP, false, false, 0);
         return;
@@ -1694,6 +2243,34 @@ static void read_control_register(struct thread *thread, uint32_t cr_index,
         case CR_SYSCALL_INDEX:
             value = thread->saved_trap_state[0].syscall_index;
             break;
+
+        case CR_PERF_EVENT_COUNT0_L:
+            value = (uint32_t) thread->core->perf_counters[0].count;
+            break;
+
+        case CR_PERF_EVENT_COUNT0_H:
+            value = (uint32_t) (thread->core->perf_counters[0].count >> 32);
+            break;
+
+        case CR_PERF_EVENT_COUNT1_L:
+            value = (uint32_t) thread->core->perf_counters[1].count;
+            break;
+
+        case CR_PERF_EVENT_COUNT1_H:
+            value = (uint32_t) (thread->core->perf_counters[1].count >> 32);
+            break;
+
+        case CR_PERF_INDEX:
+            value = thread->perf_index;
+            break;
+
+        case CR_PERF_DATA:
+            value = read_perf_data(thread);
+            break;
+
+        case CR_PREFETCH_CONTROL:
+            value = thread->core->prefetch_control;
+            break;
     }
 
     set_scalar_reg(thread, dst_src_reg, value);
@@ -1775,6 +2352,93 @@ static void write_control_register(struct thread *thread, uint32_t cr_index,
             thread->core->proc->thread_enable_mask |= value
                 & ((1ull << thread->core->proc->total_threads) - 1);
             break;
+
+        case CR_PERF_EVENT_SELECT0:
+        case CR_PERF_EVENT_SELECT1:
+        {
+            struct perf_counter *counter = &thread->core->perf_counters[
+                cr_index - CR_PERF_EVENT_SELECT0];
+            counter->control = (counter->control & ~PERF_CONTROL_EVENT_MASK)
+                               | (value & PERF_CONTROL_EVENT_MASK);
+            update_perf_selected_events(thread->core);
+            break;
+        }
+
+        case CR_PERF_INDEX:
+            thread->perf_index = (value & 0x300) | (value & (NUM_PERF_COUNTERS - 1));
+            break;
+
+        case CR_PERF_DATA:
+            write_perf_data(thread, value);
+            break;
+
+        case CR_PREFETCH_CONTROL:
+            thread->core->prefetch_control = value & (PREFETCH_CONTROL_DCACHE_EN
+                                             | PREFETCH_CONTROL_DCACHE_DISTANCE_MASK
+                                             | PREFETCH_CONTROL_ICACHE_EN);
+            break;
+
+        case CR_WAIT_FOR_WRITE:
+            // In cosimulation mode, the hardware decides when the thread
+            // wakes. Continue right away, which is a permitted spurious wake.
+            if (!thread->core->proc->enable_cosim)
+                thread->waiting_for_write = true;
+
+            break;
+    }
+}
+
+static uint32_t read_perf_data(struct thread *thread)
+{
+    const struct perf_counter *counter = &thread->core->perf_counters[
+        thread->perf_index & (NUM_PERF_COUNTERS - 1)];
+
+    switch (thread->perf_index >> 8)
+    {
+        case PERF_FIELD_CONTROL:
+            return counter->control;
+
+        case PERF_FIELD_COUNT_L:
+            return (uint32_t) counter->count;
+
+        case PERF_FIELD_COUNT_H:
+            return (uint32_t) (counter->count >> 32);
+
+        default:
+            return 0xffffffff;
+    }
+}
+
+static void write_perf_data(struct thread *thread, uint32_t value)
+{
+    struct perf_counter *counter = &thread->core->perf_counters[
+        thread->perf_index & (NUM_PERF_COUNTERS - 1)];
+    uint32_t thread_mask = ((1u << thread->core->proc->threads_per_core) - 1)
+                           << PERF_CONTROL_THREAD_SHIFT;
+
+    switch (thread->perf_index >> 8)
+    {
+        case PERF_FIELD_CONTROL:
+            // Writing zero to the overflow bit clears it, writing one leaves
+            // it unchanged.
+            counter->control = (value & (PERF_CONTROL_EVENT_MASK | thread_mask
+                                         | PERF_CONTROL_INT_EN))
+                               | (value & counter->control & PERF_CONTROL_OVERFLOW);
+
+            update_perf_selected_events(thread->core);
+
+            // This may have enabled the interrupt for a counter that has
+            // already overflowed.
+            thread->core->perf_interrupt_check = true;
+            break;
+
+        case PERF_FIELD_COUNT_L:
+            counter->count = (counter->count & 0xffffffff00000000ull) | value;
+            break;
+
+        case PERF_FIELD_COUNT_H:
+            counter->count = (counter->count & 0xffffffffull) | ((uint64_t) value << 32);
+            break;
     }
 }
 
@@ -1831,31 +2495,45 @@ static void execute_branch_inst(struct thread *thread, uint32_t instruction)
     switch (extract_unsigned_bits(instruction, 25, 3))
     {
         case BRANCH_REGISTER:
+            count_perf_event(thread, PERF_UNCOND_BRANCH);
             thread->pc = thread->scalar_reg[src_reg];
             break;
 
         case BRANCH_ZERO:
             if (thread->scalar_reg[src_reg] == 0)
+            {
+                count_perf_event(thread, PERF_COND_BRANCH_TAKEN);
                 thread->pc += offset20;
+            }
+            else
+                count_perf_event(thread, PERF_COND_BRANCH_NOT_TAKEN);
 
             break;
 
         case BRANCH_NOT_ZERO:
             if (thread->scalar_reg[src_reg] != 0)
+            {
+                count_perf_event(thread, PERF_COND_BRANCH_TAKEN);
                 thread->pc += offset20;
+            }
+            else
+                count_perf_event(thread, PERF_COND_BRANCH_NOT_TAKEN);
 
             break;
 
         case BRANCH_ALWAYS:
+            count_perf_event(thread, PERF_UNCOND_BRANCH);
             thread->pc += offset25;
             break;
 
         case BRANCH_CALL_OFFSET:
+            count_perf_event(thread, PERF_UNCOND_BRANCH);
             set_scalar_reg(thread, LINK_REG, thread->pc);
             thread->pc += offset25;
             break;
 
         case BRANCH_CALL_REGISTER:
+            count_perf_event(thread, PERF_UNCOND_BRANCH);
             set_scalar_reg(thread, LINK_REG, thread->pc);
             thread->pc = thread->scalar_reg[src_reg];
             break;
@@ -1895,6 +2573,11 @@ static void execute_cache_control_inst(struct thread *thread, uint32_t instructi
     uint32_t way;
     bool updated_entry;
 
+    // These go through the store queue in the hardware, so a following store
+    // can't be combined with an earlier one.
+    if (op == CC_DINVALIDATE || op == CC_DFLUSH || op == CC_IINVALIDATE || op == CC_MEMBAR)
+        thread->combined_store_line = INVALID_ADDR;
+
     switch (op)
     {
         case CC_DINVALIDATE:
@@ -1925,6 +2608,7 @@ static void execute_cache_control_inst(struct thread *thread, uint32_t instructi
             uint32_t phys_addr_and_flags = thread->scalar_reg[phys_addr_reg];
             uint32_t *way_ptr;
             struct tlb_entry *tlb;
+            uint32_t num_ways = TLB_WAYS;
 
             if (!thread->enable_supervisor)
             {
@@ -1944,8 +2628,34 @@ static void execute_cache_control_inst(struct thread *thread, uint32_t instructi
             }
 
             struct tlb_entry *entry = &tlb[((virtual_address / PAGE_SIZE) % TLB_SETS) * TLB_WAYS];
+            if (phys_addr_and_flags & TLB_SUPERPAGE)
+            {
+                // Remove a 4k entry for the same page, which would take
+                // priority over the superpage.
+                for (way = 0; way < TLB_WAYS; way++)
+                {
+                    if (entry[way].virtual_address == virtual_address
+                            && ((entry[way].phys_addr_and_flags & TLB_GLOBAL) != 0
+                                || entry[way].asid == thread->asid))
+                        entry[way].virtual_address = INVALID_ADDR;
+                }
+
+                virtual_address = ROUND_TO_SUPERPAGE(virtual_address);
+                num_ways = TLB_SUPERPAGE_ENTRIES;
+                if (op == CC_DTLB_INSERT)
+                {
+                    entry = thread->core->dtlb_superpages;
+                    way_ptr = &thread->core->next_dtlb_superpage;
+                }
+                else
+                {
+                    entry = thread->core->itlb_superpages;
+                    way_ptr = &thread->core->next_itlb_superpage;
+                }
+            }
+
             updated_entry = false;
-            for (way = 0; way < TLB_WAYS; way++)
+            for (way = 0; way < num_ways; way++)
             {
                 if (entry[way].virtual_address == virtual_address
                         && ((entry[way].phys_addr_and_flags & TLB_GLOBAL) != 0
@@ -1966,7 +2676,7 @@ static void execute_cache_control_inst(struct thread *thread, uint32_t instructi
                 entry[*way_ptr].asid = thread->asid;
             }
 
-            *way_ptr = (*way_ptr + 1) % TLB_WAYS;
+            *way_ptr = (*way_ptr + 1) % num_ways;
             break;
         }
 
@@ -1991,6 +2701,18 @@ static void execute_cache_control_inst(struct thread *thread, uint32_t instructi
                     thread->core->dtlb[tlb_index + way].virtual_address = INVALID_ADDR;
             }
 
+            // Also remove a superpage that contains the address
+            for (way = 0; way < TLB_SUPERPAGE_ENTRIES; way++)
+            {
+                if (thread->core->itlb_superpages[way].virtual_address
+                        == ROUND_TO_SUPERPAGE(virtual_address))
+                    thread->core->itlb_superpages[way].virtual_address = INVALID_ADDR;
+
+                if (thread->core->dtlb_superpages[way].virtual_address
+                        == ROUND_TO_SUPERPAGE(virtual_address))
+                    thread->core->dtlb_superpages[way].virtual_address = INVALID_ADDR;
+            }
+
             break;
         }
 
@@ -2011,6 +2733,12 @@ static void execute_cache_control_inst(struct thread *thread, uint32_t instructi
                 thread->core->dtlb[i].virtual_address = INVALID_ADDR;
             }
 
+            for (i = 0; i < TLB_SUPERPAGE_ENTRIES; i++)
+            {
+                thread->core->itlb_superpages[i].virtual_address = INVALID_ADDR;
+                thread->core->dtlb_superpages[i].virtual_address = INVALID_ADDR;
+            }
+
             break;
         }
     }
@@ -2020,7 +2748,26 @@ static bool execute_instruction(struct thread *thread)
 {
     uint32_t instruction;
     uint32_t physical_pc;
-    unsigned int fetch_pc = thread->pc;
+    unsigned int fetch_pc;
+
+    if (thread->core->perf_interrupt_check)
+        dispatch_perf_interrupts(thread->core);
+
+    // A thread that wrote CR_WAIT_FOR_WRITE doesn't run until the cache line
+    // of its last synchronized load is written (which clears
+    // last_sync_load_addr), or an interrupt can be dispatched to it.
+    if (thread->waiting_for_write)
+    {
+        if (thread->last_sync_load_addr != INVALID_ADDR
+            && !(thread->enable_interrupt
+            && (get_pending_interrupts(thread) & thread->interrupt_mask) != 0))
+            return true;
+
+        thread->waiting_for_write = false;
+        thread->last_sync_load_addr = INVALID_ADDR;
+    }
+
+    fetch_pc = thread->pc;
     thread->pc += 4;
 
     // Check PC alignment
@@ -2037,6 +2784,8 @@ static bool execute_instruction(struct thread *thread)
 
     instruction = *UINT32_PTR(thread->core->proc->memory, physical_pc);
     thread->core->proc->total_instructions++;
+    count_perf_event(thread, PERF_INSTRUCTION_ISSUE);
+    count_perf_event(thread, PERF_INSTRUCTION_RETIRE);
 
 restart:
     if ((instruction & 0xe0000000) == 0xc0000000)
@@ -74,6 +74,11 @@ void dbg_set_vector_reg(struct processor*, uint32_t thread_id,
                         uint32_t reg_id, uint32_t *values);
 uint32_t dbg_read_memory_byte(const struct processor*, uint32_t addr);
 void dbg_write_memory_byte(const struct processor*, uint32_t addr, uint8_t byte);
+
+// Physical memory access for devices (the DMA engine). Addresses must be word
+// aligned. A write cancels synchronized loads of the line, like a store.
+uint32_t read_memory_word(const struct processor*, uint32_t addr);
+void write_memory_word(struct processor*, uint32_t addr, uint32_t value);
 int dbg_set_breakpoint(struct processor*, uint32_t pc);
 int dbg_clear_breakpoint(struct processor*, uint32_t pc);
 void dbg_set_stop_on_fault(struct processor*, bool stop_on_fault);
@@ -0,0 +1,820 @@
+//
+// Copyright 2018 Jeff Bush
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+//
+// Processes the sampling profiler output from the hardware model
+// (+profile=<filename>). The simulator records the program counter and
+// scheduling state of every thread on every core at a fixed interval. This
+// reads symbols and line tables directly from the ELF executable and prints
+// a breakdown of where time was spent.
+//
+// Profile file format (all values little endian):
+//   char magic[4];             "NPRF"
+//   uint32_t version;          1
+//   uint32_t numCores;
+//   uint32_t threadsPerCore;
+//   uint32_t sampleInterval;   Cycles between samples
+// followed by samples, each of which has one entry per thread (core major):
+//   uint32_t pc;
+//   uint8_t state;             (ThreadState below)
+//
+
+#include <getopt.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+// This must match the encoding in hardware/testbench/soc_tb.sv
+enum ThreadState
+{
+    TS_ISSUE,
+    TS_READY,
+    TS_WAIT_ICACHE,
+    TS_WAIT_DCACHE,
+    TS_WAIT_RAW,
+    TS_WAIT_WRITEBACK,
+    TS_DISABLED,
+    NUM_THREAD_STATES
+};
+
+const char * const STATE_NAMES[NUM_THREAD_STATES] =
+{
+    "issue",
+    "ready",
+    "icache",
+    "dcache",
+    "depend",
+    "wbconf",
+    "halted"
+};
+
+struct ProfileHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t numCores;
+    uint32_t threadsPerCore;
+    uint32_t sampleInterval;
+};
+
+// Sample counts, broken down by thread state
+struct StateCounts
+{
+    uint64_t counts[NUM_THREAD_STATES] = {};
+
+    uint64_t total() const
+    {
+        uint64_t sum = 0;
+        for (int i = 0; i < TS_DISABLED; i++)
+            sum += counts[i];
+
+        return sum;
+    }
+};
+
+struct Symbol
+{
+    uint32_t address;
+    uint32_t size;
+    std::string name;
+};
+
+struct LineEntry
+{
+    uint32_t address;
+    int fileIndex;      // Into lineFileNames
+    uint32_t line;
+    bool endSequence;
+};
+
+//
+// ELF definitions. These are declared here rather than using the system
+// elf.h, which is not available on all hosts.
+//
+const uint8_t ELFCLASS32 = 1;
+const uint8_t ELFDATA2LSB = 1;
+const uint32_t SHT_SYMTAB = 2;
+const uint8_t STT_FUNC = 2;
+
+struct Elf32Header
+{
+    uint8_t e_ident[16];
+    uint16_t e_type;
+    uint16_t e_machine;
+    uint32_t e_version;
+    uint32_t e_entry;
+    uint32_t e_phoff;
+    uint32_t e_shoff;
+    uint32_t e_flags;
+    uint16_t e_ehsize;
+    uint16_t e_phentsize;
+    uint16_t e_phnum;
+    uint16_t e_shentsize;
+    uint16_t e_shnum;
+    uint16_t e_shstrndx;
+};
+
+struct Elf32SectionHeader
+{
+    uint32_t sh_name;
+    uint32_t sh_type;
+    uint32_t sh_flags;
+    uint32_t sh_addr;
+    uint32_t sh_offset;
+    uint32_t sh_size;
+    uint32_t sh_link;
+    uint32_t sh_info;
+    uint32_t sh_addralign;
+    uint32_t sh_entsize;
+};
+
+struct Elf32Symbol
+{
+    uint32_t st_name;
+    uint32_t st_value;
+    uint32_t st_size;
+    uint8_t st_info;
+    uint8_t st_other;
+    uint16_t st_shndx;
+};
+
+std::vector<uint8_t> elfContents;
+std::vector<Symbol> symbols;
+std::vector<LineEntry> lineTable;
+std::vector<std::string> lineFileNames;
+
+bool readFile(const char *filename, std::vector<uint8_t> &contents)
+{
+    FILE *file = fopen(filename, "rb");
+    if (file == NULL)
+    {
+        perror("can't open file");
+        return false;
+    }
+
+    uint8_t buffer[0x10000];
+    size_t got;
+    while ((got = fread(buffer, 1, sizeof(buffer), file)) > 0)
+        contents.insert(contents.end(), buffer, buffer + got);
+
+    fclose(file);
+    return true;
+}
+
+// XXX These assume a little endian host, like the ELF file.
+template <typename T>
+T readValue(const uint8_t *ptr)
+{
+    T value;
+    memcpy(&value, ptr, sizeof(T));
+    return value;
+}
+
+// Offsets and sizes come from the file, so everything is checked against
+// the file size before it is read, in case the file is truncated or corrupt.
+bool inFile(size_t offset, size_t length)
+{
+    return offset <= elfContents.size() && length <= elfContents.size() - offset;
+}
+
+// Headers are copied out, because they may not be aligned in the file.
+bool getSectionHeader(int index, Elf32SectionHeader &section)
+{
+    Elf32Header header = readValue<Elf32Header>(elfContents.data());
+    size_t offset = header.e_shoff + size_t(index) * header.e_shentsize;
+    if (!inFile(offset, sizeof(Elf32SectionHeader)))
+        return false;
+
+    section = readValue<Elf32SectionHeader>(elfContents.data() + offset);
+    return inFile(section.sh_offset, section.sh_size);
+}
+
+// Return the null terminated string at offset in a string table section, or
+// NULL if it isn't entirely inside the section.
+const char *getString(const Elf32SectionHeader &stringSection, uint32_t offset)
+{
+    if (offset >= stringSection.sh_size)
+        return NULL;
+
+    const uint8_t *str = elfContents.data() + stringSection.sh_offset + offset;
+    if (memchr(str, 0, stringSection.sh_size - offset) == NULL)
+        return NULL;
+
+    return reinterpret_cast<const char*>(str);
+}
+
+bool findSection(const char *name, Elf32SectionHeader &section)
+{
+    Elf32Header header = readValue<Elf32Header>(elfContents.data());
+    Elf32SectionHeader stringSection;
+    if (!getSectionHeader(header.e_shstrndx, stringSection))
+        return false;
+
+    for (int i = 0; i < header.e_shnum; i++)
+    {
+        if (!getSectionHeader(i, section))
+            return false;
+
+        const char *sectionName = getString(stringSection, section.sh_name);
+        if (sectionName != NULL && strcmp(sectionName, name) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+bool readSymbols()
+{
+    Elf32Header header = readValue<Elf32Header>(elfContents.data());
+    for (int i = 0; i < header.e_shnum; i++)
+    {
+        Elf32SectionHeader section;
+        if (!getSectionHeader(i, section))
+            return false;
+
+        if (section.sh_type != SHT_SYMTAB)
+            continue;
+
+        Elf32SectionHeader stringSection;
+        if (!getSectionHeader(int(section.sh_link), stringSection))
+            return false;
+
+        uint32_t numSymbols = section.sh_size / sizeof(Elf32Symbol);
+        for (uint32_t symIndex = 0; symIndex < numSymbols; symIndex++)
+        {
+            Elf32Symbol sym = readValue<Elf32Symbol>(elfContents.data()
+                + section.sh_offset + symIndex * sizeof(Elf32Symbol));
+            if ((sym.st_info & 0xf) != STT_FUNC)
+                continue;
+
+            const char *name = getString(stringSection, sym.st_name);
+            if (name == NULL)
+                return false;
+
+            Symbol newSym;
+            newSym.address = sym.st_value;
+            newSym.size = sym.st_size;
+            newSym.name = name;
+            symbols.push_back(newSym);
+        }
+    }
+
+    std::sort(symbols.begin(), symbols.end(), [](const Symbol &a, const Symbol &b) {
+        return a.address < b.address;
+    });
+
+    return true;
+}
+
+const Symbol *findSymbol(uint32_t pc)
+{
+    auto it = std::upper_bound(symbols.begin(), symbols.end(), pc,
+        [](uint32_t addr, const Symbol &sym) { return addr < sym.address; });
+    if (it == symbols.begin())
+        return NULL;
+
+    --it;
+
+    // Assembly functions often don't have a size. In that case, assume it
+    // extends up to the next symbol.
+    if (it->size != 0 && pc >= it->address + it->size)
+        return NULL;
+
+    return &*it;
+}
+
+// The LEB128 readers stop at end. Callers check for ptr reaching end
+// (which includes a value that was cut off).
+uint32_t readUleb128(const uint8_t *&ptr, const uint8_t *end)
+{
+    uint32_t result = 0;
+    int shift = 0;
+    uint8_t byte;
+    do
+    {
+        if (ptr == end)
+            return result;
+
+        byte = *ptr++;
+        if (shift < 32)
+            result |= uint32_t(byte & 0x7f) << shift;
+
+        shift += 7;
+    }
+    while (byte & 0x80);
+
+    return result;
+}
+
+int32_t readSleb128(const uint8_t *&ptr, const uint8_t *end)
+{
+    int32_t result = 0;
+    int shift = 0;
+    uint8_t byte;
+    do
+    {
+        if (ptr == end)
+            return result;
+
+        byte = *ptr++;
+        if (shift < 32)
+            result |= int32_t(byte & 0x7f) << shift;
+
+        shift += 7;
+    }
+    while (byte & 0x80);
+
+    if (shift < 32 && (byte & 0x40))
+        result |= -(1 << shift);
+
+    return result;
+}
+
+//
+// Decode the DWARF line number program (versions 2-4) in the .debug_line
+// section to get a table mapping addresses to source lines.
+//
+void readLineTable()
+{
+    Elf32SectionHeader section;
+    if (!findSection(".debug_line", section))
+        return;
+
+    const uint8_t *ptr = elfContents.data() + section.sh_offset;
+    const uint8_t *sectionEnd = ptr + section.sh_size;
+    while (sectionEnd - ptr >= 4)
+    {
+        uint32_t unitLength = readValue<uint32_t>(ptr);
+        ptr += 4;
+        if (unitLength == 0xffffffff)
+        {
+            fprintf(stderr, "64-bit DWARF is not supported, line info unavailable\n");
+            return;
+        }
+
+        // Must at least contain the version and header length.
+        if (unitLength > size_t(sectionEnd - ptr) || unitLength < 6)
+        {
+            fprintf(stderr, "malformed line table, line info unavailable\n");
+            return;
+        }
+
+        const uint8_t *unitEnd = ptr + unitLength;
+        uint16_t version = readValue<uint16_t>(ptr);
+        ptr += 2;
+        if (version < 2 || version > 4)
+        {
+            fprintf(stderr, "DWARF line table version %d is not supported\n", version);
+            ptr = unitEnd;
+            continue;
+        }
+
+        uint32_t headerLength = readValue<uint32_t>(ptr);
+        ptr += 4;
+        if (headerLength > size_t(unitEnd - ptr) || headerLength < (version >= 4 ? 6u : 5u))
+        {
+            fprintf(stderr, "malformed line table, line info unavailable\n");
+            return;
+        }
+
+        const uint8_t *programStart = ptr + headerLength;
+        uint8_t minInstructionLength = *ptr++;
+        if (version >= 4)
+            ptr++;  // maximum_operations_per_instruction
+
+        ptr++;  // default_is_stmt
+        int8_t lineBase = int8_t(*ptr++);
+        uint8_t lineRange = *ptr++;
+        uint8_t opcodeBase = *ptr++;
+        const uint8_t *standardOpcodeLengths = ptr;
+        if (lineRange == 0 || opcodeBase == 0 || opcodeBase - 1 > programStart - ptr)
+        {
+            fprintf(stderr, "malformed line table, line info unavailable\n");
+            return;
+        }
+
+        ptr += opcodeBase - 1;
+
+        // Both lists are terminated by an empty string, and all strings must
+        // end before the line program.
+        std::vector<std::string> includeDirs;
+        includeDirs.push_back("");
+        while (ptr < programStart && *ptr != 0)
+        {
+            const char *dir = reinterpret_cast<const char*>(ptr);
+            if (memchr(dir, 0, size_t(programStart - ptr)) == NULL)
+                break;
+
+            includeDirs.push_back(dir);
+            ptr += strlen(dir) + 1;
+        }
+
+        if (ptr == programStart)
+        {
+            fprintf(stderr, "malformed line table, line info unavailable\n");
+            return;
+        }
+
+        ptr++;
+
+        // File numbers in the line program are one based.
+        int fileBase = int(lineFileNames.size()) - 1;
+        while (ptr < programStart && *ptr != 0)
+        {
+            const char *name = reinterpret_cast<const char*>(ptr);
+            if (memchr(name, 0, size_t(programStart - ptr)) == NULL)
+                break;
+
+            ptr += strlen(name) + 1;
+            uint32_t dirIndex = readUleb128(ptr, programStart);
+            readUleb128(ptr, programStart);   // Modification time
+            readUleb128(ptr, programStart);   // Length
+            if (dirIndex != 0 && dirIndex < includeDirs.size() && name[0] != '/')
+                lineFileNames.push_back(includeDirs[dirIndex] + "/" + name);
+            else
+                lineFileNames.push_back(name);
+        }
+
+        if (ptr >= programStart)
+        {
+            fprintf(stderr, "malformed line table, line info unavailable\n");
+            return;
+        }
+
+        // Run the state machine
+        ptr = programStart;
+        uint32_t address = 0;
+        uint32_t file = 1;
+        int32_t line = 1;
+        while (ptr < unitEnd)
+        {
+            uint8_t opcode = *ptr++;
+            bool emitRow = false;
+            bool endSequence = false;
+            if (opcode >= opcodeBase)
+            {
+                // Special opcode
+                uint8_t adjustedOpcode = opcode - opcodeBase;
+                address += (adjustedOpcode / lineRange) * minInstructionLength;
+                line += lineBase + adjustedOpcode % lineRange;
+                emitRow = true;
+            }
+            else if (opcode == 0)
+            {
+                // Extended opcode
+                uint32_t length = readUleb128(ptr, unitEnd);
+                if (length == 0 || length > size_t(unitEnd - ptr))
+                {
+                    fprintf(stderr, "malformed line table, line info unavailable\n");
+                    return;
+                }
+
+                const uint8_t *next = ptr + length;
+                switch (*ptr)
+                {
+                    case 1: // DW_LNE_end_sequence
+                        emitRow = true;
+                        endSequence = true;
+                        break;
+
+                    case 2: // DW_LNE_set_address
+                        if (length >= 5)
+                            address = readValue<uint32_t>(ptr + 1);
+
+                        break;
+
+                    case 3: // DW_LNE_define_file
+                        if (memchr(ptr + 1, 0, length - 1) != NULL)
+                            lineFileNames.push_back(reinterpret_cast<const char*>(ptr + 1));
+
+                        break;
+                }
+
+                ptr = next;
+            }
+            else
+            {
+                switch (opcode)
+                {
+                    case 1: // DW_LNS_copy
+                        emitRow = true;
+                        break;
+
+                    case 2: // DW_LNS_advance_pc
+                        address += readUleb128(ptr, unitEnd) * minInstructionLength;
+                        break;
+
+                    case 3: // DW_LNS_advance_line
+                        line += readSleb128(ptr, unitEnd);
+                        break;
+
+                    case 4: // DW_LNS_set_file
+                        file = readUleb128(ptr, unitEnd);
+                        break;
+
+                    case 8: // DW_LNS_const_add_pc
+                        address += ((255 - opcodeBase) / lineRange) * minInstructionLength;
+                        break;
+
+                    case 9: // DW_LNS_fixed_advance_pc
+                        if (unitEnd - ptr < 2)
+                        {
+                            ptr = unitEnd;
+                            break;
+                        }
+
+                        address += readValue<uint16_t>(ptr);
+                        ptr += 2;
+                        break;
+
+                    default:
+                        // Skip operands of any other opcodes
+                        for (int i = 0; i < standardOpcodeLengths[opcode - 1]; i++)
+                            readUleb128(ptr, unitEnd);
+                }
+            }
+
+            if (emitRow)
+            {
+                LineEntry entry;
+                entry.address = address;
+                entry.fileIndex = fileBase + int(file);
+                entry.line = uint32_t(line);
+                entry.endSequence = endSequence;
+                lineTable.push_back(entry);
+                if (endSequence)
+                {
+                    address = 0;
+                    file = 1;
+                    line = 1;
+                }
+            }
+        }
+
+        ptr = unitEnd;
+    }
+
+    // Sequences can be in any order in the section. Sort by address, but keep
+    // the end of a sequence before the start of one that begins at the same
+    // address.
+    std::stable_sort(lineTable.begin(), lineTable.end(),
+        [](const LineEntry &a, const LineEntry &b) {
+            if (a.address != b.address)
+                return a.address < b.address;
+
+            return a.endSequence && !b.endSequence;
+        });
+}
+
+const LineEntry *findLine(uint32_t pc)
+{
+    auto it = std::upper_bound(lineTable.begin(), lineTable.end(), pc,
+        [](uint32_t addr, const LineEntry &entry) { return addr < entry.address; });
+    if (it == lineTable.begin())
+        return NULL;
+
+    --it;
+    if (it->endSequence || it->fileIndex < 0
+            || it->fileIndex >= int(lineFileNames.size()))
+        return NULL;
+
+    return &*it;
+}
+
+void printStateHeader(const char *label)
+{
+    printf("%10s %7s", "samples", "%total");
+    for (int i = 0; i < TS_DISABLED; i++)
+        printf(" %7s", STATE_NAMES[i]);
+
+    printf(" %s\n", label);
+}
+
+void printStateRow(const StateCounts &counts, uint64_t totalSamples, const char *label)
+{
+    uint64_t samples = counts.total();
+    printf("%10llu %6.2f%%", static_cast<unsigned long long>(samples),
+           double(samples) / double(totalSamples) * 100);
+    for (int i = 0; i < TS_DISABLED; i++)
+        printf(" %6.2f%%", double(counts.counts[i]) / double(samples) * 100);
+
+    printf(" %s\n", label);
+}
+
+void printSorted(const std::map<std::string, StateCounts> &table, uint64_t totalSamples,
+                 int maxEntries)
+{
+    std::vector<std::pair<std::string, StateCounts>> sorted(table.begin(), table.end());
+    std::sort(sorted.begin(), sorted.end(), [](const std::pair<std::string, StateCounts> &a,
+        const std::pair<std::string, StateCounts> &b) {
+        return a.second.total() > b.second.total();
+    });
+
+    int count = 0;
+    for (auto &entry : sorted)
+    {
+        if (maxEntries > 0 && count++ == maxEntries)
+            break;
+
+        printStateRow(entry.second, totalSamples, entry.first.c_str());
+    }
+}
+
+void usage()
+{
+    printf("nyuzi_profile [options] <elf file> <profile file>\n");
+    printf("  -l           Show breakdown by source line (requires debug info)\n");
+    printf("  -t           Show breakdown by hardware thread\n");
+    printf("  -n <count>   Maximum number of functions or lines to print (default all)\n");
+}
+
+}
+
+int main(int argc, char * const argv[])
+{
+    int c;
+    bool showLines = false;
+    bool showThreads = false;
+    int maxEntries = 0;
+
+    while ((c = getopt(argc, argv, "ltn:")) != -1)
+    {
+        switch (c)
+        {
+            case 'l':
+                showLines = true;
+                break;
+
+            case 't':
+                showThreads = true;
+                break;
+
+            case 'n':
+                maxEntries = atoi(optarg);
+                break;
+
+            case '?':
+                usage();
+                return 1;
+        }
+    }
+
+    if (argc < optind + 2)
+    {
+        fprintf(stderr, "Not enough arguments\n");
+        usage();
+        return 1;
+    }
+
+    if (!readFile(argv[optind], elfContents))
+        return 1;
+
+    Elf32Header elfHeader;
+    if (elfContents.size() < sizeof(elfHeader))
+    {
+        fprintf(stderr, "%s is not an ELF file\n", argv[optind]);
+        return 1;
+    }
+
+    elfHeader = readValue<Elf32Header>(elfContents.data());
+    if (memcmp(elfHeader.e_ident, "\177ELF", 4) != 0
+            || elfHeader.e_ident[4] != ELFCLASS32
+            || elfHeader.e_ident[5] != ELFDATA2LSB)
+    {
+        fprintf(stderr, "%s is not a 32-bit little endian ELF file\n", argv[optind]);
+        return 1;
+    }
+
+    if (!readSymbols())
+    {
+        fprintf(stderr, "error reading symbols\n");
+        return 1;
+    }
+
+    if (showLines)
+        readLineTable();
+
+    std::vector<uint8_t> profileContents;
+    if (!readFile(argv[optind + 1], profileContents))
+        return 1;
+
+    if (profileContents.size() < sizeof(ProfileHeader))
+    {
+        fprintf(stderr, "profile file is truncated\n");
+        return 1;
+    }
+
+    ProfileHeader header = readValue<ProfileHeader>(profileContents.data());
+    if (memcmp(header.magic, "NPRF", 4) != 0 || header.version != 1)
+    {
+        fprintf(stderr, "bad profile file format\n");
+        return 1;
+    }
+
+    const int ENTRY_SIZE = 5;
+    uint32_t totalThreads = header.numCores * header.threadsPerCore;
+    std::vector<StateCounts> threadCounts(totalThreads);
+    std::map<std::string, StateCounts> functionCounts;
+    std::map<std::string, StateCounts> lineCounts;
+    StateCounts totalCounts;
+    uint64_t numSamples = 0;
+
+    const uint8_t *ptr = profileContents.data() + sizeof(ProfileHeader);
+    const uint8_t *end = profileContents.data() + profileContents.size();
+    while (ptr + totalThreads * ENTRY_SIZE <= end)
+    {
+        for (uint32_t thread = 0; thread < totalThreads; thread++)
+        {
+            uint32_t pc = readValue<uint32_t>(ptr);
+            uint8_t state = ptr[4];
+            ptr += ENTRY_SIZE;
+            if (state >= NUM_THREAD_STATES)
+            {
+                fprintf(stderr, "bad thread state in profile file\n");
+                return 1;
+            }
+
+            threadCounts[thread].counts[state]++;
+            if (state == TS_DISABLED)
+                continue;
+
+            totalCounts.counts[state]++;
+            const Symbol *sym = findSymbol(pc);
+            functionCounts[sym ? sym->name : "(unknown)"].counts[state]++;
+            if (showLines)
+            {
+                const LineEntry *line = findLine(pc);
+                if (line)
+                {
+                    char label[16];
+                    snprintf(label, sizeof(label), ":%u", line->line);
+                    lineCounts[lineFileNames[size_t(line->fileIndex)] + label].counts[state]++;
+                }
+                else
+                    lineCounts["(unknown)"].counts[state]++;
+            }
+        }
+
+        numSamples++;
+    }
+
+    uint64_t totalSamples = totalCounts.total();
+    printf("%llu samples, %u cores, %u threads per core, sampled every %u cycles\n",
+           static_cast<unsigned long long>(numSamples), header.numCores,
+           header.threadsPerCore, header.sampleInterval);
+    if (totalSamples == 0)
+        return 0;
+
+    printf("\n");
+    printStateHeader("function");
+    printSorted(functionCounts, totalSamples, maxEntries);
+
+    if (showLines)
+    {
+        printf("\n");
+        printStateHeader("line");
+        printSorted(lineCounts, totalSamples, maxEntries);
+    }
+
+    if (showThreads)
+    {
+        printf("\n");
+        printStateHeader("thread");
+        for (uint32_t thread = 0; thread < totalThreads; thread++)
+        {
+            char label[64];
+            snprintf(label, sizeof(label), "core %u thread %u (%.2f%% halted)",
+                     thread / header.threadsPerCore, thread % header.threadsPerCore,
+                     double(threadCounts[thread].counts[TS_DISABLED])
+                     / double(numSamples) * 100);
+            if (threadCounts[thread].total() != 0)
+                printStateRow(threadCounts[thread], totalSamples, label);
+        }
+    }
+
+    printf("\n");
+    printStateRow(totalCounts, totalSamples, "total");
+
+    return 0;
+}